@@ -8,3 +8,9 @@ array set colorcount {
 array names colorcount
 
 array get colorcount
+
+set colorcount(extra) 1
+
+unset colorcount(extra)
+
+puts [array get colorcount]
@@ -0,0 +1,41 @@
+puts [expr {9223372036854775807 + 1}]
+puts [expr {-9223372036854775808 - 1}]
+puts [expr {2 ^ 100}]
+puts [expr {3 ^ 200 % 1000007}]
+puts [expr {123456789012345678901234567890 * 987654321098765432109876543210}]
+puts [expr {(2 ^ 100) / (2 ^ 98)}]
+puts [expr {-(2 ^ 64) % 7}]
+puts [expr {(2 ^ 64) > 9223372036854775807}]
+puts [expr {(2 ^ 64) == 18446744073709551616}]
+puts [expr {abs(-9223372036854775808)}]
+puts [expr {-9223372036854775807 - 1}]
+puts [expr {(2 ^ 64) - (2 ^ 64) + 5}]
+puts [expr {(2 ^ 64) * 1.0}]
+set x 18446744073709551616
+puts [expr {$x + 1}]
+puts [expr {$x * $x}]
+set y 9223372036854775806
+incr y
+incr y
+puts $y
+incr y -2
+puts $y
+incr x $x
+puts $x
+puts [format "%d|%5d|%-30d|%+d|%030d" $x 7 $x $x $x]
+puts [format "%s %d %.3f" abc [expr {-(2 ^ 70)}] 1.5]
+catch {expr {(2 ^ 64) / 0}} m; puts $m
+catch {expr {2 ^ (2 ^ 40)}} m; puts $m
+puts [expr {(-1) ^ (2 ^ 70)}]
+puts [expr {1 ^ (2 ^ 70)}]
+puts [expr {(2 ^ 64) && 0}]
+puts [expr {int(2 ^ 64)}]
+set z abc
+catch {incr z} m; puts $m
+puts [expr {-9223372036854775808 / -1}]
+puts [expr {-9223372036854775808 % -1}]
+puts [expr {int(1e20)}]
+puts [expr {int(-2.5e30)}]
+puts [expr {round(1e19)}]
+puts [expr {round(-1e19)}]
+catch {expr {int(1e400)}} m; puts $m
@@ -0,0 +1,52 @@
+for {set i 0} {$i < 3} {incr i} {
+  foreach j {1 2 3 4} {
+    if {$j == 2} continue
+
+    if {$j == 4} break
+
+    puts "$i $j"
+  }
+}
+
+proc find { l x } {
+  set n 0
+
+  foreach v $l {
+    if {$v == $x} {
+      return $n
+    }
+
+    incr n
+  }
+
+  return -1
+}
+
+puts [find {5 6 7 8} 7]
+puts [find {5 6 7 8} 9]
+
+proc count_to { n } {
+  set i 0
+
+  while {1} {
+    incr i
+
+    if {$i >= $n} break
+  }
+
+  return $i
+}
+
+puts [count_to 4]
+
+puts [catch {break}]
+puts [catch {continue}]
+puts [catch {return 5} msg]
+puts $msg
+
+proc bad_break { } {
+  break
+}
+
+puts [catch {bad_break} msg]
+puts $msg
@@ -0,0 +1,43 @@
+proc check { x } {
+  if {$x > 1} {
+    error "value $x too large"
+  }
+
+  return $x
+}
+
+set count 0
+
+for {set i 0} {$i < 5} {incr i} {
+  set rc [catch {check $i} msg]
+
+  if {$rc} {
+    incr count
+  }
+}
+
+puts $count
+puts $msg
+
+puts [catch {lindex} msg]
+puts $msg
+
+puts [catch {set ok 1} msg]
+puts $msg
+
+proc inner_fail { } {
+  set local 1
+
+  catch {error "fail"}
+
+  return $local
+}
+
+puts [inner_fail]
+
+puts [catch {expr 1 +} msg]
+puts $msg
+
+error "top level error"
+
+puts "not reached"
@@ -0,0 +1,17 @@
+puts $env(HOME)
+
+for {set i 0} {$i < 3} {incr i} {
+  puts $env(HOME)
+}
+
+set env(CTCL_TEST) hello
+
+puts $env(CTCL_TEST)
+
+puts [exec printenv CTCL_TEST]
+
+unset env(CTCL_TEST)
+
+array set env {CTCL_TEST2 there}
+
+puts "<$env(CTCL_TEST)> <$env(CTCL_TEST2)>"
@@ -1 +1,116 @@
 puts [expr "1 + 2"]
+
+puts [expr {-2 + 3}]
+puts [expr {2 * -3}]
+puts [expr {- -4}]
+puts [expr {-(2 + 3) * 2}]
+puts [expr {1 - -1.5}]
+
+set n -1
+
+puts [expr {$n >= 0}]
+puts [expr {1*2 + 3*4 + 5*6 + 7*8 + 9*10 + 11*12 + 13*14 + 15*16 + 17*18 + 19*20}]
+
+puts [expr {2147483647 + 1}]
+puts [expr {9007199254740993 + 2}]
+puts [expr {3000000000 * 3}]
+puts [expr {2 ^ 62}]
+puts [expr {-7 / 2}]
+puts [expr {abs(-5)}]
+
+puts [catch {expr {7 / 0}} msg]
+puts $msg
+
+proc count { } {
+  global calls
+
+  incr calls
+
+  return 1
+}
+
+set calls 0
+
+puts [expr {0 && [count]}]
+puts [expr {1 || [count]}]
+puts [expr {1 && [count]}]
+puts [expr {0 || [count]}]
+puts $calls
+
+puts [expr {[info exists undefined] && $undefined > 0}]
+
+set x 5
+
+puts [expr {[info exists x] && $x > 0}]
+puts [expr {$x > 3 ? 10 : [count]}]
+puts [expr {$x > 7 ? 10 : $x < 0 ? 20 : 30}]
+puts [expr {!($x > 3)}]
+puts $calls
+
+set week 0
+
+foreach secs {100 700000} {
+  if {$secs > 60*60*24*7} { incr week }
+}
+
+puts $week
+puts [expr {-2*-3 + !0 + (1 ? 2 : 3)}]
+
+set y 3
+
+puts [expr {$y*$y + $y}]
+
+proc tcl::mathfunc::double_it { x } {
+  return [expr {$x * 2}]
+}
+
+puts [expr {double_it(21)}]
+puts [expr {sqrt(16) + pow(2, 10) + min(3, 1, 2) + max(1.5, 2)}]
+puts [expr {round(2.6) + int(3.9) + hypot(3, 4) + abs(-7)}]
+
+puts [catch {expr {sqrt(1, 2)}} msg]
+puts $msg
+
+set a "hello"
+set b "world"
+set n 007
+
+puts [expr {$a eq "hello"}]
+puts [expr {$a ne $b}]
+puts [expr {$a < $b}]
+puts [expr {$n == 7}]
+puts [expr {$n eq "007"}]
+puts [expr {"$a [string length $b]"}]
+puts [expr {$n > 3 ? "big" : "small"}]
+puts [expr {true && !false}]
+
+puts [catch {expr {$a + 1}} msg]
+puts $msg
+
+puts [expr {1/3.0}]
+puts [expr {0.1 + 0.2}]
+puts [expr {" 0x1f " + 1}]
+
+set c 1
+puts [expr {!($c ? 0 : 2)}]
+puts [expr {-($c ? 1 : 2)}]
+puts [expr {-(1 + 2)}]
+puts [expr {!0}]
+puts [expr {1.0}]
+puts [expr {2.0000001}]
+puts [expr {1e-7}]
+set x [expr {2.0*3}]
+puts $x
+puts [expr {$x/4}]
+puts [expr {1e20}]
+puts [expr {10/4}]
+
+puts [expr {3000000.0 + 1}]
+puts [expr {1500000.0}]
+puts [expr {1e16}]
+puts [expr {1e17}]
+puts [expr {0.00001}]
+
+puts [expr {0x10}]
+puts [expr {0x10 + 0o17 + 0b101}]
+puts [expr {0xFFFFFFFFFFFFFFFF}]
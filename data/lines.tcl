@@ -0,0 +1,25 @@
+proc square { x } {
+  set y [expr {$x * $x}]
+
+  return $y
+}
+
+profile lines start
+
+set total 0
+
+for {set i 0} {$i < 3} {incr i} {
+  incr total [square $i]
+}
+
+if {$total > 100} {
+  puts "not reached"
+}
+
+profile lines stop
+
+puts $total
+
+foreach entry [profile lines data] {
+  puts "[lindex $entry 1] [lindex $entry 2]"
+}
@@ -1,3 +1,6 @@
 set a [list 1 2 3]
 
 puts [llength $a]
+
+puts [lsort -integer {10 2 33 -4 0x10}]
+puts [lsort -real {1.5 -2 1e2 0.25}]
@@ -0,0 +1,34 @@
+set small "abc"
+
+set big {}
+
+for {set i 0} {$i < 100} {incr i} {
+  lappend big $i
+}
+
+for {set i 0} {$i < 10} {incr i} {
+  set arr($i) $i
+}
+
+set usage [memory usage]
+
+puts [lindex [lindex $usage 0] 0]
+
+set big_bytes   [memory usage big]
+set small_bytes [memory usage small]
+
+puts [expr {$big_bytes > $small_bytes}]
+
+array set data [memory data]
+
+puts [expr {$data(list.count) > 0}]
+puts [expr {$data(total.peakBytes) >= $data(total.bytes)}]
+
+unset big
+
+set big_bytes [memory usage arr]
+
+puts [expr {$big_bytes > 0}]
+
+puts [catch {memory usage nothing} msg]
+puts $msg
@@ -0,0 +1,27 @@
+proc build { n } {
+  set l {}
+
+  for {set i 0} {$i < $n} {incr i} {
+    lappend l "item $i"
+  }
+
+  return [llength $l]
+}
+
+puts [build 100]
+
+array set before [memory pool]
+
+puts [build 100]
+
+array set after [memory pool]
+
+set allocs [expr {$after(allocs) - $before(allocs)}]
+set reused [expr {$after(reused) - $before(reused)}]
+
+puts [expr {$allocs > 0}]
+puts [expr {$reused > 0}]
+puts [expr {$after(bytes) > 0}]
+
+puts [catch {memory pool extra} msg]
+puts $msg
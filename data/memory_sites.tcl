@@ -0,0 +1,61 @@
+proc leak { n } {
+  global cache
+
+  for {set i 0} {$i < $n} {incr i} {
+    set cache($i) "value $i"
+  }
+}
+
+proc temp { n } {
+  set l {}
+
+  for {set i 0} {$i < $n} {incr i} {
+    lappend l $i
+  }
+
+  return [llength $l]
+}
+
+memory sites start
+
+memory sites snapshot before
+
+leak 20
+temp 20
+
+memory sites snapshot after
+
+memory sites stop
+
+set diff [memory sites diff before after]
+
+set top [lindex $diff 0]
+
+puts [lindex $top 0]
+set dcount [lindex $top 1]
+
+puts [expr {$dcount > 0}]
+
+puts [catch {memory sites diff nothing} msg]
+puts $msg
+
+proc mk { } {
+  return [string repeat x 10]
+}
+
+memory sites clear
+memory sites start
+
+memory sites snapshot before
+
+for {set i 0} {$i < 10} {incr i} {
+  lappend ::leak [mk]
+}
+
+memory sites snapshot after
+
+memory sites stop
+
+set top [lindex [memory sites diff before after] 0]
+
+puts [lindex $top 0]
@@ -0,0 +1,56 @@
+namespace eval config {
+  variable width 10
+  variable height 20
+}
+
+puts $config::width
+puts $::config::height
+
+for {set i 0} {$i < 3} {incr i} {
+  puts [expr $config::width * $i]
+}
+
+set ::config::width 30
+
+puts $config::width
+
+namespace delete config
+
+namespace eval config {
+  variable width 5
+}
+
+puts $config::width
+
+namespace eval ::outer::inner {
+  variable depth 2
+}
+
+puts $::outer::inner::depth
+
+namespace delete ::outer::inner
+
+puts [catch {puts $::outer::inner::depth} msg]
+
+namespace delete ::outer
+
+puts [catch {namespace delete ::outer} msg]
+puts $msg
+
+for {set i 0} {$i < 2000} {incr i} {
+  set ::v$i $i
+}
+
+puts $::v1999
+
+# namespace deleted while in use is freed when its frames end
+namespace eval foo { set x 1; namespace delete ::foo; set y 2; puts "y $y" }
+
+namespace eval bar {
+  proc p { n } { namespace delete ::bar; return [q $n] }
+  proc q { n } { return [expr {$n * 2}] }
+
+  puts [p 21]
+}
+
+namespace eval a { namespace eval b { namespace delete ::a; set v 3; puts "v $v" } }
@@ -0,0 +1,68 @@
+proc fib { n } {
+  if {$n < 2} {
+    return $n
+  }
+
+  set a [fib [expr {$n - 1}]]
+  set b [fib [expr {$n - 2}]]
+
+  return [expr {$a + $b}]
+}
+
+profile start
+
+puts [fib 10]
+
+profile stop
+
+foreach entry [profile data] {
+  set name  [lindex $entry 0]
+  set type  [lindex $entry 1]
+  set count [lindex $entry 2]
+
+  switch $type {
+    proc {
+      puts "$name $count"
+    }
+  }
+}
+
+set n1 [info cmdcount]
+set x 1
+set n2 [info cmdcount]
+
+puts [expr {$n2 - $n1}]
+
+set report [profile report -sort count -limit 2]
+
+puts [string length $report]
+
+profile reset
+
+puts [llength [profile data]]
+
+proc maybe_stop { stop } {
+  for {set i 0} {$i < 100} {incr i} {
+    set x $i
+  }
+
+  if {$stop} {
+    profile stop
+  }
+}
+
+profile start
+
+maybe_stop 1
+
+profile start
+
+maybe_stop 0
+
+profile stop
+
+foreach entry [profile data] {
+  if {[lindex $entry 0] == "maybe_stop"} {
+    puts [expr {[lindex $entry 3] > 0}]
+  }
+}
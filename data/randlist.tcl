@@ -0,0 +1,22 @@
+puts [expr {srand(42)}]
+set a [expr {rand()}]
+puts [expr {srand(42)}]
+set b [expr {rand()}]
+puts [expr {$a == $b}]
+set r [expr {rand(10, 20)}]
+puts [expr {$r >= 10 && $r < 20}]
+
+expr {srand(7)}
+set l [randlist uniform 1000 5 6]
+puts [llength $l]
+puts [expr {[vexpr min $l] >= 5 && [vexpr max $l] < 6}]
+
+set n [randlist normal 100000 10 2]
+puts [expr {abs([vexpr mean $n] - 10) < 0.05}]
+puts [llength [randlist normal 3]]
+puts [randlist uniform 0]
+
+catch {randlist foo 3} m; puts $m
+catch {randlist uniform -1} m; puts $m
+catch {expr {srand(1.5)}} m; puts $m
+catch {randlist uniform 1000000000000} m; puts $m
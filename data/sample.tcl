@@ -0,0 +1,41 @@
+proc work { n } {
+  set s 0
+
+  for {set i 0} {$i < $n} {incr i} {
+    incr s $i
+  }
+
+  return $s
+}
+
+proc outer { } {
+  work 20000
+}
+
+profile sample start 1000
+
+puts [outer]
+
+profile sample stop
+
+set count [profile sample count]
+
+puts [expr {$count > 0}]
+
+set total 0
+
+foreach {stack n} [profile sample folded] {
+  incr total $n
+}
+
+puts [expr {$total == $count}]
+
+profile sample write /tmp/ctcl_sample.folded
+
+puts [file exists /tmp/ctcl_sample.folded]
+
+file delete /tmp/ctcl_sample.folded
+
+profile sample clear
+
+puts [profile sample count]
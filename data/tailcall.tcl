@@ -0,0 +1,161 @@
+proc sum_to { n total } {
+  if {$n == 0} {
+    return $total
+  }
+
+  tailcall sum_to [expr {$n - 1}] [expr {$total + $n}]
+}
+
+puts [sum_to 20000 0]
+
+proc walk { n } {
+  global depth
+
+  set depth $n
+
+  if {$n > 0} {
+    walk [expr {$n - 1}]
+  } else {
+    set depth done
+  }
+}
+
+walk 3000
+
+puts $depth
+
+proc fact { n } {
+  if {$n <= 1} {
+    return 1
+  }
+
+  set r [fact [expr {$n - 1}]]
+
+  return [expr {$n * $r}]
+}
+
+puts [fact 10]
+
+proc loop_tail { } {
+  tailcall puts "tail command"
+}
+
+loop_tail
+
+puts [catch {tailcall puts x} msg]
+puts $msg
+
+proc forever { } {
+  forever_sub
+}
+
+proc forever_sub { } {
+  set x [forever]
+}
+
+puts [catch {forever} msg]
+puts $msg
+
+puts [string length [fact 2000]]
+
+proc sum { n } {
+  if {$n == 0} {
+    return 0
+  }
+
+  set s [sum [expr {$n - 1}]]
+
+  expr {$n + $s}
+}
+
+puts [sum 5000]
+
+proc catch_down { n } {
+  if {$n == 0} {
+    error bottom
+  }
+
+  catch {catch_down [expr {$n - 1}]} msg
+
+  return "$n-$msg"
+}
+
+puts [string range [catch_down 5000] 0 20]
+
+proc up_down { n } {
+  if {$n == 0} {
+    return done
+  }
+
+  uplevel 1 [list set level $n]
+
+  return [up_down [expr {$n - 1}]]
+}
+
+puts [up_down 5000]
+
+proc callee { } {
+  catch {puts $caller_local} msg
+
+  return $msg
+}
+
+proc caller { } {
+  set caller_local 1
+
+  callee
+}
+
+puts [caller]
+
+proc loop_down { n } {
+  foreach i {1} {
+    if {$n > 0} {
+      set r [loop_down [expr {$n - 1}]]
+    }
+  }
+
+  return $n
+}
+
+puts [loop_down 5000]
+
+# depth first search of chain graph recursing from loop body
+proc visit { node } {
+  global children
+
+  set count 1
+
+  foreach child $children($node) {
+    incr count [visit $child]
+  }
+
+  return $count
+}
+
+for {set i 0} {$i < 5000} {incr i} {
+  set children($i) [expr {$i + 1}]
+}
+
+set children(5000) {}
+
+puts [visit 0]
+
+proc expr_down { n } {
+  if {$n == 0} {
+    return 0
+  }
+
+  return [expr {1 + [expr_down [expr {$n - 1}]]}]
+}
+
+puts [expr_down 5000]
+
+# break in command operand of expression ends enclosing loop
+proc expr_break { } {
+  foreach i {1 2 3} {
+    puts [expr {[if {$i == 2} break; set i] * 2}]
+  }
+}
+
+expr_break
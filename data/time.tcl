@@ -0,0 +1,28 @@
+set n 0
+
+set t [time {incr n} 100]
+
+puts $n
+puts [lindex $t 1]
+
+set n 0
+
+set r [timerate {incr n} 1000 50]
+
+puts $n
+puts [lindex $r 0]
+puts [lindex $r 1]
+puts [llength $r]
+
+set min [lindex $r 5]
+set p50 [lindex $r 9]
+set max [lindex $r 7]
+
+puts [expr {$min <= $p50 && $p50 <= $max}]
+
+puts [catch {time {error "time failed"}} msg]
+puts $msg
+
+set t [time {after 20; break} 1000]
+
+puts [expr {[lindex $t 0] >= 10000}]
@@ -0,0 +1,80 @@
+proc on_write { name index op } {
+  puts "$op $name"
+}
+
+proc on_read { name index op } {
+  puts "$op $name"
+}
+
+set a 1
+
+trace add variable a write on_write
+
+set a 2
+set a 3
+
+trace add variable a read on_read
+
+puts $a
+
+puts [trace info variable a]
+
+trace remove variable a read on_read
+trace remove variable a write on_write
+
+set a 4
+
+puts $a
+
+trace add variable b unset on_write
+
+set b 1
+
+unset b
+
+proc square { x } {
+  return [expr $x * $x]
+}
+
+proc on_exec { args } {
+  puts "exec: $args"
+}
+
+trace add execution square {enter leave} on_exec
+
+puts [square 3]
+
+trace remove execution square {enter leave} on_exec
+
+puts [square 4]
+
+proc fail { } {
+  error "failed"
+}
+
+trace add execution fail leave on_exec
+
+puts [catch {fail} msg]
+puts $msg
+
+trace remove execution fail leave on_exec
+
+proc once { args } {
+  puts "once"
+
+  trace remove variable c write once
+}
+
+proc always { args } {
+  puts "always"
+}
+
+set c 0
+
+trace add variable c write once
+trace add variable c write always
+
+set c 1
+set c 2
+
+trace remove variable c write always
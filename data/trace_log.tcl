@@ -0,0 +1,71 @@
+proc add { a b } {
+  return [expr {$a + $b}]
+}
+
+profile trace start -argsize 8
+
+set x [add 1 2]
+
+puts "x is \"$x\""
+
+profile trace stop
+
+puts [profile trace count]
+
+profile trace write /tmp/ctcl_trace.json
+
+puts [file exists /tmp/ctcl_trace.json]
+
+profile trace clear
+
+puts [profile trace count]
+
+profile trace start -maxevents 2
+
+add 3 4
+
+profile trace stop
+
+puts [profile trace count]
+
+profile trace clear
+
+profile trace start -argsize 8
+
+set s abcdeé
+
+profile trace stop
+
+profile trace write /tmp/ctcl_trace.json
+
+set fd [open /tmp/ctcl_trace.json r]
+set data [read $fd]
+close $fd
+
+puts [string match {*"args":"s abcde..."*} $data]
+
+proc count { l } {
+  return [llength $l]
+}
+
+set big [list a {b c} d]
+
+for {set i 0} {$i < 1000} {incr i} {
+  lappend big $i
+}
+
+profile trace clear
+
+profile trace start -argsize 12
+
+count $big
+
+profile trace stop
+
+profile trace write /tmp/ctcl_trace.json
+
+set fd [open /tmp/ctcl_trace.json r]
+set data [read $fd]
+close $fd
+
+puts [string match {*"args":"a {b c} d 0 ..."*} $data]
@@ -0,0 +1,25 @@
+proc incr_caller { varName } {
+  uplevel 1 "incr $varName"
+}
+
+proc set_global { } {
+  uplevel #0 { set g 42 }
+}
+
+set i 1
+
+incr_caller i
+
+puts $i
+
+set_global
+
+puts $g
+
+proc level_test { } {
+  puts [info level]
+
+  uplevel { puts [info level] }
+}
+
+level_test
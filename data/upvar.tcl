@@ -0,0 +1,64 @@
+proc add_item { listName item } {
+  upvar $listName l
+
+  lappend l $item
+}
+
+proc set_value { varName value } {
+  upvar 1 $varName v
+
+  set v $value
+}
+
+set items {a b}
+
+add_item items c
+add_item items d
+
+puts $items
+
+set_value x 10
+
+puts $x
+
+proc outer { } {
+  set y 1
+
+  inner
+
+  puts $y
+}
+
+proc inner { } {
+  upvar #0 x gx
+  upvar y ly
+
+  set ly [expr $gx + 1]
+}
+
+outer
+
+proc get_elem { } {
+  upvar 1 arr(key) v
+
+  return $v
+}
+
+proc incr_elem { } {
+  upvar arr(count) c
+
+  incr c
+}
+
+set arr(key) 1
+
+set_value arr(key) 5
+set_value arr(other) 6
+
+puts "$arr(key) $arr(other) [get_elem]"
+
+set arr(count) 1
+
+incr_elem
+
+puts $arr(count)
@@ -0,0 +1,27 @@
+set a {1 2 3 4 5}
+set b {10 20 30 40 50}
+puts [vexpr + $a $b]
+puts [vexpr * $a 2]
+puts [vexpr / $a 2]
+puts [vexpr < $a 3]
+puts [vexpr - $a]
+puts [vexpr sum $a]
+puts [vexpr mean $a]
+puts [vexpr min {3 -1 7}]
+puts [vexpr max {3 -1 7 9 2 8}]
+puts [vexpr dot $a $b]
+puts [vexpr scan + $a]
+puts [vexpr scan max {1 3 2 5 4}]
+puts [vexpr max $a 3]
+puts [vexpr sqrt {4 9 2}]
+catch {vexpr + {1 2} {1 2 3}} m; puts $m
+catch {vexpr + {1 x} 1} m; puts $m
+catch {vexpr foo $a} m; puts $m
+catch {vexpr min {}} m; puts $m
+puts [vexpr sum {}]
+puts [vexpr + {9007199254740993 1} 2]
+puts [vexpr sum {9007199254740993 1}]
+puts [vexpr * $a 2.5]
+puts [vexpr % {7 -7 7} {3 3 -3}]
+catch {vexpr + {9223372036854775807} 1} m; puts $m
+catch {vexpr % $a 0} m; puts $m
@@ -2,19 +2,28 @@
 #define CTCL_H
 
 #include <CRefPtr.h>
-#include <CBool.h>
 
 #include <map>
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <string>
 #include <iostream>
+#include <csignal>
 #include <sys/types.h>
+#include <sys/time.h>
 
 class CTcl;
 class CStrParse;
 class CTclValue;
 class CTclTimer;
+class CTclScope;
+class CTclParse;
+class CTclExprCache;
+class CTclEval;
+class CEvalRandom;
+class CEvalValue;
+struct CEvalProgram;
 class CHistory;
 
 using CTclValueRef = CRefPtr<CTclValue>;
@@ -30,12 +39,14 @@ class CTclValue {
   };
 
  public:
-  CTclValue(ValueType type) :
-   type_(type) {
-  }
+  CTclValue(ValueType type);
 
   virtual ~CTclValue() { }
 
+  // values are allocated from size class pools (see CTclValuePool)
+  static void *operator new(size_t size);
+  static void operator delete(void *p, size_t size);
+
   ValueType getType() const { return type_; }
 
   virtual CTclValue *dup() const = 0;
@@ -67,6 +78,9 @@ class CTclValue {
 
   virtual void addValue(CTclValueRef) { assert(false); }
 
+  // approximate bytes used by value (including contained values)
+  virtual ulong memUsage() const = 0;
+
   bool checkInt (CTcl *tcl, long   &i);
   bool checkReal(CTcl *tcl, double &r);
 
@@ -84,6 +98,7 @@ class CTclValue {
 
  protected:
   ValueType type_ { ValueType::NONE };
+  uint      site_ { 0 }; // allocation site (0 if not tracked)
 };
 
 //---
@@ -92,13 +107,273 @@ bool operator<(CTclValueRef lhs, CTclValueRef rhs);
 
 //---
 
+// memory accounting : live count and (approximate) bytes of value objects by
+// value type. Bytes are object size plus owned storage (not contained values).
+// When site tracking is on values are also tagged with the current allocation
+// site (proc and source line) and counted per site.
+//
+// Counters are process wide (values do not know their interpreter) so with
+// several interpreters they are the totals of all of them
+class CTclProcessMemory {
+ public:
+  struct Stats {
+    long  count     { 0 };
+    long  bytes     { 0 };
+    long  peakCount { 0 };
+    long  peakBytes { 0 };
+    ulong allocs    { 0 };
+  };
+
+  struct SiteStats {
+    std::string name;
+    long        count  { 0 };
+    long        bytes  { 0 };
+    ulong       allocs { 0 };
+  };
+
+  using SiteMap  = std::map<uint,SiteStats>;
+  using Snapshot = std::map<std::string,SiteStats>;
+
+  static const uint NUM_TYPES = uint(CTclValue::ValueType::VALUE_MAP) + 1;
+
+ public:
+  static void alloc(CTclValue::ValueType type, uint site, long bytes) {
+    auto &stats = stats_[uint(type)];
+
+    ++stats.count;
+    ++stats.allocs;
+
+    stats.peakCount = std::max(stats.peakCount, stats.count);
+
+    addBytes(stats, bytes);
+
+    if (site)
+      addSite(site, 1, bytes);
+  }
+
+  static void free(CTclValue::ValueType type, uint site, long bytes) {
+    auto &stats = stats_[uint(type)];
+
+    --stats.count;
+
+    addBytes(stats, -bytes);
+
+    if (site)
+      addSite(site, -1, -bytes);
+  }
+
+  static void resize(CTclValue::ValueType type, uint site, long oldBytes, long newBytes) {
+    if (oldBytes == newBytes)
+      return;
+
+    addBytes(stats_[uint(type)], newBytes - oldBytes);
+
+    if (site)
+      addSite(site, 0, newBytes - oldBytes);
+  }
+
+  //---
+
+  // site of new values (0 for none)
+  static uint getCurrentSite() { return currentSite_; }
+  static void setCurrentSite(uint site) { currentSite_ = site; }
+
+  static uint getSiteId(const std::string &name);
+
+  static const SiteMap &getSites() { return sites_; }
+
+  // forget sites (values already tagged are no longer counted)
+  static void clearSites();
+
+  static void getSnapshot(Snapshot &snapshot);
+
+  static void saveSnapshot(const std::string &name);
+  static bool getSavedSnapshot(const std::string &name, Snapshot &snapshot);
+
+  //---
+
+  static const Stats &getStats(CTclValue::ValueType type) { return stats_[uint(type)]; }
+
+  static long getTotalBytes() { return totalBytes_; }
+  static long getPeakBytes () { return peakBytes_; }
+
+  static void resetPeak();
+
+  static long getNumScopes() { return numScopes_; }
+
+  static void addScope   () { ++numScopes_; }
+  static void removeScope() { --numScopes_; }
+
+ private:
+  static void addSite(uint site, long count, long bytes);
+
+  static void addBytes(Stats &stats, long bytes) {
+    stats.bytes += bytes;
+    totalBytes_ += bytes;
+
+    if (bytes > 0) {
+      stats.peakBytes = std::max(stats.peakBytes, stats.bytes);
+      peakBytes_      = std::max(peakBytes_, totalBytes_);
+    }
+  }
+
+ private:
+  static Stats stats_[NUM_TYPES];
+  static long  totalBytes_;
+  static long  peakBytes_;
+  static long  numScopes_;
+
+  using SiteIds   = std::map<std::string,uint>;
+  using Snapshots = std::map<std::string,Snapshot>;
+
+  static uint      currentSite_;
+  static uint      lastSiteId_;
+  static SiteIds   siteIds_;
+  static SiteMap   sites_;
+  static Snapshots snapshots_;
+};
+
+//---
+
+// pool allocator for value objects : blocks are rounded up to a size class
+// and freed blocks are kept on a per class free list for reuse, so the many
+// short lived temporary values (command results, substitutions, expression
+// values) do not go through malloc. Blocks are carved from chunks which are
+// kept for the life of the process. Interpreter is single threaded so lists
+// are not locked.
+class CTclValuePool {
+ public:
+  static const size_t GRANULE     = 16;
+  static const uint   NUM_CLASSES = 16;  // blocks up to 256 bytes
+  static const uint   CHUNK_SIZE  = 64;  // blocks per chunk
+
+  struct Stats {
+    ulong allocs { 0 }; // pool allocations
+    ulong reused { 0 }; // allocations satisfied from free list
+    ulong large  { 0 }; // allocations too large for pool
+    ulong chunks { 0 }; // chunks allocated
+    ulong bytes  { 0 }; // bytes in chunks
+  };
+
+ public:
+  static void *alloc(size_t size) {
+    uint c = sizeClass(size);
+
+    if (c >= NUM_CLASSES) {
+      ++stats_.large;
+
+      return ::operator new(size);
+    }
+
+    ++stats_.allocs;
+
+    Block *block = freeList_[c];
+
+    if (! block)
+      return allocChunk(c);
+
+    ++stats_.reused;
+
+    freeList_[c] = block->next;
+
+    --numFree_[c];
+
+    return block;
+  }
+
+  static void free(void *p, size_t size) {
+    uint c = sizeClass(size);
+
+    if (c >= NUM_CLASSES) {
+      ::operator delete(p);
+      return;
+    }
+
+    Block *block = static_cast<Block *>(p);
+
+    block->next  = freeList_[c];
+    freeList_[c] = block;
+
+    ++numFree_[c];
+  }
+
+  static const Stats &getStats() { return stats_; }
+
+  static size_t classSize(uint c) { return (c + 1)*GRANULE; }
+
+  // number of blocks on free list of size class
+  static ulong numFree(uint c) { return numFree_[c]; }
+
+ private:
+  struct Block {
+    Block *next;
+  };
+
+  static uint sizeClass(size_t size) { return uint((size + GRANULE - 1)/GRANULE) - 1; }
+
+  static void *allocChunk(uint c);
+
+ private:
+  static Block *freeList_[NUM_CLASSES];
+  static ulong  numFree_ [NUM_CLASSES];
+  static Stats  stats_;
+};
+
+//---
+
+// number <-> string conversion for values. Uses std::from_chars/std::to_chars
+// (locale independent, no allocation) with a fast path for short decimal
+// integers. Reals are formatted as the shortest string which reads back as
+// the same value (with a decimal point or exponent so it stays real).
+//
+// Integers may have leading/trailing space, a sign and a 0x (hex), 0o (octal)
+// or 0b (binary) prefix. Leading zeros are decimal.
+class CTclNumber {
+ public:
+  static const long SMALL_INT_MAX = 1024; // cached strings for [0, SMALL_INT_MAX)
+
+ public:
+  static bool toInteger(const std::string &str, long &i);
+  static bool toReal   (const std::string &str, double &r);
+
+  static std::string toString(long   i);
+  static std::string toString(ulong  i);
+  static std::string toString(double r);
+};
+
+//---
+
+inline
+CTclValue::
+CTclValue(ValueType type) :
+ type_(type), site_(CTclProcessMemory::getCurrentSite())
+{
+}
+
+inline void *
+CTclValue::
+operator new(size_t size)
+{
+  return CTclValuePool::alloc(size);
+}
+
+inline void
+CTclValue::
+operator delete(void *p, size_t size)
+{
+  CTclValuePool::free(p, size);
+}
+
+//---
+
 class CTclString : public CTclValue {
  public:
   CTclString(const std::string &str="") :
    CTclValue(ValueType::STRING), str_(str) {
+    CTclProcessMemory::alloc(type_, site_, allocBytes());
   }
 
- ~CTclString() { }
+ ~CTclString() { CTclProcessMemory::free(type_, site_, allocBytes()); }
 
   CTclString *dup() const override { return new CTclString(str_); }
 
@@ -117,18 +392,57 @@ class CTclString : public CTclValue {
   bool toInt (long   &i) const override;
   bool toReal(double &r) const override;
 
+  // get (cached) integer or real value of string. Integers too large for
+  // 64 bits are returned as (approximate) reals
+  bool getNumber(long &i, double &r, bool &isReal) const;
+
+  // is decimal integer too large for 64 bits
+  bool isBigInteger() const;
+
   bool toBool() const override;
 
   CTclValueRef toList(CTcl *tcl) const override;
 
   const std::string &getValue() const { return str_; }
 
-  void setValue(const std::string &str) { str_ = str; }
+  void setValue(const std::string &str) {
+    long bytes = allocBytes();
+
+    str_ = str;
+
+    numType_ = NumType::UNKNOWN;
+
+    CTclProcessMemory::resize(type_, site_, bytes, allocBytes());
+  }
+
+  void appendValue(const std::string &str) {
+    long bytes = allocBytes();
+
+    str_ += str;
+
+    numType_ = NumType::UNKNOWN;
+
+    CTclProcessMemory::resize(type_, site_, bytes, allocBytes());
+  }
 
-  void appendValue(const std::string &str) { str_ += str; }
+  ulong memUsage() const override { return allocBytes(); }
 
  private:
-  std::string str_;
+  long allocBytes() const { return long(sizeof(*this) + str_.capacity()); }
+
+ private:
+  enum class NumType {
+    UNKNOWN,
+    NONE,
+    INTEGER,
+    BIGINT,
+    REAL
+  };
+
+  std::string     str_;
+  mutable NumType numType_ { NumType::UNKNOWN };
+  mutable long    integer_ { 0 };
+  mutable double  real_    { 0.0 };
 };
 
 //---
@@ -140,13 +454,22 @@ class CTclArray : public CTclValue {
  public:
   CTclArray() :
    CTclValue(ValueType::ARRAY) {
+    bytes_ = sizeof(*this);
+
+    CTclProcessMemory::alloc(type_, site_, bytes_);
   }
 
   CTclArray(const ValueMap &values) :
    CTclValue(ValueType::ARRAY), values_(values) {
+    bytes_ = sizeof(*this);
+
+    for (const auto &pv : values_)
+      bytes_ += nodeBytes(pv.first);
+
+    CTclProcessMemory::alloc(type_, site_, bytes_);
   }
 
- ~CTclArray() { }
+ ~CTclArray() { CTclProcessMemory::free(type_, site_, bytes_); }
 
   CTclArray *dup() const override { return new CTclArray(values_); }
 
@@ -209,11 +532,58 @@ class CTclArray : public CTclValue {
   }
 
   void setValue(const std::string &indexStr, CTclValueRef value) {
-    values_[indexStr] = value->dup();
+    auto p = values_.find(indexStr);
+
+    if (p == values_.end()) {
+      long bytes = nodeBytes(indexStr);
+
+      bytes_ += bytes;
+
+      CTclProcessMemory::resize(type_, site_, 0, bytes);
+
+      values_[indexStr] = value->dup();
+    }
+    else
+      (*p).second = value->dup();
+  }
+
+  bool removeValue(const std::string &indexStr) {
+    auto p = values_.find(indexStr);
+
+    if (p == values_.end())
+      return false;
+
+    values_.erase(p);
+
+    long bytes = nodeBytes(indexStr);
+
+    bytes_ -= bytes;
+
+    CTclProcessMemory::resize(type_, site_, bytes, 0);
+
+    return true;
+  }
+
+  uint getNumValues() const { return uint(values_.size()); }
+
+  ulong memUsage() const override {
+    ulong bytes = bytes_;
+
+    for (const auto &pv : values_)
+      bytes += pv.second->memUsage();
+
+    return bytes;
+  }
+
+ private:
+  // map node : key, value ref and tree links
+  static long nodeBytes(const std::string &key) {
+    return long(sizeof(ValueMap::value_type) + 4*sizeof(void *) + key.capacity());
   }
 
  private:
   ValueMap values_;
+  long     bytes_ { 0 };
 };
 
 //---
@@ -225,9 +595,10 @@ class CTclList : public CTclValue {
  public:
   CTclList(const ValueList &values=ValueList()) :
    CTclValue(ValueType::LIST), values_(values) {
+    CTclProcessMemory::alloc(type_, site_, allocBytes());
   }
 
- ~CTclList() { }
+ ~CTclList() { CTclProcessMemory::free(type_, site_, allocBytes()); }
 
   CTclList *dup() const override { return new CTclList(values_); }
 
@@ -258,6 +629,8 @@ class CTclList : public CTclValue {
 
   uint getLength() const override { return uint(values_.size()); }
 
+  const ValueList &getValues() const { return values_; }
+
   CTclValueRef getIndexValue(uint i) const override {
     assert(i < values_.size());
 
@@ -269,11 +642,29 @@ class CTclList : public CTclValue {
   }
 
   void addValue(CTclValueRef value) override {
+    long bytes = allocBytes();
+
     values_.push_back(CTclValueRef(value->dup()));
+
+    CTclProcessMemory::resize(type_, site_, bytes, allocBytes());
   }
 
   void print(std::ostream &os) const override;
 
+  ulong memUsage() const override {
+    ulong bytes = allocBytes();
+
+    for (const auto &value : values_)
+      bytes += value->memUsage();
+
+    return bytes;
+  }
+
+ private:
+  long allocBytes() const {
+    return long(sizeof(*this) + values_.capacity()*sizeof(CTclValueRef));
+  }
+
  private:
   ValueList values_;
 };
@@ -300,6 +691,52 @@ class CTclCommand {
 
   virtual CTclValueRef exec(const std::vector<CTclValueRef> &args) = 0;
 
+  // commands which end by running a script in the caller's frame (if, eval) can
+  // return it so the evaluation trampoline runs it without nesting.
+  // returns false if there is no script to run (or on error)
+  virtual bool hasScript() const { return false; }
+
+  virtual bool getScript(const std::vector<CTclValueRef> &, CTclValueRef &) { return false; }
+
+  // how script is run : INLINE passes completion code to caller, CATCH makes
+  // completion code the command result (see scriptResult) and UPLEVEL runs in
+  // the level started by getScript (ended when script completes)
+  enum class ScriptType { INLINE, CATCH, UPLEVEL };
+
+  virtual ScriptType scriptType() const { return ScriptType::INLINE; }
+
+  // command result from script completion code and value (CATCH)
+  virtual CTclValueRef scriptResult(const std::vector<CTclValueRef> &, int, CTclValueRef value) {
+    return value;
+  }
+
+  // loop commands (for, foreach, while) can run their body in a loop frame of
+  // the evaluation trampoline so recursion from a loop body does not nest.
+  // loopStart checks args and does loop initialization, loopNext does per
+  // iteration code (next script, test, loop variables) and returns body to run
+  // (false when loop done or on error)
+  struct LoopState {
+    std::vector<CTclValueRef> values;     // converted args (foreach lists)
+    uint                      iter { 0 }; // number of started iterations
+  };
+
+  virtual bool hasLoop() const { return false; }
+
+  virtual bool loopStart(const std::vector<CTclValueRef> &, LoopState &) { return false; }
+
+  virtual bool loopNext(const std::vector<CTclValueRef> &, LoopState &, CTclValueRef &) {
+    return false;
+  }
+
+  // run loop (when not run by trampoline)
+  CTclValueRef execLoop(const std::vector<CTclValueRef> &args);
+
+  // expression commands (expr) can return their expression so the evaluation
+  // trampoline runs its command operands without nesting
+  virtual bool hasExpr() const { return false; }
+
+  virtual std::string getExpr(const std::vector<CTclValueRef> &) const { return ""; }
+
  protected:
   CTcl*       tcl_ { nullptr };
   std::string name_;
@@ -316,19 +753,40 @@ class CTclProc {
    tcl_(tcl), name_(name), args_(args), body_(body) {
   }
 
+ ~CTclProc();
+
   const std::string &getName() const { return name_; }
 
   void getArgs(ArgList &args) const { args = args_; }
 
   CTclValueRef getBody() const { return body_; }
 
+  // source file and line of definition
+  const std::string &getFileName() const { return fileName_; }
+  uint getLineNum() const { return lineNum_; }
+
+  void setLocation(const std::string &fileName, uint lineNum) {
+    fileName_ = fileName; lineNum_ = lineNum;
+  }
+
+  // namespace (or global) scope of definition (parent of call scope). If ref
+  // is set the proc keeps the scope referenced (proc defined in call scope)
+  CTclScope *getScope() const { return scope_; }
+  void setScope(CTclScope *scope, bool ref);
+
   CTclValueRef exec(const std::vector<CTclValueRef> &args);
 
+  CTclScope *bindArgs(const std::vector<CTclValueRef> &args);
+
  private:
   CTcl*        tcl_ { nullptr };
   std::string  name_;
   ArgList      args_;
   CTclValueRef body_;
+  CTclScope*   scope_ { nullptr };
+  bool         scopeRef_ { false };
+  std::string  fileName_;
+  uint         lineNum_ { 0 };
 };
 
 //---
@@ -373,6 +831,15 @@ class CTclCatchCommand : public CTclCommand {
   CTclCatchCommand(CTcl *tcl) : CTclCommand(tcl, "catch") { }
 
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+
+  bool hasScript() const override { return true; }
+
+  bool getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script) override;
+
+  ScriptType scriptType() const override { return ScriptType::CATCH; }
+
+  CTclValueRef scriptResult(const std::vector<CTclValueRef> &args, int code,
+                            CTclValueRef value) override;
 };
 
 class CTclCDCommand : public CTclCommand {
@@ -417,11 +884,22 @@ class CTclEofCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclErrorCommand : public CTclCommand {
+ public:
+  CTclErrorCommand(CTcl *tcl) : CTclCommand(tcl, "error") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclEvalCommand : public CTclCommand {
  public:
   CTclEvalCommand(CTcl *tcl) : CTclCommand(tcl, "eval") { }
 
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+
+  bool hasScript() const override { return true; }
+
+  bool getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script) override;
 };
 
 class CTclExecCommand : public CTclCommand {
@@ -443,6 +921,10 @@ class CTclExprCommand : public CTclCommand {
   CTclExprCommand(CTcl *tcl) : CTclCommand(tcl, "expr") { }
 
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+
+  bool hasExpr() const override { return true; }
+
+  std::string getExpr(const std::vector<CTclValueRef> &args) const override;
 };
 
 class CTclFileCommand : public CTclCommand {
@@ -465,7 +947,14 @@ class CTclForCommand : public CTclCommand {
 
   uint getType() const { return uint(CommandType::ITERATION); }
 
-  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override { return execLoop(args); }
+
+  bool hasLoop() const override { return true; }
+
+  bool loopStart(const std::vector<CTclValueRef> &args, LoopState &state) override;
+
+  bool loopNext(const std::vector<CTclValueRef> &args, LoopState &state,
+                CTclValueRef &body) override;
 };
 
 class CTclForeachCommand : public CTclCommand {
@@ -474,7 +963,14 @@ class CTclForeachCommand : public CTclCommand {
 
   uint getType() const { return uint(CommandType::ITERATION); }
 
-  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override { return execLoop(args); }
+
+  bool hasLoop() const override { return true; }
+
+  bool loopStart(const std::vector<CTclValueRef> &args, LoopState &state) override;
+
+  bool loopNext(const std::vector<CTclValueRef> &args, LoopState &state,
+                CTclValueRef &body) override;
 };
 
 class CTclFormatCommand : public CTclCommand {
@@ -517,6 +1013,10 @@ class CTclIfCommand : public CTclCommand {
   CTclIfCommand(CTcl *tcl) : CTclCommand(tcl, "if") { }
 
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+
+  bool hasScript() const override { return true; }
+
+  bool getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script) override;
 };
 
 class CTclIncrCommand : public CTclCommand {
@@ -617,6 +1117,13 @@ class CTclLSortCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclMemoryCommand : public CTclCommand {
+ public:
+  CTclMemoryCommand(CTcl *tcl) : CTclCommand(tcl, "memory") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclNamespaceCommand : public CTclCommand {
  public:
   CTclNamespaceCommand(CTcl *tcl) : CTclCommand(tcl, "namespace") { }
@@ -638,6 +1145,13 @@ class CTclPackageCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclProfileCommand : public CTclCommand {
+ public:
+  CTclProfileCommand(CTcl *tcl) : CTclCommand(tcl, "profile") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclProcCommand : public CTclCommand {
  public:
   CTclProcCommand(CTcl *tcl) : CTclCommand(tcl, "proc") { }
@@ -666,6 +1180,13 @@ class CTclPwdCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclRandListCommand : public CTclCommand {
+ public:
+  CTclRandListCommand(CTcl *tcl) : CTclCommand(tcl, "randlist") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclReadCommand : public CTclCommand {
  public:
   CTclReadCommand(CTcl *tcl) : CTclCommand(tcl, "read") { }
@@ -715,6 +1236,34 @@ class CTclUpdateCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclTailcallCommand : public CTclCommand {
+ public:
+  CTclTailcallCommand(CTcl *tcl) : CTclCommand(tcl, "tailcall") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
+class CTclTimeCommand : public CTclCommand {
+ public:
+  CTclTimeCommand(CTcl *tcl) : CTclCommand(tcl, "time") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
+class CTclTimerateCommand : public CTclCommand {
+ public:
+  CTclTimerateCommand(CTcl *tcl) : CTclCommand(tcl, "timerate") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
+class CTclTraceCommand : public CTclCommand {
+ public:
+  CTclTraceCommand(CTcl *tcl) : CTclCommand(tcl, "trace") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclUnsetCommand : public CTclCommand {
  public:
   CTclUnsetCommand(CTcl *tcl) : CTclCommand(tcl, "unset") { }
@@ -722,6 +1271,26 @@ class CTclUnsetCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclUplevelCommand : public CTclCommand {
+ public:
+  CTclUplevelCommand(CTcl *tcl) : CTclCommand(tcl, "uplevel") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+
+  bool hasScript() const override { return true; }
+
+  bool getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script) override;
+
+  ScriptType scriptType() const override { return ScriptType::UPLEVEL; }
+};
+
+class CTclUpvarCommand : public CTclCommand {
+ public:
+  CTclUpvarCommand(CTcl *tcl) : CTclCommand(tcl, "upvar") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclVariableCommand : public CTclCommand {
  public:
   CTclVariableCommand(CTcl *tcl) : CTclCommand(tcl, "variable") { }
@@ -729,13 +1298,27 @@ class CTclVariableCommand : public CTclCommand {
   CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
 };
 
+class CTclVExprCommand : public CTclCommand {
+ public:
+  CTclVExprCommand(CTcl *tcl) : CTclCommand(tcl, "vexpr") { }
+
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+};
+
 class CTclWhileCommand : public CTclCommand {
  public:
   CTclWhileCommand(CTcl *tcl) : CTclCommand(tcl, "while") { }
 
   uint getType() const { return uint(CommandType::ITERATION); }
 
-  CTclValueRef exec(const std::vector<CTclValueRef> &args) override;
+  CTclValueRef exec(const std::vector<CTclValueRef> &args) override { return execLoop(args); }
+
+  bool hasLoop() const override { return true; }
+
+  bool loopStart(const std::vector<CTclValueRef> &args, LoopState &state) override;
+
+  bool loopNext(const std::vector<CTclValueRef> &args, LoopState &state,
+                CTclValueRef &body) override;
 };
 
 //---
@@ -743,17 +1326,40 @@ class CTclWhileCommand : public CTclCommand {
 class CTclVariable;
 
 class CTclVariableProc {
+ public:
+  enum class TraceOp {
+    NONE  = 0,
+    READ  = (1<<0),
+    WRITE = (1<<1),
+    UNSET = (1<<2)
+  };
+
  public:
   CTclVariableProc() { }
 
   virtual ~CTclVariableProc() { }
 
+  uint getId() const { return id_; }
   void setId(uint id) { id_ = id; }
 
+  // mask of TraceOp values to be notified of (default write)
+  uint getOps() const { return ops_; }
+  void setOps(uint ops) { ops_ = ops; }
+
+  // removed while variable's traces are running (deleted after they finish)
+  bool isRemoved() const { return removed_; }
+  void setRemoved(bool b) { removed_ = b; }
+
   virtual void notify(CTclVariable *var) = 0;
 
+  virtual void notify(CTclVariable *var, TraceOp op, const std::string & /*index*/) {
+    if (op == TraceOp::WRITE) notify(var);
+  }
+
  protected:
-  uint id_ { 0 };
+  uint id_      { 0 };
+  uint ops_     { uint(TraceOp::WRITE) };
+  bool removed_ { false };
 };
 
 //---
@@ -772,38 +1378,98 @@ class CTclVariable {
 
   virtual CTclValueRef getValue() const;
 
+  // value without firing read traces
+  CTclValueRef peekValue() const { return value_; }
+
   virtual void setValue(CTclValueRef value);
 
   virtual CTclValueRef getArrayValue(const std::string &indexStr) const;
 
   virtual void setArrayValue(const std::string &indexStr, CTclValueRef value);
 
+  virtual void removeArrayValue(const std::string &indexStr);
+
   virtual void appendValue(CTclValueRef value);
 
   uint addNotifyProc(CTclVariableProc *proc);
 
+  bool removeNotifyProc(uint id);
+
+  void getNotifyProcs(std::vector<CTclVariableProc *> &procs) const;
+
+  // single check of combined ops mask so untraced variables pay no cost
+  bool isTraced(CTclVariableProc::TraceOp op) const { return (traceOps_ & uint(op)); }
+
+  void callNotifyProcs(CTclVariableProc::TraceOp op, const std::string &index="") const;
+
  private:
-  void callNotifyProcs();
+  void updateTraceOps();
+
+  void removePendingNotifyProcs();
 
  private:
-  using VariableProcList = std::list<CTclVariableProc *>;
+  using VariableProcList = std::vector<CTclVariableProc *>;
 
   static uint notifyProcId_;
 
   CTclValueRef     value_;
   VariableProcList notifyProcs_;
+  uint             traceOps_ { 0 };
+  mutable bool     inNotify_ { false };
 };
 
 using CTclVariableRef = CRefPtr<CTclVariable>;
 
 //---
 
+// env array variable : snapshot of process environment built on first access
+// and kept up to date by writes through the interpreter
 class CTclEnvVariable : public CTclVariable {
  public:
   CTclEnvVariable();
 
+  bool hasValue() const override { return true; }
+
+  CTclValueRef getValue() const override;
+
+  void setValue(CTclValueRef value) override;
+
   CTclValueRef getArrayValue(const std::string &indexStr) const override;
 
+  void setArrayValue(const std::string &indexStr, CTclValueRef value) override;
+
+  void removeArrayValue(const std::string &indexStr) override;
+
+  // force reload of snapshot (environment changed outside interpreter)
+  void invalidate() { valid_ = false; }
+
+ private:
+  void updateValues() const;
+
+ private:
+  mutable CTclValueRef values_;
+  mutable bool         valid_ { false };
+};
+
+//---
+
+// link to element of array variable (upvar of name(index)). Reads and writes
+// go through the array variable
+class CTclArrayElementVariable : public CTclVariable {
+ public:
+  CTclArrayElementVariable(CTclVariableRef var, const std::string &indexStr);
+
+  bool hasValue() const override;
+
+  CTclValueRef getValue() const override;
+
+  void setValue(CTclValueRef value) override;
+
+  void appendValue(CTclValueRef value) override;
+
+ private:
+  CTclVariableRef var_;
+  std::string     indexStr_;
 };
 
 //---
@@ -816,6 +1482,9 @@ class CTclScope {
 
   CTclScope *parentScope() const { return parent_; }
 
+  // enclosing namespace (or global) scope (skips proc call scope)
+  CTclScope *namespaceScope();
+
   CTclVariableRef addVariable(const std::string &varName, CTclValueRef value);
   CTclVariableRef addVariable(const std::string &varName, CTclVariableRef var);
 
@@ -845,6 +1514,14 @@ class CTclScope {
 
   CTclScope *getNamedScope(const std::string &name, bool create_it=false);
 
+  bool removeNamedScope(const std::string &name);
+
+  // reference from current or stacked scope, proc call scope (as parent) or
+  // proc. Counts are kept for scope and its parents so a namespace removed
+  // while in use is freed when it and its children are no longer referenced
+  void ref();
+  void unref();
+
  private:
   using VariableList = std::map<std::string,CTclVariableRef>;
   using ProcList     = std::map<std::string,CTclProc *>;
@@ -856,6 +1533,8 @@ class CTclScope {
   VariableList vars_;
   ProcList     procs_;
   ScopeMap     scopeMap_;
+  uint         refCount_ { 0 };
+  bool         deleted_  { false }; // removed from parent (free when unreferenced)
 };
 
 //---
@@ -872,6 +1551,196 @@ class CTclError {
 
 //---
 
+// call profiler : call counts and inclusive (total) and exclusive (self) times
+// of commands and procs
+class CTclProfiler {
+ public:
+  enum class CallType {
+    COMMAND,
+    PROC
+  };
+
+  struct Stats {
+    CallType type   { CallType::COMMAND };
+    ulong    count  { 0 };
+    long     total  { 0 }; // nsecs (outermost call only for recursion)
+    long     self   { 0 }; // nsecs
+    uint     active { 0 };
+  };
+
+  using StatsMap = std::map<std::string,Stats>;
+
+ public:
+  CTclProfiler() { }
+
+  void startCall(const std::string &name, CallType type);
+  void endCall();
+
+  // drop calls in progress (profiling started/stopped mid call)
+  void clearCalls();
+
+  void reset();
+
+  const StatsMap &getStats() const { return stats_; }
+
+  // sort is count, total, self or name. limit of 0 is all entries
+  std::string report(const std::string &sort="self", uint limit=0) const;
+
+ private:
+  struct Call {
+    Stats* stats { nullptr };
+    long   start { 0 };
+    long   child { 0 };
+  };
+
+  using CallStack = std::vector<Call>;
+
+  StatsMap  stats_;
+  CallStack calls_;
+};
+
+//---
+
+// sampling profiler : SIGPROF ticks are recorded (as the current call stack) at
+// the next command boundary into a ring buffer and output as folded stacks for
+// flame graph tools. Samples overwritten in the ring are added to per stack
+// counts so output covers the whole run
+class CTclSampler {
+ public:
+  CTclSampler(uint size=65536);
+ ~CTclSampler();
+
+  bool start(uint hz);
+  void stop();
+
+  bool isRunning() const { return running_; }
+
+  // tick(s) waiting to be recorded
+  static bool isPending() { return pending_ != 0; }
+
+  void sample(const std::string &stack);
+
+  void clear();
+
+  ulong getNumSamples() const { return numSamples_; }
+  ulong getNumEvicted() const { return numEvicted_; }
+
+  std::string folded() const;
+
+  bool writeFolded(const std::string &fileName) const;
+
+ private:
+  static void tickHandler(int);
+
+ private:
+  struct Sample {
+    std::string stack;
+    uint        ticks { 0 };
+  };
+
+  using Samples     = std::vector<Sample>;
+  using StackCounts = std::map<std::string,ulong>;
+
+  static volatile sig_atomic_t pending_;
+
+  struct sigaction oldAction_;            // tick handler before start
+  struct itimerval oldTimer_;             // profile timer before start
+  Samples          samples_;
+  StackCounts      evicted_;              // ticks of samples overwritten in ring
+  uint             pos_        { 0 };
+  ulong            numSamples_ { 0 };
+  ulong            numEvicted_ { 0 };
+  bool             running_    { false };
+};
+
+//---
+
+// trace event log : buffered begin/end events of commands and procs written as
+// Chrome trace event JSON (chrome://tracing, Perfetto)
+class CTclTraceLog {
+ public:
+  CTclTraceLog();
+
+  uint getMaxEvents() const { return maxEvents_; }
+  void setMaxEvents(uint n) { maxEvents_ = n; }
+
+  uint getArgSize() const { return argSize_; }
+  void setArgSize(uint n) { argSize_ = n; }
+
+  void begin(const std::string &name, const char *category,
+             const std::vector<CTclValueRef> &args);
+  void end();
+
+  // drop open calls (tracing started/stopped mid call)
+  void clearCalls() { recorded_.clear(); }
+
+  void clear();
+
+  ulong getNumEvents () const { return events_.size(); }
+  ulong getNumDropped() const { return numDropped_; }
+
+  bool writeJson(const std::string &fileName) const;
+
+ private:
+  struct Event {
+    char        phase    { 'B' };
+    std::string name;
+    const char* category { nullptr };
+    std::string args;
+    long        ts       { 0 }; // nsecs from start
+    uint        depth    { 0 };
+  };
+
+  using Events   = std::vector<Event>;
+  using Recorded = std::vector<bool>;
+
+  Events   events_;
+  Recorded recorded_;
+  uint     maxEvents_  { 1000000 };
+  uint     argSize_    { 64 };
+  ulong    numDropped_ { 0 };
+  long     start_      { 0 };
+};
+
+//---
+
+// line profiler : execution count and (exclusive) time per source line. Time
+// between two line events is given to the first line
+class CTclLineProfiler {
+ public:
+  struct LineStats {
+    ulong count { 0 };
+    long  nsecs { 0 };
+  };
+
+  using LineMap = std::map<uint,LineStats>;
+  using FileMap = std::map<std::string,LineMap>;
+
+ public:
+  CTclLineProfiler() { }
+
+  void line(const std::string &fileName, uint lineNum);
+
+  // give time since last line event to last line
+  void flush();
+
+  void clear();
+
+  const FileMap &getFiles() const { return files_; }
+
+  // source listing annotated with count and time of each line
+  std::string listing(const std::string &fileName) const;
+
+ private:
+  FileMap     files_;
+  std::string lastFile_;
+  LineMap*    lastLines_ { nullptr };
+  LineStats*  lastStats_ { nullptr };
+  long        lastTime_  { 0 };
+};
+
+//---
+
 class CTcl {
  private:
   class SetSeparator {
@@ -892,20 +1761,57 @@ class CTcl {
     char  old_c_ { '\0' };
   };
 
+  // resolved qualified names cached (cache cleared when full)
+  static const uint MAX_QUALIFIED_NAMES = 1000;
+
+  // expression evaluators kept after deep (recursive) expression nesting ends
+  static const uint MAX_EVALS = 32;
+
+  // resolved qualified variable name (ns::name or ::name)
+  struct QualifiedName {
+    bool        local { false };   // not qualified, lookup from current scope
+    CTclScope*  scope { nullptr }; // namespace scope (null if not found)
+    std::string name;              // variable name in scope
+  };
+
+ public:
+  // completion code of script (Tcl result codes)
+  enum class ResultCode {
+    OK       = 0,
+    ERROR    = 1,
+    RETURN   = 2,
+    BREAK    = 3,
+    CONTINUE = 4
+  };
+
+  enum class ExecTraceOp {
+    NONE  = 0,
+    ENTER = (1<<0),
+    LEAVE = (1<<1)
+  };
+
+  struct ExecTrace {
+    uint        ops { 0 };
+    std::string command;
+  };
+
+  using ExecTraceList = std::vector<ExecTrace>;
+
  public:
   CTcl(int argc, char **argv);
  ~CTcl();
 
-  bool getBreakFlag() const { return breakFlag_; }
-  void setBreakFlag(bool flag=true) { breakFlag_ = flag; }
+  // pending completion code of last command (consumed by execScript)
+  ResultCode getResultCode() const { return resultCode_; }
+  void setResultCode(ResultCode code) { resultCode_ = code; }
+
+  bool isError() const { return resultCode_ == ResultCode::ERROR; }
+
+  const std::string &getErrorMsg() const { return errorMsg_; }
 
-  bool getContinueFlag() const { return continueFlag_; }
-  void setContinueFlag(bool flag=true) { continueFlag_ = flag; }
+  void resetError();
 
-  bool getReturnFlag() const { return returnFlag_; }
-  bool getReturnFlag(CTclValueRef &val) const { val = returnVal_; return returnFlag_; }
-  void setReturnFlag(bool flag=false) { returnFlag_ = flag; }
-  void setReturnFlag(CTclValueRef val, bool flag=true) { returnVal_ = val; returnFlag_ = flag; }
+  bool reportError();
 
   bool getDebug() const { return debug_; }
   void setDebug(bool debug=true) { debug_ = debug; }
@@ -915,15 +1821,40 @@ class CTcl {
 
   bool parseFile(const std::string &filename);
 
+  bool sourceFile(const std::string &filename);
+
   bool isCompleteLine(const std::string &line);
 
   CTclValueRef parseLine(const std::string &str);
 
   CTclValueRef parseString(const std::string &str);
 
+  ResultCode execScript(const std::string &str, CTclValueRef &value);
+
+  void checkTopLevelCode();
+
+  ResultCode callProc(CTclProc *proc, const std::vector<CTclValueRef> &args,
+                      CTclValueRef &value);
+
+  void setTailCall(const std::vector<CTclValueRef> &args) { tailCall_ = args; }
+
+  // limits of nested (C++ stack) evaluations : count and bytes of stack used
+  // since outermost evaluation (default from process stack size limit)
+  uint getMaxNestDepth() const { return maxNestDepth_; }
+  void setMaxNestDepth(uint depth) { maxNestDepth_ = depth; }
+
+  ulong getMaxNestStack() const { return maxNestStack_; }
+  void setMaxNestStack(ulong bytes) { maxNestStack_ = bytes; }
+
+  uint getMaxFrameDepth() const { return maxFrameDepth_; }
+  void setMaxFrameDepth(uint depth) { maxFrameDepth_ = depth; }
+
+  CTclValueRef evalScript(const std::string &str);
+
   bool processLine(const std::string &line);
 
-  bool readArgList(std::vector<CTclValueRef> &args);
+  bool readArgList(std::vector<CTclValueRef> &args,
+                   std::vector<CTclValueRef> *substArgs=nullptr);
 
   bool readExecString(std::vector<CTclValueRef> &args);
 
@@ -945,18 +1876,69 @@ class CTcl {
 
   CTclScope *getNamedScope(const std::string &name, bool create_it=false);
 
+  void namespacesChanged();
+
   void pushScope(CTclScope *scope);
   void popScope();
   void unwindScope();
 
-  void         startCommand(CTclCommand *cmd);
+  uint       getLevel() const;
+  bool       parseLevel(const std::string &str, uint &level) const;
+  CTclScope *getLevelScope(uint level) const;
+
+  void startLevel(uint level);
+  void endLevel();
+
+  void         startCommand(CTclCommand *cmd, const std::vector<CTclValueRef> &args);
   void         endCommand();
   CTclCommand *getCommand() const;
 
-  void      startProc(CTclProc *proc);
+  void      startProc(CTclProc *proc, const std::vector<CTclValueRef> &args);
   void      endProc();
   CTclProc *getProc() const;
 
+  ulong getCmdCount() const { return cmdCount_; }
+
+  bool isProfiling() const { return profiling_; }
+
+  void startProfile();
+  void stopProfile();
+
+  CTclProfiler *getProfiler() const { return profiler_; }
+
+  bool isSampling() const { return sampling_; }
+
+  bool startSampling(uint hz=1000);
+  void stopSampling();
+
+  CTclSampler *getSampler() const { return sampler_; }
+
+  bool isTracing() const { return tracing_; }
+
+  void startTraceLog();
+  void stopTraceLog();
+
+  CTclTraceLog *getTraceLog() const { return traceLog_; }
+
+  bool isLineProfiling() const { return lineProfiling_; }
+
+  void startLineProfile();
+  void stopLineProfile();
+
+  CTclLineProfiler *getLineProfiler() const { return lineProfiler_; }
+
+  bool isMemorySites() const { return memorySites_; }
+
+  void startMemorySites();
+  void stopMemorySites();
+
+  // open parse buffers and their bytes
+  void getParseMemory(uint &num, ulong &bytes) const;
+
+  // file and line of current command
+  const std::string &getSourceFile() const;
+  uint getSourceLine();
+
   void addCommand(CTclCommand *command);
 
   CTclCommand *getCommand(const std::string &name);
@@ -1015,8 +1997,17 @@ class CTcl {
 
   CTclValueRef evalString(const std::string &str);
 
+  // interpreter random number generator (used by rand(), srand() and randlist)
+  CEvalRandom &getRandom() const { return *random_; }
+
+  void setRandomSeed(ulong seed);
+
   CTclValueRef evalArgs(const std::vector<CTclValueRef> &args);
 
+  void addExecTrace(const std::string &name, uint ops, const std::string &command);
+  bool removeExecTrace(const std::string &name, uint ops, const std::string &command);
+  void getExecTraces(const std::string &name, ExecTraceList &traces) const;
+
   std::string lookupPathCommand(const std::string &name) const;
 
   void startFileParse(const std::string &fileName);
@@ -1032,34 +2023,136 @@ class CTcl {
 
   static bool needsBraces(const std::string &str);
 
+ private:
+  // frame run by evaluation trampoline
+  struct EvalFrame {
+    enum class Type {
+      SCRIPT,  // script run by execScript (completion code returned to caller)
+      INLINE,  // script of if/eval (completion code passed to enclosing frame)
+      PROC,    // proc body
+      CATCH,   // script of catch (completion code is command result)
+      UPLEVEL, // script of uplevel (as INLINE but run in other level)
+      LOOP,    // body of loop command (run for each iteration)
+      EXPR     // command operand of expr (as INLINE, result resumes expression)
+    };
+
+    using Args = std::vector<CTclValueRef>;
+
+    Type         type  { Type::SCRIPT };
+    CTclProc*    proc  { nullptr };
+    CTclScope*   scope { nullptr };
+    CTclCommand* cmd   { nullptr }; // command of CATCH script or LOOP body
+    Args         args;              // command args of CATCH script or LOOP body
+    CTclCommand::LoopState loop;    // loop state of LOOP body
+    CTclEval*    eval  { nullptr }; // evaluator of EXPR (suspended at operand)
+    CRefPtr<CEvalProgram> program;  // compiled expression of EXPR
+    std::string  expr;              // expression string of EXPR
+    bool         subst { false };   // result substituted into pending command
+    Args         pending;           // args read so far of command being substituted
+  };
+
+  using EvalFrameStack = std::vector<EvalFrame>;
+
  private:
   bool isCompleteLine1(char endChar);
 
+  void takeSample();
+
+  void setCommandStart();
+  uint locLine(uint i);
+  void lineEvent(const std::vector<CTclValueRef> &args);
+
+  void updateMemorySite();
+
+  ResultCode runFrames(EvalFrameStack &frames, CTclValueRef &value);
+
+  bool isExecTraced(const std::string &name) const;
+
+  bool pushProcFrame(EvalFrameStack &frames, CTclProc *proc,
+                     const std::vector<CTclValueRef> &args);
+  EvalFrame popFrame(EvalFrameStack &frames);
+
+  CTclEval *pushEval();
+  void popEval();
+
+  CTclValueRef evalResult(CTclEval &eval, const std::string &str, bool rc,
+                          const CEvalValue &result);
+
+  CTclValueRef evalArgs1(const std::vector<CTclValueRef> &args);
+
+  CTclValueRef evalTracedArgs(const std::vector<CTclValueRef> &args,
+                              const ExecTraceList &traces);
+
+  const QualifiedName &resolveQualifiedName(const std::string &varName);
+
  private:
   using CommandStack = std::vector<CTclCommand *>;
   using ProcStack    = std::vector<CTclProc *>;
+  using EvalStack    = std::vector<CTclEval *>;
   using CommandList  = std::map<std::string,CTclCommand *>;
   using ScopeStack   = std::vector<CTclScope *>;
+  using LevelStack   = std::vector<ScopeStack>;
   using ParseStack   = std::vector<CStrParse *>;
   using FileMap      = std::map<std::string,FILE *>;
   using TimerMap     = std::map<std::string,CTclTimer *>;
+  using QualifiedMap = std::map<std::string,QualifiedName>;
+  using ExecTraceMap = std::map<std::string,ExecTraceList>;
+  using Args         = std::vector<CTclValueRef>;
+
+  // source location of parse. Only the start of the current command is recorded
+  // per command, its line is computed on demand (see getSourceLine)
+  struct ParseLoc {
+    std::string fileName;            // file of file parse or proc body
+    bool        hasFile   { false }; // fileName set (else that of enclosing parse)
+    uint        lineNum   { 0 };     // line at pos (0 if not known yet)
+    int         pos       { 0 };
+    int         cmdPos    { 0 };     // start of current command
+    CStrParse*  parse     { nullptr };
+    CTclParse*  fileParse { nullptr };
+  };
+
+  using LocStack = std::vector<ParseLoc>;
 
   CStrParse*   parse_     { nullptr };
   ParseStack   parseStack_;
+  LocStack     locStack_;
   CommandList  cmds_;
   ScopeStack   scopeStack_;
+  LevelStack   levelStack_;
   CTclScope*   scope_     { nullptr };
   CTclScope*   gscope_    { nullptr };
   CommandStack cmdStack_;
   ProcStack    procStack_;
   CHistory*    history_   { nullptr };
+  CTclExprCache *exprCache_ { nullptr };
+  EvalStack      evals_;                 // reused expression evaluators (per nesting)
+  uint           evalDepth_ { 0 };
+  CEvalRandom*   random_    { nullptr };
   FileMap      fileMap_;
   TimerMap     timerMap_;
+  QualifiedMap qualifiedMap_;
+  ExecTraceMap execTraces_;
+  bool         inExecTrace_ { false };
   char         separator_ { ';' };
-  CBool        breakFlag_;
-  CBool        continueFlag_;
-  CBool        returnFlag_;
-  CTclValueRef returnVal_;
+  ResultCode   resultCode_ { ResultCode::OK };
+  std::string  errorMsg_;
+  Args         tailCall_;
+  ulong        cmdCount_      { 0 };
+  bool         profiling_     { false };
+  CTclProfiler *profiler_     { nullptr };
+  bool         sampling_      { false };
+  CTclSampler* sampler_       { nullptr };
+  bool         tracing_       { false };
+  CTclTraceLog *traceLog_     { nullptr };
+  bool         lineProfiling_ { false };
+  CTclLineProfiler *lineProfiler_ { nullptr };
+  bool         memorySites_   { false };
+  uint         nestDepth_     { 0 };
+  uint         maxNestDepth_  { 100000 };
+  const char*  stackBase_     { nullptr }; // stack address of outermost evaluation
+  ulong        maxNestStack_  { 0 };
+  uint         frameDepth_    { 0 };
+  uint         maxFrameDepth_ { 1000000 };
   bool         debug_     { false };
 };
 
@@ -2,483 +2,1176 @@
 #include <CStrParse.h>
 #include <vector>
 #include <cmath>
+#include <cctype>
+#include <cassert>
+#include <cstdlib>
+#include <climits>
+#include <cstdio>
+#include <unordered_map>
+#include <charconv>
 
 #define DEG_TO_RAD(a) (M_PI*(a)/180.0)
 #define RAD_TO_DEG(a) (180.0*(a)/M_PI)
 
-static CEvalOp power_op_         = { "^" , 6 };
-static CEvalOp times_op_         = { "*" , 5 };
-static CEvalOp divide_op_        = { "/" , 5 };
-static CEvalOp modulus_op_       = { "%" , 5 };
-static CEvalOp plus_op_          = { "+" , 4 };
-static CEvalOp minus_op_         = { "-" , 4 };
-static CEvalOp less_op_          = { "<" , 3 };
-static CEvalOp less_equal_op_    = { "<=", 3 };
-static CEvalOp greater_op_       = { ">" , 3 };
-static CEvalOp greater_equal_op_ = { ">=", 3 };
-static CEvalOp equals_op_        = { "==", 2 };
-static CEvalOp not_equals_op_    = { "!=", 2 };
+static CEvalOp power_op_         = { "^" , 7 };
+static CEvalOp times_op_         = { "*" , 6 };
+static CEvalOp divide_op_        = { "/" , 6 };
+static CEvalOp modulus_op_       = { "%" , 6 };
+static CEvalOp plus_op_          = { "+" , 5 };
+static CEvalOp minus_op_         = { "-" , 5 };
+static CEvalOp less_op_          = { "<" , 4 };
+static CEvalOp less_equal_op_    = { "<=", 4 };
+static CEvalOp greater_op_       = { ">" , 4 };
+static CEvalOp greater_equal_op_ = { ">=", 4 };
+static CEvalOp equals_op_        = { "==", 3 };
+static CEvalOp not_equals_op_    = { "!=", 3 };
+static CEvalOp string_eq_op_     = { "eq", 2 };
+static CEvalOp string_ne_op_     = { "ne", 2 };
 static CEvalOp and_op_           = { "&&", 1 };
 static CEvalOp or_op_            = { "||", 0 };
 
+
 CEval::
 CEval()
 {
 }
 
 CEval::
-CEval(const CEval &eval) :
- forceReal_(eval.forceReal_),
- degrees_  (eval.degrees_),
- debug_    (eval.debug_)
+~CEval()
 {
 }
 
+bool
 CEval::
-~CEval()
+eval(const std::string &str, double *result)
 {
-  reset();
+  CEvalValue rvalue;
+
+  if (! eval(str, rvalue))
+    return false;
+
+  *result = rvalue.toReal();
+
+  return true;
 }
 
-void
+bool
 CEval::
-reset()
+eval(const std::string &str, CEvalValue &result)
 {
-  lastOp_ = nullptr;
+  CEvalProgram program;
+
+  if (! compile(str, program))
+    return false;
 
-  stack_.clear();
+  return run(program, result);
 }
 
+//------
+
+// compile expression by recursive descent. Precedence (lowest first) is
+// ?:, ||, &&, eq ne, == !=, < <= > >=, + -, * / %, ^, unary - + !
 bool
 CEval::
-eval(const std::string &str, double *result)
+compile(const std::string &str, CEvalProgram &program)
 {
-  CEvalValueRef rvalue;
+  program.insts.clear();
 
-  if (! eval(str, rvalue))
+  CStrParse parse(str);
+
+  if (! compileTernary(parse, program))
     return false;
 
-  *result = rvalue->toReal();
+  parse.skipSpace();
+
+  if (! parse.eof())
+    return false;
+
+  assignSlots(program);
 
   return true;
 }
 
+// give each distinct variable a slot so it can be loaded once per run
+void
+CEval::
+assignSlots(CEvalProgram &program)
+{
+  std::vector<const CEvalInst *> vars;
+
+  bool hasCommand = false;
+
+  for (auto &inst : program.insts) {
+    if      (inst.type == CEvalInst::Type::COMMAND ||
+             (inst.type == CEvalInst::Type::FUNCTION && ! inst.func))
+      hasCommand = true;
+    else if (inst.type == CEvalInst::Type::VARIABLE) {
+      uint slot = 0;
+
+      for ( ; slot < vars.size(); ++slot) {
+        const CEvalInst *var = vars[slot];
+
+        if (var->str == inst.str && var->isArray == inst.isArray && var->index == inst.index &&
+            var->asString == inst.asString)
+          break;
+      }
+
+      if (slot == vars.size())
+        vars.push_back(&inst);
+
+      inst.slot = slot;
+    }
+  }
+
+  program.numSlots  = vars.size();
+  program.reuseVars = (! hasCommand && program.numSlots <= CEvalProgram::MAX_SLOTS);
+}
+
+// cond ? expr1 : expr2 (right associative, only one of expr1 and expr2 evaluated)
 bool
 CEval::
-eval(const std::string &str, CEvalValueRef &result)
+compileTernary(CStrParse &parse, CEvalProgram &program)
 {
-  reset();
+  auto &insts = program.insts;
 
-  CStrParse parse(str);
+  if (! compileBinary(parse, program, 0))
+    return false;
+
+  parse.skipSpace();
+
+  if (! parse.isChar('?'))
+    return true;
+
+  parse.skipChar();
+
+  CEvalInst jumpFalse;
+
+  jumpFalse.type = CEvalInst::Type::JUMP_FALSE;
+
+  uint jumpFalsePos = insts.size();
+
+  insts.push_back(jumpFalse);
+
+  if (! compileTernary(parse, program))
+    return false;
+
+  parse.skipSpace();
+
+  if (! parse.isChar(':'))
+    return false;
+
+  parse.skipChar();
+
+  CEvalInst jump;
+
+  jump.type = CEvalInst::Type::JUMP;
+
+  uint jumpPos = insts.size();
+
+  insts.push_back(jump);
+
+  insts[jumpFalsePos].n = insts.size();
 
-  return eval1(parse, result);
+  if (! compileTernary(parse, program))
+    return false;
+
+  insts[jumpPos].n = insts.size();
+
+  return true;
 }
 
+// binary operators of at least specified precedence (left associative).
+// Right hand side of && and || is skipped when left hand side decides result
 bool
 CEval::
-eval1(CStrParse &parse, CEvalValueRef &result)
+compileBinary(CStrParse &parse, CEvalProgram &program, int precedence)
 {
-  while (! parse.eof()) {
+  auto &insts = program.insts;
+
+  uint lhsPos = insts.size();
+
+  if (! compileUnary(parse, program))
+    return false;
+
+  while (true) {
     parse.skipSpace();
 
-    if (parse.eof()) break;
+    CEvalOp *op = peekOp(parse);
 
-    // value
-    if      (parse.isDigit() || parse.isChar('.')) {
-      double real    = 0.0;
-      int    integer = 0;
-      bool   is_real = false;
+    if (! op || op->precedence < precedence)
+      break;
+
+    (void) readOp(parse);
+
+    if (op == &and_op_ || op == &or_op_) {
+      CEvalInst jump;
+
+      jump.type = (op == &and_op_ ? CEvalInst::Type::AND : CEvalInst::Type::OR);
 
-      if (! parse.readNumber(real, integer, is_real))
+      uint jumpPos = insts.size();
+
+      insts.push_back(jump);
+
+      if (! compileBinary(parse, program, op->precedence + 1))
         return false;
 
-      if (! is_real && forceReal_) {
-        real    = integer;
-        is_real = true;
-      }
+      CEvalInst toBool;
 
-      if (is_real)
-        pushValue(CEvalValueRef(new CEvalRealValue(real)));
-      else
-        pushValue(CEvalValueRef(new CEvalIntValue(integer)));
+      toBool.type = CEvalInst::Type::BOOL;
+
+      insts.push_back(toBool);
+
+      insts[jumpPos].n = insts.size();
     }
-    // operator
-    else if (parse.isOneOf("+-*/%<>=!&|^")) {
-      CEvalOp *op = readOp(parse);
+    else {
+      uint rhsPos = insts.size();
 
-      if (! op)
+      if (! compileBinary(parse, program, op->precedence + 1))
         return false;
 
-      if (hasOperator() || ! hasValue()) {
-        if (op == &plus_op_ || op == &minus_op_) {
-          CEvalValueRef result1;
+      // variable or command operands of eq/ne are compared using their string value
+      if (op == &string_eq_op_ || op == &string_ne_op_) {
+        auto setAsString = [&](uint pos1, uint pos2) {
+          if (pos2 == pos1 + 1 && (insts[pos1].type == CEvalInst::Type::VARIABLE ||
+                                   insts[pos1].type == CEvalInst::Type::COMMAND))
+            insts[pos1].asString = true;
+        };
 
-          if (! eval1(parse, result1))
-            return false;
+        setAsString(lhsPos, rhsPos);
+        setAsString(rhsPos, insts.size());
+      }
 
-          if (result1->getType() == CEVAL_VALUE_REAL) {
-            double real = result1->toReal();
+      CEvalInst inst;
 
-            if (op == &minus_op_) real = -real;
+      inst.type = CEvalInst::Type::OPERATOR;
+      inst.op   = op;
 
-            pushValue(CEvalValueRef(new CEvalRealValue(real)));
-          }
-          else if (result1->getType() == CEVAL_VALUE_INTEGER) {
-            int integer = result1->toInt();
+      insts.push_back(inst);
 
-            if (op == &minus_op_) integer = -integer;
+      (void) foldBinary(program, lhsPos);
+    }
+  }
 
-            pushValue(CEvalValueRef(new CEvalIntValue(integer)));
-          }
-          else
-            return false;
-        }
-        else
-          return false;
-      }
-      else {
-        if (checkLastOperator(op)) {
-          if (! evalLastOperator())
-            return false;
-        }
+  return true;
+}
 
-        pushOperator(op);
-      }
+// unary minus, plus and not (apply to next operand)
+bool
+CEval::
+compileUnary(CStrParse &parse, CEvalProgram &program)
+{
+  parse.skipSpace();
+
+  if (parse.isOneOf("-+!")) {
+    char c = '\0';
+
+    parse.readChar(&c);
+
+    uint operandPos = program.insts.size();
+
+    if (! compileUnary(parse, program))
+      return false;
+
+    if (c != '+') {
+      CEvalInst inst;
+
+      inst.type = (c == '-' ? CEvalInst::Type::NEGATE : CEvalInst::Type::NOT);
+
+      program.insts.push_back(inst);
+
+      (void) foldUnary(program, operandPos);
     }
-    // bracketed expression
-    else if (parse.isChar('(')) {
-      int pos1 = parse.getPos();
 
-      if (! parse.skipChar())
+    return true;
+  }
+
+  return compilePrimary(parse, program);
+}
+
+// number, bracketed expression, function call, boolean, variable, command or string
+bool
+CEval::
+compilePrimary(CStrParse &parse, CEvalProgram &program)
+{
+  parse.skipSpace();
+
+  if      (parse.isDigit() || parse.isChar('.')) {
+    CEvalInst inst;
+
+    if (! readNumber(parse, program, inst.value))
+      return false;
+
+    if (forceReal_ && inst.value.isInteger())
+      inst.value = CEvalValue(inst.value.toReal());
+
+    program.insts.push_back(inst);
+  }
+  else if (parse.isChar('(')) {
+    parse.skipChar();
+
+    if (! compileTernary(parse, program))
+      return false;
+
+    parse.skipSpace();
+
+    if (! parse.isChar(')'))
+      return false;
+
+    parse.skipChar();
+  }
+  else if (parse.isAlpha()) {
+    if (! compileFunction(parse, program))
+      return false;
+  }
+  else if (parse.isChar('$')) {
+    if (! compileVariable(parse, program))
+      return false;
+  }
+  else if (parse.isChar('[')) {
+    if (! compileCommand(parse, program))
+      return false;
+  }
+  else if (parse.isChar('"')) {
+    if (! compileString(parse, program))
+      return false;
+  }
+  else if (parse.isChar('{')) {
+    if (! compileBraces(parse, program))
+      return false;
+  }
+  else
+    return false;
+
+  return true;
+}
+
+// replace unary operator applied to value (operand at operandPos) by result.
+// Only folded if operand is a single value (not the last value of a sub expression)
+bool
+CEval::
+foldUnary(CEvalProgram &program, uint operandPos)
+{
+  auto &insts = program.insts;
+
+  uint n = insts.size();
+
+  if (n != operandPos + 2 || insts[n - 2].type != CEvalInst::Type::VALUE)
+    return false;
+
+  CEvalValue &value = insts[n - 2].value;
+
+  if      (insts[n - 1].type == CEvalInst::Type::NEGATE) {
+    if (! negateValue(value, value))
+      return false;
+
+    keepBigInt(program, value);
+  }
+  else if (insts[n - 1].type == CEvalInst::Type::NOT)
+    value = CEvalValue(long(! value.toBool()));
+  else
+    return false;
+
+  insts.pop_back();
+
+  return true;
+}
+
+// replace binary operator applied to two values (left value at lhsPos) by result.
+// Not folded if evaluation fails so error is reported when run
+bool
+CEval::
+foldBinary(CEvalProgram &program, uint lhsPos)
+{
+  auto &insts = program.insts;
+
+  uint n = insts.size();
+
+  if (n != lhsPos + 3)
+    return false;
+
+  const auto &inst1 = insts[lhsPos    ];
+  const auto &inst2 = insts[lhsPos + 1];
+
+  if (inst1.type != CEvalInst::Type::VALUE || inst2.type != CEvalInst::Type::VALUE)
+    return false;
+
+  CEvalValue value;
+
+  if (! evalOperator(inst1.value, insts[n - 1].op, inst2.value, value))
+    return false;
+
+  keepBigInt(program, value);
+
+  insts.resize(lhsPos + 1);
+
+  insts[lhsPos].value = value;
+
+  return true;
+}
+
+// move folded big integer value (owned by evaluator) to program
+void
+CEval::
+keepBigInt(CEvalProgram &program, CEvalValue &value)
+{
+  if (value.getType() != CEVAL_VALUE_BIGINT)
+    return;
+
+  program.bigInts.push_back(*value.getBigInt());
+
+  value = CEvalValue(&program.bigInts.back());
+}
+
+// replace pure function of values (starting at argsPos) by result
+bool
+CEval::
+foldFunction(CEvalProgram &program, uint argsPos)
+{
+  auto &insts = program.insts;
+
+  const auto &inst = insts.back();
+
+  if (! inst.func || ! inst.func->pure || insts.size() != argsPos + inst.n + 1)
+    return false;
+
+  std::vector<CEvalValue> args;
+
+  for (uint i = argsPos; i < argsPos + inst.n; ++i) {
+    if (insts[i].type != CEvalInst::Type::VALUE)
+      return false;
+
+    args.push_back(insts[i].value);
+  }
+
+  CEvalValue value;
+
+  if (! inst.func->proc(this, args.data(), inst.n, value))
+    return false;
+
+  keepBigInt(program, value);
+
+  insts.resize(argsPos + 1);
+
+  insts[argsPos] = CEvalInst();
+
+  insts[argsPos].value = value;
+
+  return true;
+}
+
+// name(arg, ...)
+bool
+CEval::
+compileFunction(CStrParse &parse, CEvalProgram &program)
+{
+  CEvalInst inst;
+
+  inst.type = CEvalInst::Type::FUNCTION;
+
+  if (! parse.readIdentifier(inst.str))
+    return false;
+
+  parse.skipSpace();
+
+  // boolean literal (true, false, yes, no, on, off)
+  if (! parse.isChar('(')) {
+    bool b;
+
+    if (! stringToBool(inst.str, b))
+      return false;
+
+    CEvalInst inst1;
+
+    inst1.value = CEvalValue(long(b));
+
+    program.insts.push_back(inst1);
+
+    return true;
+  }
+
+  // builtin function or user function (resolved when run)
+  inst.func = getFunction(inst.str);
+
+  if (! inst.func && ! isUserFunction(inst.str))
+    return false;
+
+  uint argsPos = program.insts.size();
+
+  parse.skipChar();
+
+  parse.skipSpace();
+
+  if (parse.isChar(')'))
+    parse.skipChar();
+  else {
+    while (true) {
+      if (! compileTernary(parse, program))
         return false;
 
-      int depth = 1;
+      ++inst.n;
 
-      while (! parse.eof()) {
-        char c;
+      parse.skipSpace();
 
-        if (! parse.readChar(&c))
-          return false;
+      char c = '\0';
 
+      if (! parse.readChar(&c))
+        return false;
+
+      if      (c == ')')
+        break;
+      else if (c != ',')
+        return false;
+    }
+  }
+
+  if (inst.func && (inst.n < inst.func->minArgs || inst.n > inst.func->maxArgs))
+    return false;
+
+  program.insts.push_back(inst);
+
+  (void) foldFunction(program, argsPos);
+
+  return true;
+}
+
+// $name, ${name} or $name(index)
+bool
+CEval::
+compileVariable(CStrParse &parse, CEvalProgram &program)
+{
+  CEvalInst inst;
+
+  inst.type = CEvalInst::Type::VARIABLE;
+
+  parse.skipChar();
+
+  char c = '\0';
+
+  if (parse.isChar('{')) {
+    parse.skipChar();
+
+    while (parse.readChar(&c) && c != '}')
+      inst.str += c;
+
+    if (c != '}')
+      return false;
+  }
+  else {
+    while (parse.isAlpha() || parse.isDigit() || parse.isOneOf("_:")) {
+      parse.readChar(&c);
+
+      inst.str += c;
+    }
+
+    if (parse.isChar('(')) {
+      parse.skipChar();
+
+      int depth = 1;
+
+      while (parse.readChar(&c)) {
         if      (c == '(')
           ++depth;
         else if (c == ')') {
-          --depth;
-
-          if (depth == 0)
+          if (--depth == 0)
             break;
         }
+
+        inst.index += c;
       }
 
       if (depth != 0)
         return false;
 
-      int pos2 = parse.getPos();
+      inst.isArray = true;
+    }
+  }
+
+  if (inst.str.empty())
+    return false;
+
+  program.insts.push_back(inst);
+
+  return true;
+}
+
+// "string" with variable, command and backslash substitution
+bool
+CEval::
+compileString(CStrParse &parse, CEvalProgram &program)
+{
+  auto &insts = program.insts;
+
+  parse.skipChar();
 
-      std::string str1 = parse.getAt(pos1 + 1, pos2 - pos1 - 2);
+  uint numParts = 0;
 
-      CEval eval1(*this);
+  CEvalInst literal;
 
-      CEvalValueRef result1;
+  literal.type = CEvalInst::Type::STRING;
 
-      if (! eval1.eval(str1, result1))
+  auto addLiteral = [&]() {
+    if (literal.str.empty()) return;
+
+    insts.push_back(literal);
+
+    literal.str.clear();
+
+    ++numParts;
+  };
+
+  char c = '\0';
+
+  while (! parse.isChar('"')) {
+    if      (parse.isChar('$')) {
+      addLiteral();
+
+      if (! compileVariable(parse, program))
         return false;
 
-      pushValue(result1);
+      insts.back().asString = true;
+
+      ++numParts;
     }
-    // function
-    else if (parse.isAlpha()) {
-      std::string name;
+    else if (parse.isChar('[')) {
+      addLiteral();
 
-      if (! parse.readIdentifier(name))
+      if (! compileCommand(parse, program))
         return false;
 
-      parse.skipSpace();
+      insts.back().asString = true;
+
+      ++numParts;
+    }
+    else if (parse.isChar('\\')) {
+      parse.skipChar();
 
-      if (! parse.isChar('('))
+      if (! parse.readChar(&c))
         return false;
 
-      int pos1 = parse.getPos();
+      switch (c) {
+        case 'n': literal.str += '\n'; break;
+        case 't': literal.str += '\t'; break;
+        case 'r': literal.str += '\r'; break;
+        default : literal.str += c   ; break;
+      }
+    }
+    else if (parse.readChar(&c))
+      literal.str += c;
+    else
+      return false;
+  }
 
-      if (! parse.skipChar())
-        return false;
+  parse.skipChar();
 
-      int depth = 1;
+  if (! literal.str.empty() || numParts == 0) {
+    insts.push_back(literal);
 
-      while (! parse.eof()) {
-        char c;
+    ++numParts;
+  }
 
-        if (! parse.readChar(&c))
-          return false;
+  if (numParts > 1) {
+    CEvalInst concat;
 
-        if      (c == '(')
-          ++depth;
-        else if (c == ')') {
-          --depth;
+    concat.type = CEvalInst::Type::CONCAT;
+    concat.n    = numParts;
 
-          if (depth == 0)
-            break;
-        }
-      }
+    insts.push_back(concat);
+  }
 
-      if (depth != 0)
+  return true;
+}
+
+// {string} (no substitution)
+bool
+CEval::
+compileBraces(CStrParse &parse, CEvalProgram &program)
+{
+  CEvalInst inst;
+
+  inst.type = CEvalInst::Type::STRING;
+
+  parse.skipChar();
+
+  int depth = 1;
+
+  char c = '\0';
+
+  while (parse.readChar(&c)) {
+    if      (c == '{')
+      ++depth;
+    else if (c == '}') {
+      if (--depth == 0)
+        break;
+    }
+
+    inst.str += c;
+  }
+
+  if (depth != 0)
+    return false;
+
+  program.insts.push_back(inst);
+
+  return true;
+}
+
+// [command]
+bool
+CEval::
+compileCommand(CStrParse &parse, CEvalProgram &program)
+{
+  CEvalInst inst;
+
+  inst.type = CEvalInst::Type::COMMAND;
+
+  parse.skipChar();
+
+  int depth = 1;
+
+  char c = '\0';
+
+  while (parse.readChar(&c)) {
+    if      (c == '\\') {
+      inst.str += c;
+
+      if (! parse.readChar(&c))
         return false;
+    }
+    else if (c == '[')
+      ++depth;
+    else if (c == ']') {
+      if (--depth == 0)
+        break;
+    }
 
-      int pos2 = parse.getPos();
+    inst.str += c;
+  }
 
-      std::string str1 = parse.getAt(pos1 + 1, pos2 - pos1 - 2);
+  if (depth != 0)
+    return false;
 
-      std::vector<std::string> args;
+  program.insts.push_back(inst);
 
-      CStrParse parse1(str1);
+  return true;
+}
 
-      while (! parse1.eof()) {
-        int ppos1 = parse1.getPos();
+//------
 
-        while (! parse1.eof() && ! parse1.isChar(','))
-          parse1.skipChar();
+// run compiled expression on value stack
+bool
+CEval::
+run(const CEvalProgram &program, CEvalValue &result)
+{
+  resetRun(program);
 
-        int ppos2 = parse1.getPos();
+  bool suspended;
 
-        std::string arg = parse1.getAt(ppos1, ppos2 - ppos1);
+  return runInsts(program, 0, result, false, suspended);
+}
 
-        args.push_back(arg);
+bool
+CEval::
+start(const CEvalProgram &program, CEvalValue &result, bool &suspended)
+{
+  resetRun(program);
 
-        if (! parse1.eof() && parse1.isChar(','))
-          parse1.skipChar();
-      }
+  return runInsts(program, 0, result, true, suspended);
+}
 
-      auto num_args = args.size();
+bool
+CEval::
+resume(const CEvalProgram &program, CEvalValue &result, bool &suspended)
+{
+  return runInsts(program, pc_, result, true, suspended);
+}
 
-      std::vector<CEvalValueRef> arg_vals;
+void
+CEval::
+resetRun(const CEvalProgram &program)
+{
+  stack_  .clear();
+  strings_.clear();
+  bigInts_.clear();
 
-      for (uint i = 0; i < num_args; ++i) {
-        CEval eval1(*this);
+  errorMsg_ = "";
 
-        CEvalValueRef arg_val;
+  if (program.reuseVars)
+    std::fill(slotSet_, slotSet_ + program.numSlots, false);
 
-        if (! eval1.eval(args[i], arg_val))
-          return false;
+  pc_            = 0;
+  suspendedInst_ = nullptr;
+}
 
-        arg_vals.push_back(arg_val);
-      }
+// run instructions from pc. If suspend is set then stop before running a
+// command operand (see start)
+bool
+CEval::
+runInsts(const CEvalProgram &program, uint pc, CEvalValue &result,
+         bool suspend, bool &suspended)
+{
+  suspended = false;
 
-      if      (name == "abs") {
-        if (num_args != 1) return false;
+  bool reuseVars = program.reuseVars;
 
-        double result1 = fabs(arg_vals[0]->toReal());
+  const auto &insts = program.insts;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "acos") {
-        if (num_args != 1) return false;
+  uint numInsts = insts.size();
 
-        double result1 = acos(arg_vals[0]->toReal());
+  while (pc < numInsts) {
+    const auto &inst = insts[pc++];
 
-        if (degrees_) result1 = RAD_TO_DEG(result1);
+    switch (inst.type) {
+      case CEvalInst::Type::VALUE: {
+        stack_.push_back(inst.value);
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "asin") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::STRING: {
+        stack_.push_back(CEvalValue(&inst.str));
 
-        double result1 = asin(arg_vals[0]->toReal());
+        break;
+      }
+      case CEvalInst::Type::VARIABLE: {
+        if (reuseVars && slotSet_[inst.slot]) {
+          stack_.push_back(slotValues_[inst.slot]);
+          break;
+        }
 
-        if (degrees_) result1 = RAD_TO_DEG(result1);
+        CEvalValue value;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "atan") {
-        if (num_args != 1) return false;
+        if (! getVariable(inst.str, inst.index, inst.isArray, inst.asString, value))
+          return false;
 
-        double result1 = atan(arg_vals[0]->toReal());
+        if (reuseVars) {
+          slotValues_[inst.slot] = value;
+          slotSet_   [inst.slot] = true;
+        }
 
-        if (degrees_) result1 = RAD_TO_DEG(result1);
+        stack_.push_back(value);
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "atan2") {
-        if (num_args != 2) return false;
+      case CEvalInst::Type::COMMAND: {
+        if (suspend) {
+          pc_            = pc;
+          suspendedInst_ = &inst;
+          suspended      = true;
 
-        double result1 = atan2(arg_vals[0]->toReal(), arg_vals[1]->toReal());
+          return true;
+        }
 
-        if (degrees_) result1 = RAD_TO_DEG(result1);
+        CEvalValue value;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "ceil") {
-        if (num_args != 1) return false;
+        if (! execCommand(inst.str, inst.asString, value))
+          return false;
 
-        double result1 = ceil(arg_vals[0]->toReal());
+        stack_.push_back(value);
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "cos") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::CONCAT: {
+        if (stack_.size() < inst.n)
+          return false;
 
-        double a = arg_vals[0]->toReal();
+        uint pos = stack_.size() - inst.n;
 
-        if (degrees_) a = DEG_TO_RAD(a);
+        std::string str;
 
-        double result1 = cos(a);
+        for (uint i = pos; i < pos + inst.n; ++i)
+          str += stack_[i].toString();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "cosh") {
-        if (num_args != 1) return false;
+        for (uint i = 0; i < inst.n; ++i)
+          stack_.pop_back();
 
-        double result1 = cosh(arg_vals[0]->toReal());
+        stack_.push_back(CEvalValue(addString(str)));
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "exp") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::OPERATOR: {
+        if (stack_.size() < 2)
+          return false;
 
-        double result1 = exp(arg_vals[0]->toReal());
+        CEvalValue value2 = stack_.back(); stack_.pop_back();
+        CEvalValue value1 = stack_.back(); stack_.pop_back();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "floor") {
-        if (num_args != 1) return false;
+        CEvalValue value;
+
+        if (! evalOperator(value1, inst.op, value2, value))
+          return false;
 
-        double result1 = floor(arg_vals[0]->toReal());
+        stack_.push_back(value);
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "log") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::NEGATE: {
+        if (stack_.empty())
+          return false;
 
-        double result1 = log(arg_vals[0]->toReal());
+        CEvalValue value;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "log10") {
-        if (num_args != 1) return false;
+        if (! toNumber(stack_.back(), value)) {
+          errorMsg_ = "can't use non-numeric string as operand of \"-\"";
+          return false;
+        }
 
-        double result1 = log10(arg_vals[0]->toReal());
+        if (! negateValue(value, stack_.back()))
+          return false;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "mod") {
-        if (num_args != 2) return false;
+      case CEvalInst::Type::NOT:
+      case CEvalInst::Type::BOOL: {
+        if (stack_.empty())
+          return false;
 
-        double result1 = fmod(arg_vals[0]->toReal(), arg_vals[1]->toReal());
+        CEvalValue &value = stack_.back();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "pow") {
-        if (num_args != 2) return false;
+        bool b;
 
-        double result1 = pow(arg_vals[0]->toReal(), arg_vals[1]->toReal());
+        if (! valueToBool(value, b))
+          return false;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        value = CEvalValue(long(inst.type == CEvalInst::Type::NOT ? ! b : b));
+
+        break;
       }
-      else if (name == "rand") {
-        double result1 = 0.0;
-
-        if      (num_args == 0)
-          result1 = randIn(0.0, 1.0);
-        else if (num_args == 1) {
-          double x = arg_vals[0]->toReal();
-
-          if (x > 0)
-            result1 = randIn(0.0, x);
-          else
-            result1 = randIn(x, 0.0);
+      case CEvalInst::Type::FUNCTION: {
+        if (stack_.size() < inst.n)
+          return false;
+
+        uint pos = stack_.size() - inst.n;
+
+        CEvalValue value;
+
+        if (inst.func) {
+          // builtin functions take numbers
+          for (uint i = pos; i < pos + inst.n; ++i) {
+            if (stack_[i].isString() && ! toNumber(stack_[i], stack_[i])) {
+              errorMsg_ = "expected number but got \"" + stack_[i].getString() + "\"";
+              return false;
+            }
+          }
+
+          if (! inst.func->proc(this, &stack_[pos], inst.n, value))
+            return false;
         }
-        else if (num_args == 2) {
-          double x = arg_vals[0]->toReal();
-          double y = arg_vals[1]->toReal();
-
-          if (y > x)
-            result1 = randIn(x, y);
-          else
-            result1 = randIn(y, x);
+        else {
+          if (! callUserFunction(inst.str, &stack_[pos], inst.n, value))
+            return false;
         }
-        else
-          return false;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        for (uint i = 0; i < inst.n; ++i)
+          stack_.pop_back();
+
+        stack_.push_back(value);
+
+        break;
+      }
+      case CEvalInst::Type::JUMP: {
+        pc = inst.n;
+
+        break;
       }
-      else if (name == "sin") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::JUMP_FALSE: {
+        if (stack_.empty())
+          return false;
 
-        double a = arg_vals[0]->toReal();
+        bool b;
+
+        if (! valueToBool(stack_.back(), b))
+          return false;
 
-        if (degrees_) a = DEG_TO_RAD(a);
+        stack_.pop_back();
 
-        double result1 = sin(a);
+        if (! b)
+          pc = inst.n;
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "sinh") {
-        if (num_args != 1) return false;
+      case CEvalInst::Type::AND:
+      case CEvalInst::Type::OR: {
+        if (stack_.empty())
+          return false;
+
+        bool b;
+
+        if (! valueToBool(stack_.back(), b))
+          return false;
+
+        if (b == (inst.type == CEvalInst::Type::OR)) {
+          stack_.back() = CEvalValue(long(b));
 
-        double result1 = sinh(arg_vals[0]->toReal());
+          pc = inst.n;
+        }
+        else
+          stack_.pop_back();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
+        break;
       }
-      else if (name == "sqrt") {
-        if (num_args != 1) return false;
+      default:
+        assert(false);
+        break;
+    }
+
+    if (getDebug())
+      printStack();
+  }
+
+  if (stack_.size() != 1)
+    return false;
+
+  result = stack_.back();
+
+  return true;
+}
+
+//------
+
+// read integer (64 bit) or real number. Integers which do not fit are read as
+// big integers (owned by program). Integers may have a 0x (hex), 0o (octal)
+// or 0b (binary) prefix
+bool
+CEval::
+readNumber(CStrParse &parse, CEvalProgram &program, CEvalValue &value)
+{
+  if (parse.isChar('0')) {
+    int pos = parse.getPos();
+
+    parse.skipChar();
+
+    int base = 10;
+
+    if      (parse.isOneOf("xX")) base = 16;
+    else if (parse.isOneOf("oO")) base = 8;
+    else if (parse.isOneOf("bB")) base = 2;
+
+    if (base != 10) {
+      parse.skipChar();
+
+      std::string digits;
+
+      char c = '\0';
+
+      while ((parse.isDigit() || parse.isAlpha()) && parse.readChar(&c))
+        digits += c;
+
+      return readBaseInteger(digits, base, program, value);
+    }
+
+    parse.setPos(pos);
+  }
+
+  std::string str;
+
+  bool is_real = false;
+
+  auto readDigits = [&]() {
+    char c = '\0';
+
+    while (parse.isDigit() && parse.readChar(&c))
+      str += c;
+  };
+
+  char c = '\0';
+
+  readDigits();
+
+  if (parse.isChar('.')) {
+    parse.readChar(&c);
+
+    str += c;
+
+    is_real = true;
+
+    readDigits();
+  }
+
+  if (str.empty() || str == ".")
+    return false;
+
+  if (parse.isOneOf("eE")) {
+    parse.readChar(&c);
+
+    str += c;
+
+    if (parse.isOneOf("+-")) {
+      parse.readChar(&c);
+
+      str += c;
+    }
+
+    if (! parse.isDigit())
+      return false;
+
+    is_real = true;
+
+    readDigits();
+  }
+
+  const char *s = str.data();
+  const char *e = s + str.size();
+
+  if (! is_real) {
+    long integer;
+
+    if (std::from_chars(s, e, integer).ec == std::errc()) {
+      value = CEvalValue(integer);
+      return true;
+    }
 
-        double result1 = sqrt(arg_vals[0]->toReal());
+    program.bigInts.emplace_back();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "tan") {
-        if (num_args != 1) return false;
+    if (CEvalBigInt::fromString(str, program.bigInts.back())) {
+      value = CEvalValue(&program.bigInts.back());
+      return true;
+    }
+  }
 
-        double a = arg_vals[0]->toReal();
+  double real;
 
-        if (degrees_) a = DEG_TO_RAD(a);
+  if (std::from_chars(s, e, real).ec != std::errc())
+    real = strtod(str.c_str(), nullptr); // out of range (inf/zero)
 
-        double result1 = tan(a);
+  value = CEvalValue(real);
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else if (name == "tanh") {
-        if (num_args != 1) return false;
+  return true;
+}
 
-        double result1 = tanh(arg_vals[0]->toReal());
+// convert digits of integer in base 2, 8 or 16 (no prefix). Integers which do
+// not fit are stored as big integers (owned by program)
+bool
+CEval::
+readBaseInteger(const std::string &digits, int base, CEvalProgram &program, CEvalValue &value)
+{
+  const char *s = digits.data();
+  const char *e = s + digits.size();
 
-        pushValue(CEvalValueRef(new CEvalRealValue(result1)));
-      }
-      else
-        return false;
-    }
-    else {
-      if (! handleUnknown(parse))
-        return false;
-    }
+  ulong u;
 
-    if (getDebug())
-      printStack();
-  }
+  auto res = std::from_chars(s, e, u, base);
 
-  if (checkLastOperator(nullptr)) {
-    if (! evalLastOperator())
-      return false;
+  if (res.ptr != e || (res.ec != std::errc() && res.ec != std::errc::result_out_of_range))
+    return false;
 
-    if (getDebug())
-      printStack();
+  if (res.ec == std::errc() && u <= ulong(LONG_MAX)) {
+    value = CEvalValue(long(u));
+    return true;
   }
 
-  auto size = stack_.size();
+  // accumulate digits into big integer
+  CEvalBigInt bi;
 
-  while (size > 1) {
-    if (size < 3) return false;
+  CEvalBigInt bbase((long(base)));
 
-    if (! evalLastOperator())
-      return false;
-
-    if (getDebug())
-      printStack();
+  for (auto c : digits) {
+    long d = (isdigit(c) ? c - '0' : tolower(c) - 'a' + 10);
 
-    size = stack_.size();
+    bi = bi*bbase + CEvalBigInt(d);
   }
 
-  if (! popValue(result))
-    return false;
+  program.bigInts.push_back(bi);
+
+  value = CEvalValue(&program.bigInts.back());
 
   return true;
 }
@@ -489,7 +1182,7 @@ readOp(CStrParse &parse)
 {
   CEvalOp *op = nullptr;
 
-  char c;
+  char c = '\0';
 
   if (! parse.readChar(&c))
     return 0;
@@ -567,116 +1260,268 @@ readOp(CStrParse &parse)
 
       break;
     }
+    case 'e': {
+      if (parse.isChar('q')) {
+        parse.readChar(&c);
+
+        op = &string_eq_op_;
+      }
+      else
+        return 0;
+
+      break;
+    }
+    case 'n': {
+      if (parse.isChar('e')) {
+        parse.readChar(&c);
+
+        op = &string_ne_op_;
+      }
+      else
+        return 0;
+
+      break;
+    }
   }
 
   return op;
 }
 
-void
+// convert string (optional sign and number surrounded by space) to value.
+// Integers can have 0x (hex), 0o (octal) or 0b (binary) prefix and decimal
+// integers too large for an integer are real
+bool
 CEval::
-pushValue(CEvalValueRef valueRef)
+stringToValue(const std::string &str, CEvalValue &value)
 {
-  stack_.push_back(valueRef);
+  const char *s = str.data();
+  const char *e = s + str.size();
+
+  while (s < e && isspace(*s)) ++s;
+  while (e > s && isspace(e[-1])) --e;
+
+  bool negate = false;
+
+  if (s < e && (*s == '+' || *s == '-')) {
+    negate = (*s == '-');
+
+    ++s;
+  }
+
+  if (s == e || (! isdigit(*s) && *s != '.'))
+    return false;
+
+  int base = 10;
+
+  if (e - s > 2 && s[0] == '0') {
+    char c = char(tolower(s[1]));
+
+    if      (c == 'x') base = 16;
+    else if (c == 'o') base = 8;
+    else if (c == 'b') base = 2;
+
+    if (base != 10)
+      s += 2;
+  }
+
+  // integer (parsed unsigned so LONG_MIN can be represented)
+  ulong u;
+
+  auto ires = std::from_chars(s, e, u, base);
+
+  if (ires.ec == std::errc() && ires.ptr == e &&
+      u <= ulong(LONG_MAX) + (negate ? 1 : 0)) {
+    value = CEvalValue(negate ? long(0UL - u) : long(u));
+    return true;
+  }
+
+  if (base != 10)
+    return false;
+
+  // real
+  double r;
+
+  auto rres = std::from_chars(s, e, r);
+
+  if (rres.ptr != e)
+    return false;
+
+  if      (rres.ec == std::errc::result_out_of_range)
+    r = strtod(std::string(s, e).c_str(), nullptr);
+  else if (rres.ec != std::errc())
+    return false;
+
+  value = CEvalValue(negate ? -r : r);
+
+  return true;
 }
 
+// convert string (true, false, yes, no, on, off) to boolean
 bool
 CEval::
-popValue(CEvalValueRef &valueRef)
+stringToBool(const std::string &str, bool &b)
 {
-  if (! hasValue()) return false;
+  std::string lstr = str;
 
-  valueRef = stack_.back();
+  for (auto &c : lstr)
+    c = char(tolower(c));
 
-  stack_.pop_back();
+  if      (lstr == "true" || lstr == "yes" || lstr == "on")
+    b = true;
+  else if (lstr == "false" || lstr == "no" || lstr == "off")
+    b = false;
+  else
+    return false;
 
   return true;
 }
 
-void
+// get number for value (strings must be numeric)
+bool
 CEval::
-pushOperator(CEvalOp *op)
+toNumber(const CEvalValue &value, CEvalValue &number)
 {
-  stack_.push_back(CEvalValueRef(new CEvalOperatorValue(op)));
+  if (! value.isString()) {
+    number = value;
+    return true;
+  }
 
-  lastOp_ = op;
+  return stringToNumber(value.getString(), number);
 }
 
+// get boolean for value (strings must be numeric or boolean)
 bool
 CEval::
-popOperator(CEvalOp **op1)
+valueToBool(const CEvalValue &value, bool &b)
 {
-  if (! hasOperator())
-    return false;
+  if (! value.isString()) {
+    b = value.toBool();
+    return true;
+  }
 
-  CEvalOperatorValue *op = stack_.back().cast<CEvalOperatorValue>();
+  CEvalValue number;
 
-  *op1 = op->getOp();
+  if      (stringToNumber(value.getString(), number))
+    b = number.toBool();
+  else if (! stringToBool(value.getString(), b)) {
+    errorMsg_ = "expected boolean value but got \"" + value.getString() + "\"";
+    return false;
+  }
 
-  stack_.pop_back();
+  return true;
+}
 
-  updateLastOp();
+const std::string *
+CEval::
+addString(const std::string &str)
+{
+  strings_.push_back(str);
 
-  return true;
+  return &strings_.back();
 }
 
-void
+const CEvalBigInt *
 CEval::
-updateLastOp()
+addBigInt(const CEvalBigInt &i)
 {
-  lastOp_ = nullptr;
+  bigInts_.push_back(i);
 
-  auto num = stack_.size();
+  return &bigInts_.back();
+}
 
-  for (uint i = 0; i < num; ++i) {
-    CEvalValueRef value = stack_[i];
+CEvalValue
+CEval::
+bigIntValue(const CEvalBigInt &i)
+{
+  long l;
 
-    if (value->getType() == CEVAL_VALUE_OPERATOR)
-      lastOp_ = value.cast<CEvalOperatorValue>()->getOp();
-  }
+  if (i.toLong(l))
+    return CEvalValue(l);
+
+  return CEvalValue(addBigInt(i));
 }
 
+// convert string to value. Decimal integers too large for 64 bits are big integers
 bool
 CEval::
-hasValue()
+stringToNumber(const std::string &str, CEvalValue &value)
 {
-  return (! stack_.empty() && stack_.back()->isValue());
+  if (! stringToValue(str, value))
+    return false;
+
+  if (value.getType() == CEVAL_VALUE_REAL) {
+    CEvalBigInt i;
+
+    if (CEvalBigInt::fromString(str, i))
+      value = CEvalValue(addBigInt(i));
+  }
+
+  return true;
 }
 
-bool
+// get next operator without reading it
+CEvalOp *
 CEval::
-hasOperator()
+peekOp(CStrParse &parse)
 {
-  return (! stack_.empty() && stack_.back()->getType() == CEVAL_VALUE_OPERATOR);
+  int pos = parse.getPos();
+
+  CEvalOp *op = readOp(parse);
+
+  parse.setPos(pos);
+
+  return op;
 }
 
-CEvalValueRef
+// apply binary operator. Integer operators are done in 64 bit integer arithmetic,
+// overflow of +, -, * and ^ gives a big integer result and integer divide by zero fails
+bool
 CEval::
-evalOperator(CEvalValueRef value2)
+evalOperator(const CEvalValue &value1, CEvalOp *op, const CEvalValue &value2,
+             CEvalValue &result)
 {
-  CEvalOp *op;
+  // eq and ne always compare as strings
+  if (op == &string_eq_op_ || op == &string_ne_op_) {
+    bool equal = (value1.toString() == value2.toString());
 
-  bool rc1 = popOperator(&op);
+    result = CEvalValue(long(op == &string_eq_op_ ? equal : ! equal));
 
-  assert(rc1);
+    return true;
+  }
 
-  CEvalValueRef value1;
+  // string operands are used as numbers if numeric. Otherwise comparisons are
+  // done on strings and other operators fail
+  if (value1.isString() || value2.isString()) {
+    CEvalValue number1, number2;
 
-  bool rc2 = popValue(value1);
+    if (toNumber(value1, number1) && toNumber(value2, number2))
+      return evalOperator(number1, op, number2, result);
 
-  assert(rc2);
+    int cmp = value1.toString().compare(value2.toString());
 
-  return evalOperator(value1, op, value2);
-}
+    long ivalue = 0;
 
-CEvalValueRef
-CEval::
-evalOperator(CEvalValueRef value1, CEvalOp *op, CEvalValueRef value2)
-{
-  if (value1->getType() == CEVAL_VALUE_REAL || value2->getType() == CEVAL_VALUE_REAL) {
-    double rvalue1 = value1->toReal();
-    double rvalue2 = value2->toReal();
+    if      (op == &less_op_         ) ivalue = (cmp <  0);
+    else if (op == &less_equal_op_   ) ivalue = (cmp <= 0);
+    else if (op == &greater_op_      ) ivalue = (cmp >  0);
+    else if (op == &greater_equal_op_) ivalue = (cmp >= 0);
+    else if (op == &equals_op_       ) ivalue = (cmp == 0);
+    else if (op == &not_equals_op_   ) ivalue = (cmp != 0);
+    else {
+      errorMsg_ = std::string("can't use non-numeric string as operand of \"") + op->str + "\"";
+      return false;
+    }
+
+    result = CEvalValue(ivalue);
+
+    return true;
+  }
+
+  if (value1.getType() == CEVAL_VALUE_REAL || value2.getType() == CEVAL_VALUE_REAL) {
+    double rvalue1 = value1.toReal();
+    double rvalue2 = value2.toReal();
 
-    int    ivalue = 0;
+    long   ivalue = 0;
     double rvalue = 0.0;
     bool   is_int = false;
 
@@ -697,24 +1542,51 @@ evalOperator(CEvalValueRef value1, CEvalOp *op, CEvalValueRef value2)
     else                               assert(false);
 
     if (is_int)
-      return CEvalValueRef(new CEvalIntValue(ivalue));
+      result = CEvalValue(ivalue);
     else
-      return CEvalValueRef(new CEvalRealValue(rvalue));
+      result = CEvalValue(rvalue);
+  }
+  else if (value1.getType() == CEVAL_VALUE_BIGINT || value2.getType() == CEVAL_VALUE_BIGINT) {
+    return evalBigOperator(value1, op, value2, result);
   }
   else {
-    int ivalue1 = value1->toInt();
-    int ivalue2 = value2->toInt();
+    long ivalue1 = value1.toInt();
+    long ivalue2 = value2.toInt();
 
-    int    ivalue = 0;
+    long   ivalue = 0;
     double rvalue = 0;
 
     bool is_real = false;
 
-    if      (op == &times_op_        ) ivalue = ivalue1 *  ivalue2;
-    else if (op == &divide_op_       ) ivalue = ivalue1 /  ivalue2;
-    else if (op == &modulus_op_      ) ivalue = ivalue1 %  ivalue2;
-    else if (op == &plus_op_         ) ivalue = ivalue1 +  ivalue2;
-    else if (op == &minus_op_        ) ivalue = ivalue1 -  ivalue2;
+    if      (op == &times_op_) {
+      if (__builtin_mul_overflow(ivalue1, ivalue2, &ivalue))
+        return evalBigOperator(value1, op, value2, result);
+    }
+    else if (op == &divide_op_ || op == &modulus_op_) {
+      if (ivalue2 == 0) {
+        errorMsg_ = "divide by zero";
+        return false;
+      }
+
+      if (ivalue2 == -1) { // LONG_MIN / -1 overflows
+        if (op == &modulus_op_)
+          ivalue = 0;
+        else if (ivalue1 == LONG_MIN)
+          return evalBigOperator(value1, op, value2, result);
+        else
+          ivalue = -ivalue1;
+      }
+      else
+        ivalue = (op == &divide_op_ ? ivalue1 / ivalue2 : ivalue1 % ivalue2);
+    }
+    else if (op == &plus_op_) {
+      if (__builtin_add_overflow(ivalue1, ivalue2, &ivalue))
+        return evalBigOperator(value1, op, value2, result);
+    }
+    else if (op == &minus_op_) {
+      if (__builtin_sub_overflow(ivalue1, ivalue2, &ivalue))
+        return evalBigOperator(value1, op, value2, result);
+    }
     else if (op == &less_op_         ) ivalue = ivalue1 <  ivalue2;
     else if (op == &less_equal_op_   ) ivalue = ivalue1 <= ivalue2;
     else if (op == &greater_op_      ) ivalue = ivalue1 >  ivalue2;
@@ -723,49 +1595,330 @@ evalOperator(CEvalValueRef value1, CEvalOp *op, CEvalValueRef value2)
     else if (op == &not_equals_op_   ) ivalue = ivalue1 != ivalue2;
     else if (op == &and_op_          ) ivalue = ivalue1 && ivalue2;
     else if (op == &or_op_           ) ivalue = ivalue1 || ivalue2;
-    else if (op == &power_op_        ) { rvalue = pow(ivalue1, ivalue2); is_real = true; }
+    else if (op == &power_op_) {
+      if      (ivalue2 < 0) {
+        rvalue = pow(double(ivalue1), double(ivalue2)); is_real = true; }
+      else if (! intPower(ivalue1, ivalue2, ivalue))
+        return evalBigOperator(value1, op, value2, result);
+    }
     else                               assert(false);
 
     if (is_real)
-      return CEvalValueRef(new CEvalRealValue(rvalue));
+      result = CEvalValue(rvalue);
     else
-      return CEvalValueRef(new CEvalIntValue(ivalue));
+      result = CEvalValue(ivalue);
   }
+
+  return true;
 }
 
+// apply binary operator to integers (at least one big or 64 bit result overflowed).
+// Result is 64 bit integer if in range
 bool
 CEval::
-checkLastOperator(CEvalOp *op)
+evalBigOperator(const CEvalValue &value1, CEvalOp *op, const CEvalValue &value2,
+                CEvalValue &result)
 {
-  if (! lastOp_) return false;
-  if (! op     ) return true ;
+  CEvalBigInt ivalue1 = value1.toBigInt();
+  CEvalBigInt ivalue2 = value2.toBigInt();
+
+  if      (op == &times_op_) result = bigIntValue(ivalue1*ivalue2);
+  else if (op == &plus_op_ ) result = bigIntValue(ivalue1 + ivalue2);
+  else if (op == &minus_op_) result = bigIntValue(ivalue1 - ivalue2);
+  else if (op == &divide_op_ || op == &modulus_op_) {
+    CEvalBigInt quotient, remainder;
+
+    if (! CEvalBigInt::divMod(ivalue1, ivalue2, quotient, remainder)) {
+      errorMsg_ = "divide by zero";
+      return false;
+    }
+
+    result = bigIntValue(op == &divide_op_ ? quotient : remainder);
+  }
+  else if (op == &power_op_) {
+    // negative exponent gives real, 0, 1 and -1 give same magnitude for any exponent
+    if      (ivalue2.isNegative())
+      result = CEvalValue(pow(value1.toReal(), value2.toReal()));
+    else if (ivalue1.numBits() <= 1) {
+      CEvalBigInt quotient, remainder;
+
+      CEvalBigInt::divMod(ivalue2, CEvalBigInt(2L), quotient, remainder);
+
+      if      (ivalue1.isZero())
+        result = CEvalValue(long(ivalue2.isZero() ? 1 : 0));
+      else if (ivalue1.isNegative())
+        result = CEvalValue(long(remainder.isZero() ? 1 : -1));
+      else
+        result = CEvalValue(1L);
+    }
+    else {
+      long exponent;
+
+      if (! ivalue2.toLong(exponent) ||
+          ivalue1.numBits()*ulong(exponent) > MAX_BIGINT_BITS) {
+        errorMsg_ = "exponent too large";
+        return false;
+      }
+
+      result = bigIntValue(ivalue1.pow(ulong(exponent)));
+    }
+  }
+  else {
+    int cmp = ivalue1.cmp(ivalue2);
+
+    long ivalue = 0;
+
+    if      (op == &less_op_         ) ivalue = (cmp <  0);
+    else if (op == &less_equal_op_   ) ivalue = (cmp <= 0);
+    else if (op == &greater_op_      ) ivalue = (cmp >  0);
+    else if (op == &greater_equal_op_) ivalue = (cmp >= 0);
+    else if (op == &equals_op_       ) ivalue = (cmp == 0);
+    else if (op == &not_equals_op_   ) ivalue = (cmp != 0);
+    else if (op == &and_op_          ) ivalue = (! ivalue1.isZero() && ! ivalue2.isZero());
+    else if (op == &or_op_           ) ivalue = (! ivalue1.isZero() || ! ivalue2.isZero());
+    else                               assert(false);
+
+    result = CEvalValue(ivalue);
+  }
+
+  return true;
+}
 
-  int prec1 = lastOp_->precedence;
-  int prec2 = op     ->precedence;
+// negate number (negative of smallest 64 bit integer is big integer)
+bool
+CEval::
+negateValue(const CEvalValue &value, CEvalValue &result)
+{
+  if      (value.getType() == CEVAL_VALUE_REAL)
+    result = CEvalValue(-value.toReal());
+  else if (value.getType() == CEVAL_VALUE_BIGINT)
+    result = bigIntValue(-(*value.getBigInt()));
+  else if (value.getType() == CEVAL_VALUE_INTEGER) {
+    if (value.toInt() == LONG_MIN)
+      result = bigIntValue(-CEvalBigInt(LONG_MIN));
+    else
+      result = CEvalValue(-value.toInt());
+  }
+  else
+    return false;
 
-  return (prec2 <= prec1);
+  return true;
 }
 
+// integer power by repeated squaring (fails on overflow)
 bool
 CEval::
-evalLastOperator()
+intPower(long base, long exponent, long &result)
 {
-  CEvalValueRef value1, value2;
-  CEvalOp*      op;
+  result = 1;
+
+  while (exponent > 0) {
+    if (exponent & 1) {
+      if (__builtin_mul_overflow(result, base, &result))
+        return false;
+    }
+
+    exponent >>= 1;
+
+    if (exponent > 0 && __builtin_mul_overflow(base, base, &base))
+      return false;
+  }
+
+  return true;
+}
 
-  bool rc1 = popValue(value1);
-  bool rc2 = popOperator(&op);
-  bool rc3 = popValue(value2);
+// builtin math functions
+static bool
+realResult(double r, CEvalValue &result)
+{
+  result = CEvalValue(r);
 
-  if (! rc1 || ! rc2 || ! rc3) return false;
+  return true;
+}
 
-  CEvalValueRef value = evalOperator(value2, op, value1);
+// integer for integral real (big integer if outside 64 bit range)
+static bool
+integerResult(CEval *eval, double r, CEvalValue &result)
+{
+  if (! std::isfinite(r)) {
+    eval->setErrorMsg("integer value too large to represent");
+    return false;
+  }
 
-  pushValue(value);
+  // [-2^63, 2^63) is in range
+  if (r >= -9223372036854775808.0 && r < 9223372036854775808.0)
+    result = CEvalValue(long(r));
+  else
+    result = eval->bigIntValue(CEvalBigInt::fromReal(r));
 
   return true;
 }
 
+using CEvalFunctionMap = std::unordered_map<std::string,CEvalFunction>;
+
+static CEvalFunctionMap &
+evalFunctions()
+{
+  static CEvalFunctionMap functions;
+
+  return functions;
+}
+
+void
+CEval::
+initFunctions()
+{
+  static bool initialized;
+
+  if (initialized) return;
+
+  initialized = true;
+
+  using Args = const CEvalValue *;
+
+  // name, proc, min args, max args, pure
+  addFunction({"abs", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    if      (args[0].getType() == CEVAL_VALUE_INTEGER && args[0].toInt() != LONG_MIN)
+      result = CEvalValue(std::abs(args[0].toInt()));
+    else if (args[0].isInteger())
+      result = eval->bigIntValue(args[0].toBigInt().abs());
+    else
+      result = CEvalValue(fabs(args[0].toReal()));
+    return true; }, 1, 1, true});
+
+  addFunction({"acos", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double r = acos(args[0].toReal());
+    return realResult(eval->getDegrees() ? RAD_TO_DEG(r) : r, result); }, 1, 1, false});
+  addFunction({"asin", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double r = asin(args[0].toReal());
+    return realResult(eval->getDegrees() ? RAD_TO_DEG(r) : r, result); }, 1, 1, false});
+  addFunction({"atan", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double r = atan(args[0].toReal());
+    return realResult(eval->getDegrees() ? RAD_TO_DEG(r) : r, result); }, 1, 1, false});
+  addFunction({"atan2", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double r = atan2(args[0].toReal(), args[1].toReal());
+    return realResult(eval->getDegrees() ? RAD_TO_DEG(r) : r, result); }, 2, 2, false});
+
+  addFunction({"cos", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double a = args[0].toReal();
+    return realResult(cos(eval->getDegrees() ? DEG_TO_RAD(a) : a), result); }, 1, 1, false});
+  addFunction({"sin", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double a = args[0].toReal();
+    return realResult(sin(eval->getDegrees() ? DEG_TO_RAD(a) : a), result); }, 1, 1, false});
+  addFunction({"tan", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    double a = args[0].toReal();
+    return realResult(tan(eval->getDegrees() ? DEG_TO_RAD(a) : a), result); }, 1, 1, false});
+
+  addFunction({"ceil", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(ceil(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"cosh", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(cosh(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"exp", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(exp(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"floor", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(floor(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"log", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(log(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"log10", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(log10(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"sinh", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(sinh(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"sqrt", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(sqrt(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"tanh", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(tanh(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"double", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(args[0].toReal(), result); }, 1, 1, true});
+
+  addFunction({"fmod", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(fmod(args[0].toReal(), args[1].toReal()), result); }, 2, 2, true});
+  addFunction({"mod", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(fmod(args[0].toReal(), args[1].toReal()), result); }, 2, 2, true});
+  addFunction({"pow", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(pow(args[0].toReal(), args[1].toReal()), result); }, 2, 2, true});
+  addFunction({"hypot", [](CEval *, Args args, uint, CEvalValue &result) {
+    return realResult(hypot(args[0].toReal(), args[1].toReal()), result); }, 2, 2, true});
+
+  addFunction({"int", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    if (args[0].isInteger()) {
+      result = args[0];
+      return true;
+    }
+    return integerResult(eval, std::trunc(args[0].toReal()), result); }, 1, 1, true});
+  addFunction({"round", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    if (args[0].isInteger()) {
+      result = args[0];
+      return true;
+    }
+    return integerResult(eval, std::round(args[0].toReal()), result); }, 1, 1, true});
+
+  // min/max of one or more values (integer if all integer)
+  addFunction({"min", [](CEval *, Args args, uint numArgs, CEvalValue &result) {
+    result = args[0];
+    for (uint i = 1; i < numArgs; ++i) {
+      if (args[i].toReal() < result.toReal()) result = args[i]; }
+    return true; }, 1, UINT_MAX, true});
+  addFunction({"max", [](CEval *, Args args, uint numArgs, CEvalValue &result) {
+    result = args[0];
+    for (uint i = 1; i < numArgs; ++i) {
+      if (args[i].toReal() > result.toReal()) result = args[i]; }
+    return true; }, 1, UINT_MAX, true});
+
+  // srand(seed) : seed generator and return first random number
+  addFunction({"srand", [](CEval *eval, Args args, uint, CEvalValue &result) {
+    if (! args[0].isInteger()) {
+      eval->setErrorMsg("expected integer but got \"" + args[0].toString() + "\"");
+      return false;
+    }
+
+    eval->getRandom().setSeed(uint64_t(args[0].toInt()));
+
+    return realResult(eval->getRandom().nextReal(), result); }, 1, 1, false});
+
+  // rand(), rand(max) or rand(min, max)
+  addFunction({"rand", [](CEval *eval, Args args, uint numArgs, CEvalValue &result) {
+    double r = 0.0;
+
+    if      (numArgs == 0)
+      r = eval->randIn(0.0, 1.0);
+    else if (numArgs == 1) {
+      double x = args[0].toReal();
+
+      r = (x > 0 ? eval->randIn(0.0, x) : eval->randIn(x, 0.0));
+    }
+    else {
+      double x = args[0].toReal();
+      double y = args[1].toReal();
+
+      r = (y > x ? eval->randIn(x, y) : eval->randIn(y, x));
+    }
+
+    return realResult(r, result); }, 0, 2, false});
+}
+
+void
+CEval::
+addFunction(const CEvalFunction &function)
+{
+  evalFunctions()[function.name] = function;
+}
+
+const CEvalFunction *
+CEval::
+getFunction(const std::string &name)
+{
+  initFunctions();
+
+  const auto &functions = evalFunctions();
+
+  auto p = functions.find(name);
+
+  if (p == functions.end())
+    return nullptr;
+
+  return &(*p).second;
+}
+
 void
 CEval::
 printStack()
@@ -773,7 +1926,7 @@ printStack()
   auto num = stack_.size();
 
   for (uint i = 0; i < num; ++i) {
-    stack_[i]->print();
+    stack_[i].print();
 
     std::cout << " ";
   }
@@ -781,36 +1934,124 @@ printStack()
   std::cout << "\n";
 }
 
+CEvalRandom &
+CEval::
+getRandom()
+{
+  static CEvalRandom defRandom;
+
+  return (random_ ? *random_ : defRandom);
+}
+
 double
 CEval::
 randIn(double min_val, double max_val)
 {
-  return (max_val - min_val)*((1.0*rand())/RAND_MAX) + min_val;
+  return getRandom().nextReal(min_val, max_val);
 }
 
 //------
 
 void
-CEvalRealValue::
-print()
+CEvalRandom::
+setSeed(uint64_t seed)
+{
+  // expand seed with splitmix64 so similar seeds give unrelated states
+  for (auto &s : s_) {
+    seed += 0x9e3779b97f4a7c15;
+
+    uint64_t z = seed;
+
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27))*0x94d049bb133111eb;
+
+    s = z ^ (z >> 31);
+  }
+
+  hasSpare_ = false;
+}
+
+// Marsaglia polar method (generates pairs so second value is kept for next call)
+double
+CEvalRandom::
+nextNormal()
 {
-  std::cout << value_;
+  if (hasSpare_) {
+    hasSpare_ = false;
+
+    return spare_;
+  }
+
+  double u, v, s;
+
+  do {
+    u = 2.0*nextReal() - 1.0;
+    v = 2.0*nextReal() - 1.0;
+
+    s = u*u + v*v;
+  } while (s >= 1.0 || s == 0.0);
+
+  double f = std::sqrt(-2.0*std::log(s)/s);
+
+  spare_    = v*f;
+  hasSpare_ = true;
+
+  return u*f;
 }
 
 //------
 
-void
-CEvalIntValue::
-print()
+bool
+CEvalValue::
+toBool() const
 {
-  std::cout << value_;
+  if      (type_ == CEVAL_VALUE_REAL   ) return real_ != 0.0;
+  else if (type_ == CEVAL_VALUE_INTEGER) return integer_ != 0;
+  else if (type_ == CEVAL_VALUE_BIGINT ) return ! big_->isZero();
+  else if (type_ == CEVAL_VALUE_STRING ) {
+    CEvalValue number;
+    bool       b = false;
+
+    if (CEval::stringToValue(*str_, number))
+      return number.toBool();
+
+    (void) CEval::stringToBool(*str_, b);
+
+    return b;
+  }
+  else
+    return false;
 }
 
-//------
+// string form of value (shortest real which reads back as same value)
+std::string
+CEvalValue::
+toString() const
+{
+  if      (type_ == CEVAL_VALUE_REAL) {
+    char buffer[32];
+
+    auto res = std::to_chars(buffer, buffer + sizeof(buffer), real_, std::chars_format::general);
+
+    return std::string(buffer, res.ptr);
+  }
+  else if (type_ == CEVAL_VALUE_INTEGER)
+    return std::to_string(integer_);
+  else if (type_ == CEVAL_VALUE_BIGINT)
+    return big_->toString();
+  else if (type_ == CEVAL_VALUE_STRING)
+    return *str_;
+  else
+    return op_->str;
+}
 
 void
-CEvalOperatorValue::
-print()
+CEvalValue::
+print() const
 {
-  std::cout << op_->str;
+  if      (type_ == CEVAL_VALUE_REAL   ) std::cout << real_;
+  else if (type_ == CEVAL_VALUE_INTEGER) std::cout << integer_;
+  else if (type_ == CEVAL_VALUE_BIGINT ) std::cout << big_->toString();
+  else if (type_ == CEVAL_VALUE_STRING ) std::cout << "\"" << *str_ << "\"";
+  else                                   std::cout << op_->str;
 }
@@ -1,114 +1,318 @@
 #ifndef CEVAL_H
 #define CEVAL_H
 
-#include <CRefPtr.h>
+#include <CEvalBigInt.h>
+#include <string>
+#include <vector>
 #include <deque>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <sys/types.h>
 
 class CStrParse;
+class CEval;
 
 struct CEvalOp {
   const char *str;
   int         precedence;
 };
 
-class CEvalValue;
-
-using CEvalValueRef = CRefPtr<CEvalValue>;
-
 enum CEvalValueType {
   CEVAL_VALUE_REAL,
   CEVAL_VALUE_INTEGER,
+  CEVAL_VALUE_BIGINT,
+  CEVAL_VALUE_STRING,
   CEVAL_VALUE_OPERATOR
 };
 
+// stack entry : real, 64 bit integer, string or operator held inline (tagged
+// union). String and big integer values point to values owned by the program
+// or evaluator. Big integers are only used for values outside 64 bit range
 class CEvalValue {
  public:
-  CEvalValue(CEvalValueType type) :
-   type_(type) {
+  CEvalValue() :
+   type_(CEVAL_VALUE_INTEGER), integer_(0) {
+  }
+
+  explicit CEvalValue(double real) :
+   type_(CEVAL_VALUE_REAL), real_(real) {
+  }
+
+  explicit CEvalValue(long integer) :
+   type_(CEVAL_VALUE_INTEGER), integer_(integer) {
   }
 
-  virtual ~CEvalValue() { }
+  explicit CEvalValue(const CEvalBigInt *big) :
+   type_(CEVAL_VALUE_BIGINT), big_(big) {
+  }
+
+  explicit CEvalValue(const std::string *str) :
+   type_(CEVAL_VALUE_STRING), str_(str) {
+  }
+
+  explicit CEvalValue(CEvalOp *op) :
+   type_(CEVAL_VALUE_OPERATOR), op_(op) {
+  }
 
   CEvalValueType getType() const { return type_; }
 
-  virtual bool isValue() const { return false; }
+  bool isString() const { return type_ == CEVAL_VALUE_STRING; }
 
-  virtual double toReal() const { return 0.0; }
-  virtual int    toInt () const { return 0  ; }
+  // integer (64 bit or big)
+  bool isInteger() const { return type_ == CEVAL_VALUE_INTEGER || type_ == CEVAL_VALUE_BIGINT; }
 
-  virtual void print() { }
+  bool isValue() const { return type_ != CEVAL_VALUE_OPERATOR; }
 
- protected:
+  double toReal() const {
+    if      (type_ == CEVAL_VALUE_REAL   ) return real_;
+    else if (type_ == CEVAL_VALUE_INTEGER) return double(integer_);
+    else if (type_ == CEVAL_VALUE_BIGINT ) return big_->toReal();
+    else                                   return 0.0;
+  }
+
+  // integer value (big integers are clamped to 64 bit range)
+  long toInt() const {
+    if      (type_ == CEVAL_VALUE_REAL   ) return long(real_);
+    else if (type_ == CEVAL_VALUE_INTEGER) return integer_;
+    else if (type_ == CEVAL_VALUE_BIGINT ) return (big_->isNegative() ? LONG_MIN : LONG_MAX);
+    else                                   return 0;
+  }
+
+  // big integer value (64 bit integer converted)
+  CEvalBigInt toBigInt() const {
+    if (type_ == CEVAL_VALUE_BIGINT) return *big_;
+    else                             return CEvalBigInt(toInt());
+  }
+
+  const CEvalBigInt *getBigInt() const { return big_; }
+
+  bool toBool() const;
+
+  const std::string &getString() const { return *str_; }
+
+  // string form of value
+  std::string toString() const;
+
+  CEvalOp *getOp() const { return (type_ == CEVAL_VALUE_OPERATOR ? op_ : nullptr); }
+
+  void print() const;
+
+ private:
   CEvalValueType type_;
+
+  union {
+    double             real_;
+    long               integer_;
+    const CEvalBigInt *big_;
+    const std::string *str_;
+    CEvalOp           *op_;
+  };
 };
 
 //---
 
-class CEvalRealValue : public CEvalValue {
+// value/operator stack : entries are stored in a fixed size inline array and
+// only move to the heap for deeply nested expressions
+class CEvalStack {
+ public:
+  static const uint INLINE_SIZE = 32;
+
  public:
-  CEvalRealValue(double value) :
-   CEvalValue(CEVAL_VALUE_REAL), value_(value) {
+  CEvalStack() { }
+
+  CEvalStack(const CEvalStack &) = delete;
+  CEvalStack &operator=(const CEvalStack &) = delete;
+
+  bool empty() const { return size_ == 0; }
+
+  uint size() const { return size_; }
+
+  const CEvalValue &operator[](uint i) const { return data_[i]; }
+  CEvalValue       &operator[](uint i)       { return data_[i]; }
+
+  const CEvalValue &back() const { return data_[size_ - 1]; }
+  CEvalValue       &back()       { return data_[size_ - 1]; }
+
+  void push_back(const CEvalValue &value) {
+    if (size_ >= capacity_)
+      grow();
+
+    data_[size_++] = value;
   }
 
-  bool isValue() const override { return true; }
+  void pop_back() { --size_; }
 
-  double getValue() const { return value_; }
+  void clear() { size_ = 0; }
 
-  double toReal() const override { return value_; }
-  int    toInt () const override { return int(value_); }
+ private:
+  void grow() {
+    std::vector<CEvalValue> heap(2*capacity_);
 
-  void print() override;
+    std::copy(data_, data_ + size_, heap.begin());
 
- protected:
-  double value_;
+    heap_.swap(heap);
+
+    data_     = heap_.data();
+    capacity_ = heap_.size();
+  }
+
+ private:
+  CEvalValue              inline_[INLINE_SIZE];
+  std::vector<CEvalValue> heap_;
+  CEvalValue*             data_     { inline_ };
+  uint                    size_     { 0 };
+  uint                    capacity_ { INLINE_SIZE };
 };
 
 //---
 
-class CEvalIntValue : public CEvalValue {
+// xoshiro256** pseudo random number generator (state seeded by splitmix64)
+class CEvalRandom {
  public:
-  CEvalIntValue(int value) :
-   CEvalValue(CEVAL_VALUE_INTEGER), value_(value) {
+  explicit CEvalRandom(uint64_t seed=0) { setSeed(seed); }
+
+  void setSeed(uint64_t seed);
+
+  uint64_t next() {
+    uint64_t result = rotl(s_[1]*5, 7)*9;
+
+    uint64_t t = s_[1] << 17;
+
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+
+    s_[2] ^= t;
+
+    s_[3] = rotl(s_[3], 45);
+
+    return result;
   }
 
-  bool isValue() const override { return true; }
+  // uniform real in [0, 1) (53 bits)
+  double nextReal() { return double(next() >> 11)*(1.0/9007199254740992.0); }
 
-  int getValue() const { return value_; }
+  // uniform real in [min, max)
+  double nextReal(double min, double max) { return min + (max - min)*nextReal(); }
 
-  double toReal() const override { return double(value_); }
-  int    toInt () const override { return value_; }
+  // standard normal real (mean 0, standard deviation 1)
+  double nextNormal();
 
-  void print() override;
+ private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
 
- protected:
-  int value_;
+ private:
+  uint64_t s_[4];
+  bool     hasSpare_ { false };
+  double   spare_    { 0.0 };
 };
 
 //---
 
-class CEvalOperatorValue : public CEvalValue {
- public:
-  CEvalOperatorValue(CEvalOp *op) :
-   CEvalValue(CEVAL_VALUE_OPERATOR), op_(op) {
-  }
+// math function : proc is called with number of arguments in range
+// [minArgs, maxArgs]. Pure functions (result only depends on arguments)
+// with constant arguments are evaluated when compiled
+struct CEvalFunction {
+  using Proc = bool (*)(CEval *eval, const CEvalValue *args, uint numArgs,
+                        CEvalValue &result);
+
+  std::string name;
+  Proc        proc    { nullptr };
+  uint        minArgs { 0 };
+  uint        maxArgs { 0 };
+  bool        pure    { true };
+};
 
-  CEvalOp *getOp() const { return op_; }
+//---
 
-  void print() override;
+// compiled expression instruction
+struct CEvalInst {
+  enum class Type {
+    VALUE,      // push value
+    STRING,     // push string str
+    VARIABLE,   // push value of variable str (with index if isArray)
+    COMMAND,    // push result of command str
+    CONCAT,     // pop n values and push concatenated string
+    OPERATOR,   // pop two values and push result of op
+    NEGATE,     // negate top value
+    NOT,        // logical not of top value
+    BOOL,       // convert top value to 0 or 1
+    FUNCTION,   // pop n arguments and push result of function func (user function str)
+    JUMP,       // jump to n
+    JUMP_FALSE, // pop value and jump to n if false
+    AND,        // if top value false replace by 0 and jump to n, else pop
+    OR          // if top value true replace by 1 and jump to n, else pop
+  };
+
+  Type        type    { Type::VALUE };
+  CEvalValue  value;
+  CEvalOp*    op      { nullptr };
+  uint        n       { 0 };
+  std::string str;
+  std::string index;
+  bool        isArray  { false };
+  bool        asString { false };  // variable/command value needed as string
+  uint        slot     { 0 };      // variable slot (same for same variable)
+
+  const CEvalFunction *func { nullptr };
+};
 
- protected:
-  CEvalOp *op_;
+// compiled expression : instructions for stack machine. Constant sub expressions
+// are folded when compiled. Variables are loaded once per run unless the
+// expression contains commands (which may change them)
+struct CEvalProgram {
+  static const uint MAX_SLOTS = 16;
+
+  CEvalProgram() { }
+
+  CEvalProgram(const CEvalProgram &) = delete;
+  CEvalProgram &operator=(const CEvalProgram &) = delete;
+
+  std::vector<CEvalInst>  insts;
+  std::deque<CEvalBigInt> bigInts; // constant big integers used by instructions
+  uint                   numSlots  { 0 };
+  bool                   reuseVars { false };
 };
 
 //---
 
 class CEval {
+ public:
+  // largest big integer result (bits) of power operator
+  static const ulong MAX_BIGINT_BITS = 1UL<<24;
+
  public:
   CEval();
 
   virtual ~CEval();
 
-  virtual bool handleUnknown(CStrParse &) { return false; }
+  // get value of variable operand ($name or $name(index)). Value is a number
+  // if the variable is numeric (and asString is false) otherwise a string (see addString)
+  virtual bool getVariable(const std::string & /*name*/, const std::string & /*index*/,
+                           bool /*isArray*/, bool /*asString*/, CEvalValue & /*value*/) {
+    return false;
+  }
+
+  // get result of command operand ([cmd])
+  virtual bool execCommand(const std::string & /*cmd*/, bool /*asString*/,
+                           CEvalValue & /*value*/) {
+    return false;
+  }
+
+  // user defined math function (used for names which are not builtin functions)
+  virtual bool isUserFunction(const std::string & /*name*/) { return false; }
+
+  virtual bool callUserFunction(const std::string & /*name*/, const CEvalValue * /*args*/,
+                                uint /*numArgs*/, CEvalValue & /*result*/) {
+    return false;
+  }
+
+  // builtin math functions (shared by all evaluators)
+  static void addFunction(const CEvalFunction &function);
+
+  static const CEvalFunction *getFunction(const std::string &name);
 
   void setDebug(bool debug=true) { debug_ = debug; }
   bool getDebug() const { return debug_; }
@@ -116,51 +320,125 @@ class CEval {
   void setForceReal(bool forceReal=true) { forceReal_ = forceReal; }
 
   void setDegrees(bool degrees=true) { degrees_ = degrees; }
+  bool getDegrees() const { return degrees_; }
 
   bool eval(const std::string &str, double *result);
 
+  // evaluate to typed (integer or real) result
+  bool eval(const std::string &str, CEvalValue &result);
+
+  // compile expression and run compiled expression
+  bool compile(const std::string &str, CEvalProgram &program);
+
+  bool run(const CEvalProgram &program, CEvalValue &result);
+
+  // run compiled expression stopping at a command operand (suspended is set) so
+  // the caller can run the command (suspendedInst) without nesting and continue
+  // with resume after pushing the command result (pushValue)
+  bool start (const CEvalProgram &program, CEvalValue &result, bool &suspended);
+  bool resume(const CEvalProgram &program, CEvalValue &result, bool &suspended);
+
+  const CEvalInst *suspendedInst() const { return suspendedInst_; }
+
+  void pushValue(const CEvalValue &value) { stack_.push_back(value); }
+
+  // error message of last failed run (empty if none)
+  const std::string &getErrorMsg() const { return errorMsg_; }
+
+  void setErrorMsg(const std::string &msg) { errorMsg_ = msg; }
+
+  // add string value (valid until next run)
+  const std::string *addString(const std::string &str);
+
+  // add big integer value (valid until next run)
+  const CEvalBigInt *addBigInt(const CEvalBigInt &i);
+
+  // integer value for big integer (64 bit integer if in range)
+  CEvalValue bigIntValue(const CEvalBigInt &i);
+
+  // random number generator used by rand() and srand(). Evaluators share a
+  // default generator unless one is set
+  void setRandom(CEvalRandom *random) { random_ = random; }
+
+  CEvalRandom &getRandom();
+
+  double randIn(double min_val, double max_val);
+
+  // convert string (optional sign and number surrounded by space) to value
+  static bool stringToValue(const std::string &str, CEvalValue &value);
+
+  // convert string to value allowing big integers
+  bool stringToNumber(const std::string &str, CEvalValue &value);
+
+  // convert string boolean (true, false, yes, no, on, off) to value
+  static bool stringToBool(const std::string &str, bool &b);
+
  protected:
-  CEval(const CEval &eval);
+  bool compileTernary(CStrParse &parse, CEvalProgram &program);
+  bool compileBinary (CStrParse &parse, CEvalProgram &program, int precedence);
+  bool compileUnary  (CStrParse &parse, CEvalProgram &program);
+  bool compilePrimary(CStrParse &parse, CEvalProgram &program);
 
-  void reset();
+  bool compileFunction(CStrParse &parse, CEvalProgram &program);
+  bool compileVariable(CStrParse &parse, CEvalProgram &program);
+  bool compileCommand (CStrParse &parse, CEvalProgram &program);
+  bool compileString  (CStrParse &parse, CEvalProgram &program);
+  bool compileBraces  (CStrParse &parse, CEvalProgram &program);
 
-  CEvalOp *readOp(CStrParse &parse);
+  bool foldUnary (CEvalProgram &program, uint operandPos);
+  bool foldBinary(CEvalProgram &program, uint lhsPos);
+  bool foldFunction(CEvalProgram &program, uint argsPos);
 
-  void pushValue(CEvalValueRef valueRef);
+  void assignSlots(CEvalProgram &program);
 
-  bool popValue(CEvalValueRef &value);
+  static void keepBigInt(CEvalProgram &program, CEvalValue &value);
 
-  void pushOperator(CEvalOp *op);
-  bool popOperator(CEvalOp **op);
+  static bool readNumber(CStrParse &parse, CEvalProgram &program, CEvalValue &value);
+  static bool readBaseInteger(const std::string &digits, int base, CEvalProgram &program,
+                              CEvalValue &value);
 
-  void updateLastOp();
+  CEvalOp *readOp(CStrParse &parse);
+  CEvalOp *peekOp(CStrParse &parse);
 
-  bool hasValue();
-  bool hasOperator();
+  bool evalOperator(const CEvalValue &value1, CEvalOp *op, const CEvalValue &value2,
+                    CEvalValue &result);
 
-  bool eval(const std::string &str, CEvalValueRef &result);
+  bool evalBigOperator(const CEvalValue &value1, CEvalOp *op, const CEvalValue &value2,
+                       CEvalValue &result);
 
-  bool eval1(CStrParse &parse, CEvalValueRef &result);
+  bool negateValue(const CEvalValue &value, CEvalValue &result);
 
-  CEvalValueRef evalOperator(CEvalValueRef value2);
-  CEvalValueRef evalOperator(CEvalValueRef value1, CEvalOp *op, CEvalValueRef value2);
+  bool toNumber(const CEvalValue &value, CEvalValue &number);
 
-  bool checkLastOperator(CEvalOp *op);
+  bool valueToBool(const CEvalValue &value, bool &b);
 
-  bool evalLastOperator();
+  static bool intPower(long base, long exponent, long &result);
 
   void printStack();
 
-  double randIn(double min_val, double max_val);
+  void resetRun(const CEvalProgram &program);
 
- protected:
-  using ValueStack = std::deque<CEvalValueRef>;
+  bool runInsts(const CEvalProgram &program, uint pc, CEvalValue &result,
+                bool suspend, bool &suspended);
 
-  ValueStack stack_;
-  CEvalOp*   lastOp_    { nullptr };
-  bool       forceReal_ { false };
-  bool       degrees_   { false };
-  bool       debug_     { false };
+  static void initFunctions();
+
+ protected:
+  using Strings = std::deque<std::string>;
+  using BigInts = std::deque<CEvalBigInt>;
+
+  CEvalStack  stack_;
+  Strings     strings_;
+  BigInts     bigInts_;
+  std::string errorMsg_;
+  CEvalValue  slotValues_[CEvalProgram::MAX_SLOTS];
+  bool        slotSet_   [CEvalProgram::MAX_SLOTS];
+  CEvalRandom *random_   { nullptr };
+  uint        pc_        { 0 };       // next instruction of suspended run
+  const CEvalInst *suspendedInst_ { nullptr };
+  bool        forceReal_ { false };
+  bool        degrees_   { false };
+  bool        debug_     { false };
 };
 
 #endif
@@ -0,0 +1,674 @@
+#include <CEvalBigInt.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cmath>
+
+CEvalBigInt::
+CEvalBigInt(long l)
+{
+  ulong u = (l < 0 ? 0UL - ulong(l) : ulong(l));
+
+  while (u) {
+    mag_.push_back(Limb(u));
+
+    u >>= 32;
+  }
+
+  neg_ = (l < 0);
+}
+
+bool
+CEvalBigInt::
+fromString(const std::string &str, CEvalBigInt &i)
+{
+  static const Limb pow10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+  const char *s = str.data();
+  const char *e = s + str.size();
+
+  while (s < e && isspace(*s)) ++s;
+  while (e > s && isspace(e[-1])) --e;
+
+  bool neg = false;
+
+  if (s < e && (*s == '+' || *s == '-')) {
+    neg = (*s == '-');
+
+    ++s;
+  }
+
+  if (s == e)
+    return false;
+
+  for (const char *p = s; p < e; ++p)
+    if (! isdigit(*p))
+      return false;
+
+  // first chunk has remainder digits so rest are full 9 digit chunks
+  Limbs mag;
+
+  size_t len = size_t(e - s) % 9;
+
+  if (len == 0)
+    len = 9;
+
+  while (s < e) {
+    Limb chunk = 0;
+
+    for (size_t k = 0; k < len; ++k)
+      chunk = 10*chunk + Limb(*s++ - '0');
+
+    mulSmallAdd(mag, pow10[len], chunk);
+
+    len = 9;
+  }
+
+  i.mag_.swap(mag);
+
+  i.neg_ = neg;
+
+  i.normalize();
+
+  return true;
+}
+
+CEvalBigInt
+CEvalBigInt::
+fromReal(double r)
+{
+  CEvalBigInt i;
+
+  // r = mantissa*2^exp where mantissa is 53 bit integer
+  int exp;
+
+  double f = std::frexp(std::trunc(std::fabs(r)), &exp);
+
+  if (f == 0.0)
+    return i;
+
+  uint64_t mantissa = uint64_t(std::ldexp(f, 53));
+
+  exp -= 53;
+
+  if (exp < 0) {
+    mantissa >>= -exp;
+
+    exp = 0;
+  }
+
+  i = CEvalBigInt(long(mantissa));
+
+  if (exp > 0)
+    i = i*CEvalBigInt(2L).pow(ulong(exp));
+
+  if (r < 0)
+    i = -i;
+
+  return i;
+}
+
+std::string
+CEvalBigInt::
+toString() const
+{
+  if (isZero())
+    return "0";
+
+  // split into base 10^9 chunks (least significant first)
+  std::vector<Limb> chunks;
+
+  Limbs a = mag_;
+
+  while (! a.empty())
+    chunks.push_back(divSmall(a, 1000000000));
+
+  std::string str;
+
+  str.reserve(9*chunks.size() + 1);
+
+  if (neg_)
+    str += '-';
+
+  str += std::to_string(chunks.back());
+
+  char buffer[16];
+
+  for (size_t k = chunks.size() - 1; k > 0; --k) {
+    snprintf(buffer, sizeof(buffer), "%09u", uint(chunks[k - 1]));
+
+    str += buffer;
+  }
+
+  return str;
+}
+
+bool
+CEvalBigInt::
+toLong(long &l) const
+{
+  if (mag_.size() > 2)
+    return false;
+
+  ulong u = 0;
+
+  if (mag_.size() > 0) u  = mag_[0];
+  if (mag_.size() > 1) u |= ulong(mag_[1]) << 32;
+
+  if (neg_) {
+    if (u > ulong(LONG_MAX) + 1)
+      return false;
+
+    l = long(0UL - u);
+  }
+  else {
+    if (u > ulong(LONG_MAX))
+      return false;
+
+    l = long(u);
+  }
+
+  return true;
+}
+
+double
+CEvalBigInt::
+toReal() const
+{
+  double r = 0.0;
+
+  for (size_t k = mag_.size(); k > 0; --k)
+    r = r*4294967296.0 + mag_[k - 1];
+
+  return (neg_ ? -r : r);
+}
+
+ulong
+CEvalBigInt::
+numBits() const
+{
+  if (isZero())
+    return 0;
+
+  return ulong(mag_.size() - 1)*32 + ulong(32 - __builtin_clz(mag_.back()));
+}
+
+int
+CEvalBigInt::
+cmp(const CEvalBigInt &rhs) const
+{
+  if (neg_ != rhs.neg_)
+    return (neg_ ? -1 : 1);
+
+  int c = cmpMag(mag_, rhs.mag_);
+
+  return (neg_ ? -c : c);
+}
+
+CEvalBigInt
+CEvalBigInt::
+operator-() const
+{
+  CEvalBigInt r = *this;
+
+  if (! r.isZero())
+    r.neg_ = ! r.neg_;
+
+  return r;
+}
+
+CEvalBigInt
+CEvalBigInt::
+abs() const
+{
+  CEvalBigInt r = *this;
+
+  r.neg_ = false;
+
+  return r;
+}
+
+CEvalBigInt
+operator+(const CEvalBigInt &lhs, const CEvalBigInt &rhs)
+{
+  CEvalBigInt r;
+
+  if (lhs.neg_ == rhs.neg_) {
+    CEvalBigInt::addMag(lhs.mag_, rhs.mag_, r.mag_);
+
+    r.neg_ = lhs.neg_;
+  }
+  else {
+    int c = CEvalBigInt::cmpMag(lhs.mag_, rhs.mag_);
+
+    if      (c > 0) {
+      CEvalBigInt::subMag(lhs.mag_, rhs.mag_, r.mag_);
+
+      r.neg_ = lhs.neg_;
+    }
+    else if (c < 0) {
+      CEvalBigInt::subMag(rhs.mag_, lhs.mag_, r.mag_);
+
+      r.neg_ = rhs.neg_;
+    }
+  }
+
+  r.normalize();
+
+  return r;
+}
+
+CEvalBigInt
+operator-(const CEvalBigInt &lhs, const CEvalBigInt &rhs)
+{
+  return lhs + (-rhs);
+}
+
+CEvalBigInt
+operator*(const CEvalBigInt &lhs, const CEvalBigInt &rhs)
+{
+  CEvalBigInt r;
+
+  CEvalBigInt::mulMag(lhs.mag_, rhs.mag_, r.mag_);
+
+  r.neg_ = (lhs.neg_ != rhs.neg_);
+
+  r.normalize();
+
+  return r;
+}
+
+bool
+CEvalBigInt::
+divMod(const CEvalBigInt &lhs, const CEvalBigInt &rhs,
+       CEvalBigInt &quotient, CEvalBigInt &remainder)
+{
+  if (rhs.isZero())
+    return false;
+
+  CEvalBigInt q, r;
+
+  divModMag(lhs.mag_, rhs.mag_, q.mag_, r.mag_);
+
+  // truncate towards zero : remainder has sign of dividend
+  q.neg_ = (lhs.neg_ != rhs.neg_);
+  r.neg_ = lhs.neg_;
+
+  q.normalize();
+  r.normalize();
+
+  quotient  = q;
+  remainder = r;
+
+  return true;
+}
+
+CEvalBigInt
+CEvalBigInt::
+pow(ulong exponent) const
+{
+  CEvalBigInt result(1L);
+  CEvalBigInt base = *this;
+
+  while (exponent > 0) {
+    if (exponent & 1)
+      result = result*base;
+
+    exponent >>= 1;
+
+    if (exponent > 0)
+      base = base*base;
+  }
+
+  return result;
+}
+
+//---
+
+void
+CEvalBigInt::
+normalize()
+{
+  trim(mag_);
+
+  if (mag_.empty())
+    neg_ = false;
+}
+
+int
+CEvalBigInt::
+cmpMag(const Limbs &a, const Limbs &b)
+{
+  if (a.size() != b.size())
+    return (a.size() < b.size() ? -1 : 1);
+
+  for (size_t k = a.size(); k > 0; --k) {
+    if (a[k - 1] != b[k - 1])
+      return (a[k - 1] < b[k - 1] ? -1 : 1);
+  }
+
+  return 0;
+}
+
+void
+CEvalBigInt::
+addMag(const Limbs &a, const Limbs &b, Limbs &r)
+{
+  const Limbs &l = (a.size() >= b.size() ? a : b);
+  const Limbs &s = (a.size() >= b.size() ? b : a);
+
+  Limbs res(l.size() + 1);
+
+  uint64_t carry = 0;
+
+  for (size_t k = 0; k < l.size(); ++k) {
+    uint64_t t = uint64_t(l[k]) + (k < s.size() ? s[k] : 0) + carry;
+
+    res[k] = Limb(t);
+    carry  = t >> 32;
+  }
+
+  res[l.size()] = Limb(carry);
+
+  trim(res);
+
+  r.swap(res);
+}
+
+// subtract magnitudes (a >= b)
+void
+CEvalBigInt::
+subMag(const Limbs &a, const Limbs &b, Limbs &r)
+{
+  Limbs res(a.size());
+
+  int64_t borrow = 0;
+
+  for (size_t k = 0; k < a.size(); ++k) {
+    int64_t t = int64_t(a[k]) - (k < b.size() ? b[k] : 0) - borrow;
+
+    borrow = (t < 0);
+
+    res[k] = Limb(t);
+  }
+
+  trim(res);
+
+  r.swap(res);
+}
+
+void
+CEvalBigInt::
+mulMag(const Limbs &a, const Limbs &b, Limbs &r)
+{
+  size_t na = a.size();
+  size_t nb = b.size();
+
+  if (na == 0 || nb == 0) {
+    r.clear();
+    return;
+  }
+
+  if (std::min(na, nb) >= KARATSUBA_THRESHOLD) {
+    karatsuba(a, b, r);
+    return;
+  }
+
+  // schoolbook multiply
+  Limbs res(na + nb, 0);
+
+  for (size_t i = 0; i < na; ++i) {
+    uint64_t carry = 0;
+
+    for (size_t j = 0; j < nb; ++j) {
+      uint64_t t = uint64_t(a[i])*b[j] + res[i + j] + carry;
+
+      res[i + j] = Limb(t);
+      carry      = t >> 32;
+    }
+
+    res[i + nb] = Limb(carry);
+  }
+
+  trim(res);
+
+  r.swap(res);
+}
+
+// a*b = z2*B^2m + z1*B^m + z0 where z1 = (a0 + a1)(b0 + b1) - z0 - z2
+void
+CEvalBigInt::
+karatsuba(const Limbs &a, const Limbs &b, Limbs &r)
+{
+  size_t m = std::max(a.size(), b.size())/2;
+
+  auto split = [&](const Limbs &x, Limbs &x0, Limbs &x1) {
+    size_t n0 = std::min(m, x.size());
+
+    x0.assign(x.begin(), x.begin() + n0);
+    x1.assign(x.begin() + n0, x.end());
+
+    trim(x0);
+  };
+
+  Limbs a0, a1, b0, b1;
+
+  split(a, a0, a1);
+  split(b, b0, b1);
+
+  Limbs z0, z1, z2, sa, sb;
+
+  mulMag(a0, b0, z0);
+  mulMag(a1, b1, z2);
+
+  addMag(a0, a1, sa);
+  addMag(b0, b1, sb);
+
+  mulMag(sa, sb, z1);
+
+  subMag(z1, z0, z1);
+  subMag(z1, z2, z1);
+
+  Limbs res(a.size() + b.size() + 1, 0);
+
+  addShifted(res, z0, 0);
+  addShifted(res, z1, uint(m));
+  addShifted(res, z2, uint(2*m));
+
+  trim(res);
+
+  r.swap(res);
+}
+
+// long division of magnitudes (Knuth algorithm D)
+void
+CEvalBigInt::
+divModMag(const Limbs &a, const Limbs &b, Limbs &q, Limbs &r)
+{
+  if (cmpMag(a, b) < 0) {
+    q.clear();
+
+    r = a;
+
+    return;
+  }
+
+  if (b.size() == 1) {
+    q = a;
+
+    Limb rem = divSmall(q, b[0]);
+
+    r.clear();
+
+    if (rem)
+      r.push_back(rem);
+
+    return;
+  }
+
+  size_t n = b.size();
+  size_t m = a.size() - n;
+
+  // normalize so top bit of divisor is set
+  int s = __builtin_clz(b.back());
+
+  Limbs vn(n), un(a.size() + 1);
+
+  for (size_t i = n - 1; i > 0; --i)
+    vn[i] = (b[i] << s) | (s ? b[i - 1] >> (32 - s) : 0);
+
+  vn[0] = b[0] << s;
+
+  un[a.size()] = (s ? a.back() >> (32 - s) : 0);
+
+  for (size_t i = a.size() - 1; i > 0; --i)
+    un[i] = (a[i] << s) | (s ? a[i - 1] >> (32 - s) : 0);
+
+  un[0] = a[0] << s;
+
+  Limbs res(m + 1);
+
+  const uint64_t base = uint64_t(1) << 32;
+
+  for (size_t j = m + 1; j > 0; --j) {
+    size_t jj = j - 1;
+
+    // estimate quotient digit
+    uint64_t num  = (uint64_t(un[jj + n]) << 32) | un[jj + n - 1];
+    uint64_t qhat = num/vn[n - 1];
+    uint64_t rhat = num%vn[n - 1];
+
+    while (qhat >= base || qhat*vn[n - 2] > ((rhat << 32) | un[jj + n - 2])) {
+      --qhat;
+
+      rhat += vn[n - 1];
+
+      if (rhat >= base)
+        break;
+    }
+
+    // multiply and subtract
+    int64_t k = 0;
+    int64_t t;
+
+    for (size_t i = 0; i < n; ++i) {
+      uint64_t p = qhat*vn[i];
+
+      t = int64_t(un[i + jj]) - k - int64_t(p & 0xFFFFFFFF);
+
+      un[i + jj] = Limb(t);
+
+      k = int64_t(p >> 32) - (t >> 32);
+    }
+
+    t = int64_t(un[jj + n]) - k;
+
+    un[jj + n] = Limb(t);
+
+    res[jj] = Limb(qhat);
+
+    // add back if subtracted too much
+    if (t < 0) {
+      --res[jj];
+
+      uint64_t carry = 0;
+
+      for (size_t i = 0; i < n; ++i) {
+        uint64_t t1 = uint64_t(un[i + jj]) + vn[i] + carry;
+
+        un[i + jj] = Limb(t1);
+
+        carry = t1 >> 32;
+      }
+
+      un[jj + n] = Limb(uint64_t(un[jj + n]) + carry);
+    }
+  }
+
+  // unnormalize remainder
+  Limbs rem(n);
+
+  for (size_t i = 0; i < n; ++i)
+    rem[i] = (un[i] >> s) | (s ? un[i + 1] << (32 - s) : 0);
+
+  trim(res);
+  trim(rem);
+
+  q.swap(res);
+  r.swap(rem);
+}
+
+// add a*B^shift to r (r must be large enough for result)
+void
+CEvalBigInt::
+addShifted(Limbs &r, const Limbs &a, uint shift)
+{
+  uint64_t carry = 0;
+
+  size_t k = 0;
+
+  for ( ; k < a.size(); ++k) {
+    uint64_t t = uint64_t(r[k + shift]) + a[k] + carry;
+
+    r[k + shift] = Limb(t);
+
+    carry = t >> 32;
+  }
+
+  for (k += shift; carry && k < r.size(); ++k) {
+    uint64_t t = uint64_t(r[k]) + carry;
+
+    r[k] = Limb(t);
+
+    carry = t >> 32;
+  }
+}
+
+// divide by single limb in place and return remainder
+CEvalBigInt::Limb
+CEvalBigInt::
+divSmall(Limbs &a, Limb d)
+{
+  uint64_t rem = 0;
+
+  for (size_t k = a.size(); k > 0; --k) {
+    uint64_t cur = (rem << 32) | a[k - 1];
+
+    a[k - 1] = Limb(cur/d);
+
+    rem = cur%d;
+  }
+
+  trim(a);
+
+  return Limb(rem);
+}
+
+// a = a*m + add
+void
+CEvalBigInt::
+mulSmallAdd(Limbs &a, Limb m, Limb add)
+{
+  uint64_t carry = add;
+
+  for (auto &limb : a) {
+    uint64_t t = uint64_t(limb)*m + carry;
+
+    limb  = Limb(t);
+    carry = t >> 32;
+  }
+
+  if (carry)
+    a.push_back(Limb(carry));
+}
+
+// remove leading zero limbs
+void
+CEvalBigInt::
+trim(Limbs &a)
+{
+  while (! a.empty() && a.back() == 0)
+    a.pop_back();
+}
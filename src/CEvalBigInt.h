@@ -0,0 +1,88 @@
+#ifndef CEVAL_BIG_INT_H
+#define CEVAL_BIG_INT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+
+// arbitrary precision integer used when 64 bit integer arithmetic overflows.
+// Stored as sign and magnitude (32 bit limbs, least significant first, no
+// leading zero limbs, zero has no limbs and is never negative).
+//
+// Large multiplies use Karatsuba, division truncates towards zero (like the
+// 64 bit integer operators) and decimal conversion works in base 10^9 chunks.
+class CEvalBigInt {
+ public:
+  using Limb  = uint32_t;
+  using Limbs = std::vector<Limb>;
+
+  // below this number of limbs multiply uses schoolbook method
+  static const uint KARATSUBA_THRESHOLD = 32;
+
+ public:
+  CEvalBigInt() { }
+
+  explicit CEvalBigInt(long l);
+
+  // decimal string (optional surrounding space and sign)
+  static bool fromString(const std::string &str, CEvalBigInt &i);
+
+  // integer part of finite real
+  static CEvalBigInt fromReal(double r);
+
+  std::string toString() const;
+
+  bool isZero    () const { return mag_.empty(); }
+  bool isNegative() const { return neg_; }
+
+  // get value if in range of long
+  bool toLong(long &l) const;
+
+  double toReal() const;
+
+  // number of significant bits of magnitude
+  ulong numBits() const;
+
+  int cmp(const CEvalBigInt &rhs) const;
+
+  bool operator==(const CEvalBigInt &rhs) const { return cmp(rhs) == 0; }
+  bool operator< (const CEvalBigInt &rhs) const { return cmp(rhs) <  0; }
+
+  CEvalBigInt operator-() const;
+
+  CEvalBigInt abs() const;
+
+  friend CEvalBigInt operator+(const CEvalBigInt &lhs, const CEvalBigInt &rhs);
+  friend CEvalBigInt operator-(const CEvalBigInt &lhs, const CEvalBigInt &rhs);
+  friend CEvalBigInt operator*(const CEvalBigInt &lhs, const CEvalBigInt &rhs);
+
+  // quotient and remainder (fails on divide by zero)
+  static bool divMod(const CEvalBigInt &lhs, const CEvalBigInt &rhs,
+                     CEvalBigInt &quotient, CEvalBigInt &remainder);
+
+  CEvalBigInt pow(ulong exponent) const;
+
+ private:
+  void normalize();
+
+  static int  cmpMag(const Limbs &a, const Limbs &b);
+  static void addMag(const Limbs &a, const Limbs &b, Limbs &r);
+  static void subMag(const Limbs &a, const Limbs &b, Limbs &r);
+  static void mulMag(const Limbs &a, const Limbs &b, Limbs &r);
+  static void karatsuba(const Limbs &a, const Limbs &b, Limbs &r);
+  static void divModMag(const Limbs &a, const Limbs &b, Limbs &q, Limbs &r);
+
+  static void addShifted(Limbs &r, const Limbs &a, uint shift);
+
+  static Limb divSmall(Limbs &a, Limb d);
+  static void mulSmallAdd(Limbs &a, Limb m, Limb add);
+
+  static void trim(Limbs &a);
+
+ private:
+  Limbs mag_;
+  bool  neg_ { false };
+};
+
+#endif
@@ -17,7 +17,18 @@
 #include <CFileMatch.h>
 #include <CTimer.h>
 #include <CEnv.h>
+#include <algorithm>
+#include <cstring>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <chrono>
+#include <random>
 #include <cmath>
+#include <charconv>
+#include <climits>
+#include <new>
+
+extern char **environ;
 
 class CTclParse : public CStrParse {
  public:
@@ -26,12 +37,203 @@ class CTclParse : public CStrParse {
 
   bool eof() const override;
 
+  // file line number of buffer position
+  uint getLineNum(int pos) const;
+
  private:
   bool fillBuffer();
 
  private:
-  CTcl  *tcl_  { nullptr };
-  CFile *file_ { nullptr };
+  struct LineStart {
+    int  pos  { 0 };
+    uint line { 0 };
+  };
+
+  using LineStarts = std::vector<LineStart>;
+
+  CTcl       *tcl_    { nullptr };
+  CFile      *file_   { nullptr };
+  uint        lineNum_ { 0 };
+  LineStarts  lineStarts_;
+};
+
+//------
+
+// compiled expressions by expression string. Programs are reference counted so
+// clearing a full cache does not affect expressions being run
+class CTclExprCache {
+ public:
+  using ProgramRef = CRefPtr<CEvalProgram>;
+
+  static const uint MAX_PROGRAMS = 1000;
+
+ public:
+  CTclExprCache() { }
+
+  ProgramRef getProgram(CEval &eval, const std::string &str) {
+    auto p = programs_.find(str);
+
+    if (p != programs_.end())
+      return (*p).second;
+
+    ProgramRef program(new CEvalProgram);
+
+    if (! eval.compile(str, *program))
+      return ProgramRef();
+
+    if (programs_.size() >= MAX_PROGRAMS)
+      programs_.clear();
+
+    programs_[str] = program;
+
+    return program;
+  }
+
+ private:
+  using Programs = std::map<std::string,ProgramRef>;
+
+  Programs programs_;
+};
+
+//------
+
+// expression evaluator with variable and command operands read from interpreter
+// when evaluated (so skipped branches of &&, || and ?: are not evaluated).
+// Operands use the value's cached number if it has one, otherwise are strings
+class CTclEval : public CEval {
+ public:
+  CTclEval(CTcl *tcl) :
+   tcl_(tcl) {
+    setRandom(&tcl_->getRandom());
+  }
+
+  bool getVariable(const std::string &name, const std::string &index, bool isArray,
+                   bool asString, CEvalValue &value) override {
+    CTclValueRef tvalue;
+
+    if (isArray) {
+      std::string index1 = tcl_->expandExpr(index);
+
+      if (tcl_->isError())
+        return false;
+
+      tvalue = tcl_->getArrayVariableValue(name, index1);
+    }
+    else
+      tvalue = tcl_->getVariableValue(name);
+
+    if (! tvalue.isValid()) {
+      tcl_->throwError("can't read \"" + name + "\": no such variable");
+      return false;
+    }
+
+    toEvalValue(tvalue, asString, value);
+
+    return true;
+  }
+
+  bool execCommand(const std::string &cmd, bool asString, CEvalValue &value) override {
+    auto tvalue = tcl_->parseString(cmd);
+
+    if (tcl_->getResultCode() != CTcl::ResultCode::OK)
+      return false;
+
+    toEvalValue(tvalue, asString, value);
+
+    return true;
+  }
+
+  // push result of command operand run by caller (see CEval::start)
+  void pushCommandValue(const CTclValueRef &tvalue, bool asString) {
+    CEvalValue value;
+
+    toEvalValue(tvalue, asString, value);
+
+    pushValue(value);
+  }
+
+  // math functions defined as procs in tcl::mathfunc namespace
+  bool isUserFunction(const std::string &name) override {
+    return getMathFunc(name);
+  }
+
+  bool callUserFunction(const std::string &name, const CEvalValue *args, uint numArgs,
+                        CEvalValue &result) override {
+    auto *proc = getMathFunc(name);
+
+    if (! proc) {
+      tcl_->throwError("unknown math function \"" + name + "\"");
+      return false;
+    }
+
+    std::vector<CTclValueRef> targs;
+
+    for (uint i = 0; i < numArgs; ++i) {
+      if      (args[i].getType() == CEVAL_VALUE_REAL)
+        targs.push_back(tcl_->createValue(args[i].toReal()));
+      else if (args[i].getType() == CEVAL_VALUE_INTEGER)
+        targs.push_back(tcl_->createValue(args[i].toInt()));
+      else if (args[i].getType() == CEVAL_VALUE_BIGINT)
+        targs.push_back(tcl_->createValue(args[i].toString()));
+      else
+        targs.push_back(tcl_->createValue(args[i].getString()));
+    }
+
+    CTclValueRef tvalue;
+
+    (void) tcl_->callProc(proc, targs, tvalue);
+
+    if (tcl_->getResultCode() != CTcl::ResultCode::OK)
+      return false;
+
+    toEvalValue(tvalue, false, result);
+
+    return true;
+  }
+
+ private:
+  CTclProc *getMathFunc(const std::string &name) const {
+    auto *proc = tcl_->getProc("tcl::mathfunc::" + name);
+
+    if (! proc)
+      proc = tcl_->getProc("::tcl::mathfunc::" + name);
+
+    return proc;
+  }
+
+  void toEvalValue(const CTclValueRef &tvalue, bool asString, CEvalValue &value) {
+    if (! tvalue.isValid()) {
+      value = CEvalValue(addString(""));
+      return;
+    }
+
+    if (tvalue->getType() == CTclValue::ValueType::STRING) {
+      const auto *str = static_cast<const CTclString *>(tvalue.get());
+
+      long   i;
+      double r;
+      bool   isReal;
+
+      if      (asString || ! str->getNumber(i, r, isReal))
+        value = CEvalValue(addString(str->getValue()));
+      else if (str->isBigInteger())
+        (void) stringToNumber(str->getValue(), value);
+      else if (isReal)
+        value = CEvalValue(r);
+      else
+        value = CEvalValue(i);
+
+      return;
+    }
+
+    std::string str = tvalue->toString();
+
+    if (asString || ! stringToNumber(str, value))
+      value = CEvalValue(addString(str));
+  }
+
+ private:
+  CTcl *tcl_ { nullptr };
 };
 
 //------
@@ -68,6 +270,10 @@ class CTclTimer : public CTimer {
   void exec() {
     (void) tcl_->parseString(script_);
 
+    tcl_->checkTopLevelCode();
+
+    (void) tcl_->reportError();
+
     delete this;
   }
 
@@ -101,6 +307,24 @@ CTcl(int argc, char **argv)
 
   history_ = new CHistory;
 
+  exprCache_ = new CTclExprCache;
+
+  // stop nested evaluation before stack overflow (keep margin for code run
+  // between checks and error handling)
+  static const ulong stackMargin = 256*1024;
+
+  struct rlimit limit;
+
+  ulong stackSize = 8*1024*1024;
+
+  if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    stackSize = ulong(limit.rlim_cur);
+
+  maxNestStack_ = (stackSize > 2*stackMargin ? stackSize - stackMargin : stackSize/2);
+
+  // seed from system (srand() or setRandomSeed() give reproducible sequence)
+  random_ = new CEvalRandom(std::random_device()());
+
   //------
 
   addCommand(new CTclCommentCommand   (this));
@@ -121,7 +345,7 @@ CTcl(int argc, char **argv)
 //addCommand(new CTclEncodingCommand  (this));
 //addCommand(new CTclEchoCommand      (this));
   addCommand(new CTclEofCommand       (this));
-//addCommand(new CTclErrorCommand     (this));
+  addCommand(new CTclErrorCommand     (this));
   addCommand(new CTclEvalCommand      (this));
   addCommand(new CTclExecCommand      (this));
   addCommand(new CTclExitCommand      (this));
@@ -158,14 +382,17 @@ CTcl(int argc, char **argv)
   addCommand(new CTclLSearchCommand   (this));
   addCommand(new CTclLSetCommand      (this));
   addCommand(new CTclLSortCommand     (this));
+  addCommand(new CTclMemoryCommand    (this));
   addCommand(new CTclNamespaceCommand (this));
   addCommand(new CTclOpenCommand      (this));
   addCommand(new CTclPackageCommand   (this));
 //addCommand(new CTclPArrayCommand    (this));
   addCommand(new CTclPidCommand       (this));
   addCommand(new CTclProcCommand      (this));
+  addCommand(new CTclProfileCommand   (this));
   addCommand(new CTclPutsCommand      (this));
   addCommand(new CTclPwdCommand       (this));
+  addCommand(new CTclRandListCommand  (this));
   addCommand(new CTclReadCommand      (this));
 //addCommand(new CTclRegexpCommand    (this));
 //addCommand(new CTclRenameCommand    (this));
@@ -179,14 +406,17 @@ CTcl(int argc, char **argv)
   addCommand(new CTclStringCommand    (this));
 //addCommand(new CTclSubstCommand     (this));
   addCommand(new CTclSwitchCommand    (this));
+  addCommand(new CTclTailcallCommand  (this));
 //addCommand(new CTclTellCommand      (this));
-//addCommand(new CTclTimeCommand      (this));
-//addCommand(new CTclTraceCommand     (this));
+  addCommand(new CTclTimeCommand      (this));
+  addCommand(new CTclTimerateCommand  (this));
+  addCommand(new CTclTraceCommand     (this));
   addCommand(new CTclUnsetCommand     (this));
   addCommand(new CTclUpdateCommand    (this));
-//addCommand(new CTclUplevelCommand   (this));
-//addCommand(new CTclUpvarCommand     (this));
+  addCommand(new CTclUplevelCommand   (this));
+  addCommand(new CTclUpvarCommand     (this));
   addCommand(new CTclVariableCommand  (this));
+  addCommand(new CTclVExprCommand     (this));
 //addCommand(new CTclVWaitCommand     (this));
   addCommand(new CTclWhileCommand     (this));
 }
@@ -197,11 +427,28 @@ CTcl::
   for (auto &pc : cmds_)
     delete pc.second;
 
-  delete scope_;
+  auto *gscope = scope_;
 
   popScope();
 
+  delete gscope;
+
   delete history_;
+
+  for (auto *eval : evals_)
+    delete eval;
+
+  delete exprCache_;
+
+  delete random_;
+
+  delete profiler_;
+
+  delete sampler_;
+
+  delete traceLog_;
+
+  delete lineProfiler_;
 }
 
 bool
@@ -283,6 +530,18 @@ isCompleteLine1(char endChar)
 bool
 CTcl::
 parseFile(const std::string &filename)
+{
+  bool rc = sourceFile(filename);
+
+  (void) reportError();
+
+  return rc;
+}
+
+// parse file leaving any error in result code (for source command)
+bool
+CTcl::
+sourceFile(const std::string &filename)
 {
   if (! CFile::isRegular(filename)) {
     std::cerr << "Invalid file " << filename << "\n";
@@ -296,28 +555,43 @@ parseFile(const std::string &filename)
   while (! parse_->eof()) {
     std::vector<CTclValueRef> args;
 
-    try {
-      if (! readArgList(args)) {
-        rc = false;
-        break;
-      }
+    setCommandStart();
 
-      auto value = evalArgs(args);
+    if (memorySites_)
+      updateMemorySite();
 
-      if (getDebug() && value.isValid()) {
-        value->print(std::cerr);
-
-        std::cerr << "\n";
-      }
+    if (! readArgList(args)) {
+      rc = false;
+      break;
     }
-    catch (CTclError err) {
-      std::cerr << err.getMsg() << "\n";
+
+    if (lineProfiling_)
+      lineEvent(args);
+
+    auto value = evalArgs(args);
+
+    if (getResultCode() != ResultCode::OK) {
+      // return stops file
+      if (getResultCode() == ResultCode::RETURN)
+        setResultCode(ResultCode::OK);
+
+      checkTopLevelCode();
+
       break;
     }
+
+    if (getDebug() && value.isValid()) {
+      value->print(std::cerr);
+
+      std::cerr << "\n";
+    }
   }
 
   endParse();
 
+  if (memorySites_)
+    updateMemorySite();
+
   return rc;
 }
 
@@ -325,2379 +599,6939 @@ CTclValueRef
 CTcl::
 parseLine(const std::string &str)
 {
-  CTclValueRef value;
+  auto value = parseString(str);
 
-  try {
-    value = parseString(str);
+  checkTopLevelCode();
 
-    addHistory(str);
-  }
-  catch (CTclError err) {
-    std::cerr << err.getMsg() << "\n";
-  }
+  if (reportError())
+    return CTclValueRef();
+
+  addHistory(str);
 
   return value;
 }
 
+// parse string for embedding code : errors are thrown as CTclError
+CTclValueRef
+CTcl::
+evalScript(const std::string &str)
+{
+  auto value = parseString(str);
+
+  checkTopLevelCode();
+
+  if (isError()) {
+    std::string msg = getErrorMsg();
+
+    resetError();
+
+    throw CTclError(msg);
+  }
+
+  return value;
+}
+// run script passing any break, continue or return on to the enclosing command
 CTclValueRef
 CTcl::
 parseString(const std::string &str)
 {
   CTclValueRef value;
 
-  startStringParse(str);
+  auto code = execScript(str, value);
 
-  bool rc = true;
+  if (code != ResultCode::OK && code != ResultCode::ERROR)
+    setResultCode(code);
 
-  while (! parse_->eof()) {
-    std::vector<CTclValueRef> args;
+  return value;
+}
 
-    if (! readArgList(args)) {
-      rc = false;
-      break;
-    }
+// run script returning its completion code. Break, continue and return are
+// taken from the interpreter so the caller acts on a local value; errors are
+// left set so they keep propagating
+CTcl::ResultCode
+CTcl::
+execScript(const std::string &str, CTclValueRef &value)
+{
+  value = CTclValueRef();
 
-    value = evalArgs(args);
+  EvalFrameStack frames;
 
-    if (getDebug() && value.isValid()) {
-      value->print(std::cerr);
+  frames.push_back(EvalFrame());
 
-      std::cerr << "\n";
-    }
+  startStringParse(str);
 
-    if (getBreakFlag() || getContinueFlag() || getReturnFlag())
-      break;
-  }
+  return runFrames(frames, value);
+}
 
-  endParse();
+// call proc with (unparsed) argument values
+CTcl::ResultCode
+CTcl::
+callProc(CTclProc *proc, const std::vector<CTclValueRef> &args, CTclValueRef &value)
+{
+  value = CTclValueRef();
 
-  if (! rc)
-    return CTclValueRef();
+  EvalFrameStack frames;
 
-  return value;
+  if (! pushProcFrame(frames, proc, args))
+    return ResultCode::ERROR;
+
+  return runFrames(frames, value);
 }
 
-bool
+// evaluation trampoline. Procs, the scripts of if/eval/catch/uplevel, the
+// bodies of for/foreach/while and the command operands of expr, both when run
+// as a command and as a command substitution, push a frame onto the heap frame
+// stack and are run by this loop rather than a nested C++ call, so recursion
+// and tailcall depth is only limited by memory
+CTcl::ResultCode
 CTcl::
-readArgList(std::vector<CTclValueRef> &args)
+runFrames(EvalFrameStack &frames, CTclValueRef &value)
 {
-  while (! parse_->eof()) {
-    while (parse_->isChar(' ') || parse_->isChar('\t'))
-      parse_->skipChar();
-
-    if (parse_->eof())
-      return true;
+  // conditions of if/while/for, other script commands etc. still nest on C++
+  // stack
+  char stackPos;
 
-    if      (parse_->isChar(';') || parse_->isChar('\n')) {
-      parse_->skipChar();
+  if (nestDepth_ == 0)
+    stackBase_ = &stackPos;
 
-      return true;
-    }
-    else if (parse_->isChar('[')) {
-      std::vector<CTclValueRef> args1;
+  ulong stackUsed = ulong(stackBase_ > &stackPos ? stackBase_ - &stackPos :
+                                                    &stackPos - stackBase_);
 
-      if (! readExecString(args1))
-        return false;
+  if (nestDepth_ >= maxNestDepth_ || stackUsed >= maxNestStack_) {
+    while (! frames.empty())
+      popFrame(frames);
 
-      auto value = evalArgs(args1);
+    throwError("too many nested evaluations (infinite loop?)");
 
-      if (! value.isValid()) {
-        std::cerr << "Invalid value\n";
-        return false;
-      }
+    return ResultCode::ERROR;
+  }
 
-      args.push_back(value);
-    }
-    else if (parse_->isChar(']')) {
-      return true;
-    }
-    else if (parse_->isChar('{')) {
-      std::string str;
+  ++nestDepth_;
 
-      if (! readLiteralString(str))
-        return false;
+  auto code = ResultCode::OK;
 
-      args.push_back(createValue(str));
-    }
-    else if (parse_->isChar('\"')) {
-      std::string str;
+  Args args, substArgs, pending;
 
-      if (! readDoubleQuotedString(str))
-        return false;
+  bool tailCall = false; // args is tailcall of popped proc
+  bool subst    = false; // args is substituted command of pending command
+  bool resume   = false; // continue reading pending command (args)
+  bool abandon  = false; // end script of top frame (invalid substituted value)
 
-      args.push_back(createValue(str));
-    }
-    else if (parse_->isChar('\'')) {
-      std::string str;
+  // substitute value into pending command and resume reading it
+  auto substValue = [&](Args &pending1) {
+    if (! value.isValid()) {
+      std::cerr << "Invalid value\n";
 
-      if (! readSingleQuotedString(str))
-        return false;
+      abandon = true;
 
-      args.push_back(createValue(str));
+      return;
     }
-    else if (parse_->isChar('$')) {
-      parse_->skipChar();
 
-      std::string varName, indexName;
-      bool        is_array;
+    args.swap(pending1);
 
-      if (! readVariableName(varName, indexName, is_array))
-        return false;
+    args.push_back(value);
 
-      CTclValueRef value;
+    resume = true;
+  };
 
-      if (is_array)
-        value = getArrayVariableValue(varName, indexName);
-      else
-        value = getVariableValue(varName);
+  // pop frame of completed script and complete the command which ran it
+  auto endFrame = [&](ResultCode rc) {
+    auto frame = popFrame(frames);
 
-      if (! value.isValid()) {
-        throwError("can't read \"" + varName + "\": no such variable");
-        return false;
-      }
+    if (frame.type == EvalFrame::Type::CATCH)
+      value = frame.cmd->scriptResult(frame.args, int(rc), value);
 
-      if (parse_->isSpace())
-        args.push_back(value);
-      else {
-        std::string str1 = value->toString();
+    // run pending tailcall in caller's frame
+    if (frame.type == EvalFrame::Type::PROC && ! tailCall_.empty()) {
+      args.swap(tailCall_);
 
-        std::string str2;
+      tailCall_.clear();
 
-        if (! readWord(str2, ';'))
-          return false;
+      tailCall = true;
 
-        args.push_back(createValue(str1 + str2));
-      }
-    }
-    else {
-      std::string str;
+      subst = frame.subst;
 
-      if (! readWord(str, ';'))
-        return false;
+      pending.swap(frame.pending);
 
-      args.push_back(createValue(str));
+      return;
     }
-  }
 
-  return true;
-}
-
-bool
-CTcl::
-readExecString(std::vector<CTclValueRef> &args)
-{
-  assert(parse_->isChar('['));
+    if (frame.subst)
+      substValue(frame.pending);
+  };
 
-  parse_->skipChar();
+  // result of command script of pushed frame is substituted into pending command
+  auto substFrame = [&]() {
+    auto &frame = frames.back();
 
-  parse_->skipSpace();
+    frame.subst = subst;
 
-  while (! parse_->isChar(']')) {
-    if      (parse_->isChar('{')) {
-      std::string str1;
+    frame.pending.swap(pending);
 
-      if (! readLiteralString(str1))
-        return false;
+    subst = false;
+  };
 
-      args.push_back(createValue(str1));
-    }
-    else if (parse_->isChar('\"')) {
-      std::string str1;
+  // run body of next iteration of loop frame or end loop (false on error)
+  auto nextLoop = [&]() {
+    auto &frame = frames.back();
 
-      if (! readDoubleQuotedString(str1))
-        return false;
+    CTclValueRef body;
 
-      args.push_back(createValue(str1));
-    }
-    else if (parse_->isChar('\'')) {
-      std::string str1;
+    if (frame.cmd->loopNext(frame.args, frame.loop, body)) {
+      endParse();
 
-      if (! readSingleQuotedString(str1))
-        return false;
+      startStringParse(body->toString());
 
-      args.push_back(createValue(str1));
+      return true;
     }
-    else {
-      std::string str;
 
-      if (! readWord(str, ']'))
-        return false;
+    if (isError())
+      return false;
 
-      args.push_back(createValue(str));
-    }
+    value = CTclValueRef();
 
-    parse_->skipSpace();
-  }
+    endFrame(ResultCode::OK);
 
-  parse_->skipChar();
+    return true;
+  };
 
-  return true;
-}
+  // run next command operand of expression frame (suspended evaluator) or end
+  // expression (false on error)
+  auto nextExpr = [&](bool rc, bool suspended, const CEvalValue &result) {
+    auto &frame = frames.back();
 
-CTclList *
-CTcl::
-stringToList(const std::string &str)
-{
-  auto *list = new CTclList;
+    if (rc && suspended) {
+      value = CTclValueRef();
 
-  startStringParse(str);
+      endParse();
 
-  while (! parse_->eof()) {
-    while (parse_->isSpace())
-      parse_->skipChar();
+      startStringParse(frame.eval->suspendedInst()->str);
 
-    if (parse_->eof())
-      break;
+      return true;
+    }
 
-    if      (parse_->isChar('{')) {
-      std::string str1;
+    value = evalResult(*frame.eval, frame.expr, rc, result);
 
-      if (! readLiteralString(str1))
-        break;
+    if (isError())
+      return false;
 
-      list->addValue(createValue(str1));
-    }
-    else if (parse_->isChar('\"')) {
-      std::string str1;
+    endFrame(ResultCode::OK);
 
-      if (! readDoubleQuotedString(str1))
-        break;
+    return true;
+  };
 
-      list->addValue(createValue(str1));
-    }
-    else {
-      std::string str1;
+  // end of script of top frame (loop body runs next iteration, command operand
+  // value resumes expression)
+  auto endScript = [&]() {
+    if (frames.back().type == EvalFrame::Type::LOOP)
+      return nextLoop();
 
-      while (! parse_->eof()) {
-        if (parse_->isSpace())
-          break;
+    if (frames.back().type == EvalFrame::Type::EXPR) {
+      auto &frame = frames.back();
 
-        if (parse_->isChar('\\')) {
-          parse_->skipChar();
+      frame.eval->pushCommandValue(value, frame.eval->suspendedInst()->asString);
 
-          char c;
+      CEvalValue result;
+      bool       suspended;
 
-          if (! parse_->readChar(&c)) {
-            std::cerr << "Invalid char after \\\n";
-            break;
-          }
+      bool rc = frame.eval->resume(*frame.program, result, suspended);
 
-          str1 += c;
-        }
-        else {
-          char c;
+      return nextExpr(rc, suspended, result);
+    }
 
-          if (! parse_->readChar(&c)) {
-            std::cerr << "Invalid char\n";
-            break;
-          }
+    endFrame(ResultCode::OK);
 
-          str1 += c;
-        }
-      }
+    return true;
+  };
 
-      list->addValue(createValue(str1));
-    }
-  }
+  // unwind frames to enclosing catch (false if none so error passed to caller)
+  auto catchError = [&]() {
+    subst = false;
 
-  endParse();
+    pending.clear();
 
-  return list;
-}
+    tailCall_.clear();
 
-bool
-CTcl::
-readLiteralString(std::string &str)
-{
-  assert(parse_->isChar('{'));
+    while (! frames.empty() && frames.back().type != EvalFrame::Type::CATCH)
+      popFrame(frames);
 
-  SetSeparator sepSep(this, '\n');
+    if (frames.empty())
+      return false;
 
-  parse_->skipChar();
+    value = createValue(getErrorMsg());
 
-  while (! parse_->eof() && ! parse_->isChar('}')) {
-    if (parse_->isChar('{')) {
-      std::string str1;
+    resetError();
 
-      if (! readLiteralString(str1))
-        return false;
+    endFrame(ResultCode::ERROR);
 
-      str += "{" + str1 + "}";
-    }
-    else {
-      char c;
+    return true;
+  };
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Unterminated string\n";
-        return false;
-      }
+  while (tailCall || ! frames.empty()) {
+    if (! tailCall) {
+      if      (abandon) {
+        abandon = false;
 
-      str += c;
-    }
-  }
+        value = CTclValueRef();
 
-  if (! parse_->isChar('}')) {
-    std::cerr << "Unterminated string\n";
-    return false;
-  }
+        if (endScript())
+          continue;
 
-  parse_->skipChar();
+        if (catchError())
+          continue;
 
-  return true;
-}
+        code = ResultCode::ERROR;
 
-bool
-CTcl::
-readDoubleQuotedString(std::string &str)
-{
-  assert(parse_->isChar('\"'));
+        break;
+      }
+      else if (! resume) {
+        // end of script/proc body (value is value of last command)
+        if (parse_->eof()) {
+          if (endScript())
+            continue;
 
-  parse_->skipChar();
+          if (catchError())
+            continue;
 
-  while (! parse_->isChar('\"')) {
-    if      (parse_->isChar('[')) {
-      std::vector<CTclValueRef> args1;
+          code = ResultCode::ERROR;
 
-      if (! readExecString(args1))
-        return false;
+          break;
+        }
 
-      auto value = evalArgs(args1);
+        args.clear();
 
-      if (! value.isValid()) {
-        std::cerr << "Invalid value\n";
-        return false;
+        setCommandStart();
+
+        if (memorySites_)
+          updateMemorySite();
       }
 
-      str += value->toString();
-    }
-    else if (parse_->isChar('$')) {
-      parse_->skipChar();
+      resume = false;
 
-      std::string varName, indexName;
-      bool        is_array;
+      if (! readArgList(args, &substArgs)) {
+        value = CTclValueRef();
 
-      if (! readVariableName(varName, indexName, is_array))
-        return false;
+        if (! isError() && endScript())
+          continue;
 
-      CTclValueRef value;
+        if (catchError())
+          continue;
 
-      if (is_array)
-        value = getArrayVariableValue(varName, indexName);
-      else
-        value = getVariableValue(varName);
+        code = ResultCode::ERROR;
 
-      if (! value.isValid()) {
-        throwError("can't read \"" + varName + "\": no such variable");
-        return false;
+        break;
       }
 
-      str += value->toString();
-    }
-    else if (parse_->isChar('\\')) {
-      parse_->skipChar();
+      // run substituted command and then resume reading command
+      if (! substArgs.empty()) {
+        pending.swap(args);
 
-      char c;
+        args.swap(substArgs);
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Invalid char after \\\n";
-        return false;
-      }
+        substArgs.clear();
 
-      switch (c) {
-        case 'a': str += '\a'; break;
-        case 'b': str += '\b'; break;
-        case 'f': str += '\f'; break;
-        case 'n': str += '\n'; break;
-        case 'r': str += '\r'; break;
-        case 't': str += '\t'; break;
-        case 'v': str += '\v'; break;
-        default : str += c   ; break;
+        subst = true;
+      }
+      else {
+        if (lineProfiling_)
+          lineEvent(args);
+      }
+    }
 
-        // octal
-        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': {
-          char value = c - '0';
+    tailCall = false;
 
-          int num = 1;
+    std::string name = (! args.empty() ? args[0]->toString() : "");
 
-          while (! parse_->eof()) {
-            if (! parse_->readChar(&c)) {
-              std::cerr << "Invalid octal\n";
-              return false;
-            }
+    auto *cmd  = (! args.empty() && ! isExecTraced(name) ? getCommand(name) : nullptr);
+    auto *proc = (! args.empty() && ! isExecTraced(name) && ! cmd ? getProc(name) : nullptr);
 
-            if (! CStrUtil::isodigit(c)) {
-              parse_->unreadChar();
-              break;
-            }
+    if      (cmd && cmd->hasLoop()) {
+      value = CTclValueRef();
 
-            value = (value << 3) | (c - '0');
+      EvalFrame frame;
 
-            ++num;
+      frame.type = EvalFrame::Type::LOOP;
+      frame.cmd  = cmd;
+      frame.args = Args(args.begin() + 1, args.end());
 
-            if (num == 3) break;
-          }
+      startCommand(cmd, frame.args);
 
-          str += value;
+      bool rc = cmd->loopStart(frame.args, frame.loop);
 
-          break;
-        }
+      endCommand();
 
-        // hex
-        case 'x': {
-          char value = 0;
+      CTclValueRef body;
 
-          while (! parse_->eof()) {
-            if (! parse_->readChar(&c)) {
-              std::cerr << "Invalid hex\n";
-              return false;
-            }
+      if (rc)
+        rc = cmd->loopNext(frame.args, frame.loop, body);
 
-            if (! isxdigit(c)) {
-              parse_->unreadChar();
-              break;
-            }
+      if (isError()) {
+        if (catchError())
+          continue;
 
-            char value1 = 0;
+        code = ResultCode::ERROR;
 
-            if (isdigit(c))
-              value1 = c - '0';
-            else if (islower(c))
-              value1 = c - 'a';
-            else
-              value1 = c - 'A';
+        break;
+      }
 
-            value = (value << 4) | value1;
-          }
+      if (rc) {
+        frames.push_back(std::move(frame));
 
-          str += value;
+        substFrame();
 
-          break;
-        }
+        startStringParse(body->toString());
       }
-    }
-    else {
-      char c;
+      else if (subst) {
+        subst = false;
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Invalid char\n";
-        return false;
+        substValue(pending);
       }
 
-      str += c;
+      continue;
     }
-  }
+    else if (cmd && cmd->hasScript()) {
+      value = CTclValueRef();
 
-  parse_->skipChar();
+      Args args1(args.begin() + 1, args.end());
 
-  return true;
-}
+      startCommand(cmd, args1);
 
-bool
-CTcl::
-readSingleQuotedString(std::string &str)
-{
-  assert(parse_->isChar('\''));
+      CTclValueRef script;
 
-  parse_->skipChar();
+      bool rc = cmd->getScript(args1, script);
 
-  while (! parse_->isChar('\'')) {
-    char c;
+      endCommand();
 
-    if (! parse_->readChar(&c)) {
-      std::cerr << "Unterminated string\n";
-      return false;
-    }
+      if (isError()) {
+        if (catchError())
+          continue;
 
-    str += c;
-  }
+        code = ResultCode::ERROR;
 
-  parse_->skipChar();
+        break;
+      }
 
-  return true;
-}
+      if (rc) {
+        EvalFrame frame;
 
-bool
-CTcl::
-readVariableName(std::string &varName, std::string &indexName, bool &is_array)
-{
-  // ${name} - name can have any characters
-  if (parse_->isChar('{')) {
-    if (! readLiteralString(varName))
-      return false;
-  }
-  // $name - sequence of one or more characters that are a letter, digit,
-  // underscore, or namespace separators (two or more colons)
-  else {
-    while (! parse_->eof()) {
-      char c;
+        switch (cmd->scriptType()) {
+          case CTclCommand::ScriptType::CATCH:
+            frame.type = EvalFrame::Type::CATCH;
+            frame.cmd  = cmd;
+            frame.args = args1;
+            break;
+          case CTclCommand::ScriptType::UPLEVEL:
+            frame.type = EvalFrame::Type::UPLEVEL;
+            break;
+          default:
+            frame.type = EvalFrame::Type::INLINE;
+            break;
+        }
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Missing variable char\n";
-        return false;
+        frames.push_back(std::move(frame));
+
+        substFrame();
+
+        startStringParse(script->toString());
       }
+      else if (subst) {
+        subst = false;
 
-      if (! isalnum(c) && c != '_' && c != ':') {
-        parse_->unreadChar();
-        break;
+        substValue(pending);
       }
 
-      varName += c;
+      continue;
     }
-  }
+    else if (cmd && cmd->hasExpr()) {
+      Args args1(args.begin() + 1, args.end());
 
-  is_array = false;
+      EvalFrame frame;
 
-  // $name(index) - name must contain only letters, digits, underscores, and namespace
-  // separators, and may be an empty string. Command substitutions, variable substitutions,
-  // and backslash substitutions are performed on the characters of index.
-  if (parse_->isChar('(')) {
-    parse_->skipChar();
+      frame.type = EvalFrame::Type::EXPR;
+      frame.eval = pushEval();
+      frame.expr = cmd->getExpr(args1);
 
-    std::string str2;
+      startCommand(cmd, args1);
 
-    int depth = 1;
+      frame.program = exprCache_->getProgram(*frame.eval, frame.expr);
 
-    while (! parse_->eof()) {
-      char c;
+      CEvalValue result;
+      bool       suspended = false;
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Missing variable char\n";
-        return false;
-      }
+      bool rc = (frame.program.isValid() &&
+                 frame.eval->start(*frame.program, result, suspended));
 
-      if      (c == '(')
-        ++depth;
-      else if (c == ')') {
-        --depth;
+      endCommand();
 
-        if (depth == 0) break;
-      }
+      // run command operand in expression frame
+      if (rc && suspended) {
+        value = CTclValueRef();
 
-      str2 += c;
-    }
+        frames.push_back(std::move(frame));
 
-    if (depth != 0) {
-      std::cerr << "Invalid () nesting\n";
-      return false;
-    }
+        substFrame();
 
-    indexName = expandExpr(str2);
+        startStringParse(frames.back().eval->suspendedInst()->str);
 
-    is_array = true;
-  }
+        continue;
+      }
 
-  return true;
-}
+      popEval();
 
-bool
-CTcl::
-readWord(std::string &str, char endChar)
-{
-  assert(! parse_->isSpace());
+      value = evalResult(*frame.eval, frame.expr, rc, result);
 
-  while (! parse_->eof()) {
-    if (parse_->isSpace() || parse_->isChar(endChar))
-      break;
+      if (isError()) {
+        if (catchError())
+          continue;
 
-    if      (parse_->isChar('[')) {
-      std::vector<CTclValueRef> args1;
+        code = ResultCode::ERROR;
 
-      if (! readExecString(args1))
-        return false;
+        break;
+      }
 
-      auto value = evalArgs(args1);
+      if (subst) {
+        subst = false;
 
-      if (! value.isValid()) {
-        std::cerr << "Invalid value\n";
-        return false;
+        substValue(pending);
       }
 
-      str += value->toString();
+      continue;
     }
-    else if (parse_->isChar('$')) {
-      parse_->skipChar();
-
-      std::string varName, indexName;
-      bool        is_array;
+    else if (proc) {
+      value = CTclValueRef();
 
-      if (! readVariableName(varName, indexName, is_array))
-        return false;
+      if (pushProcFrame(frames, proc, Args(args.begin() + 1, args.end()))) {
+        substFrame();
 
-      CTclValueRef value;
+        continue;
+      }
 
-      if (is_array)
-        value = getArrayVariableValue(varName, indexName);
-      else
-        value = getVariableValue(varName);
+      if (catchError())
+        continue;
 
-      if (! value.isValid()) {
-        throwError("can't read \"" + varName + "\": no such variable");
-        return false;
-      }
+      code = ResultCode::ERROR;
 
-      str += value->toString();
+      break;
     }
-    else if (parse_->isChar('\\')) {
-      parse_->skipChar();
 
-      char c;
+    value = evalArgs(args);
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Invalid char after \\\n";
-        return false;
-      }
+    if (getDebug() && value.isValid()) {
+      value->print(std::cerr);
 
-      str += c;
+      std::cerr << "\n";
     }
-    else {
-      char c;
 
-      if (! parse_->readChar(&c)) {
-        std::cerr << "Invalid char\n";
-        return false;
+    auto rc = getResultCode();
+
+    if (rc == ResultCode::OK) {
+      if (subst) {
+        subst = false;
+
+        substValue(pending);
       }
 
-      str += c;
+      continue;
     }
-  }
 
-  return true;
-}
+    if (rc == ResultCode::ERROR) {
+      if (catchError())
+        continue;
 
-std::string
-CTcl::
-expandExpr(const std::string &str)
-{
-  std::string str1;
+      code = rc;
 
-  startStringParse(str);
+      break;
+    }
 
-  while (! parse_->eof()) {
-    char c;
+    // command being substituted into is not run
+    subst = false;
 
-    if (! parse_->readChar(&c))
+    pending.clear();
+
+    // inline script passes code to enclosing frame (return also leaves loops)
+    while (! frames.empty() && (frames.back().type == EvalFrame::Type::INLINE ||
+                                frames.back().type == EvalFrame::Type::UPLEVEL ||
+                                frames.back().type == EvalFrame::Type::EXPR    ||
+                                (frames.back().type == EvalFrame::Type::LOOP &&
+                                 rc == ResultCode::RETURN)))
+      popFrame(frames);
+
+    // command run from tailcall of outermost proc, code belongs to caller
+    if (frames.empty())
       break;
 
-    if (c == '$') {
-      std::string varName, indexName;
-      bool        is_array;
+    setResultCode(ResultCode::OK);
 
-      if (! readVariableName(varName, indexName, is_array))
-        break;
+    // plain script passes code to caller
+    if (frames.back().type == EvalFrame::Type::SCRIPT) {
+      code = rc;
 
-      CTclValueRef value;
+      popFrame(frames);
 
-      if (is_array)
-        value = getArrayVariableValue(varName, indexName);
-      else
-        value = getVariableValue(varName);
+      break;
+    }
 
-      if (! value.isValid()) {
-        throwError("can't read \"" + varName + "\": no such variable");
-        return "";
+    // break ends loop and continue runs next iteration
+    if (frames.back().type == EvalFrame::Type::LOOP) {
+      if (rc == ResultCode::BREAK) {
+        value = CTclValueRef();
+
+        endFrame(ResultCode::OK);
+
+        continue;
       }
 
-      str1 += value->toString();
+      if (nextLoop())
+        continue;
+
+      if (catchError())
+        continue;
+
+      code = ResultCode::ERROR;
+
+      break;
     }
-    else
-      str1 += c;
+
+    // catch or return from proc completes command
+    if (frames.back().type == EvalFrame::Type::CATCH || rc == ResultCode::RETURN) {
+      endFrame(rc);
+
+      continue;
+    }
+
+    popFrame(frames);
+
+    throwError(std::string("invoked \"") +
+               (rc == ResultCode::BREAK ? "break" : "continue") + "\" outside of a loop");
+
+    if (catchError())
+      continue;
+
+    code = ResultCode::ERROR;
+
+    break;
   }
 
-  endParse();
+  // unwind frames left by error
+  while (! frames.empty())
+    popFrame(frames);
 
-  return str1;
-}
+  if (code == ResultCode::ERROR)
+    tailCall_.clear();
 
-void
-CTcl::
-addHistory(const std::string &str)
-{
-  history_->addCommand(str);
-}
+  --nestDepth_;
 
-CTclScope *
-CTcl::
-getNamedScope(const std::string &name, bool create_it)
-{
-  return scope_->getNamedScope(name, create_it);
+  return code;
 }
 
-void
+// traced commands use normal evaluation (see evalArgs)
+bool
 CTcl::
-pushScope(CTclScope *scope)
+isExecTraced(const std::string &name) const
 {
-  scopeStack_.push_back(scope_);
+  if (execTraces_.empty() || inExecTrace_)
+    return false;
 
-  scope_ = scope;
+  return (execTraces_.find(name) != execTraces_.end());
 }
 
-void
+bool
 CTcl::
-popScope()
+pushProcFrame(EvalFrameStack &frames, CTclProc *proc, const std::vector<CTclValueRef> &args)
 {
-  assert(! scopeStack_.empty());
+  if (frameDepth_ >= maxFrameDepth_) {
+    throwError("too many nested evaluations (infinite loop?)");
+    return false;
+  }
 
-  scope_ = scopeStack_.back();
+  auto *scope = proc->bindArgs(args);
 
-  scopeStack_.pop_back();
+  if (! scope)
+    return false;
+
+  pushScope(scope);
+
+  startProc(proc, args);
+
+  EvalFrame frame;
+
+  frame.type  = EvalFrame::Type::PROC;
+  frame.proc  = proc;
+  frame.scope = scope;
+
+  frames.push_back(std::move(frame));
+
+  ++frameDepth_;
+
+  startStringParse(proc->getBody()->toString());
+
+  // body lines are relative to proc definition
+  auto &loc = locStack_.back();
+
+  loc.fileName = proc->getFileName();
+  loc.hasFile  = true;
+  loc.lineNum  = std::max(proc->getLineNum(), 1U);
+
+  return true;
 }
 
-void
+CTcl::EvalFrame
 CTcl::
-unwindScope()
+popFrame(EvalFrameStack &frames)
 {
-  while (! scopeStack_.empty())
+  assert(! frames.empty());
+
+  auto frame = std::move(frames.back());
+
+  frames.pop_back();
+
+  endParse();
+
+  if      (frame.type == EvalFrame::Type::PROC) {
     popScope();
 
-  pushScope(gscope_);
-}
+    delete frame.scope;
 
-void
-CTcl::
-startCommand(CTclCommand *cmd)
-{
-  cmdStack_.push_back(cmd);
+    endProc();
 
-  if (getDebug()) std::cerr << "Start: " << cmdStack_.back()->getName() << "\n";
+    --frameDepth_;
+  }
+  else if (frame.type == EvalFrame::Type::UPLEVEL)
+    endLevel();
+  else if (frame.type == EvalFrame::Type::EXPR)
+    popEval();
+
+  // remaining allocations of enclosing command are from its site
+  if (memorySites_)
+    updateMemorySite();
+
+  return frame;
 }
 
+// break or continue reaching top level (or proc body) is an error
 void
 CTcl::
-endCommand()
+checkTopLevelCode()
 {
-  assert(! cmdStack_.empty());
+  auto code = getResultCode();
 
-  if (getDebug()) std::cerr << "End: " << cmdStack_.back()->getName() << "\n";
+  if      (code == ResultCode::BREAK) {
+    setResultCode(ResultCode::OK);
 
-  cmdStack_.pop_back();
+    throwError("invoked \"break\" outside of a loop");
+  }
+  else if (code == ResultCode::CONTINUE) {
+    setResultCode(ResultCode::OK);
+
+    throwError("invoked \"continue\" outside of a loop");
+  }
+  else if (code == ResultCode::RETURN)
+    setResultCode(ResultCode::OK);
 }
 
-CTclCommand *
+// read command args. If substArgs is given a command substitution word is not
+// evaluated but returned in substArgs (args so far are kept) so the evaluation
+// trampoline can run it and then resume reading with its result appended
+bool
 CTcl::
-getCommand() const
+readArgList(std::vector<CTclValueRef> &args, std::vector<CTclValueRef> *substArgs)
 {
-  if (cmdStack_.empty()) return nullptr;
+  while (! parse_->eof()) {
+    while (parse_->isChar(' ') || parse_->isChar('\t'))
+      parse_->skipChar();
 
-  return cmdStack_.back();
-}
+    if (parse_->eof())
+      return true;
 
-void
-CTcl::
-startProc(CTclProc *proc)
-{
-  procStack_.push_back(proc);
+    if      (parse_->isChar(';') || parse_->isChar('\n')) {
+      parse_->skipChar();
 
-  if (getDebug()) std::cerr << "Start: " << procStack_.back()->getName() << "\n";
-}
+      return true;
+    }
+    else if (parse_->isChar('[')) {
+      std::vector<CTclValueRef> args1;
 
-void
-CTcl::
-endProc()
-{
-  assert(! procStack_.empty());
+      if (! readExecString(args1))
+        return false;
 
-  if (getDebug()) std::cerr << "End: " << procStack_.back()->getName() << "\n";
+      if (substArgs && ! args1.empty()) {
+        *substArgs = args1;
+        return true;
+      }
 
-  procStack_.pop_back();
-}
+      auto value = evalArgs(args1);
 
-CTclProc *
-CTcl::
-getProc() const
-{
-  if (procStack_.empty()) return nullptr;
+      if (isError())
+        return false;
 
-  return procStack_.back();
-}
+      if (! value.isValid()) {
+        std::cerr << "Invalid value\n";
+        return false;
+      }
 
-void
-CTcl::
-addCommand(CTclCommand *command)
-{
-  cmds_[command->getName()] = command;
-}
+      args.push_back(value);
+    }
+    else if (parse_->isChar(']')) {
+      return true;
+    }
+    else if (parse_->isChar('{')) {
+      std::string str;
 
-CTclCommand *
-CTcl::
-getCommand(const std::string &name)
-{
-  auto p = cmds_.find(name);
+      if (! readLiteralString(str))
+        return false;
 
-  if (p == cmds_.end())
-    return nullptr;
+      args.push_back(createValue(str));
+    }
+    else if (parse_->isChar('\"')) {
+      std::string str;
 
-  return (*p).second;
-}
+      if (! readDoubleQuotedString(str))
+        return false;
 
-void
-CTcl::
-getCommandNames(std::vector<std::string> &names) const
-{
-  for (const auto &pc : cmds_)
-    names.push_back(pc.first);
-}
+      args.push_back(createValue(str));
+    }
+    else if (parse_->isChar('\'')) {
+      std::string str;
 
-CTclVariableRef
-CTcl::
-addVariable(const std::string &varName, CTclValueRef value)
-{
-  return getScope()->addVariable(varName, value);
-}
+      if (! readSingleQuotedString(str))
+        return false;
 
-CTclVariableRef
-CTcl::
-addVariable(const std::string &varName, CTclVariableRef var)
-{
-  return getScope()->addVariable(varName, var);
-}
+      args.push_back(createValue(str));
+    }
+    else if (parse_->isChar('$')) {
+      parse_->skipChar();
 
-CTclVariableRef
-CTcl::
-getVariable(const std::string &varName)
-{
-  bool global = false;
+      std::string varName, indexName;
+      bool        is_array;
 
-  std::vector<std::string> names;
+      if (! readVariableName(varName, indexName, is_array))
+        return false;
 
-  uint len = varName.size();
-  uint pos = 0;
+      CTclValueRef value;
 
-  while (pos < len) {
-    if (varName[pos] == ':') {
-      ++pos;
+      if (is_array)
+        value = getArrayVariableValue(varName, indexName);
+      else
+        value = getVariableValue(varName);
 
-      while (pos < len && varName[pos] == ':')
-        ++pos;
+      if (! value.isValid()) {
+        throwError("can't read \"" + varName + "\": no such variable");
+        return false;
+      }
 
-      if (names.empty())
-        global = true;
-    }
+      if (parse_->isSpace())
+        args.push_back(value);
+      else {
+        std::string str1 = value->toString();
 
-    if (pos < len) {
-      std::string name;
+        std::string str2;
 
-      while (pos < len && varName[pos] != ':')
-        name += varName[pos++];
+        if (! readWord(str2, ';'))
+          return false;
 
-      names.push_back(name);
+        args.push_back(createValue(str1 + str2));
+      }
     }
-  }
+    else {
+      std::string str;
 
-  uint num_names = names.size();
+      if (! readWord(str, ';'))
+        return false;
 
-  if (num_names > 1) {
-    auto *scope = getGlobalScope();
+      args.push_back(createValue(str));
+    }
+  }
 
-    for (uint i = 0; i < num_names - 1; ++i) {
-      scope = scope->getNamedScope(names[i]);
+  return true;
+}
 
-      if (scope == nullptr)
-        return CTclVariableRef();
-    }
+bool
+CTcl::
+readExecString(std::vector<CTclValueRef> &args)
+{
+  assert(parse_->isChar('['));
 
-    auto var = scope->getVariable(names[num_names - 1]);
+  parse_->skipChar();
 
-    if (var.isValid())
-      return var;
-  }
-  else {
-    if (global) {
-      auto *scope = getGlobalScope();
+  parse_->skipSpace();
+
+  while (! parse_->isChar(']')) {
+    if      (parse_->isChar('{')) {
+      std::string str1;
 
-      auto var = scope->getVariable(names[0]);
+      if (! readLiteralString(str1))
+        return false;
 
-      if (var.isValid())
-        return var;
+      args.push_back(createValue(str1));
     }
-    else {
-      auto *scope = getScope();
+    else if (parse_->isChar('\"')) {
+      std::string str1;
 
-      while (scope) {
-        auto var = scope->getVariable(varName);
+      if (! readDoubleQuotedString(str1))
+        return false;
+
+      args.push_back(createValue(str1));
+    }
+    else if (parse_->isChar('\'')) {
+      std::string str1;
 
-        if (var.isValid())
-          return var;
+      if (! readSingleQuotedString(str1))
+        return false;
 
-        auto *parentScope = scope->parentScope();
+      args.push_back(createValue(str1));
+    }
+    else {
+      std::string str;
 
-        if (parentScope == nullptr)
-          break;
+      if (! readWord(str, ']'))
+        return false;
 
-        scope = parentScope;
-      }
+      args.push_back(createValue(str));
     }
-  }
 
-  return CTclVariableRef();
-}
+    parse_->skipSpace();
+  }
 
-CTclValueRef
-CTcl::
-getVariableValue(const std::string &varName)
-{
-  auto var = getVariable(varName);
+  parse_->skipChar();
 
-  if (var.isValid())
-    return var->getValue();
-  else
-    return CTclValueRef();
+  return true;
 }
 
-void
+CTclList *
 CTcl::
-setVariableValue(const std::string &varName, CTclValueRef value)
+stringToList(const std::string &str)
 {
-  auto *scope = getScope();
-
-  while (scope) {
-    auto var = scope->getVariable(varName);
+  auto *list = new CTclList;
 
-    if (var.isValid()) {
-      var->setValue(value);
-      return;
-    }
+  startStringParse(str);
 
-    auto *parentScope = scope->parentScope();
+  while (! parse_->eof()) {
+    while (parse_->isSpace())
+      parse_->skipChar();
 
-    if (parentScope == nullptr)
+    if (parse_->eof())
       break;
 
-    scope = parentScope;
-  }
+    if      (parse_->isChar('{')) {
+      std::string str1;
 
-  if (scope)
-    scope->setVariableValue(varName, value);
-}
+      if (! readLiteralString(str1))
+        break;
 
-CTclValueRef
-CTcl::
-getArrayVariableValue(const std::string &varName, const std::string &indexStr)
-{
-  auto var = getVariable(varName);
+      list->addValue(createValue(str1));
+    }
+    else if (parse_->isChar('\"')) {
+      std::string str1;
+
+      if (! readDoubleQuotedString(str1))
+        break;
+
+      list->addValue(createValue(str1));
+    }
+    else {
+      std::string str1;
+
+      while (! parse_->eof()) {
+        if (parse_->isSpace())
+          break;
+
+        if (parse_->isChar('\\')) {
+          parse_->skipChar();
+
+          char c;
+
+          if (! parse_->readChar(&c)) {
+            std::cerr << "Invalid char after \\\n";
+            break;
+          }
+
+          str1 += c;
+        }
+        else {
+          char c;
+
+          if (! parse_->readChar(&c)) {
+            std::cerr << "Invalid char\n";
+            break;
+          }
+
+          str1 += c;
+        }
+      }
+
+      list->addValue(createValue(str1));
+    }
+  }
+
+  endParse();
+
+  return list;
+}
+
+bool
+CTcl::
+readLiteralString(std::string &str)
+{
+  assert(parse_->isChar('{'));
+
+  SetSeparator sepSep(this, '\n');
+
+  parse_->skipChar();
+
+  while (! parse_->eof() && ! parse_->isChar('}')) {
+    if (parse_->isChar('{')) {
+      std::string str1;
+
+      if (! readLiteralString(str1))
+        return false;
+
+      str += "{" + str1 + "}";
+    }
+    else {
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Unterminated string\n";
+        return false;
+      }
+
+      str += c;
+    }
+  }
+
+  if (! parse_->isChar('}')) {
+    std::cerr << "Unterminated string\n";
+    return false;
+  }
+
+  parse_->skipChar();
+
+  return true;
+}
+
+bool
+CTcl::
+readDoubleQuotedString(std::string &str)
+{
+  assert(parse_->isChar('\"'));
+
+  parse_->skipChar();
+
+  while (! parse_->isChar('\"')) {
+    if      (parse_->isChar('[')) {
+      std::vector<CTclValueRef> args1;
+
+      if (! readExecString(args1))
+        return false;
+
+      auto value = evalArgs(args1);
+
+      if (isError())
+        return false;
+
+      if (! value.isValid()) {
+        std::cerr << "Invalid value\n";
+        return false;
+      }
+
+      str += value->toString();
+    }
+    else if (parse_->isChar('$')) {
+      parse_->skipChar();
+
+      std::string varName, indexName;
+      bool        is_array;
+
+      if (! readVariableName(varName, indexName, is_array))
+        return false;
+
+      CTclValueRef value;
+
+      if (is_array)
+        value = getArrayVariableValue(varName, indexName);
+      else
+        value = getVariableValue(varName);
+
+      if (! value.isValid()) {
+        throwError("can't read \"" + varName + "\": no such variable");
+        return false;
+      }
+
+      str += value->toString();
+    }
+    else if (parse_->isChar('\\')) {
+      parse_->skipChar();
+
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Invalid char after \\\n";
+        return false;
+      }
+
+      switch (c) {
+        case 'a': str += '\a'; break;
+        case 'b': str += '\b'; break;
+        case 'f': str += '\f'; break;
+        case 'n': str += '\n'; break;
+        case 'r': str += '\r'; break;
+        case 't': str += '\t'; break;
+        case 'v': str += '\v'; break;
+        default : str += c   ; break;
+
+        // octal
+        case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': {
+          char value = c - '0';
+
+          int num = 1;
+
+          while (! parse_->eof()) {
+            if (! parse_->readChar(&c)) {
+              std::cerr << "Invalid octal\n";
+              return false;
+            }
+
+            if (! CStrUtil::isodigit(c)) {
+              parse_->unreadChar();
+              break;
+            }
+
+            value = (value << 3) | (c - '0');
+
+            ++num;
+
+            if (num == 3) break;
+          }
+
+          str += value;
+
+          break;
+        }
+
+        // hex
+        case 'x': {
+          char value = 0;
+
+          while (! parse_->eof()) {
+            if (! parse_->readChar(&c)) {
+              std::cerr << "Invalid hex\n";
+              return false;
+            }
+
+            if (! isxdigit(c)) {
+              parse_->unreadChar();
+              break;
+            }
+
+            char value1 = 0;
+
+            if (isdigit(c))
+              value1 = c - '0';
+            else if (islower(c))
+              value1 = c - 'a';
+            else
+              value1 = c - 'A';
+
+            value = (value << 4) | value1;
+          }
+
+          str += value;
+
+          break;
+        }
+      }
+    }
+    else {
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Invalid char\n";
+        return false;
+      }
+
+      str += c;
+    }
+  }
+
+  parse_->skipChar();
+
+  return true;
+}
+
+bool
+CTcl::
+readSingleQuotedString(std::string &str)
+{
+  assert(parse_->isChar('\''));
+
+  parse_->skipChar();
+
+  while (! parse_->isChar('\'')) {
+    char c;
+
+    if (! parse_->readChar(&c)) {
+      std::cerr << "Unterminated string\n";
+      return false;
+    }
+
+    str += c;
+  }
+
+  parse_->skipChar();
+
+  return true;
+}
+
+bool
+CTcl::
+readVariableName(std::string &varName, std::string &indexName, bool &is_array)
+{
+  // ${name} - name can have any characters
+  if (parse_->isChar('{')) {
+    if (! readLiteralString(varName))
+      return false;
+  }
+  // $name - sequence of one or more characters that are a letter, digit,
+  // underscore, or namespace separators (two or more colons)
+  else {
+    while (! parse_->eof()) {
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Missing variable char\n";
+        return false;
+      }
+
+      if (! isalnum(c) && c != '_' && c != ':') {
+        parse_->unreadChar();
+        break;
+      }
+
+      varName += c;
+    }
+  }
+
+  is_array = false;
+
+  // $name(index) - name must contain only letters, digits, underscores, and namespace
+  // separators, and may be an empty string. Command substitutions, variable substitutions,
+  // and backslash substitutions are performed on the characters of index.
+  if (parse_->isChar('(')) {
+    parse_->skipChar();
+
+    std::string str2;
+
+    int depth = 1;
+
+    while (! parse_->eof()) {
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Missing variable char\n";
+        return false;
+      }
+
+      if      (c == '(')
+        ++depth;
+      else if (c == ')') {
+        --depth;
+
+        if (depth == 0) break;
+      }
+
+      str2 += c;
+    }
+
+    if (depth != 0) {
+      std::cerr << "Invalid () nesting\n";
+      return false;
+    }
+
+    indexName = expandExpr(str2);
+
+    is_array = true;
+  }
+
+  return true;
+}
+
+bool
+CTcl::
+readWord(std::string &str, char endChar)
+{
+  assert(! parse_->isSpace());
+
+  while (! parse_->eof()) {
+    if (parse_->isSpace() || parse_->isChar(endChar))
+      break;
+
+    if      (parse_->isChar('[')) {
+      std::vector<CTclValueRef> args1;
+
+      if (! readExecString(args1))
+        return false;
+
+      auto value = evalArgs(args1);
+
+      if (isError())
+        return false;
+
+      if (! value.isValid()) {
+        std::cerr << "Invalid value\n";
+        return false;
+      }
+
+      str += value->toString();
+    }
+    else if (parse_->isChar('$')) {
+      parse_->skipChar();
+
+      std::string varName, indexName;
+      bool        is_array;
+
+      if (! readVariableName(varName, indexName, is_array))
+        return false;
+
+      CTclValueRef value;
+
+      if (is_array)
+        value = getArrayVariableValue(varName, indexName);
+      else
+        value = getVariableValue(varName);
+
+      if (! value.isValid()) {
+        throwError("can't read \"" + varName + "\": no such variable");
+        return false;
+      }
+
+      str += value->toString();
+    }
+    else if (parse_->isChar('\\')) {
+      parse_->skipChar();
+
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Invalid char after \\\n";
+        return false;
+      }
+
+      str += c;
+    }
+    else {
+      char c;
+
+      if (! parse_->readChar(&c)) {
+        std::cerr << "Invalid char\n";
+        return false;
+      }
+
+      str += c;
+    }
+  }
+
+  return true;
+}
+
+std::string
+CTcl::
+expandExpr(const std::string &str)
+{
+  std::string str1;
+
+  startStringParse(str);
+
+  while (! parse_->eof()) {
+    char c;
+
+    if (! parse_->readChar(&c))
+      break;
+
+    if (c == '$') {
+      std::string varName, indexName;
+      bool        is_array;
+
+      if (! readVariableName(varName, indexName, is_array))
+        break;
+
+      CTclValueRef value;
+
+      if (is_array)
+        value = getArrayVariableValue(varName, indexName);
+      else
+        value = getVariableValue(varName);
+
+      if (! value.isValid()) {
+        throwError("can't read \"" + varName + "\": no such variable");
+        return "";
+      }
+
+      str1 += value->toString();
+    }
+    else
+      str1 += c;
+  }
+
+  endParse();
+
+  return str1;
+}
+
+void
+CTcl::
+addHistory(const std::string &str)
+{
+  history_->addCommand(str);
+}
+
+// get namespace scope of (possibly qualified) name. Absolute names start at the
+// global scope and relative names at the current scope
+CTclScope *
+CTcl::
+getNamedScope(const std::string &name, bool create_it)
+{
+  auto *scope = (name.compare(0, 2, "::") == 0 ? getGlobalScope() : scope_);
+
+  uint len = name.size();
+  uint pos = 0;
+
+  while (pos < len) {
+    while (pos < len && name[pos] == ':')
+      ++pos;
+
+    if (pos >= len)
+      break;
+
+    uint start = pos;
+
+    while (pos < len && name[pos] != ':')
+      ++pos;
+
+    scope = scope->getNamedScope(name.substr(start, pos - start), create_it);
+
+    if (! scope)
+      return nullptr;
+  }
+
+  return scope;
+}
+
+// namespace created or deleted so cached qualified names are invalid
+void
+CTcl::
+namespacesChanged()
+{
+  qualifiedMap_.clear();
+}
+
+void
+CTcl::
+pushScope(CTclScope *scope)
+{
+  scope->ref();
+
+  scopeStack_.push_back(scope_);
+
+  scope_ = scope;
+}
+
+void
+CTcl::
+popScope()
+{
+  assert(! scopeStack_.empty());
+
+  auto *scope = scope_;
+
+  scope_ = scopeStack_.back();
+
+  scopeStack_.pop_back();
+
+  scope->unref();
+}
+
+void
+CTcl::
+unwindScope()
+{
+  while (! scopeStack_.empty())
+    popScope();
+
+  levelStack_.clear();
+
+  pushScope(gscope_);
+}
+
+// current call frame level (0 is global)
+uint
+CTcl::
+getLevel() const
+{
+  assert(! scopeStack_.empty());
+
+  return uint(scopeStack_.size() - 1);
+}
+
+// parse level string : #n is absolute, n is relative to current level
+bool
+CTcl::
+parseLevel(const std::string &str, uint &level) const
+{
+  if (str.empty())
+    return false;
+
+  long l;
+
+  if (str[0] == '#') {
+    if (! CTclNumber::toInteger(str.substr(1), l))
+      return false;
+  }
+  else {
+    if (! isdigit(str[0]) || ! CTclNumber::toInteger(str, l))
+      return false;
+
+    l = long(getLevel()) - l;
+  }
+
+  if (l < 0 || l > long(getLevel()))
+    return false;
+
+  level = uint(l);
+
+  return true;
+}
+
+CTclScope *
+CTcl::
+getLevelScope(uint level) const
+{
+  assert(level <= getLevel());
+
+  if (level == getLevel())
+    return scope_;
+
+  // scope stack starts with null scope before global
+  return scopeStack_[level + 1];
+}
+
+// make scope at level current, hiding (but saving) the frames above it
+void
+CTcl::
+startLevel(uint level)
+{
+  assert(level <= getLevel());
+
+  ScopeStack frames;
+
+  for (uint i = level + 1; i < scopeStack_.size(); ++i)
+    frames.push_back(scopeStack_[i]);
+
+  frames.push_back(scope_);
+
+  scopeStack_.resize(level + 1);
+
+  scope_ = frames.front();
+
+  levelStack_.push_back(frames);
+}
+
+void
+CTcl::
+endLevel()
+{
+  assert(! levelStack_.empty());
+
+  ScopeStack frames = levelStack_.back();
+
+  levelStack_.pop_back();
+
+  uint numFrames = uint(frames.size());
+
+  for (uint i = 0; i < numFrames - 1; ++i)
+    scopeStack_.push_back(frames[i]);
+
+  scope_ = frames[numFrames - 1];
+}
+
+void
+CTcl::
+startCommand(CTclCommand *cmd, const std::vector<CTclValueRef> &args)
+{
+  if (sampling_ && CTclSampler::isPending())
+    takeSample();
+
+  cmdStack_.push_back(cmd);
+
+  ++cmdCount_;
+
+  if (profiling_)
+    profiler_->startCall(cmd->getName(), CTclProfiler::CallType::COMMAND);
+
+  if (tracing_)
+    traceLog_->begin(cmd->getName(), "command", args);
+
+  if (getDebug()) std::cerr << "Start: " << cmdStack_.back()->getName() << "\n";
+}
+
+void
+CTcl::
+endCommand()
+{
+  assert(! cmdStack_.empty());
+
+  if (getDebug()) std::cerr << "End: " << cmdStack_.back()->getName() << "\n";
+
+  if (profiling_)
+    profiler_->endCall();
+
+  if (tracing_)
+    traceLog_->end();
+
+  if (sampling_ && CTclSampler::isPending())
+    takeSample();
+
+  cmdStack_.pop_back();
+}
+
+CTclCommand *
+CTcl::
+getCommand() const
+{
+  if (cmdStack_.empty()) return nullptr;
+
+  return cmdStack_.back();
+}
+
+void
+CTcl::
+startProc(CTclProc *proc, const std::vector<CTclValueRef> &args)
+{
+  if (sampling_ && CTclSampler::isPending())
+    takeSample();
+
+  procStack_.push_back(proc);
+
+  ++cmdCount_;
+
+  if (profiling_)
+    profiler_->startCall(proc->getName(), CTclProfiler::CallType::PROC);
+
+  if (tracing_)
+    traceLog_->begin(proc->getName(), "proc", args);
+
+  if (getDebug()) std::cerr << "Start: " << procStack_.back()->getName() << "\n";
+}
+
+void
+CTcl::
+endProc()
+{
+  assert(! procStack_.empty());
+
+  if (getDebug()) std::cerr << "End: " << procStack_.back()->getName() << "\n";
+
+  if (profiling_)
+    profiler_->endCall();
+
+  if (tracing_)
+    traceLog_->end();
+
+  if (sampling_ && CTclSampler::isPending())
+    takeSample();
+
+  procStack_.pop_back();
+}
+
+CTclProc *
+CTcl::
+getProc() const
+{
+  if (procStack_.empty()) return nullptr;
+
+  return procStack_.back();
+}
+
+void
+CTcl::
+startProfile()
+{
+  if (! profiler_)
+    profiler_ = new CTclProfiler;
+
+  profiler_->clearCalls();
+
+  profiling_ = true;
+}
+
+void
+CTcl::
+stopProfile()
+{
+  if (profiler_)
+    profiler_->clearCalls();
+
+  profiling_ = false;
+}
+
+bool
+CTcl::
+startSampling(uint hz)
+{
+  if (! sampler_)
+    sampler_ = new CTclSampler;
+
+  if (! sampler_->start(hz))
+    return false;
+
+  sampling_ = true;
+
+  return true;
+}
+
+void
+CTcl::
+stopSampling()
+{
+  if (sampler_)
+    sampler_->stop();
+
+  sampling_ = false;
+}
+
+void
+CTcl::
+startTraceLog()
+{
+  if (! traceLog_)
+    traceLog_ = new CTclTraceLog;
+
+  traceLog_->clearCalls();
+
+  tracing_ = true;
+}
+
+void
+CTcl::
+stopTraceLog()
+{
+  if (traceLog_)
+    traceLog_->clearCalls();
+
+  tracing_ = false;
+}
+
+void
+CTcl::
+startLineProfile()
+{
+  if (! lineProfiler_)
+    lineProfiler_ = new CTclLineProfiler;
+
+  lineProfiling_ = true;
+}
+
+void
+CTcl::
+stopLineProfile()
+{
+  if (lineProfiler_)
+    lineProfiler_->flush();
+
+  lineProfiling_ = false;
+}
+
+// record current call stack (procs, outermost first, then current command)
+void
+CTcl::
+takeSample()
+{
+  std::string stack;
+
+  for (const auto *proc : procStack_) {
+    if (! stack.empty()) stack += ";";
+
+    stack += proc->getName();
+  }
+
+  if (! cmdStack_.empty()) {
+    if (! stack.empty()) stack += ";";
+
+    stack += cmdStack_.back()->getName();
+  }
+
+  if (stack.empty())
+    stack = "<toplevel>";
+
+  sampler_->sample(stack);
+}
+
+void
+CTcl::
+addCommand(CTclCommand *command)
+{
+  cmds_[command->getName()] = command;
+}
+
+CTclCommand *
+CTcl::
+getCommand(const std::string &name)
+{
+  auto p = cmds_.find(name);
+
+  if (p == cmds_.end())
+    return nullptr;
+
+  return (*p).second;
+}
+
+void
+CTcl::
+getCommandNames(std::vector<std::string> &names) const
+{
+  for (const auto &pc : cmds_)
+    names.push_back(pc.first);
+}
+
+CTclVariableRef
+CTcl::
+addVariable(const std::string &varName, CTclValueRef value)
+{
+  return getScope()->addVariable(varName, value);
+}
+
+CTclVariableRef
+CTcl::
+addVariable(const std::string &varName, CTclVariableRef var)
+{
+  return getScope()->addVariable(varName, var);
+}
+
+CTclVariableRef
+CTcl::
+getVariable(const std::string &varName)
+{
+  if (varName.find(':') != std::string::npos) {
+    const auto &qname = resolveQualifiedName(varName);
+
+    if (! qname.local) {
+      if (! qname.scope)
+        return CTclVariableRef();
+
+      return qname.scope->getVariable(qname.name);
+    }
+  }
+
+  auto *scope = getScope();
+
+  while (scope) {
+    auto var = scope->getVariable(varName);
+
+    if (var.isValid())
+      return var;
+
+    auto *parentScope = scope->parentScope();
+
+    if (parentScope == nullptr)
+      break;
+
+    scope = parentScope;
+  }
+
+  return CTclVariableRef();
+}
+
+// parse qualified name into namespace scope and name (cached until namespaces change)
+const CTcl::QualifiedName &
+CTcl::
+resolveQualifiedName(const std::string &varName)
+{
+  auto p = qualifiedMap_.find(varName);
+
+  if (p != qualifiedMap_.end())
+    return (*p).second;
+
+  QualifiedName qname;
+
+  bool global = false;
+
+  std::vector<std::string> names;
+
+  uint len = varName.size();
+  uint pos = 0;
+
+  while (pos < len) {
+    if (varName[pos] == ':') {
+      ++pos;
+
+      while (pos < len && varName[pos] == ':')
+        ++pos;
+
+      if (names.empty())
+        global = true;
+    }
+
+    if (pos < len) {
+      std::string name;
+
+      while (pos < len && varName[pos] != ':')
+        name += varName[pos++];
+
+      names.push_back(name);
+    }
+  }
+
+  uint num_names = names.size();
+
+  if      (num_names > 1) {
+    auto *scope = getGlobalScope();
+
+    for (uint i = 0; i < num_names - 1; ++i) {
+      scope = scope->getNamedScope(names[i]);
+
+      if (scope == nullptr)
+        break;
+    }
+
+    qname.scope = scope;
+    qname.name  = names[num_names - 1];
+  }
+  else if (num_names == 1 && global) {
+    qname.scope = getGlobalScope();
+    qname.name  = names[0];
+  }
+  else
+    qname.local = true;
+
+  if (qualifiedMap_.size() >= MAX_QUALIFIED_NAMES)
+    qualifiedMap_.clear();
+
+  auto p1 = qualifiedMap_.insert(QualifiedMap::value_type(varName, qname));
+
+  return (*p1.first).second;
+}
+
+CTclValueRef
+CTcl::
+getVariableValue(const std::string &varName)
+{
+  auto var = getVariable(varName);
+
+  if (var.isValid())
+    return var->getValue();
+  else
+    return CTclValueRef();
+}
+
+void
+CTcl::
+setVariableValue(const std::string &varName, CTclValueRef value)
+{
+  if (varName.find(':') != std::string::npos) {
+    const auto &qname = resolveQualifiedName(varName);
+
+    if (! qname.local) {
+      if (! qname.scope) {
+        throwError("can't set \"" + varName + "\": parent namespace doesn't exist");
+        return;
+      }
+
+      qname.scope->setVariableValue(qname.name, value);
+
+      return;
+    }
+  }
+
+  auto *scope = getScope();
+
+  while (scope) {
+    auto var = scope->getVariable(varName);
+
+    if (var.isValid()) {
+      var->setValue(value);
+      return;
+    }
+
+    auto *parentScope = scope->parentScope();
+
+    if (parentScope == nullptr)
+      break;
+
+    scope = parentScope;
+  }
+
+  if (scope)
+    scope->setVariableValue(varName, value);
+}
+
+CTclValueRef
+CTcl::
+getArrayVariableValue(const std::string &varName, const std::string &indexStr)
+{
+  auto var = getVariable(varName);
+
+  if (var.isValid())
+    return var->getArrayValue(indexStr);
+  else
+    return CTclValueRef();
+}
+
+void
+CTcl::
+setArrayVariableValue(const std::string &varName, const std::string &indexStr, CTclValueRef value)
+{
+  auto var = getVariable(varName);
+
+  if (! var.isValid()) {
+    auto *array = new CTclArray;
+
+    array->setValue(indexStr, value);
+
+    setVariableValue(varName, CTclValueRef(array));
+  }
+  else
+    return var->setArrayValue(indexStr, value);
+}
+
+// remove variable or array element (name(index))
+void
+CTcl::
+removeVariable(const std::string &varName)
+{
+  auto len = varName.size();
+  auto pos = varName.find('(');
+
+  if (pos != std::string::npos && pos > 0 && varName[len - 1] == ')') {
+    auto var = getVariable(varName.substr(0, pos));
+
+    if (var.isValid())
+      var->removeArrayValue(varName.substr(pos + 1, len - pos - 2));
+
+    return;
+  }
+
+  getScope()->removeVariable(varName);
+}
+
+CTclProc *
+CTcl::
+defineProc(const std::string &name, const std::vector<std::string> &args, CTclValueRef body)
+{
+  return getScope()->defineProc(name, args, body);
+}
+
+CTclProc *
+CTcl::
+getProc(const std::string &name)
+{
+  auto *scope = getScope();
+
+  while (scope) {
+    auto *proc = scope->getProc(name);
+
+    if (proc) return proc;
+
+    scope = scope->parentScope();
+  }
+
+  return nullptr;
+}
+
+std::string
+CTcl::
+openFile(const std::string &fileName, const std::string &mode)
+{
+  FILE *fp = fopen(fileName.c_str(), mode.c_str());
+
+  if (fp == nullptr) {
+    if      (errno == ENOENT)
+      throwError("File does not exist");
+    else if (errno == EACCES)
+      throwError("No read permission for file");
+    else
+      throwError("Open Failed");
+
+    return "";
+  }
+
+  int num = fileno(fp);
+
+  std::string handle = "file" + CStrUtil::toString(num);
+
+  fileMap_[handle] = fp;
+
+  return handle;
+}
+
+void
+CTcl::
+closeFile(const std::string &handle)
+{
+  auto p = fileMap_.find(handle);
+
+  if (p == fileMap_.end())
+    return;
+
+  fclose((*p).second);
+
+  fileMap_.erase(p);
+}
+
+void
+CTcl::
+writeToFile(const std::string &handle, const std::string &str)
+{
+  auto p = fileMap_.find(handle);
+
+  if (p == fileMap_.end())
+    return;
+
+  fwrite(str.c_str(), 1, str.size(), (*p).second);
+}
+
+FILE *
+CTcl::
+getFile(const std::string &handle)
+{
+  auto p = fileMap_.find(handle);
+
+  if (p == fileMap_.end())
+    return nullptr;
+
+  return (*p).second;
+}
+
+std::string
+CTcl::
+addTimer(int ms, const std::string &script)
+{
+  auto *timer = new CTclTimer(this, ms, script);
+
+  return timer->getName();
+}
+
+bool
+CTcl::
+cancelTimer(const std::string &id)
+{
+  auto p = timerMap_.find(id);
+
+  if (p == timerMap_.end())
+    return false;
+
+  delete (*p).second;
+
+  return true;
+}
+
+void
+CTcl::
+insertTimer(CTclTimer *timer)
+{
+  std::string name = timer->getName();
+
+  timerMap_[name] = timer;
+}
+
+void
+CTcl::
+clearTimer(CTclTimer *timer)
+{
+  std::string name = timer->getName();
+
+  auto p = timerMap_.find(name);
+
+  if (p != timerMap_.end())
+    timerMap_.erase(p);
+}
+
+void
+CTcl::
+getTimerNames(std::vector<std::string> &names)
+{
+  for (const auto &pt : timerMap_)
+    names.push_back(pt.first);
+}
+
+CTclTimer *
+CTcl::
+getTimer(const std::string &id)
+{
+  auto p = timerMap_.find(id);
+
+  if (p == timerMap_.end())
+    return nullptr;
+
+  return (*p).second;
+}
+
+void
+CTcl::
+update(bool /*idletasks*/)
+{
+  std::vector<CTclTimer *> timers;
+
+  for (const auto &pt : timerMap_) {
+    auto *timer = pt.second;
+
+    if (timer->isTriggered())
+      timers.push_back(timer);
+  }
+
+  uint num_timers = timers.size();
+
+  for (uint i = 0; i < num_timers; ++i)
+    timers[i]->exec();
+}
+
+CTclValueRef
+CTcl::
+createValue(long value) const
+{
+  return CTclValueRef(new CTclString(CTclNumber::toString(value)));
+}
+
+CTclValueRef
+CTcl::
+createValue(ulong value) const
+{
+  return CTclValueRef(new CTclString(CTclNumber::toString(value)));
+}
+
+CTclValueRef
+CTcl::
+createValue(double value) const
+{
+  return CTclValueRef(new CTclString(CTclNumber::toString(value)));
+}
+
+CTclValueRef
+CTcl::
+createValue(const std::string &str) const
+{
+  return CTclValueRef(new CTclString(str));
+}
+
+CTclValueRef
+CTcl::
+createValue(const std::vector<std::string> &strs) const
+{
+  auto *list = new CTclList;
+
+  uint numStrs = strs.size();
+
+  for (uint i = 0; i < numStrs; ++i)
+    list->addValue(createValue(strs[i]));
+
+  return CTclValueRef(list);
+}
+
+CTclValueRef
+CTcl::
+createValue(const std::vector<CTclValueRef> &values) const
+{
+  auto *list = new CTclList;
+
+  uint numValues = values.size();
+
+  for (uint i = 0; i < numValues; ++i)
+    list->addValue(values[i]);
+
+  return CTclValueRef(list);
+}
+
+void
+CTcl::
+setRandomSeed(ulong seed)
+{
+  random_->setSeed(seed);
+}
+
+CTclValueRef
+CTcl::
+evalString(const std::string &str)
+{
+  auto &eval = *pushEval();
+
+  auto program = exprCache_->getProgram(eval, str);
+
+  CEvalValue result;
+
+  bool rc = (program.isValid() && eval.run(*program, result));
+
+  popEval();
+
+  return evalResult(eval, str, rc, result);
+}
+
+// reuse evaluator (and its buffers) of this nesting level. Command operands
+// can evaluate nested expressions so each level has its own
+CTclEval *
+CTcl::
+pushEval()
+{
+  if (evalDepth_ >= evals_.size())
+    evals_.push_back(new CTclEval(this));
+
+  return evals_[evalDepth_++];
+}
+
+void
+CTcl::
+popEval()
+{
+  assert(evalDepth_ > 0);
+
+  --evalDepth_;
+
+  if (evalDepth_ == 0 && evals_.size() > MAX_EVALS) {
+    for (uint i = MAX_EVALS; i < evals_.size(); ++i)
+      delete evals_[i];
+
+    evals_.resize(MAX_EVALS);
+  }
+}
+
+// value of evaluated expression (or error)
+CTclValueRef
+CTcl::
+evalResult(CTclEval &eval, const std::string &str, bool rc, const CEvalValue &result)
+{
+  if (! rc) {
+    if (getResultCode() == ResultCode::OK) {
+      if (eval.getErrorMsg() != "")
+        throwError(eval.getErrorMsg());
+      else
+        throwError("error in expression \"" + str + "\"");
+    }
+
+    return CTclValueRef();
+  }
+
+  if (result.isString())
+    return CTclValueRef(new CTclString(result.getString()));
+
+  // result keeps type : integers are exact and reals always have a decimal
+  // point or exponent
+  if (result.getType() == CEVAL_VALUE_BIGINT)
+    return CTclValueRef(new CTclString(result.toString()));
+
+  if (result.getType() == CEVAL_VALUE_INTEGER)
+    return CTclValueRef(new CTclString(CTclNumber::toString(result.toInt())));
+
+  return CTclValueRef(new CTclString(CTclNumber::toString(result.toReal())));
+}
+
+CTclValueRef
+CTcl::
+evalArgs(const std::vector<CTclValueRef> &args)
+{
+  if (! execTraces_.empty() && ! inExecTrace_ && ! args.empty()) {
+    auto p = execTraces_.find(args[0]->toString());
+
+    if (p != execTraces_.end())
+      return evalTracedArgs(args, (*p).second);
+  }
+
+  return evalArgs1(args);
+}
+
+CTclValueRef
+CTcl::
+evalTracedArgs(const std::vector<CTclValueRef> &args, const ExecTraceList &traces)
+{
+  auto cmdStr = CTclList(args).toString();
+
+  // copy traces as callbacks may change them
+  ExecTraceList traces1 = traces;
+
+  auto callTraces = [&](ExecTraceOp op, const std::vector<CTclValueRef> &values) {
+    for (const auto &trace : traces1) {
+      if (! (trace.ops & uint(op)) || isError())
+        continue;
+
+      inExecTrace_ = true;
+
+      CTclValueRef value;
+
+      (void) execScript(trace.command + " " + CTclList(values).toString(), value);
+
+      inExecTrace_ = false;
+    }
+  };
+
+  callTraces(ExecTraceOp::ENTER, { createValue(cmdStr), createValue("enter") });
+
+  if (isError()) return CTclValueRef();
+
+  auto value = evalArgs1(args);
+
+  // keep pending error or break/continue/return of command while leave traces
+  // run (an error result is the error message)
+  auto code = getResultCode();
+
+  std::string errorMsg;
+
+  if (code == ResultCode::ERROR) {
+    errorMsg = getErrorMsg();
+
+    resetError();
+  }
+
+  auto result = (code == ResultCode::ERROR ? createValue(errorMsg) :
+                 (value.isValid() ? value : createValue("")));
+
+  setResultCode(ResultCode::OK);
+
+  callTraces(ExecTraceOp::LEAVE,
+             { createValue(cmdStr), createValue(long(code)), result, createValue("leave") });
+
+  // error in leave trace replaces result of command
+  if (isError())
+    return CTclValueRef();
+
+  if (code == ResultCode::ERROR) {
+    throwError(errorMsg);
+
+    return value;
+  }
+
+  setResultCode(code);
+
+  return value;
+}
+
+void
+CTcl::
+addExecTrace(const std::string &name, uint ops, const std::string &command)
+{
+  ExecTrace trace;
+
+  trace.ops     = ops;
+  trace.command = command;
+
+  execTraces_[name].push_back(trace);
+}
+
+bool
+CTcl::
+removeExecTrace(const std::string &name, uint ops, const std::string &command)
+{
+  auto p = execTraces_.find(name);
+
+  if (p == execTraces_.end())
+    return false;
+
+  auto &traces = (*p).second;
+
+  auto pt = std::find_if(traces.begin(), traces.end(), [&](const ExecTrace &trace) {
+    return (trace.ops == ops && trace.command == command);
+  });
+
+  if (pt == traces.end())
+    return false;
+
+  traces.erase(pt);
+
+  if (traces.empty())
+    execTraces_.erase(p);
+
+  return true;
+}
+
+void
+CTcl::
+getExecTraces(const std::string &name, ExecTraceList &traces) const
+{
+  auto p = execTraces_.find(name);
+
+  if (p != execTraces_.end())
+    traces = (*p).second;
+}
+
+CTclValueRef
+CTcl::
+evalArgs1(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs == 0) return CTclValueRef();
+
+  std::string name = args[0]->toString();
+
+  auto *cmd = getCommand(name);
+
+  if (cmd) {
+    std::vector<CTclValueRef> args1;
+
+    if (getDebug())
+      std::cerr << "Exec:" << name;
+
+    for (uint i = 1; i < numArgs; ++i) {
+      if (getDebug())
+        std::cerr << " " << args[i];
+
+      args1.push_back(args[i]);
+    }
+
+    if (getDebug())
+      std::cerr << "\n";
+
+    startCommand(cmd, args1);
+
+    auto ret = cmd->exec(args1);
+
+    endCommand();
+
+    return ret;
+  }
+  else {
+    auto *proc = getProc(name);
+
+    if (proc) {
+      std::vector<CTclValueRef> args1;
+
+      for (uint i = 1; i < numArgs; ++i)
+        args1.push_back(args[i]);
+
+      return proc->exec(args1);
+    }
+
+    //-------
+
+    std::vector<CCommand *> cmds;
+
+    bool ignore_arg = false;
+
+    std::string path = lookupPathCommand(name);
+
+    if (path == "") {
+      throwError("invalid command name \"" + name + "\"");
+      return CTclValueRef();
+    }
+
+    auto *command = new CCommand(name, path);
+
+    cmds.push_back(command);
+
+//CCommandMgrInst->setDebug(true);
+
+    for (uint i = 1; i < numArgs; ++i) {
+      std::string arg = args[i]->toString();
+
+      if (ignore_arg) {
+        command->addArg(arg);
+
+        continue;
+      }
+
+      if      (arg == "--") {
+        ignore_arg = true;
+      }
+      else if (arg == "|" || arg == "|&") {
+        if (i >= numArgs - 1) {
+          throwError("illegal use of | or |& in command");
+          return CTclValueRef();
+        }
+
+        ignore_arg = false;
+
+        ++i;
+
+        command->addPipeDest(1);
+
+        if (arg == "|&")
+          command->addPipeDest(2);
+
+        name = args[i]->toString();
+        path = lookupPathCommand(name);
+
+        if (path == "") {
+          throwError("couldn't execute \"" + name + "\" no such file or directory");
+          return CTclValueRef();
+        }
+
+        command = new CCommand(name, path);
+
+        cmds.push_back(command);
+
+        command->addPipeSrc();
+      }
+      else if (arg == "<") {
+        if (i >= numArgs - 1) {
+          throwError("can't specify \"" + arg + "\" as last word in command");
+          return CTclValueRef();
+        }
+
+        ++i;
+
+        const std::string &src = args[i]->toString();
+
+        command->addFileSrc(src);
+      }
+      else if (arg == "<@") {
+        if (i >= numArgs - 1) {
+          throwError("can't specify \"" + arg + "\" as last word in command");
+          return CTclValueRef();
+        }
+
+        ++i;
+
+        const std::string &fileId = args[i]->toString();
+
+        FILE *fp = nullptr;
+
+        if (fileId == "stdin")
+          fp = stdin;
+        else {
+          fp = getFile(fileId);
+
+          if (fp == nullptr) {
+            throwError("can not find channel named \"" + fileId + "\"");
+            return CTclValueRef();
+          }
+        }
+
+        command->addFileSrc(fp);
+      }
+      else if (arg == "<<") {
+      }
+      else if (arg == ">" || arg == ">&") {
+        if (i >= numArgs - 1) {
+          throwError("can't specify \"" + arg + "\" as last word in command");
+          return CTclValueRef();
+        }
+
+        ++i;
+
+        const std::string &dest = args[i]->toString();
+
+        command->addFileDest(dest);
+
+        if (arg == ">&")
+          command->addFileDest(dest, 2);
+      }
+      else if (arg == "2>") {
+      }
+      else if (arg == ">>" || arg == ">>&") {
+        if (i >= numArgs - 1) {
+          throwError("can't specify \"" + arg + "\" as last word in command");
+          return CTclValueRef();
+        }
+
+        ++i;
+
+        const std::string &dest = args[i]->toString();
+
+        command->addFileDest(dest);
+
+        if (arg == ">>&")
+          command->addFileDest(dest, 2);
+
+        command->setFileDestAppend(true);
+      }
+      else if (arg == "2>>") {
+      }
+      else if (arg == ">@" || arg == ">&@") {
+        if (i >= numArgs - 1) {
+          throwError("can't specify \"" + arg + "\" as last word in command");
+          return CTclValueRef();
+        }
+
+        ++i;
+
+        const std::string &fileId = args[i]->toString();
+
+        FILE *fp = nullptr;
+
+        if      (fileId == "stdout")
+          fp = stdout;
+        else if (fileId == "stderr")
+          fp = stderr;
+        else {
+          fp = getFile(fileId);
+
+          if (fp == nullptr) {
+            throwError("can not find channel named \"" + fileId + "\"");
+            return CTclValueRef();
+          }
+        }
+
+        command->addFileDest(fp);
+
+        if (arg == ">&%")
+          command->addFileDest(fp, 2);
+      }
+      else if (arg == "2>@") {
+      }
+      else if (arg == "2>@1") {
+      }
+      else
+        command->addArg(arg);
+    }
+
+    uint num_cmds = cmds.size();
+
+    for (uint i = 0; i < num_cmds; ++i) {
+      auto *cmd = cmds[i];
+
+      if (i == 0)
+        cmd->setProcessGroupLeader();
+      else
+        cmd->setProcessGroup(cmds[0]);
+    }
+
+    for (uint i = 0; i < num_cmds; ++i) {
+      auto *cmd = cmds[i];
+
+      cmd->start();
+    }
+
+    for (uint i = 0; i < num_cmds; ++i) {
+      auto *cmd = cmds[i];
+
+      cmd->wait();
+    }
+
+    int rc = cmds[0]->getReturnCode();
+
+    for (uint i = 0; i < num_cmds; ++i)
+      delete cmds[i];
+
+    if (rc != 0)
+      throwError("child process exited abnormally (" + CStrUtil::toString(rc) + ")");
+
+    return CTclValueRef();
+  }
+}
+
+std::string
+CTcl::
+lookupPathCommand(const std::string &name) const
+{
+  std::string value;
+
+  if (! CEnvInst.get("PATH", value))
+    return "";
+
+  std::vector<std::string> words;
+
+  CStrUtil::addFields(value, words, ":");
+
+  uint num_words = words.size();
+
+  for (uint i = 0; i < num_words; ++i) {
+    std::string path = words[i] + "/" + name;
+
+    if (! CFile::isRegular(path) || ! CFile::isExecutable(path))
+      continue;
+
+    return path;
+  }
+
+  return "";
+}
+
+void
+CTcl::
+startFileParse(const std::string &fileName)
+{
+  parseStack_.push_back(parse_);
+
+  auto *parse = new CTclParse(this, fileName);
+
+  parse_ = parse;
+
+  ParseLoc loc;
+
+  loc.fileName  = fileName;
+  loc.hasFile   = true;
+  loc.parse     = parse;
+  loc.fileParse = parse;
+
+  locStack_.push_back(loc);
+}
+
+void
+CTcl::
+startStringParse(const std::string &str)
+{
+  parseStack_.push_back(parse_);
+
+  parse_ = new CStrParse(str);
+
+  // file and start line are those of enclosing command (found when needed)
+  ParseLoc loc;
+
+  loc.parse = parse_;
+
+  locStack_.push_back(loc);
+}
+
+void
+CTcl::
+endParse()
+{
+  delete parse_;
+
+  parse_ = parseStack_.back();
+
+  parseStack_.pop_back();
+
+  locStack_.pop_back();
+}
+
+void
+CTcl::
+getParseMemory(uint &num, ulong &bytes) const
+{
+  num   = 0;
+  bytes = 0;
+
+  auto addParse = [&](const CStrParse *parse) {
+    if (! parse) return;
+
+    ++num;
+
+    bytes += sizeof(*parse) + parse->getString().capacity();
+  };
+
+  addParse(parse_);
+
+  for (const auto *parse : parseStack_)
+    addParse(parse);
+}
+
+const std::string &
+CTcl::
+getSourceFile() const
+{
+  static std::string noFile;
+
+  for (auto p = locStack_.rbegin(); p != locStack_.rend(); ++p) {
+    if ((*p).hasFile)
+      return (*p).fileName;
+  }
+
+  return noFile;
+}
+
+uint
+CTcl::
+getSourceLine()
+{
+  if (locStack_.empty()) return 0;
+
+  return locLine(uint(locStack_.size() - 1));
+}
+
+// record start of next command of current parse (line is computed when needed)
+void
+CTcl::
+setCommandStart()
+{
+  if (locStack_.empty())
+    return;
+
+  locStack_.back().cmdPos = parse_->getPos();
+}
+
+// line of current command start of parse location i. String parses start at
+// the line of the enclosing command and count newlines from the last position
+// asked for
+uint
+CTcl::
+locLine(uint i)
+{
+  auto &loc = locStack_[i];
+
+  if (loc.fileParse)
+    return loc.fileParse->getLineNum(loc.cmdPos);
+
+  if (loc.lineNum == 0)
+    loc.lineNum = (i > 0 ? locLine(i - 1) : 1);
+
+  const std::string &str = loc.parse->getString();
+
+  int len = std::min(loc.cmdPos, int(str.size()));
+
+  for (int j = loc.pos; j < len; ++j) {
+    if (str[j] == '\n')
+      ++loc.lineNum;
+  }
+
+  loc.pos = std::max(loc.pos, len);
+
+  return loc.lineNum;
+}
+
+void
+CTcl::
+startMemorySites()
+{
+  memorySites_ = true;
+
+  updateMemorySite();
+}
+
+void
+CTcl::
+stopMemorySites()
+{
+  memorySites_ = false;
+
+  CTclProcessMemory::setCurrentSite(0);
+}
+
+// set allocation site of new values to current proc and line
+void
+CTcl::
+updateMemorySite()
+{
+  std::string name;
+
+  auto *proc = getProc();
+
+  if (proc)
+    name = proc->getName() + " ";
+
+  const std::string &fileName = getSourceFile();
+
+  name += (fileName != "" ? fileName : "<string>") + ":" + std::to_string(getSourceLine());
+
+  CTclProcessMemory::setCurrentSite(CTclProcessMemory::getSiteId(name));
+}
+
+// record execution of command (args) at current line
+void
+CTcl::
+lineEvent(const std::vector<CTclValueRef> &args)
+{
+  if (args.empty() || locStack_.empty())
+    return;
+
+  // skip comments
+  if (args[0]->toString() == "#")
+    return;
+
+  lineProfiler_->line(getSourceFile(), getSourceLine());
+}
+
+void
+CTcl::
+wrongNumArgs(const std::string &msg)
+{
+  throwError("wrong # args: should be \"" + msg + "\"");
+}
+
+void
+CTcl::
+badInteger(CTclValueRef value)
+{
+  throwError("expected integer but got \"" + value->toString() + "\"");
+}
+
+void
+CTcl::
+badReal(CTclValueRef value)
+{
+  throwError("expected number but got \"" + value->toString() + "\"");
+}
+
+// set error result : callers return immediately and the error code is
+// propagated back up through the evaluation functions
+void
+CTcl::
+throwError(const std::string &msg)
+{
+  if (isError()) return;
+
+  resultCode_ = ResultCode::ERROR;
+  errorMsg_   = msg;
+}
+
+void
+CTcl::
+resetError()
+{
+  resultCode_ = ResultCode::OK;
+
+  errorMsg_ = "";
+}
+
+// print and clear pending error (top level)
+bool
+CTcl::
+reportError()
+{
+  if (! isError())
+    return false;
+
+  std::cerr << getErrorMsg() << "\n";
+
+  resetError();
+
+  return true;
+}
+
+bool
+CTcl::
+needsBraces(const std::string &str)
+{
+  uint len = str.size();
+
+  bool is_space = false;
+
+  for (uint i = 0; i < len; ++i) {
+    if (isspace(str[i])) {
+      is_space = true;
+      break;
+    }
+  }
+
+  return (len == 0 || is_space);
+}
+
+//--------------
+
+CTclParse::
+CTclParse(CTcl *tcl, const std::string &filename) :
+ tcl_(tcl)
+{
+  file_ = new CFile(filename);
+}
+
+CTclParse::
+~CTclParse()
+{
+  delete file_;
+}
+
+bool
+CTclParse::
+fillBuffer()
+{
+  std::string line;
+
+  if (! file_->readLine(line))
+    return false;
+
+  LineStart lineStart;
+
+  lineStart.pos  = int(getString().size()) + (getPos() > 0 ? 1 : 0);
+  lineStart.line = ++lineNum_;
+
+  lineStarts_.push_back(lineStart);
+
+  uint len = line.size();
+
+  while (len > 0 && line[len - 1] == '\\') {
+    line = line.substr(0, len - 1);
+
+    std::string line1;
+
+    if (file_->readLine(line1)) {
+      ++lineNum_;
+
+      uint len1 = line1.size();
+
+      uint i = 0;
+
+      while (i < len1 && isspace(line1[i]))
+        ++i;
+
+      line += " " + line1.substr(0);
+    }
+
+    len = line.size();
+  }
+
+  if (getPos() > 0)
+    addString(tcl_->getSeparator() + line);
+  else
+    addString(line);
+
+  return true;
+}
+
+bool
+CTclParse::
+eof() const
+{
+  if (! CStrParse::eof())
+    return false;
+
+  auto *th = const_cast<CTclParse *>(this);
+
+  th->fillBuffer();
+
+  if (! CStrParse::eof())
+    return false;
+
+  return file_->eof();
+}
+
+uint
+CTclParse::
+getLineNum(int pos) const
+{
+  auto p = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), pos,
+    [](int pos, const LineStart &lineStart) { return pos < lineStart.pos; });
+
+  if (p == lineStarts_.begin())
+    return 1;
+
+  return (*(p - 1)).line;
+}
+
+//-----------
+
+CTclScope::
+CTclScope(CTcl *tcl, CTclScope *parent, const std::string &name) :
+ tcl_(tcl), parent_(parent), name_(name)
+{
+  CTclProcessMemory::addScope();
+}
+
+CTclScope::
+~CTclScope()
+{
+  CTclProcessMemory::removeScope();
+
+  for (auto &ps : scopeMap_)
+    delete ps.second;
+
+  for (auto &pp : procs_)
+    delete pp.second;
+}
+
+CTclScope *
+CTclScope::
+namespaceScope()
+{
+  auto *scope = this;
+
+  while (scope->parent_ && scope->name_ == "")
+    scope = scope->parent_;
+
+  return scope;
+}
+
+CTclVariableRef
+CTclScope::
+addVariable(const std::string &varName, CTclValueRef value)
+{
+  auto *var = new CTclVariable(value);
+
+  return addVariable(varName, CTclVariableRef(var));
+}
+
+CTclVariableRef
+CTclScope::
+addVariable(const std::string &varName, CTclVariableRef var)
+{
+  assert(var.isValid());
+
+  vars_[varName] = var;
+
+  return var;
+}
+
+CTclVariableRef
+CTclScope::
+getVariable(const std::string &varName)
+{
+  auto p = vars_.find(varName);
+
+  if (p == vars_.end())
+    return CTclVariableRef();
+
+  return (*p).second;
+}
+
+CTclValueRef
+CTclScope::
+getVariableValue(const std::string &varName)
+{
+  auto var = getVariable(varName);
+
+  if (var.isValid())
+    return var->getValue();
+  else
+    return CTclValueRef();
+}
+
+CTclValueRef
+CTclScope::
+getArrayVariableValue(const std::string &varName, const std::string &indexStr)
+{
+  auto var = getVariable(varName);
+
+  if (var.isValid())
+    return var->getArrayValue(indexStr);
+  else
+    return CTclValueRef();
+}
+
+void
+CTclScope::
+setArrayVariableValue(const std::string &varName, const std::string &indexStr, CTclValueRef value)
+{
+  auto var = getVariable(varName);
+
+  if (! var.isValid()) {
+    auto *array = new CTclArray;
+
+    array->setValue(indexStr, value);
+
+    setVariableValue(varName, CTclValueRef(array));
+  }
+  else
+    return var->setArrayValue(indexStr, value);
+}
+
+void
+CTclScope::
+getVariableNames(std::vector<std::string> &names) const
+{
+  for (const auto &pv : vars_) {
+    const auto &name = pv.first;
+
+    names.push_back(name);
+  }
+}
+
+void
+CTclScope::
+setVariableValue(const std::string &varName, CTclValueRef value)
+{
+  auto p = vars_.find(varName);
+
+  if (p == vars_.end()) {
+    auto *var = new CTclVariable;
+
+    p = vars_.insert(p, VariableList::value_type(varName, CTclVariableRef(var)));
+  }
+
+  auto var = (*p).second;
+
+  var->setValue(value);
+}
+
+void
+CTclScope::
+removeVariable(const std::string &varName)
+{
+  auto p = vars_.find(varName);
+
+  if (p != vars_.end()) {
+    auto var = (*p).second;
+
+    vars_.erase(p);
+
+    if (var->isTraced(CTclVariableProc::TraceOp::UNSET))
+      var->callNotifyProcs(CTclVariableProc::TraceOp::UNSET);
+  }
+}
+
+CTclProc *
+CTclScope::
+defineProc(const std::string &name, const std::vector<std::string> &args, CTclValueRef body)
+{
+  removeProc(name);
+
+  auto *proc = new CTclProc(tcl_, name, args, body);
+
+  // proc of namespace is freed with it, proc of call scope keeps its
+  // namespace referenced
+  auto *nscope = namespaceScope();
+
+  proc->setScope(nscope, nscope != this);
+
+  procs_[name] = proc;
+
+  return proc;
+}
+
+CTclProc *
+CTclScope::
+getProc(const std::string &varName)
+{
+  auto p = procs_.find(varName);
+
+  if (p == procs_.end())
+    return nullptr;
+
+  return (*p).second;
+}
+
+void
+CTclScope::
+removeProc(const std::string &name)
+{
+  auto p = procs_.find(name);
+
+  if (p != procs_.end()) {
+    auto *proc = (*p).second;
+
+    procs_.erase(p);
+
+    delete proc;
+  }
+}
+
+void
+CTclScope::
+getProcNames(std::vector<std::string> &names)
+{
+  for (const auto &pp : procs_) {
+    auto *proc = pp.second;
+
+    names.push_back(proc->getName());
+  }
+}
+
+CTclScope *
+CTclScope::
+getNamedScope(const std::string &name, bool create_it)
+{
+  auto p = scopeMap_.find(name);
+
+  if (p != scopeMap_.end())
+    return (*p).second;
+
+  if (! create_it)
+    return nullptr;
+
+  auto *scope = new CTclScope(tcl_, this, name);
+
+  scopeMap_[name] = scope;
+
+  tcl_->namespacesChanged();
+
+  return scope;
+}
+
+bool
+CTclScope::
+removeNamedScope(const std::string &name)
+{
+  auto p = scopeMap_.find(name);
+
+  if (p == scopeMap_.end())
+    return false;
+
+  auto *scope = (*p).second;
+
+  scopeMap_.erase(p);
+
+  // scope (or child) may be current, stacked or parent of a proc call scope
+  // (namespace deleted from inside itself) so free when last reference removed
+  if (scope->refCount_ > 0)
+    scope->deleted_ = true;
+  else
+    delete scope;
+
+  tcl_->namespacesChanged();
+
+  return true;
+}
+
+void
+CTclScope::
+ref()
+{
+  for (auto *scope = this; scope; scope = scope->parent_)
+    ++scope->refCount_;
+}
+
+void
+CTclScope::
+unref()
+{
+  // free deleted scopes once parent pointers walked (child first)
+  std::vector<CTclScope *> freeScopes;
+
+  for (auto *scope = this; scope; scope = scope->parent_) {
+    assert(scope->refCount_ > 0);
+
+    --scope->refCount_;
+
+    if (scope->deleted_ && scope->refCount_ == 0)
+      freeScopes.push_back(scope);
+  }
+
+  for (auto *scope : freeScopes)
+    delete scope;
+}
+
+//-----------
+
+uint CTclVariable::notifyProcId_;
+
+CTclVariable::
+CTclVariable(CTclValueRef value)
+{
+  if (value.isValid())
+    value_ = CTclValueRef(value->dup());
+  else
+    value_ = CTclValueRef();
+}
+
+CTclVariable::
+~CTclVariable()
+{
+  for (auto *pn : notifyProcs_)
+    delete pn;
+}
+
+std::string
+CTclVariable::
+toString() const
+{
+  if (hasValue())
+    return getValue()->toString();
+
+  return "";
+}
+
+bool
+CTclVariable::
+toBool() const
+{
+  if (hasValue())
+    return getValue()->toBool();
+
+  return false;
+}
+
+bool
+CTclVariable::
+hasValue() const
+{
+  return value_.isValid();
+}
+
+CTclValueRef
+CTclVariable::
+getValue() const
+{
+  if (isTraced(CTclVariableProc::TraceOp::READ))
+    callNotifyProcs(CTclVariableProc::TraceOp::READ);
+
+  return value_;
+}
+
+void
+CTclVariable::
+setValue(CTclValueRef value)
+{
+  if (value.isValid())
+    value_ = CTclValueRef(value->dup());
+  else
+    value_ = CTclValueRef();
+
+  if (isTraced(CTclVariableProc::TraceOp::WRITE))
+    callNotifyProcs(CTclVariableProc::TraceOp::WRITE);
+}
+
+CTclValueRef
+CTclVariable::
+getArrayValue(const std::string &indexStr) const
+{
+  if (isTraced(CTclVariableProc::TraceOp::READ))
+    callNotifyProcs(CTclVariableProc::TraceOp::READ, indexStr);
+
+  if (! hasValue())
+    return CTclValueRef();
+
+  if (value_->getType() == CTclValue::ValueType::ARRAY)
+    return value_.cast<CTclArray>()->getValue(indexStr);
+  else
+    return CTclValueRef();
+}
+
+void
+CTclVariable::
+setArrayValue(const std::string &indexStr, CTclValueRef value)
+{
+  if (! hasValue())
+    value_ = CTclValueRef(new CTclArray);
+
+  if (value_->getType() == CTclValue::ValueType::ARRAY)
+    value_.cast<CTclArray>()->setValue(indexStr, value);
+
+  if (isTraced(CTclVariableProc::TraceOp::WRITE))
+    callNotifyProcs(CTclVariableProc::TraceOp::WRITE, indexStr);
+}
+
+void
+CTclVariable::
+removeArrayValue(const std::string &indexStr)
+{
+  if (! hasValue() || value_->getType() != CTclValue::ValueType::ARRAY)
+    return;
+
+  if (! value_.cast<CTclArray>()->removeValue(indexStr))
+    return;
+
+  if (isTraced(CTclVariableProc::TraceOp::UNSET))
+    callNotifyProcs(CTclVariableProc::TraceOp::UNSET, indexStr);
+}
+
+void
+CTclVariable::
+appendValue(CTclValueRef value)
+{
+  if (hasValue()) {
+    if      (value_->getType() == CTclValue::ValueType::STRING)
+      value_.cast<CTclString>()->appendValue(value->toString());
+    else if (value_->getType() == CTclValue::ValueType::LIST)
+      value_.cast<CTclList>()->addValue(value);
+    else {
+      setValue(value);
+      return;
+    }
+
+    if (isTraced(CTclVariableProc::TraceOp::WRITE))
+      callNotifyProcs(CTclVariableProc::TraceOp::WRITE);
+  }
+  else
+    setValue(value);
+}
+
+uint
+CTclVariable::
+addNotifyProc(CTclVariableProc *proc)
+{
+  ++notifyProcId_;
+
+  proc->setId(notifyProcId_);
+
+  notifyProcs_.push_back(proc);
+
+  updateTraceOps();
+
+  return notifyProcId_;
+}
+
+bool
+CTclVariable::
+removeNotifyProc(uint id)
+{
+  auto p = std::find_if(notifyProcs_.begin(), notifyProcs_.end(),
+    [&](CTclVariableProc *proc) { return proc->getId() == id && ! proc->isRemoved(); });
+
+  if (p == notifyProcs_.end())
+    return false;
+
+  auto *proc = *p;
+
+  // proc may be running (or be next to run) so delete after traces finish
+  if (inNotify_)
+    proc->setRemoved(true);
+  else {
+    notifyProcs_.erase(p);
+
+    delete proc;
+  }
+
+  updateTraceOps();
+
+  return true;
+}
+
+void
+CTclVariable::
+removePendingNotifyProcs()
+{
+  auto p = std::remove_if(notifyProcs_.begin(), notifyProcs_.end(),
+    [](CTclVariableProc *proc) {
+      if (! proc->isRemoved()) return false;
+
+      delete proc;
+
+      return true;
+    });
+
+  notifyProcs_.erase(p, notifyProcs_.end());
+}
+
+void
+CTclVariable::
+getNotifyProcs(std::vector<CTclVariableProc *> &procs) const
+{
+  procs.clear();
+
+  for (auto *pn : notifyProcs_) {
+    if (! pn->isRemoved())
+      procs.push_back(pn);
+  }
+}
+
+void
+CTclVariable::
+updateTraceOps()
+{
+  traceOps_ = 0;
+
+  for (auto *pn : notifyProcs_) {
+    if (! pn->isRemoved())
+      traceOps_ |= pn->getOps();
+  }
+}
+
+void
+CTclVariable::
+callNotifyProcs(CTclVariableProc::TraceOp op, const std::string &index) const
+{
+  // traces are disabled while a trace callback runs
+  if (inNotify_) return;
+
+  inNotify_ = true;
+
+  auto *th = const_cast<CTclVariable *>(this);
+
+  // callbacks may add or remove procs so run procs of snapshot (removed procs
+  // are skipped and deleted afterwards)
+  auto procs = notifyProcs_;
+
+  for (auto *pn : procs) {
+    if (! pn->isRemoved() && (pn->getOps() & uint(op)))
+      pn->notify(th, op, index);
+  }
+
+  inNotify_ = false;
+
+  th->removePendingNotifyProcs();
+}
+
+//----------
+
+CTclEnvVariable::
+CTclEnvVariable()
+{
+}
+
+CTclValueRef
+CTclEnvVariable::
+getValue() const
+{
+  updateValues();
+
+  return values_;
+}
+
+CTclValueRef
+CTclEnvVariable::
+getArrayValue(const std::string &indexStr) const
+{
+  updateValues();
+
+  auto value = values_.cast<CTclArray>()->getValue(indexStr);
+
+  if (! value.isValid())
+    return CTclValueRef(new CTclString(""));
+
+  return value;
+}
+
+// set (array) value : elements are set in process environment and snapshot
+// reloaded
+void
+CTclEnvVariable::
+setValue(CTclValueRef value)
+{
+  if (! value.isValid() || value->getType() != CTclValue::ValueType::ARRAY)
+    return;
+
+  std::vector<std::string>  names;
+  std::vector<CTclValueRef> values;
+
+  value.cast<CTclArray>()->getNameValues(names, values);
+
+  for (uint i = 0; i < names.size(); ++i)
+    CEnvInst.set(names[i], values[i]->toString());
+
+  invalidate();
+
+  if (isTraced(CTclVariableProc::TraceOp::WRITE))
+    callNotifyProcs(CTclVariableProc::TraceOp::WRITE);
+}
+
+void
+CTclEnvVariable::
+setArrayValue(const std::string &indexStr, CTclValueRef value)
+{
+  updateValues();
+
+  CEnvInst.set(indexStr, value->toString());
+
+  values_.cast<CTclArray>()->setValue(indexStr, value);
+
+  if (isTraced(CTclVariableProc::TraceOp::WRITE))
+    callNotifyProcs(CTclVariableProc::TraceOp::WRITE, indexStr);
+}
+
+void
+CTclEnvVariable::
+removeArrayValue(const std::string &indexStr)
+{
+  updateValues();
+
+  CEnvInst.unset(indexStr);
+
+  if (! values_.cast<CTclArray>()->removeValue(indexStr))
+    return;
+
+  if (isTraced(CTclVariableProc::TraceOp::UNSET))
+    callNotifyProcs(CTclVariableProc::TraceOp::UNSET, indexStr);
+}
+
+void
+CTclEnvVariable::
+updateValues() const
+{
+  if (valid_) return;
+
+  auto *array = new CTclArray;
+
+  for (char **env = environ; env && *env; ++env) {
+    std::string str = *env;
+
+    auto pos = str.find('=');
+
+    if (pos == std::string::npos)
+      continue;
+
+    array->setValue(str.substr(0, pos), CTclValueRef(new CTclString(str.substr(pos + 1))));
+  }
+
+  values_ = CTclValueRef(array);
+  valid_  = true;
+}
+
+//----------
+
+CTclArrayElementVariable::
+CTclArrayElementVariable(CTclVariableRef var, const std::string &indexStr) :
+ var_(var), indexStr_(indexStr)
+{
+}
+
+bool
+CTclArrayElementVariable::
+hasValue() const
+{
+  if (! var_->hasValue())
+    return false;
+
+  auto value = var_->peekValue();
+
+  // computed value (env)
+  if (! value.isValid())
+    return var_->getArrayValue(indexStr_).isValid();
+
+  if (value->getType() != CTclValue::ValueType::ARRAY)
+    return false;
+
+  return value.cast<CTclArray>()->getValue(indexStr_).isValid();
+}
+
+CTclValueRef
+CTclArrayElementVariable::
+getValue() const
+{
+  return var_->getArrayValue(indexStr_);
+}
+
+void
+CTclArrayElementVariable::
+setValue(CTclValueRef value)
+{
+  if (value.isValid())
+    var_->setArrayValue(indexStr_, value);
+  else
+    var_->removeArrayValue(indexStr_);
+}
+
+void
+CTclArrayElementVariable::
+appendValue(CTclValueRef value)
+{
+  auto value1 = getValue();
+
+  if (! value1.isValid()) {
+    setValue(value);
+    return;
+  }
+
+  setValue(CTclValueRef(new CTclString(value1->toString() + value->toString())));
+}
+
+//----------
+
+void
+CTclString::
+print(std::ostream &os) const
+{
+  os << str_;
+}
+
+std::string
+CTclString::
+toString() const
+{
+  return str_;
+}
+
+bool
+CTclString::
+toInt(long &i) const
+{
+  double r;
+  bool   isReal;
+
+  if (! getNumber(i, r, isReal) || isReal) {
+    i = 0;
+    return false;
+  }
+
+  return true;
+}
+
+bool
+CTclString::
+toReal(double &r) const
+{
+  long i;
+  bool isReal;
+
+  if (! getNumber(i, r, isReal)) {
+    r = 0.0;
+    return false;
+  }
+
+  if (! isReal)
+    r = double(i);
+
+  return true;
+}
+
+// number (integer or real) for string. Result is cached until string changes
+bool
+CTclString::
+getNumber(long &i, double &r, bool &isReal) const
+{
+  if (numType_ == NumType::UNKNOWN) {
+    if      (CTclNumber::toInteger(str_, integer_))
+      numType_ = NumType::INTEGER;
+    else if (CTclNumber::toReal(str_, real_))
+      numType_ = (str_.find_first_of(".eEnN") == std::string::npos ?
+                  NumType::BIGINT : NumType::REAL);
+    else
+      numType_ = NumType::NONE;
+  }
+
+  i      = integer_;
+  r      = real_;
+  isReal = (numType_ == NumType::REAL || numType_ == NumType::BIGINT);
+
+  return (numType_ != NumType::NONE);
+}
+
+bool
+CTclString::
+isBigInteger() const
+{
+  long   i;
+  double r;
+  bool   isReal;
+
+  (void) getNumber(i, r, isReal);
+
+  return (numType_ == NumType::BIGINT);
+}
+
+bool
+CTclString::
+toBool() const
+{
+  bool b;
+
+  if (! CStrUtil::toBool(str_, &b))
+    b = false;
+
+  return b;
+}
+
+CTclValueRef
+CTclString::
+toList(CTcl *tcl) const
+{
+  std::vector<CTclValueRef> args;
+
+  auto *list = tcl->stringToList(str_);
+
+  return CTclValueRef(list);
+}
+
+//----------
+
+std::string
+CTclArray::
+toString() const
+{
+  return "";
+}
+
+void
+CTclArray::
+print(std::ostream &os) const
+{
+  os << "{";
+
+  for (const auto &pv : values_) {
+    os << " " << pv.first << "=";
+
+    pv.second->print(os);
+  }
+
+  os << "}";
+}
+
+bool
+CTclArray::
+toBool() const
+{
+  return ! values_.empty();
+}
+
+//----------
+
+bool
+CTclList::
+toBool() const
+{
+  return ! values_.empty();
+}
+
+std::string
+CTclList::
+toString() const
+{
+  std::string str;
+
+  for (const auto &pv : values_) {
+    auto str1 = pv->toString();
+
+    if (! str.empty()) str += " ";
+
+    if (CTcl::needsBraces(str1))
+      str += "{" + str1 + "}";
+    else
+      str += str1;
+  }
+
+  return str;
+}
+
+void
+CTclList::
+print(std::ostream &os) const
+{
+  std::string str = toString();
+
+  os << str;
+}
+
+//----------
+
+bool
+CTclValue::
+checkInt(CTcl *tcl, long &i)
+{
+  bool ok = toInt(i);
+
+  if (! ok)
+    tcl->throwError("expected integer but got \"" + toString() + "\"");
+
+  return ok;
+}
+
+bool
+CTclValue::
+checkReal(CTcl *tcl, double &r)
+{
+  bool ok = toReal(r);
+
+  if (! ok)
+    tcl->throwError("expected number but got \"" + toString() + "\"");
+
+  return ok;
+}
+
+bool
+CTclValue::
+toIndex(CTcl *tcl, long &ind)
+{
+  bool ok = toInt(ind);
+
+  if (! ok) {
+    const std::string &str = toString();
+
+    if (str == "end") {
+      ind = -1;
+    }
+    else if (str.size() > 4 && str.substr(0, 4) == "end-") {
+      std::string str1 = str.substr(4);
+
+      long ind1;
+
+      bool ok1 = CTclNumber::toInteger(str1, ind1);
+
+      if (ok1)
+        ind = -ind1 - 1;
+    }
+    else {
+      tcl->throwError("bad index \"" + toString() + "\": must be integer or end?-integer?");
+      return false;
+    }
+  }
+
+  return true;
+}
+
+CTclValueRef
+CTclValue::
+eval(CTcl *tcl) const
+{
+  const std::string &str = toString();
+
+  return tcl->evalString(str);
+}
+
+bool
+CTclValue::
+evalBool(CTcl *tcl) const
+{
+  auto value = eval(tcl);
+
+  if (! value.isValid())
+    return false;
+
+  return value->toBool();
+}
+
+CTclValueRef
+CTclValue::
+exec(CTcl *tcl) const
+{
+  const std::string &str = toString();
+
+  return tcl->parseString(str);
+}
+
+//----------
+
+// run loop body script for each iteration (loop run as command rather than by
+// evaluation trampoline)
+CTclValueRef
+CTclCommand::
+execLoop(const std::vector<CTclValueRef> &args)
+{
+  LoopState state;
+
+  if (! loopStart(args, state))
+    return CTclValueRef();
+
+  CTclValueRef body;
+
+  while (loopNext(args, state, body)) {
+    CTclValueRef value;
+
+    auto code = tcl_->execScript(body->toString(), value);
+
+    if      (code == CTcl::ResultCode::BREAK || code == CTcl::ResultCode::ERROR)
+      break;
+    else if (code == CTcl::ResultCode::RETURN) {
+      tcl_->setResultCode(code);
+      return value;
+    }
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclCommentCommand::
+exec(const std::vector<CTclValueRef> &)
+{
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclAfterCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("after option ?arg arg ...?");
+    return CTclValueRef();
+  }
+
+  const std::string &opt = args[0]->toString();
+
+  if      (opt == "cancel") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs("after cancel id|command");
+      return CTclValueRef();
+    }
+
+    for (uint i = 1; i < numArgs; ++i) {
+      const std::string &id = args[i]->toString();
+
+      tcl_->cancelTimer(id);
+    }
+  }
+  else if (opt == "idle") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs("after idle script script ...");
+      return CTclValueRef();
+    }
+
+    std::string str;
+
+    for (uint i = 1; i < numArgs; ++i) {
+      if (i > 1) str += " ";
+
+      str += args[i]->toString();
+    }
+
+    std::string name = tcl_->addTimer(0, str);
+
+    return tcl_->createValue(name);
+  }
+  else if (opt == "info") {
+    if (numArgs == 1) {
+      std::vector<std::string> names;
+
+      tcl_->getTimerNames(names);
+
+      return tcl_->createValue(names);
+    }
+    else {
+      std::vector<CTclValueRef> values;
+
+      for (uint i = 1; i < numArgs; ++i) {
+        const std::string &id = args[i]->toString();
+
+        auto *timer = tcl_->getTimer(id);
+
+        if (timer) {
+          std::vector<CTclValueRef> values1;
+
+          values1.push_back(tcl_->createValue(timer->getName  ()));
+          values1.push_back(tcl_->createValue(timer->getScript()));
+
+          values.push_back(tcl_->createValue(values1));
+        }
+        else {
+          tcl_->throwError("event \"" + id + "\" doesn't exist");
+          return CTclValueRef();
+        }
+      }
+
+      return tcl_->createValue(values);
+    }
+  }
+  else {
+    long ms;
+
+    bool ok = args[0]->toInt(ms);
+
+    if (! ok) {
+      tcl_->throwError("bad argument \"" + opt + "\": must be "
+                       "cancel, idle, info, or a number");
+      return CTclValueRef();
+    }
+
+    if (numArgs == 1)
+      COSTimer::milli_sleep(ms);
+    else {
+      std::string str;
+
+      for (uint i = 1; i < numArgs; ++i) {
+        if (i > 1) str += " ";
+
+        str += args[i]->toString();
+      }
+
+      std::string name = tcl_->addTimer(ms, str);
+
+      return tcl_->createValue(name);
+    }
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclAppendCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 2) {
+    tcl_->wrongNumArgs("append varName ?value value ...?");
+    return CTclValueRef();
+  }
+
+  auto *scope = tcl_->getScope();
+
+  const std::string &varName = args[0]->toString();
+
+  auto var = scope->getVariable(varName);
+
+  if (! var.isValid()) {
+    scope->setVariableValue(varName, args[1]);
+
+    var = scope->getVariable(varName);
+
+    for (uint i = 2; i < numArgs; ++i)
+      var->appendValue(args[i]);
+  }
+  else {
+    for (uint i = 1; i < numArgs; ++i)
+      var->appendValue(args[i]);
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclArrayCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 2) {
+    tcl_->wrongNumArgs("array option arrayName ?arg ...?");
+    return CTclValueRef();
+  }
+
+  const std::string &cmd     = args[0]->toString();
+  const std::string &varName = args[1]->toString();
+
+  if      (cmd == "anymore") {
+    return CTclValueRef();
+  }
+  else if (cmd == "donesearch") {
+    return CTclValueRef();
+  }
+  else if (cmd == "exists") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("array exists arrayName");
+      return CTclValueRef();
+    }
+
+    auto *scope = tcl_->getScope();
+
+    auto value = scope->getVariableValue(varName);
+
+    bool is_array = (value.isValid() && value->getType() == CTclValue::ValueType::VALUE_MAP);
+
+    return CTclValueRef(tcl_->createValue(long(is_array)));
+  }
+  else if (cmd == "get") {
+    auto *scope = tcl_->getScope();
+
+    auto value = scope->getVariableValue(varName);
+
+    if (! value.isValid())
+      return CTclValueRef();
+
+    if (value->getType() == CTclValue::ValueType::ARRAY) {
+      auto *array = value.cast<CTclArray>();
+
+      std::vector<std::string>  names;
+      std::vector<CTclValueRef> values;
+
+      array->getNameValues(names, values);
+
+      uint num_names = names.size();
+
+      auto *list = new CTclList;
+
+      for (uint i = 0; i < num_names; ++i) {
+        auto *list1 = new CTclList;
+
+        list1->addValue(tcl_->createValue(names[i]));
+        list1->addValue(values[i]);
+
+        list->addValue(CTclValueRef(list1));
+      }
+
+      return CTclValueRef(list);
+    }
+    else
+      return CTclValueRef();
+  }
+  else if (cmd == "names") {
+    auto *scope = tcl_->getScope();
+
+    auto value = scope->getVariableValue(varName);
+
+    if (! value.isValid())
+      return CTclValueRef();
+
+    if (value->getType() == CTclValue::ValueType::VALUE_MAP) {
+      auto *array = value.cast<CTclArray>();
+
+      std::vector<std::string> names;
+
+      array->getNames(names);
+
+      return CTclValueRef(tcl_->createValue(names));
+    }
+    else
+      return CTclValueRef();
+  }
+  else if (cmd == "nextelement") {
+    return CTclValueRef();
+  }
+  else if (cmd == "set") {
+    if (numArgs < 3) {
+      tcl_->wrongNumArgs("array set arrayName list");
+      return CTclValueRef();
+    }
+
+    CTclValueRef list;
+
+    if (args[2]->getType() == CTclValue::ValueType::LIST)
+      list = args[2];
+    else
+      list = args[2]->toList(tcl_);
+
+    uint length = list->getLength();
+
+    if (length & 1) {
+      tcl_->throwError("list must have an even number of elements");
+      return CTclValueRef();
+    }
+
+    auto *array = new CTclArray;
+
+    for (uint i = 0; i < length; i += 2) {
+      auto name  = list->getIndexValue(i    );
+      auto value = list->getIndexValue(i + 1);
+
+      array->setValue(name->toString(), value);
+    }
+
+    auto *scope = tcl_->getScope();
+
+    scope->setVariableValue(varName, CTclValueRef(array));
+
+    return CTclValueRef();
+  }
+  else if (cmd == "size") {
+    return CTclValueRef();
+  }
+  else if (cmd == "startsearch") {
+    return CTclValueRef();
+  }
+  else if (cmd == "statistics") {
+    return CTclValueRef();
+  }
+  else if (cmd == "unset") {
+    tcl_->removeVariable(varName);
+
+    return CTclValueRef();
+  }
+  else {
+    tcl_->throwError("bad option \"" + cmd + "\": must be "
+                     "anymore, donesearch, exists, get, names, nextelement, set, size, "
+                     "startsearch, statistics, or unset");
+    return CTclValueRef();
+  }
+}
+
+//----------
+
+CTclValueRef
+CTclBreakCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 0) {
+    tcl_->wrongNumArgs("break");
+    return CTclValueRef();
+  }
+
+  tcl_->setResultCode(CTcl::ResultCode::BREAK);
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclCatchCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("catch command ?varName?");
+    return CTclValueRef();
+  }
+
+  CTclValueRef value;
+
+  auto code = tcl_->execScript(args[0]->toString(), value);
+
+  if (code == CTcl::ResultCode::ERROR) {
+    value = tcl_->createValue(tcl_->getErrorMsg());
+
+    tcl_->resetError();
+  }
+
+  return scriptResult(args, int(code), value);
+}
+
+bool
+CTclCatchCommand::
+getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("catch command ?varName?");
+    return false;
+  }
+
+  script = args[0];
+
+  return true;
+}
+
+// store script value (or error message) in variable and return completion code
+CTclValueRef
+CTclCatchCommand::
+scriptResult(const std::vector<CTclValueRef> &args, int code, CTclValueRef value)
+{
+  if (args.size() > 1) {
+    const std::string &varName = args[1]->toString();
+
+    auto *scope = tcl_->getScope();
+
+    scope->setVariableValue(varName, value.isValid() ? value : tcl_->createValue(""));
+  }
+
+  return CTclValueRef(tcl_->createValue(long(code)));
+}
+
+//----------
+
+CTclValueRef
+CTclCDCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  std::string dirName;
+
+  if      (numArgs == 0)
+    dirName = COSUser::getUserHome();
+  else if (numArgs == 1)
+    dirName = args[0]->toString();
+  else {
+    tcl_->wrongNumArgs("cd ?dirName?");
+    return CTclValueRef();
+  }
+
+  if (! COSFile::changeDir(dirName)) {
+    tcl_->throwError("couldn't change working directory to \"" + dirName + "\": "
+                    "no such file or directory");
+    return CTclValueRef();
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclClockCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("clock option ?arg ...?");
+    return CTclValueRef();
+  }
+
+  const std::string &opt = args[0]->toString();
+
+  if      (opt == "clicks") {
+    long secs, usecs;
+
+    COSTime::getHRTime(&secs, &usecs);
+
+    std::string str = CStrUtil::strprintf("%d%06d", secs, usecs);
+
+    return CTclValueRef(tcl_->createValue(str));
+  }
+  else if (opt == "format") {
+  }
+  else if (opt == "scan") {
+  }
+  else if (opt == "seconds") {
+    time_t t = time(nullptr);
+
+    return CTclValueRef(tcl_->createValue(long(t)));
+  }
+  else {
+    tcl_->throwError("bad option \"" + opt + "\": must be clicks, format, scan, or seconds");
+    return CTclValueRef();
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclCloseCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("close channelId");
+    return CTclValueRef();
+  }
+
+  const std::string &name = args[0]->toString();
+
+  tcl_->closeFile(name);
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclContinueCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 0) {
+    tcl_->wrongNumArgs("continue");
+    return CTclValueRef();
+  }
+
+  tcl_->setResultCode(CTcl::ResultCode::CONTINUE);
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclEchoCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  for (uint i = 0; i < numArgs; ++i) {
+    args[i]->print(std::cout);
+
+    std::cout << "\n";
+  }
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclEofCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("eof channelId");
+    return CTclValueRef();
+  }
+
+  const std::string &fileId = args[0]->toString();
+
+  FILE *fp = nullptr;
+
+  if (fileId == "stdin")
+    fp = stdin;
+  else {
+    fp = tcl_->getFile(fileId);
+
+    if (fp == nullptr) {
+      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+      return CTclValueRef();
+    }
+  }
+
+  bool flag = feof(fp);
+
+  return CTclValueRef(tcl_->createValue(long(flag)));
+}
+
+//----------
+
+CTclValueRef
+CTclErrorCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 1 || numArgs > 3) {
+    tcl_->wrongNumArgs("error message ?errorInfo? ?errorCode?");
+    return CTclValueRef();
+  }
+
+  tcl_->throwError(args[0]->toString());
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclEvalCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  CTclValueRef script;
+
+  if (! getScript(args, script))
+    return CTclValueRef();
+
+  return script->exec(tcl_);
+}
+
+bool
+CTclEvalCommand::
+getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script)
+{
+  uint numArgs = args.size();
+
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("eval arg ?arg ...?");
+    return false;
+  }
+
+  if (numArgs == 1) {
+    script = args[0];
+    return true;
+  }
+
+  std::string str;
+
+  for (uint i = 0; i < numArgs; ++i) {
+    if (i > 0) str += " ";
+
+    str += args[i]->toString();
+  }
+
+  script = tcl_->createValue(str);
+
+  return true;
+}
+
+//----------
+
+CTclValueRef
+CTclExecCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("exec ?switches? arg ?arg ...?");
+    return CTclValueRef();
+  }
+
+  std::vector<CCommand *> cmds;
+
+  bool ignore_arg = false;
+
+  std::string name = args[0]->toString();
+  std::string path = tcl_->lookupPathCommand(name);
+
+  if (path == "") {
+    tcl_->throwError("couldn't execute \"" + name + "\" no such file or directory");
+    return CTclValueRef();
+  }
+
+  auto *command = new CCommand(name, path);
+
+  cmds.push_back(command);
+
+//CCommandMgrInst->setDebug(true);
+
+  for (uint i = 1; i < numArgs; ++i) {
+    std::string arg = args[i]->toString();
+
+    if (ignore_arg) {
+      command->addArg(arg);
+
+      continue;
+    }
+
+    if      (arg == "--") {
+      ignore_arg = true;
+    }
+    else if (arg == "|" || arg == "|&") {
+      if (i >= numArgs - 1) {
+        tcl_->throwError("illegal use of | or |& in command");
+        return CTclValueRef();
+      }
+
+      ignore_arg = false;
+
+      ++i;
+
+      command->addPipeDest(1);
+
+      if (arg == "|&")
+        command->addPipeDest(2);
+
+      name = args[i]->toString();
+      path = tcl_->lookupPathCommand(name);
+
+      if (path == "") {
+        tcl_->throwError("couldn't execute \"" + name + "\" no such file or directory");
+        return CTclValueRef();
+      }
+
+      command = new CCommand(name, path);
+
+      cmds.push_back(command);
+
+      command->addPipeSrc();
+    }
+    else if (arg == "<") {
+      if (i >= numArgs - 1) {
+        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
+        return CTclValueRef();
+      }
+
+      ++i;
+
+      const std::string &src = args[i]->toString();
+
+      command->addFileSrc(src);
+    }
+    else if (arg == "<@") {
+    }
+    else if (arg == "<<") {
+    }
+    else if (arg == ">" || arg == ">&") {
+      if (i >= numArgs - 1) {
+        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
+        return CTclValueRef();
+      }
+
+      ++i;
+
+      const std::string &dest = args[i]->toString();
+
+      command->addFileDest(dest);
+
+      if (arg == ">&")
+        command->addFileDest(dest, 2);
+    }
+    else if (arg == "2>") {
+    }
+    else if (arg == ">>") {
+      if (i >= numArgs - 1) {
+        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
+        return CTclValueRef();
+      }
+
+      ++i;
+
+      const std::string &dest = args[i]->toString();
+
+      command->addFileDest(dest);
+
+      command->setFileDestAppend(true);
+    }
+    else if (arg == "2>>") {
+    }
+    else if (arg == ">>&") {
+      if (i >= numArgs - 1) {
+        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
+        return CTclValueRef();
+      }
+
+      ++i;
+
+      const std::string &dest = args[i]->toString();
+
+      command->addFileDest(dest, 1);
+      command->addFileDest(dest, 2);
+
+      command->setFileDestAppend(true);
+    }
+    else if (arg == ">@") {
+    }
+    else if (arg == "2>@") {
+    }
+    else if (arg == "2>@1") {
+    }
+    else if (arg == ">&@") {
+    }
+    else
+      command->addArg(arg);
+  }
+
+  std::string dest;
+
+  uint num_cmds = cmds.size();
+
+  auto *cmd2 = cmds[num_cmds - 1];
+
+  cmd2->addStringDest(dest);
+
+  for (uint i = 0; i < num_cmds; ++i) {
+    auto *cmd = cmds[i];
+
+    if (i == 0)
+      cmd->setProcessGroupLeader();
+    else
+      cmd->setProcessGroup(cmds[0]);
+  }
+
+  for (uint i = 0; i < num_cmds; ++i) {
+    auto *cmd = cmds[i];
+
+    cmd->start();
+  }
+
+  for (uint i = 0; i < num_cmds; ++i) {
+    auto *cmd = cmds[i];
+
+    cmd->wait();
+  }
+
+  dest = CStrUtil::stripSpaces(dest);
+
+  for (uint i = 0; i < num_cmds; ++i)
+    delete cmds[i];
+
+  return CTclValueRef(tcl_->createValue(dest));
+}
+
+//----------
+
+CTclValueRef
+CTclExitCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs > 1) {
+    tcl_->wrongNumArgs("exit ?returnCode?");
+    return CTclValueRef();
+  }
+
+  long code = 0;
+
+  if (numArgs > 0) {
+    if (! args[0]->checkInt(tcl_, code))
+      return CTclValueRef();
+  }
+
+  exit(code);
+
+  return CTclValueRef();
+}
+
+//----------
+
+CTclValueRef
+CTclExprCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  return tcl_->evalString(getExpr(args));
+}
+
+std::string
+CTclExprCommand::
+getExpr(const std::vector<CTclValueRef> &args) const
+{
+  uint numArgs = args.size();
+
+  std::string str;
+
+  for (uint i = 0; i < numArgs; ++i) {
+    if (i > 0) str += " ";
+
+    str += args[i]->toString();
+  }
+
+  return str;
+}
+
+//----------
+
+CTclValueRef
+CTclFileCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("file option ?arg ...?");
+    return CTclValueRef();
+  }
+
+  const std::string &option = args[0]->toString();
+
+  if      (option == "atime") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file atime name ?time?");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    auto atime = CFile::getATime(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(atime)));
+  }
+  else if (option == "attributes") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file attributes name ?option? ?value? ?option value ...?");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    struct stat file_stat;
+
+    if (! CFile::getStat(fileName, &file_stat)) {
+      tcl_->wrongNumArgs("could not read \"" + fileName + "\": no such file or directory");
+      return CTclValueRef();
+    }
+
+    std::string str;
+
+    str += "-group " + COSUser::getGroupName(file_stat.st_gid);
+    str += " -owner " + COSUser::getUserName(file_stat.st_uid);
+    str += " -permissions 0" + CStrUtil::toOctString(file_stat.st_mode);
+
+    return CTclValueRef(tcl_->createValue(str));
+  }
+  else if (option == "channels") {
+    auto *list = new CTclList;
+
+    if (numArgs == 1) {
+      list->addValue(tcl_->createValue("stdin"));
+      list->addValue(tcl_->createValue("stdout"));
+      list->addValue(tcl_->createValue("stderr"));
+    }
+
+    return CTclValueRef(list);
+  }
+  else if (option == "copy") {
+  }
+  else if (option == "delete") {
+  }
+  else if (option == "dirname") {
+  }
+  else if (option == "executable") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isdirectory name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_exec = CFile::isExecutable(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(is_exec)));
+  }
+  else if (option == "exists") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file exists name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool exists = CFile::exists(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(exists)));
+  }
+  else if (option == "extension") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isdirectory name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    std::string suffix = CFile::getSuffix(fileName);
+
+    if (! suffix.empty())
+      suffix = "." + suffix;
+
+    return CTclValueRef(tcl_->createValue(suffix));
+  }
+  else if (option == "isdirectory") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isdirectory name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_dir = CFile::isDirectory(fileName);
 
-  if (var.isValid())
-    return var->getArrayValue(indexStr);
-  else
+    return CTclValueRef(tcl_->createValue(long(is_dir)));
+  }
+  else if (option == "isfile") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isregular name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_dir = CFile::isRegular(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(is_dir)));
+  }
+  else if (option == "join") {
+  }
+  else if (option == "link") {
+  }
+  else if (option == "lstat") {
+  }
+  else if (option == "mkdir") {
+  }
+  else if (option == "mtime") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file atime name ?time?");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    auto mtime = CFile::getMTime(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(mtime)));
+  }
+  else if (option == "nativename") {
+  }
+  else if (option == "normalize") {
+  }
+  else if (option == "owned") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isregular name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_owner = CFile::isOwner(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(is_owner)));
+  }
+  else if (option == "pathtype") {
+  }
+  else if (option == "readable") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isdirectory name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_read = CFile::isReadable(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(is_read)));
+  }
+  else if (option == "readlink") {
+  }
+  else if (option == "rename") {
+  }
+  else if (option == "rootname") {
+  }
+  else if (option == "separator") {
+  }
+  else if (option == "size") {
+  }
+  else if (option == "split") {
+  }
+  else if (option == "stat") {
+  }
+  else if (option == "system") {
+  }
+  else if (option == "tail") {
+  }
+  else if (option == "type") {
+  }
+  else if (option == "volumes") {
+  }
+  else if (option == "writable") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("file isdirectory name");
+      return CTclValueRef();
+    }
+
+    const std::string &fileName = args[1]->toString();
+
+    bool is_write = CFile::isWritable(fileName);
+
+    return CTclValueRef(tcl_->createValue(long(is_write)));
+  }
+  else {
+    tcl_->throwError("bad option \"" + option + "\": must be "
+                     "atime, attributes, channels, copy, delete, dirname, executable, "
+                     "exists, extension, isdirectory, isfile, join, link, lstat, mtime, "
+                     "mkdir, nativename, normalize, owned, pathtype, readable, readlink, "
+                     "rename, rootname, separator, size, split, stat, system, tail, type, "
+                     "volumes, or writable");
     return CTclValueRef();
+  }
+
+  return CTclValueRef();
 }
 
-void
-CTcl::
-setArrayVariableValue(const std::string &varName, const std::string &indexStr, CTclValueRef value)
+//----------
+
+CTclValueRef
+CTclFlushCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  auto var = getVariable(varName);
+  uint numArgs = args.size();
+
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("flush channelId");
+    return CTclValueRef();
+  }
+
+  FILE *fp = nullptr;
+
+  const std::string &fileId = args[0]->toString();
+
+  if      (fileId == "stdout")
+    fp = stdout;
+  else if (fileId == "stderr")
+    fp = stderr;
+  else {
+    fp = tcl_->getFile(fileId);
+
+    if (fp == nullptr) {
+      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+      return CTclValueRef();
+    }
+  }
+
+  fflush(fp);
+
+  return CTclValueRef();
+}
+
+//----------
+
+bool
+CTclForCommand::
+loopStart(const std::vector<CTclValueRef> &args, LoopState &)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 4) {
+    tcl_->wrongNumArgs("for start test next command");
+    return false;
+  }
+
+  args[0]->exec(tcl_);
+
+  return ! tcl_->isError();
+}
+
+// run next script (after first iteration) and test
+bool
+CTclForCommand::
+loopNext(const std::vector<CTclValueRef> &args, LoopState &state, CTclValueRef &body)
+{
+  if (state.iter > 0) {
+    args[2]->exec(tcl_);
+
+    if (tcl_->isError()) return false;
+  }
+
+  bool b = args[1]->evalBool(tcl_);
+
+  if (tcl_->isError() || ! b) return false;
+
+  body = args[3];
+
+  ++state.iter;
+
+  return true;
+}
+
+//----------
+
+bool
+CTclForeachCommand::
+loopStart(const std::vector<CTclValueRef> &args, LoopState &state)
+{
+  uint numArgs = args.size();
+
+  if (numArgs != 3) {
+    tcl_->wrongNumArgs("foreach varList list ?varList list ...? command");
+    return false;
+  }
+
+  CTclValueRef varList;
+
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    varList = args[0];
+  else
+    varList = args[0]->toList(tcl_);
+
+  uint numVars = varList->getLength();
+
+  if (numVars <= 0) {
+    tcl_->throwError("foreach varlist is empty");
+    return false;
+  }
+
+  CTclValueRef valList;
+
+  if (args[1]->getType() == CTclValue::ValueType::LIST)
+    valList = args[1];
+  else
+    valList = args[1]->toList(tcl_);
+
+  state.values = {varList, valList};
+
+  return true;
+}
+
+// set loop variables to next values
+bool
+CTclForeachCommand::
+loopNext(const std::vector<CTclValueRef> &args, LoopState &state, CTclValueRef &body)
+{
+  const auto &varList = state.values[0];
+  const auto &valList = state.values[1];
+
+  uint numVars = varList->getLength();
+  uint numVals = valList->getLength();
+
+  uint numIters = numVals/numVars;
+
+  if (state.iter >= numIters)
+    return false;
+
+  auto *scope = tcl_->getScope();
+
+  uint k = state.iter*numVars;
+
+  for (uint j = 0; j < numVars; ++j) {
+    auto value = valList->getIndexValue(k + j);
+
+    const std::string &varName = varList->getIndexValue(j)->toString();
+
+    scope->setVariableValue(varName, value);
+  }
+
+  body = args[2];
+
+  ++state.iter;
+
+  return true;
+}
+
+//----------
+
+class CTclPrintF : public CPrintF {
+ public:
+  CTclPrintF(const std::string &fmt, const std::vector<CTclValueRef> &args) :
+   CPrintF(fmt), args_(args), argNum_(0), numArgs_(0) {
+    numArgs_ = args_.size();
+  }
+
+  CTclValueRef nextArg() const { return args_[argNum_++]; }
+
+  int   getInt     () const override {
+    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
+  long  getLong    () const override {
+    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
+  LLong getLongLong() const override {
+    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
 
-  if (! var.isValid()) {
-    auto *array = new CTclArray;
+  double getDouble() const override {
+    double r=0; if (argNum_ < numArgs_) nextArg()->toReal(r); return r; }
 
-    array->setValue(indexStr, value);
+  std::string getString() const override {
+    return (argNum_ < numArgs_ ? nextArg()->toString() : "" ); }
 
-    setVariableValue(varName, CTclValueRef(array));
-  }
-  else
-    return var->setArrayValue(indexStr, value);
-}
+ private:
+  std::vector<CTclValueRef> args_;
+  mutable uint              argNum_;
+  uint                      numArgs_;
+};
 
-void
-CTcl::
-removeVariable(const std::string &varName)
+// is value a decimal integer too large for 64 bits
+static bool
+isBigIntegerValue(const CTclValueRef &value)
 {
-  getScope()->removeVariable(varName);
-}
+  if (value->getType() != CTclValue::ValueType::STRING)
+    return false;
 
-CTclProc *
-CTcl::
-defineProc(const std::string &name, const std::vector<std::string> &args, CTclValueRef body)
-{
-  return getScope()->defineProc(name, args, body);
+  return value.cast<CTclString>()->isBigInteger();
 }
 
-CTclProc *
-CTcl::
-getProc(const std::string &name)
+// format %d and %i conversions of big integer arguments (which printf can not
+// handle) into the format string. Other conversions and their arguments are
+// copied. Returns false if format can not be processed (positional arguments)
+static bool
+formatBigIntegers(const std::string &fmt, const std::vector<CTclValueRef> &args,
+                  std::string &fmt1, std::vector<CTclValueRef> &args1)
 {
-  auto *scope = getScope();
+  uint numArgs = args.size();
 
-  while (scope) {
-    auto *proc = scope->getProc(name);
+  args1.push_back(args[0]);
 
-    if (proc) return proc;
+  uint argNum = 1;
 
-    scope = scope->parentScope();
-  }
+  auto nextArg = [&]() {
+    if (argNum < numArgs)
+      args1.push_back(args[argNum++]);
+  };
 
-  return nullptr;
-}
+  uint len = fmt.size();
 
-std::string
-CTcl::
-openFile(const std::string &fileName, const std::string &mode)
-{
-  FILE *fp = fopen(fileName.c_str(), mode.c_str());
+  uint i = 0;
 
-  if (fp == nullptr) {
-    if      (errno == ENOENT)
-      throwError("File does not exist");
-    else if (errno == EACCES)
-      throwError("No read permission for file");
-    else
-      throwError("Open Failed");
+  while (i < len) {
+    if (fmt[i] != '%') {
+      fmt1 += fmt[i++];
+      continue;
+    }
 
-    return "";
-  }
+    uint start = i++;
 
-  int num = fileno(fp);
+    if (i < len && fmt[i] == '%') {
+      fmt1 += "%%";
+      ++i;
+      continue;
+    }
 
-  std::string handle = "file" + CStrUtil::toString(num);
+    // flags
+    std::string flags;
 
-  fileMap_[handle] = fp;
+    while (i < len && strchr("-+ 0#", fmt[i]))
+      flags += fmt[i++];
 
-  return handle;
-}
+    // width and precision (* takes value from argument)
+    uint width     = 0;
+    int  precision = -1;
+    bool star      = false;
 
-void
-CTcl::
-closeFile(const std::string &handle)
-{
-  auto p = fileMap_.find(handle);
+    if (i < len && fmt[i] == '*') {
+      star = true;
+      nextArg();
+      ++i;
+    }
+    else {
+      while (i < len && isdigit(fmt[i]))
+        width = 10*width + uint(fmt[i++] - '0');
+    }
 
-  if (p == fileMap_.end())
-    return;
+    if (i < len && fmt[i] == '$')
+      return false;
 
-  fclose((*p).second);
+    if (i < len && fmt[i] == '.') {
+      ++i;
 
-  fileMap_.erase(p);
-}
+      precision = 0;
 
-void
-CTcl::
-writeToFile(const std::string &handle, const std::string &str)
-{
-  auto p = fileMap_.find(handle);
+      if (i < len && fmt[i] == '*') {
+        star = true;
+        nextArg();
+        ++i;
+      }
+      else {
+        while (i < len && isdigit(fmt[i]))
+          precision = 10*precision + (fmt[i++] - '0');
+      }
+    }
 
-  if (p == fileMap_.end())
-    return;
+    while (i < len && strchr("hlLqjzt", fmt[i]))
+      ++i;
 
-  fwrite(str.c_str(), 1, str.size(), (*p).second);
-}
+    if (i >= len) {
+      fmt1 += fmt.substr(start);
+      break;
+    }
 
-FILE *
-CTcl::
-getFile(const std::string &handle)
-{
-  auto p = fileMap_.find(handle);
+    char c = fmt[i++];
 
-  if (p == fileMap_.end())
-    return nullptr;
+    if ((c == 'd' || c == 'i') && ! star && argNum < numArgs && isBigIntegerValue(args[argNum])) {
+      CEvalBigInt big;
 
-  return (*p).second;
-}
+      (void) CEvalBigInt::fromString(args[argNum++]->toString(), big);
 
-std::string
-CTcl::
-addTimer(int ms, const std::string &script)
-{
-  auto *timer = new CTclTimer(this, ms, script);
+      std::string digits = big.abs().toString();
 
-  return timer->getName();
-}
+      if (precision > int(digits.size()))
+        digits = std::string(precision - digits.size(), '0') + digits;
 
-bool
-CTcl::
-cancelTimer(const std::string &id)
-{
-  auto p = timerMap_.find(id);
+      std::string sign;
 
-  if (p == timerMap_.end())
-    return false;
+      if      (big.isNegative())                       sign = "-";
+      else if (flags.find('+') != std::string::npos) sign = "+";
+      else if (flags.find(' ') != std::string::npos) sign = " ";
 
-  delete (*p).second;
+      uint numPad = (width > sign.size() + digits.size() ?
+                     width - uint(sign.size() + digits.size()) : 0);
+
+      if      (flags.find('-') != std::string::npos)
+        fmt1 += sign + digits + std::string(numPad, ' ');
+      else if (flags.find('0') != std::string::npos && precision < 0)
+        fmt1 += sign + std::string(numPad, '0') + digits;
+      else
+        fmt1 += std::string(numPad, ' ') + sign + digits;
+    }
+    else {
+      fmt1 += fmt.substr(start, i - start);
+
+      nextArg();
+    }
+  }
+
+  // copy unused arguments
+  while (argNum < numArgs)
+    nextArg();
 
   return true;
 }
 
-void
-CTcl::
-insertTimer(CTclTimer *timer)
+CTclValueRef
+CTclFormatCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  std::string name = timer->getName();
+  uint numArgs = args.size();
 
-  timerMap_[name] = timer;
-}
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("format formatString ?arg arg ...?");
+    return CTclValueRef();
+  }
 
-void
-CTcl::
-clearTimer(CTclTimer *timer)
-{
-  std::string name = timer->getName();
+  const std::string &fmt = args[0]->toString();
 
-  auto p = timerMap_.find(name);
+  // integers too large for 64 bits are formatted before printf
+  bool hasBig = false;
 
-  if (p != timerMap_.end())
-    timerMap_.erase(p);
-}
+  for (uint i = 1; i < numArgs && ! hasBig; ++i)
+    hasBig = isBigIntegerValue(args[i]);
 
-void
-CTcl::
-getTimerNames(std::vector<std::string> &names)
-{
-  for (const auto &pt : timerMap_)
-    names.push_back(pt.first);
+  std::string               fmt1;
+  std::vector<CTclValueRef> args1;
+
+  if (hasBig && formatBigIntegers(fmt, args, fmt1, args1)) {
+    CTclPrintF printf(fmt1, args1);
+
+    printf.nextArg();
+
+    return CTclValueRef(tcl_->createValue(printf.format()));
+  }
+
+  CTclPrintF printf(fmt, args);
+
+  printf.nextArg();
+
+  std::string str = printf.format();
+
+  return CTclValueRef(tcl_->createValue(str));
 }
 
-CTclTimer *
-CTcl::
-getTimer(const std::string &id)
+//----------
+
+CTclValueRef
+CTclGetsCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  auto p = timerMap_.find(id);
+  uint numArgs = args.size();
 
-  if (p == timerMap_.end())
-    return nullptr;
+  if (numArgs < 1 || numArgs > 2) {
+    tcl_->wrongNumArgs("gets channelId ?varName?");
+    return CTclValueRef();
+  }
 
-  return (*p).second;
+  const std::string &fileId = args[0]->toString();
+
+  FILE *fp = nullptr;
+
+  if (fileId == "stdin")
+    fp = stdin;
+  else {
+    fp = tcl_->getFile(fileId);
+
+    if (fp == nullptr) {
+      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+      return CTclValueRef();
+    }
+  }
+
+  std::string line;
+
+  int c = getc(fp);
+
+  while (c != EOF && c != '\n') {
+    line += (char) c;
+
+    c = getc(fp);
+  }
+
+  if (numArgs == 2) {
+    const std::string &varName = args[1]->toString();
+
+    auto *scope = tcl_->getScope();
+
+    scope->setVariableValue(varName, tcl_->createValue(line));
+
+    auto len = line.size();
+
+    return CTclValueRef(tcl_->createValue(ulong(len)));
+  }
+  else
+    return CTclValueRef(tcl_->createValue(line));
 }
 
-void
-CTcl::
-update(bool /*idletasks*/)
-{
-  std::vector<CTclTimer *> timers;
+//----------
 
-  for (const auto &pt : timerMap_) {
-    auto *timer = pt.second;
+CTclValueRef
+CTclGlobCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-    if (timer->isTriggered())
-      timers.push_back(timer);
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("glob ?switches? name ?name ...?");
+    return CTclValueRef();
   }
 
-  uint num_timers = timers.size();
+  bool        join       = true;
+  bool        complain   = false;
+  bool        tails      = true;
+  std::string directory  = "";
+  std::string pathPrefix = "";
+  std::string types      = "";
+
+  uint pos = 0;
 
-  for (uint i = 0; i < num_timers; ++i)
-    timers[i]->exec();
-}
+  while (pos < numArgs) {
+    const std::string &arg = args[pos]->toString();
 
-CTclValueRef
-CTcl::
-createValue(long value) const
-{
-  return CTclValueRef(new CTclString(CStrUtil::toString(value)));
-}
+    if (arg.size() > 0 && arg[0] == '-') {
+      ++pos;
 
-CTclValueRef
-CTcl::
-createValue(ulong value) const
-{
-  return CTclValueRef(new CTclString(CStrUtil::toString(value)));
-}
+      if      (arg == "--"         ) break;
+      else if (arg == "-join"      ) join     = true;
+      else if (arg == "-nocomplain") complain = false;
+      else if (arg == "-tails"     ) tails    = true;
 
-CTclValueRef
-CTcl::
-createValue(double value) const
-{
-  return CTclValueRef(new CTclString(CStrUtil::toString(value)));
-}
+      else if (arg == "-directory") {
+        if (pos < numArgs)
+          directory = args[pos++]->toString();
+      }
+      else if (arg == "-path") {
+        if (pos < numArgs)
+          pathPrefix = args[pos++]->toString();
+      }
+      else if (arg == "-types") {
+        if (pos < numArgs)
+          types = args[pos++]->toString();
+      }
+      else {
+        tcl_->throwError("bad option \"" + arg + "\": must be -directory, -join, "
+                         "-nocomplain, -path, -tails, -types, or --");
+        return CTclValueRef();
+      }
+    }
+    else
+      break;
+  }
 
-CTclValueRef
-CTcl::
-createValue(const std::string &str) const
-{
-  return CTclValueRef(new CTclString(str));
-}
+  std::string allArgs;
 
-CTclValueRef
-CTcl::
-createValue(const std::vector<std::string> &strs) const
-{
-  auto *list = new CTclList;
+  for (uint pos1 = pos; pos1 < numArgs; ++pos1) {
+    const std::string &arg = args[pos]->toString();
 
-  uint numStrs = strs.size();
+    if (pos1 > pos) allArgs += " ";
 
-  for (uint i = 0; i < numStrs; ++i)
-    list->addValue(createValue(strs[i]));
+    allArgs += arg;
+  }
 
-  return CTclValueRef(list);
-}
+  if (directory != "") {
+    if (! CDir::enter(directory)) {
+      if (complain) tcl_->throwError("no files matched glob patterns \"" + allArgs + "\"");
+      return CTclValueRef();
+    }
+  }
 
-CTclValueRef
-CTcl::
-createValue(const std::vector<CTclValueRef> &values) const
-{
-  auto *list = new CTclList;
+  std::vector<std::string> files;
 
-  uint numValues = values.size();
+  for ( ; pos < numArgs; ++pos) {
+    const std::string &arg = args[pos]->toString();
 
-  for (uint i = 0; i < numValues; ++i)
-    list->addValue(values[i]);
+    CFileMatch match;
 
-  return CTclValueRef(list);
-}
+    std::vector<std::string> files1;
 
-CTclValueRef
-CTcl::
-evalString(const std::string &str)
-{
-  std::string str1 = expandExpr(str);
+    match.matchCurrentDir(arg, files1);
 
-  CEval eval;
+    std::copy(files1.begin(), files1.end(), std::back_inserter(files));
+  }
 
-  double result;
+  if (directory != "")
+    CDir::leave();
 
-  if (! eval.eval(str1, &result)) {
-    throwError("error in expression \"" + str1 + "\"");
+  if (files.empty()) {
+    if (complain) tcl_->throwError("no files matched glob patterns \"" + allArgs + "\"");
     return CTclValueRef();
   }
 
-  int ires = int(fabs(result) + 1E-6);
-
-  if      (fabs(result) - ires > 1E-6)
-    return CTclValueRef(new CTclString(CStrUtil::toString(result)));
-  else if (result < 0)
-    return CTclValueRef(new CTclString(CStrUtil::toString(-ires)));
-  else
-    return CTclValueRef(new CTclString(CStrUtil::toString(ires)));
+  return CTclValueRef(tcl_->createValue(files));
 }
 
+//----------
+
 CTclValueRef
-CTcl::
-evalArgs(const std::vector<CTclValueRef> &args)
+CTclGlobalCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs == 0) return CTclValueRef();
-
-  std::string name = args[0]->toString();
-
-  auto *cmd = getCommand(name);
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("global varName ?varName ...?");
+    return CTclValueRef();
+  }
 
-  if (cmd) {
-    std::vector<CTclValueRef> args1;
+  auto *scope  = tcl_->getScope();
+  auto *gscope = tcl_->getGlobalScope();
 
-    if (getDebug())
-      std::cerr << "Exec:" << name;
+  for (uint i = 0; i < numArgs; ++i) {
+    const std::string &varName = args[i]->toString();
 
-    for (uint i = 1; i < numArgs; ++i) {
-      if (getDebug())
-        std::cerr << " " << args[i];
+    auto var = scope->getVariable(varName);
 
-      args1.push_back(args[i]);
+    if (var.isValid()) {
+      tcl_->throwError("variable \"" + varName + "\" already exists");
+      return CTclValueRef();
     }
 
-    if (getDebug())
-      std::cerr << "\n";
-
-    startCommand(cmd);
-
-    auto ret = cmd->exec(args1);
+    var = gscope->getVariable(varName);
 
-    endCommand();
+    if (! var.isValid())
+      var = gscope->addVariable(varName, CTclValueRef());
 
-    return ret;
+    scope->addVariable(varName, var);
   }
-  else {
-    auto *proc = getProc(name);
 
-    if (proc) {
-      std::vector<CTclValueRef> args1;
+  return CTclValueRef();
+}
 
-      for (uint i = 1; i < numArgs; ++i)
-        args1.push_back(args[i]);
+//----------
 
-      startProc(proc);
+CTclValueRef
+CTclHistoryCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-      auto ret = proc->exec(args1);
+  std::string cmd;
 
-      endProc();
+  if (numArgs > 0) {
+    const std::string &cmd = args[0]->toString();
 
-      return ret;
+    if      (cmd == "add") {
     }
+    else if (cmd == "change") {
+    }
+    else if (cmd == "clear") {
+    }
+    else if (cmd == "event") {
+    }
+    else if (cmd == "info") {
+    }
+    else if (cmd == "keep") {
+    }
+    else if (cmd == "nextid") {
+    }
+    else if (cmd == "redo") {
+    }
+    else {
+      tcl_->throwError("bad option \"" + cmd + "\": must be "
+                       "add, change, clear, event, info, keep, nextid, or redo");
+      return CTclValueRef();
+    }
+  }
+  else {
+    auto *history = tcl_->getHistory();
 
-    //-------
-
-    std::vector<CCommand *> cmds;
-
-    bool ignore_arg = false;
-
-    std::string path = lookupPathCommand(name);
+    for (auto pc1 = history->beginCommand(), pc2 = history->endCommand(); pc1 != pc2; ++pc1) {
+      auto *cmd = *pc1;
 
-    if (path == "") {
-      throwError("invalid command name \"" + name + "\"");
-      return CTclValueRef();
+      std::cout << cmd->getNumber() << " " << cmd->getCommand() << "\n";
     }
+  }
 
-    auto *command = new CCommand(name, path);
+  return CTclValueRef();
+}
 
-    cmds.push_back(command);
+//----------
 
-//CCommandMgrInst->setDebug(true);
+CTclValueRef
+CTclIfCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  CTclValueRef script;
 
-    for (uint i = 1; i < numArgs; ++i) {
-      std::string arg = args[i]->toString();
+  if (! getScript(args, script))
+    return CTclValueRef();
 
-      if (ignore_arg) {
-        command->addArg(arg);
+  return script->exec(tcl_);
+}
 
-        continue;
-      }
+// get script of matching branch
+bool
+CTclIfCommand::
+getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script)
+{
+  uint numArgs = args.size();
 
-      if      (arg == "--") {
-        ignore_arg = true;
-      }
-      else if (arg == "|" || arg == "|&") {
-        if (i >= numArgs - 1) {
-          throwError("illegal use of | or |& in command");
-          return CTclValueRef();
-        }
+  if (numArgs < 2) {
+    tcl_->throwError("wrong # args: no expression after \"if\" argument");
+    return false;
+  }
 
-        ignore_arg = false;
+  bool has_then = false;
 
-        ++i;
+  const std::string &name = args[1]->toString();
 
-        command->addPipeDest(1);
+  if (name == "then") {
+    if (numArgs < 3) {
+      tcl_->throwError("wrong # args: no script following \"then\" argument");
+      return false;
+    }
 
-        if (arg == "|&")
-          command->addPipeDest(2);
+    has_then = true;
+  }
 
-        name = args[i]->toString();
-        path = lookupPathCommand(name);
+  bool b = args[0]->evalBool(tcl_);
 
-        if (path == "") {
-          throwError("couldn't execute \"" + name + "\" no such file or directory");
-          return CTclValueRef();
-        }
+  if (tcl_->isError()) return false;
+
+  if (b) {
+    int pos = (has_then ? 2 : 1);
 
-        command = new CCommand(name, path);
+    script = args[pos];
 
-        cmds.push_back(command);
+    return true;
+  }
 
-        command->addPipeSrc();
-      }
-      else if (arg == "<") {
-        if (i >= numArgs - 1) {
-          throwError("can't specify \"" + arg + "\" as last word in command");
-          return CTclValueRef();
-        }
+  uint pos = (has_then ? 3 : 2);
 
-        ++i;
+  while (pos < numArgs) {
+    const std::string &name = args[pos]->toString();
 
-        const std::string &src = args[i]->toString();
+    if      (name == "elseif") {
+      ++pos;
 
-        command->addFileSrc(src);
+      if  (pos >= numArgs) {
+        tcl_->throwError("wrong # args: no expression following \"elseif\" argument");
+        return false;
       }
-      else if (arg == "<@") {
-        if (i >= numArgs - 1) {
-          throwError("can't specify \"" + arg + "\" as last word in command");
-          return CTclValueRef();
-        }
 
-        ++i;
+      if (pos >= numArgs - 1) {
+        const std::string &arg = args[pos]->toString();
+        tcl_->throwError("wrong # args: no script following \"" + arg + "\" argument");
+        return false;
+      }
 
-        const std::string &fileId = args[i]->toString();
+      bool b = args[pos]->evalBool(tcl_);
 
-        FILE *fp = nullptr;
+      if (tcl_->isError()) return false;
 
-        if (fileId == "stdin")
-          fp = stdin;
-        else {
-          fp = getFile(fileId);
+      if (b) {
+        script = args[pos + 1];
 
-          if (fp == nullptr) {
-            throwError("can not find channel named \"" + fileId + "\"");
-            return CTclValueRef();
-          }
-        }
+        return true;
+      }
 
-        command->addFileSrc(fp);
+      pos += 2;
+    }
+    else if (name == "else") {
+      ++pos;
+
+      if (pos >= numArgs) {
+        tcl_->throwError("wrong # args: no script following \"else\" argument");
+        return false;
       }
-      else if (arg == "<<") {
+
+      if (pos < numArgs - 1) {
+        tcl_->throwError("wrong # args: extra words after \"else\" clause in \"if\" command");
+        return false;
       }
-      else if (arg == ">" || arg == ">&") {
-        if (i >= numArgs - 1) {
-          throwError("can't specify \"" + arg + "\" as last word in command");
-          return CTclValueRef();
-        }
 
-        ++i;
+      script = args[pos];
 
-        const std::string &dest = args[i]->toString();
+      return true;
+    }
+    else {
+      tcl_->throwError("invalid command name \"" + name + "\"");
+      return false;
+    }
+  }
 
-        command->addFileDest(dest);
+  return false;
+}
 
-        if (arg == ">&")
-          command->addFileDest(dest, 2);
-      }
-      else if (arg == "2>") {
-      }
-      else if (arg == ">>" || arg == ">>&") {
-        if (i >= numArgs - 1) {
-          throwError("can't specify \"" + arg + "\" as last word in command");
-          return CTclValueRef();
-        }
+//----------
 
-        ++i;
+CTclValueRef
+CTclIncrCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-        const std::string &dest = args[i]->toString();
+  if (numArgs < 1 || numArgs > 2)
+    return CTclValueRef();
 
-        command->addFileDest(dest);
+  const std::string &varName = args[0]->toString();
 
-        if (arg == ">>&")
-          command->addFileDest(dest, 2);
+  auto *scope = tcl_->getScope();
 
-        command->setFileDestAppend(true);
-      }
-      else if (arg == "2>>") {
-      }
-      else if (arg == ">@" || arg == ">&@") {
-        if (i >= numArgs - 1) {
-          throwError("can't specify \"" + arg + "\" as last word in command");
-          return CTclValueRef();
-        }
+  auto var = scope->getVariable(varName);
 
-        ++i;
+  if (! var.isValid()) {
+    tcl_->throwError("can't read \"" + varName + "\": no such variable");
+    return CTclValueRef();
+  }
 
-        const std::string &fileId = args[i]->toString();
+  auto value = var->getValue();
 
-        FILE *fp = nullptr;
+  long ivalue = 0, inc = 1;
 
-        if      (fileId == "stdout")
-          fp = stdout;
-        else if (fileId == "stderr")
-          fp = stderr;
-        else {
-          fp = getFile(fileId);
+  bool ok    = value->toInt(ivalue);
+  bool incOk = (numArgs == 1 || args[1]->toInt(inc));
 
-          if (fp == nullptr) {
-            throwError("can not find channel named \"" + fileId + "\"");
-            return CTclValueRef();
-          }
-        }
+  CTclValueRef value1;
 
-        command->addFileDest(fp);
+  long sum;
 
-        if (arg == ">&%")
-          command->addFileDest(fp, 2);
-      }
-      else if (arg == "2>@") {
-      }
-      else if (arg == "2>@1") {
-      }
-      else
-        command->addArg(arg);
+  if (ok && incOk && ! __builtin_add_overflow(ivalue, inc, &sum))
+    value1 = tcl_->createValue(sum);
+  else {
+    // value or increment too large for 64 bits (or sum overflows) so use big integer
+    CEvalBigInt bvalue(ok ? ivalue : 0L), binc(incOk ? inc : 0L);
+
+    if (! ok && ! CEvalBigInt::fromString(value->toString(), bvalue)) {
+      tcl_->throwError("expected integer but got \"" + value->toString() + "\"");
+      return CTclValueRef();
     }
 
-    uint num_cmds = cmds.size();
+    if (! incOk && ! CEvalBigInt::fromString(args[1]->toString(), binc)) {
+      tcl_->throwError("expected integer but got \"" + args[1]->toString() + "\"");
+      return CTclValueRef();
+    }
 
-    for (uint i = 0; i < num_cmds; ++i) {
-      auto *cmd = cmds[i];
+    value1 = tcl_->createValue((bvalue + binc).toString());
+  }
 
-      if (i == 0)
-        cmd->setProcessGroupLeader();
-      else
-        cmd->setProcessGroup(cmds[0]);
-    }
+  var->setValue(value1);
 
-    for (uint i = 0; i < num_cmds; ++i) {
-      auto *cmd = cmds[i];
+  return value1;
+}
 
-      cmd->start();
-    }
+//----------
 
-    for (uint i = 0; i < num_cmds; ++i) {
-      auto *cmd = cmds[i];
+CTclValueRef
+CTclInfoCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-      cmd->wait();
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("info option ?arg arg ...?");
+    return CTclValueRef();
+  }
+
+  const std::string &cmd = args[0]->toString();
+
+  if      (cmd == "args") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("info args procname");
+      return CTclValueRef();
     }
 
-    int rc = cmds[0]->getReturnCode();
+    const std::string &procName = args[1]->toString();
 
-    for (uint i = 0; i < num_cmds; ++i)
-      delete cmds[i];
+    auto *proc = tcl_->getProc(procName);
 
-    if (rc != 0)
-      throwError("child process exited abnormally (" + CStrUtil::toString(rc) + ")");
+    if (! proc) {
+      tcl_->throwError("\"" + procName + "\" is not a procedure");
+      return CTclValueRef();
+    }
 
-    return CTclValueRef();
-  }
-}
+    std::vector<std::string> args;
 
-std::string
-CTcl::
-lookupPathCommand(const std::string &name) const
-{
-  std::string value;
+    proc->getArgs(args);
 
-  if (! CEnvInst.get("PATH", value))
-    return "";
+    return CTclValueRef(tcl_->createValue(args));
+  }
+  else if (cmd == "body") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("info body procname");
+      return CTclValueRef();
+    }
 
-  std::vector<std::string> words;
+    const std::string &procName = args[1]->toString();
 
-  CStrUtil::addFields(value, words, ":");
+    auto *proc = tcl_->getProc(procName);
 
-  uint num_words = words.size();
+    if (! proc) {
+      tcl_->throwError("\"" + procName + "\" is not a procedure");
+      return CTclValueRef();
+    }
 
-  for (uint i = 0; i < num_words; ++i) {
-    std::string path = words[i] + "/" + name;
+    return proc->getBody();
+  }
+  else if (cmd == "cmdcount") {
+    return CTclValueRef(tcl_->createValue(tcl_->getCmdCount()));
+  }
+  else if (cmd == "commands") {
+    std::vector<std::string> names;
 
-    if (! CFile::isRegular(path) || ! CFile::isExecutable(path))
-      continue;
+    tcl_->getCommandNames(names);
 
-    return path;
+    return CTclValueRef(tcl_->createValue(names));
   }
+  else if (cmd == "complete") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("info complete command");
+      return CTclValueRef();
+    }
 
-  return "";
-}
+    const std::string &cmd = args[1]->toString();
 
-void
-CTcl::
-startFileParse(const std::string &fileName)
-{
-  parseStack_.push_back(parse_);
+    bool rc = tcl_->isCompleteLine(cmd);
+
+    return CTclValueRef(tcl_->createValue(long(rc ? 1 : 0)));
+  }
+  else if (cmd == "default") {
+  }
+  else if (cmd == "exists") {
+    if (numArgs != 2) {
+      tcl_->wrongNumArgs("info exists command");
+      return CTclValueRef();
+    }
 
-  parse_ = new CTclParse(this, fileName);
-}
+    auto *scope = tcl_->getScope();
 
-void
-CTcl::
-startStringParse(const std::string &str)
-{
-  parseStack_.push_back(parse_);
+    const std::string &varName = args[1]->toString();
 
-  parse_ = new CStrParse(str);
-}
+    auto var = scope->getVariable(varName);
 
-void
-CTcl::
-endParse()
-{
-  delete parse_;
+    return CTclValueRef(tcl_->createValue(long(var.isValid() ? 1 : 0)));
+  }
+  else if (cmd == "frame") {
+  }
+  else if (cmd == "functions") {
+  }
+  else if (cmd == "globals") {
+    auto *scope = tcl_->getGlobalScope();
 
-  parse_ = parseStack_.back();
+    std::vector<std::string> names;
 
-  parseStack_.pop_back();
-}
+    scope->getVariableNames(names);
 
-void
-CTcl::
-wrongNumArgs(const std::string &msg)
-{
-  throwError("wrong # args: should be \"" + msg + "\"");
-}
+    return CTclValueRef(tcl_->createValue(names));
+  }
+  else if (cmd == "hostname") {
+    std::string name = COSUser::getHostName();
 
-void
-CTcl::
-badInteger(CTclValueRef value)
-{
-  throwError("expected integer but got \"" + value->toString() + "\"");
-}
+    return CTclValueRef(tcl_->createValue(name));
+  }
+  else if (cmd == "level") {
+    return CTclValueRef(tcl_->createValue(long(tcl_->getLevel())));
+  }
+  else if (cmd == "library") {
+  }
+  else if (cmd == "loaded") {
+  }
+  else if (cmd == "locals") {
+  }
+  else if (cmd == "nameofexecutable") {
+  }
+  else if (cmd == "patchlevel") {
+  }
+  else if (cmd == "procs") {
+    std::vector<std::string> names;
 
-void
-CTcl::
-badReal(CTclValueRef value)
-{
-  throwError("expected number but got \"" + value->toString() + "\"");
-}
+    auto *scope = tcl_->getGlobalScope();
 
-void
-CTcl::
-throwError(const std::string &msg)
-{
-  unwindScope();
+    scope->getProcNames(names);
 
-  throw CTclError(msg);
-}
+    return CTclValueRef(tcl_->createValue(names));
+  }
+  else if (cmd == "script") {
+  }
+  else if (cmd == "sharedlibextension") {
+  }
+  else if (cmd == "tclversion") {
+  }
+  else if (cmd == "vars") {
+    auto *scope = tcl_->getScope();
 
-bool
-CTcl::
-needsBraces(const std::string &str)
-{
-  uint len = str.size();
+    std::vector<std::string> names;
 
-  bool is_space = false;
+    scope->getVariableNames(names);
 
-  for (uint i = 0; i < len; ++i) {
-    if (isspace(str[i])) {
-      is_space = true;
-      break;
-    }
+    return CTclValueRef(tcl_->createValue(names));
   }
 
-  return (len == 0 || is_space);
+  return CTclValueRef();
 }
 
-//--------------
-
-CTclParse::
-CTclParse(CTcl *tcl, const std::string &filename) :
- tcl_(tcl)
-{
-  file_ = new CFile(filename);
-}
+//----------
 
-CTclParse::
-~CTclParse()
+CTclValueRef
+CTclJoinCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  delete file_;
-}
+  uint numArgs = args.size();
 
-bool
-CTclParse::
-fillBuffer()
-{
-  std::string line;
+  if (numArgs == 0 || numArgs > 2) {
+    tcl_->wrongNumArgs("join list ?joinString?");
+    return CTclValueRef();
+  }
 
-  if (! file_->readLine(line))
-    return false;
+  CTclValueRef list;
 
-  uint len = line.size();
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
+  else
+    list = args[0]->toList(tcl_);
 
-  while (len > 0 && line[len - 1] == '\\') {
-    line = line.substr(0, len - 1);
+  std::string sep = " ";
 
-    std::string line1;
+  if (numArgs == 2)
+    sep = args[1]->toString();
 
-    if (file_->readLine(line1)) {
-      uint len1 = line1.size();
+  std::string res;
 
-      uint i = 0;
+  uint length = list->getLength();
 
-      while (i < len1 && isspace(line1[i]))
-        ++i;
+  for (uint i = 0; i < length; ++i) {
+    std::string item = list->getIndexValue(i)->toString();
 
-      line += " " + line1.substr(0);
-    }
+    if (i > 0) res += sep;
 
-    len = line.size();
+    res += item;
   }
 
-  if (getPos() > 0)
-    addString(tcl_->getSeparator() + line);
-  else
-    addString(line);
-
-  return true;
+  return CTclValueRef(tcl_->createValue(res));
 }
 
-bool
-CTclParse::
-eof() const
+//----------
+
+CTclValueRef
+CTclLAppendCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  if (! CStrParse::eof())
-    return false;
+  uint numArgs = args.size();
 
-  auto *th = const_cast<CTclParse *>(this);
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("lappend varName ?value value ...?");
+    return CTclValueRef();
+  }
 
-  th->fillBuffer();
+  const std::string &varName = args[0]->toString();
 
-  if (! CStrParse::eof())
-    return false;
+  auto *scope = tcl_->getScope();
 
-  return file_->eof();
-}
+  auto var = scope->getVariable(varName);
 
-//-----------
+  if (! var.isValid()) {
+    auto *list = new CTclList;
 
-CTclScope::
-CTclScope(CTcl *tcl, CTclScope *parent, const std::string &name) :
- tcl_(tcl), parent_(parent), name_(name)
-{
-}
+    scope->setVariableValue(varName, CTclValueRef(list));
 
-CTclScope::
-~CTclScope()
-{
-}
+    var = scope->getVariable(varName);
+  }
 
-CTclVariableRef
-CTclScope::
-addVariable(const std::string &varName, CTclValueRef value)
-{
-  auto *var = new CTclVariable(value);
+  auto value = var->getValue();
 
-  return addVariable(varName, CTclVariableRef(var));
-}
+  // convert variable value to list in place so appends are stored
+  if (value->getType() != CTclValue::ValueType::LIST) {
+    var->setValue(value->toList(tcl_));
 
-CTclVariableRef
-CTclScope::
-addVariable(const std::string &varName, CTclVariableRef var)
-{
-  assert(var.isValid());
+    value = var->getValue();
+  }
 
-  removeVariable(varName);
+  CTclValueRef list = value;
 
-  vars_[varName] = var;
+  for (uint i = 1; i < numArgs; ++i)
+    list->addValue(args[i]);
 
-  return var;
+  return CTclValueRef(list);
 }
 
-CTclVariableRef
-CTclScope::
-getVariable(const std::string &varName)
+//----------
+
+CTclValueRef
+CTclListCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  auto p = vars_.find(varName);
+  auto *list = new CTclList;
 
-  if (p == vars_.end())
-    return CTclVariableRef();
+  uint numArgs = args.size();
 
-  return (*p).second;
+  for (uint i = 0; i < numArgs; ++i)
+    list->addValue(args[i]);
+
+  return CTclValueRef(list);
 }
 
+//----------
+
 CTclValueRef
-CTclScope::
-getVariableValue(const std::string &varName)
+CTclLIndexCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  auto var = getVariable(varName);
+  uint numArgs = args.size();
+
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("lindex list ?index...?");
+    return CTclValueRef();
+  }
+
+  if (numArgs == 1) {
+    if (args[0]->getType() == CTclValue::ValueType::LIST)
+      return args[0];
+    else
+      return args[0]->toList(tcl_);
+  }
 
-  if (var.isValid())
-    return var->getValue();
-  else
+  long ind;
+
+  if (! args[1]->toIndex(tcl_, ind))
     return CTclValueRef();
-}
 
-CTclValueRef
-CTclScope::
-getArrayVariableValue(const std::string &varName, const std::string &indexStr)
-{
-  auto var = getVariable(varName);
+  CTclValueRef list;
 
-  if (var.isValid())
-    return var->getArrayValue(indexStr);
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
   else
-    return CTclValueRef();
-}
+    list = args[0]->toList(tcl_);
 
-void
-CTclScope::
-setArrayVariableValue(const std::string &varName, const std::string &indexStr, CTclValueRef value)
-{
-  auto var = getVariable(varName);
+  int length = list->getLength();
 
-  if (! var.isValid()) {
-    auto *array = new CTclArray;
+  if (ind < 0) ind = length + ind;
 
-    array->setValue(indexStr, value);
+  if (ind < 0 || ind >= length)
+    return CTclValueRef();
 
-    setVariableValue(varName, CTclValueRef(array));
-  }
-  else
-    return var->setArrayValue(indexStr, value);
+  return list->getIndexValue(ind);
 }
 
-void
-CTclScope::
-getVariableNames(std::vector<std::string> &names) const
+//----------
+
+CTclValueRef
+CTclLInsertCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  for (const auto &pv : vars_) {
-    const auto &name = pv.first;
+  uint numArgs = args.size();
 
-    names.push_back(name);
+  if (numArgs < 3) {
+    tcl_->wrongNumArgs("linsert list index element ?element ...?");
+    return CTclValueRef();
   }
-}
 
-void
-CTclScope::
-setVariableValue(const std::string &varName, CTclValueRef value)
-{
-  auto p = vars_.find(varName);
+  long ind;
 
-  if (p == vars_.end()) {
-    auto *var = new CTclVariable;
+  if (! args[1]->toIndex(tcl_, ind))
+    return CTclValueRef();
 
-    p = vars_.insert(p, VariableList::value_type(varName, CTclVariableRef(var)));
-  }
+  CTclValueRef list;
 
-  auto var = (*p).second;
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
+  else
+    list = args[0]->toList(tcl_);
 
-  var->setValue(value);
-}
+  int length = list->getLength();
 
-void
-CTclScope::
-removeVariable(const std::string &varName)
-{
-  auto p = vars_.find(varName);
+  if (ind < 0) ind = length + ind;
 
-  if (p != vars_.end())
-    vars_.erase(p);
-}
+  if (ind < 0 || ind > length)
+    return CTclValueRef();
 
-CTclProc *
-CTclScope::
-defineProc(const std::string &name, const std::vector<std::string> &args, CTclValueRef body)
-{
-  removeProc(name);
+  auto *list1 = new CTclList;
 
-  auto *proc = new CTclProc(tcl_, name, args, body);
+  for (int i = 0; i < ind; ++i)
+    list1->addValue(list->getIndexValue(i));
 
-  procs_[name] = proc;
+  for (uint i = 2; i < numArgs; ++i)
+    list1->addValue(args[i]);
 
-  return proc;
+  for (uint i = ind; i < numArgs; ++i)
+    list1->addValue(list->getIndexValue(i));
+
+  return CTclValueRef(list1);
 }
 
-CTclProc *
-CTclScope::
-getProc(const std::string &varName)
-{
-  auto p = procs_.find(varName);
+//----------
 
-  if (p == procs_.end())
-    return nullptr;
+CTclValueRef
+CTclLLengthCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-  return (*p).second;
-}
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("llength list");
+    return CTclValueRef();
+  }
 
-void
-CTclScope::
-removeProc(const std::string &name)
-{
-  auto p = procs_.find(name);
+  CTclValueRef list;
 
-  if (p != procs_.end()) {
-    auto *proc = (*p).second;
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
+  else
+    list = args[0]->toList(tcl_);
 
-    procs_.erase(p);
+  auto length = list->getLength();
 
-    delete proc;
-  }
+  return CTclValueRef(tcl_->createValue(ulong(length)));
 }
 
-void
-CTclScope::
-getProcNames(std::vector<std::string> &names)
+//----------
+
+CTclValueRef
+CTclLRangeCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  for (const auto &pp : procs_) {
-    auto *proc = pp.second;
+  uint numArgs = args.size();
 
-    names.push_back(proc->getName());
+  if (numArgs != 3) {
+    tcl_->wrongNumArgs("lrange list first last");
+    return CTclValueRef();
   }
-}
 
-CTclScope *
-CTclScope::
-getNamedScope(const std::string &name, bool create_it)
-{
-  auto p = scopeMap_.find(name);
+  CTclValueRef list;
 
-  if (p != scopeMap_.end())
-    return (*p).second;
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
+  else
+    list = args[0]->toList(tcl_);
 
-  if (! create_it)
-    return nullptr;
+  int length = list->getLength();
 
-  auto *scope = new CTclScope(tcl_, this, name);
+  long first;
 
-  scopeMap_[name] = scope;
+  if (! args[1]->toIndex(tcl_, first))
+    return CTclValueRef();
 
-  return scope;
-}
+  long last;
 
-//-----------
+  if (! args[2]->toIndex(tcl_, last))
+    return CTclValueRef();
 
-uint CTclVariable::notifyProcId_;
+  auto *list1 = new CTclList;
 
-CTclVariable::
-CTclVariable(CTclValueRef value)
-{
-  if (value.isValid())
-    value_ = CTclValueRef(value->dup());
-  else
-    value_ = CTclValueRef();
-}
+  for (int i = first; i <= last && i >= 0 && i < length; ++i) {
+    auto value = list->getIndexValue(i);
 
-CTclVariable::
-~CTclVariable()
-{
+    list1->addValue(CTclValueRef(value->dup()));
+  }
+
+  return CTclValueRef(list1);
 }
 
-std::string
-CTclVariable::
-toString() const
+//----------
+
+CTclValueRef
+CTclLRepeatCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  if (hasValue())
-    return getValue()->toString();
+  uint numArgs = args.size();
 
-  return "";
-}
+  if (numArgs < 2) {
+    tcl_->wrongNumArgs("lrepeat positiveCount value ?value ...?");
+    return CTclValueRef();
+  }
 
-bool
-CTclVariable::
-toBool() const
-{
-  if (hasValue())
-    return getValue()->toBool();
+  long count;
 
-  return false;
-}
+  if (! args[0]->toIndex(tcl_, count))
+    return CTclValueRef();
 
-bool
-CTclVariable::
-hasValue() const
-{
-  return value_.isValid();
+  auto *list = new CTclList;
+
+  for (int i = 0; i < count; ++i) {
+    for (uint j = 1; j < numArgs; ++j)
+      list->addValue(CTclValueRef(args[j]->dup()));
+  }
+
+  return CTclValueRef(list);
 }
 
+//----------
+
 CTclValueRef
-CTclVariable::
-getValue() const
+CTclLReplaceCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  return value_;
-}
+  uint numArgs = args.size();
+
+  if (numArgs < 3) {
+    tcl_->wrongNumArgs("lreplace list first last ?element element ...?");
+    return CTclValueRef();
+  }
+
+  CTclValueRef list;
 
-void
-CTclVariable::
-setValue(CTclValueRef value)
-{
-  if (value.isValid())
-    value_ = CTclValueRef(value->dup());
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
   else
-    value_ = CTclValueRef();
+    list = args[0]->toList(tcl_);
 
-  callNotifyProcs();
-}
+  long ind1, ind2;
 
-CTclValueRef
-CTclVariable::
-getArrayValue(const std::string &indexStr) const
-{
-  if (! hasValue())
+  if (! args[1]->toIndex(tcl_, ind1))
     return CTclValueRef();
 
-  if (value_->getType() == CTclValue::ValueType::ARRAY)
-    return value_.cast<CTclArray>()->getValue(indexStr);
-  else
+  if (! args[2]->toIndex(tcl_, ind2))
     return CTclValueRef();
-}
 
-void
-CTclVariable::
-setArrayValue(const std::string &indexStr, CTclValueRef value)
-{
-  if (value_->getType() == CTclValue::ValueType::ARRAY)
-    value_.cast<CTclArray>()->setValue(indexStr, value);
+  int length = list->getLength();
 
-  callNotifyProcs();
-}
+  if (ind1 < 0) ind1 += length;
+  if (ind2 < 0) ind2 += length;
 
-void
-CTclVariable::
-appendValue(CTclValueRef value)
-{
-  if (hasValue()) {
-    if      (value_->getType() == CTclValue::ValueType::STRING)
-      value_.cast<CTclString>()->appendValue(value->toString());
-    else if (value_->getType() == CTclValue::ValueType::LIST)
-      value_.cast<CTclList>()->addValue(value);
-    else
-      setValue(value);
+  auto *list1 = new CTclList;
+
+  if (ind1 < 0 || ind1 >= length) {
+    tcl_->throwError("list doesn't contain element " + CStrUtil::toString(ind1));
+    return CTclValueRef();
   }
-  else
-    setValue(value);
-}
 
-uint
-CTclVariable::
-addNotifyProc(CTclVariableProc *proc)
-{
-  ++notifyProcId_;
+  if (ind2 < 0 || ind2 >= length) {
+    tcl_->throwError("list doesn't contain element " + CStrUtil::toString(ind2));
+    return CTclValueRef();
+  }
 
-  proc->setId(notifyProcId_);
+  for (int i = 0; i < ind1 && i < int(length); ++i) {
+    auto value = list->getIndexValue(i);
 
-  notifyProcs_.push_back(proc);
+    list1->addValue(value);
+  }
 
-  return notifyProcId_;
-}
+  for (uint i = 3; i < numArgs; ++i)
+    list1->addValue(args[i]);
 
-void
-CTclVariable::
-callNotifyProcs()
-{
-  for (auto *pn : notifyProcs_)
-    pn->notify(this);
-}
+  for (int i = ind2 + 1; i < int(length); ++i) {
+    auto value = list->getIndexValue(i);
 
-//----------
+    list1->addValue(value);
+  }
 
-CTclEnvVariable::
-CTclEnvVariable()
-{
+  return CTclValueRef(list1);
 }
 
+//----------
+
 CTclValueRef
-CTclEnvVariable::
-getArrayValue(const std::string &indexStr) const
+CTclLSearchCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  std::string value;
-
-  if (! CEnvInst.get(indexStr, value))
-    value = "";
+#if 0
+  static CommandOpts[] = {
+    { "-exact"      , COMMAND_OPT_FLAG },
+    { "-glob"       , COMMAND_OPT_FLAG },
+    { "-regexp"     , COMMAND_OPT_FLAG },
+    { "-sorted"     , COMMAND_OPT_FLAG },
+    { "-all"        , COMMAND_OPT_FLAG },
+    { "-inline"     , COMMAND_OPT_FLAG },
+    { "-not"        , COMMAND_OPT_FLAG },
+    { "-start"      , COMMAND_OPT_FLAG },
+    { "-ascii"      , COMMAND_OPT_FLAG },
+    { "-dictionary" , COMMAND_OPT_FLAG },
+    { "-integer"    , COMMAND_OPT_FLAG },
+    { "-nocase"     , COMMAND_OPT_FLAG },
+    { "-real"       , COMMAND_OPT_FLAG },
+    { "-decreasing" , COMMAND_OPT_FLAG },
+    { "-increasing" , COMMAND_OPT_FLAG },
+    { "-index"      , COMMAND_OPT_LIST },
+    { "-subindices" , COMMAND_OPT_FLAG },
+  };
+#endif
 
-  return CTclValueRef(new CTclString(value));
-}
+  uint numArgs = args.size();
 
-//----------
+  if (numArgs != 2) {
+    tcl_->wrongNumArgs("lsearch ?options? list pattern");
+    return CTclValueRef();
+  }
 
-void
-CTclString::
-print(std::ostream &os) const
-{
-  os << str_;
-}
+  CTclValueRef list;
 
-std::string
-CTclString::
-toString() const
-{
-  return str_;
-}
+  if (args[0]->getType() == CTclValue::ValueType::LIST)
+    list = args[0];
+  else
+    list = args[0]->toList(tcl_);
 
-bool
-CTclString::
-toInt(long &i) const
-{
-  i = 0;
+  auto value = args[1];
 
-  long l = 0;
+  auto length = list->getLength();
 
-  if (! CStrUtil::toInteger(str_, &l))
-    return false;
+  for (uint i = 0; i < length; ++i) {
+    auto value1 = list->getIndexValue(i);
 
-  i = l;
+    if (value1->cmp(value) == 0)
+      return CTclValueRef(tcl_->createValue(ulong(i)));
+  }
 
-  return true;
+  return CTclValueRef(tcl_->createValue(-1L));
 }
 
-bool
-CTclString::
-toReal(double &r) const
+//----------
+
+CTclValueRef
+CTclLSetCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  r = 0.0;
+  uint numArgs = args.size();
 
-  if (! CStrUtil::toReal(str_, &r))
-    return false;
+  if (numArgs < 2) {
+    tcl_->wrongNumArgs("lset listVar index ?index...? value");
+    return CTclValueRef();
+  }
 
-  return true;
-}
+  auto *scope = tcl_->getScope();
 
-bool
-CTclString::
-toBool() const
-{
-  bool b;
+  const std::string &varName = args[0]->toString();
 
-  if (! CStrUtil::toBool(str_, &b))
-    b = false;
+  auto var = scope->getVariable(varName);
 
-  return b;
-}
+  if (! var.isValid()) {
+    tcl_->throwError("can't read \"" + varName + "\": no such variable");
+    return CTclValueRef();
+  }
 
-CTclValueRef
-CTclString::
-toList(CTcl *tcl) const
-{
-  std::vector<CTclValueRef> args;
+  if (numArgs > 2) {
+    auto value = var->getValue();
 
-  auto *list = tcl->stringToList(str_);
+    for (uint i = 1; i < numArgs - 2; ++i) {
+      CTclValueRef list;
 
-  return CTclValueRef(list);
-}
+      if (value->getType() == CTclValue::ValueType::LIST)
+        list = value;
+      else
+        list = value->toList(tcl_);
 
-//----------
+      long ind;
 
-std::string
-CTclArray::
-toString() const
-{
-  return "";
-}
+      if (! args[i]->toIndex(tcl_, ind))
+        return CTclValueRef();
 
-void
-CTclArray::
-print(std::ostream &os) const
-{
-  os << "{";
+      value = list->getIndexValue(ind);
+    }
 
-  for (const auto &pv : values_) {
-    os << " " << pv.first << "=";
+    CTclValueRef list;
 
-    pv.second->print(os);
-  }
+    if (value->getType() == CTclValue::ValueType::LIST)
+      list = value;
+    else
+      list = value->toList(tcl_);
 
-  os << "}";
-}
+    long ind;
 
-bool
-CTclArray::
-toBool() const
-{
-  return ! values_.empty();
-}
+    if (! args[numArgs - 2]->toIndex(tcl_, ind))
+      return CTclValueRef();
 
-//----------
+    list->setIndexValue(ind, args[numArgs - 1]);
 
-bool
-CTclList::
-toBool() const
-{
-  return ! values_.empty();
+    var->setValue(list);
+  }
+  else
+    var->setValue(args[1]);
+
+  return var->getValue();
 }
 
-std::string
-CTclList::
-toString() const
+//----------
+
+// lsort ?-ascii|-integer|-real? list
+CTclValueRef
+CTclLSortCommand::
+exec(const std::vector<CTclValueRef> &args)
 {
-  std::string str;
+  uint numArgs = args.size();
 
-  for (const auto &pv : values_) {
-    auto str1 = pv->toString();
+  enum class SortType { ASCII, INTEGER, REAL };
 
-    if (! str.empty()) str += " ";
+  SortType sortType = SortType::ASCII;
 
-    if (CTcl::needsBraces(str1))
-      str += "{" + str1 + "}";
-    else
-      str += str1;
+  uint i = 0;
+
+  for ( ; i + 1 < numArgs; ++i) {
+    const std::string &opt = args[i]->toString();
+
+    if      (opt == "-ascii"  ) sortType = SortType::ASCII;
+    else if (opt == "-integer") sortType = SortType::INTEGER;
+    else if (opt == "-real"   ) sortType = SortType::REAL;
+    else {
+      tcl_->throwError("bad option \"" + opt + "\": must be -ascii, -integer or -real");
+      return CTclValueRef();
+    }
   }
 
-  return str;
-}
+  if (i + 1 != numArgs) {
+    tcl_->wrongNumArgs("lsort ?options? list");
+    return CTclValueRef();
+  }
 
-void
-CTclList::
-print(std::ostream &os) const
-{
-  std::string str = toString();
+  CTclValueRef list;
 
-  os << str;
-}
+  if (args[i]->getType() == CTclValue::ValueType::LIST)
+    list = args[i];
+  else
+    list = args[i]->toList(tcl_);
 
-//----------
+  // numeric sort : convert each element once and sort on key
+  if (sortType != SortType::ASCII) {
+    struct KeyValue {
+      long         ikey { 0 };
+      double       rkey { 0.0 };
+      CTclValueRef value;
+    };
 
-bool
-CTclValue::
-checkInt(CTcl *tcl, long &i)
-{
-  bool ok = toInt(i);
+    std::vector<KeyValue> keyValues;
 
-  if (! ok)
-    tcl->badInteger(CTclValueRef(this));
+    uint length = list->getLength();
 
-  return ok;
-}
+    keyValues.reserve(length);
 
-bool
-CTclValue::
-checkReal(CTcl *tcl, double &r)
-{
-  bool ok = toReal(r);
+    for (uint j = 0; j < length; ++j) {
+      auto value = list->getIndexValue(j);
 
-  if (! ok)
-    tcl->badReal(CTclValueRef(this));
+      KeyValue kv;
 
-  return ok;
-}
+      kv.value = value;
 
-bool
-CTclValue::
-toIndex(CTcl *tcl, long &ind)
-{
-  bool ok = toInt(ind);
+      bool ok = (sortType == SortType::INTEGER ? value->toInt(kv.ikey) : value->toReal(kv.rkey));
 
-  if (! ok) {
-    const std::string &str = toString();
+      if (! ok) {
+        tcl_->throwError(std::string("expected ") +
+                         (sortType == SortType::INTEGER ? "integer" : "floating-point number") +
+                         " but got \"" + value->toString() + "\"");
+        return CTclValueRef();
+      }
 
-    if (str == "end") {
-      ind = -1;
+      keyValues.push_back(kv);
     }
-    else if (str.size() > 4 && str.substr(0, 4) == "end-") {
-      std::string str1 = str.substr(4);
 
-      long ind1;
+    if (sortType == SortType::INTEGER)
+      std::stable_sort(keyValues.begin(), keyValues.end(),
+        [](const KeyValue &lhs, const KeyValue &rhs) { return lhs.ikey < rhs.ikey; });
+    else
+      std::stable_sort(keyValues.begin(), keyValues.end(),
+        [](const KeyValue &lhs, const KeyValue &rhs) { return lhs.rkey < rhs.rkey; });
 
-      bool ok1 = CStrUtil::toInteger(str1, &ind1);
+    auto *list1 = new CTclList;
 
-      if (ok1)
-        ind = -ind1 - 1;
-    }
-    else {
-      tcl->throwError("bad index \"" + toString() + "\": must be integer or end?-integer?");
-      return false;
-    }
-  }
+    for (const auto &kv : keyValues)
+      list1->addValue(kv.value);
 
-  return true;
-}
+    return CTclValueRef(list1);
+  }
 
-CTclValueRef
-CTclValue::
-eval(CTcl *tcl) const
-{
-  const std::string &str = toString();
+  typedef std::set<CTclValueRef> ValueSet;
 
-  return tcl->evalString(str);
-}
+  ValueSet valueSet;
 
-bool
-CTclValue::
-evalBool(CTcl *tcl) const
-{
-  auto value = eval(tcl);
+  uint length = list->getLength();
 
-  return value->toBool();
-}
+  for (uint i = 0; i < length; ++i) {
+    auto value = list->getIndexValue(i);
 
-CTclValueRef
-CTclValue::
-exec(CTcl *tcl) const
-{
-  const std::string &str = toString();
+    valueSet.insert(value);
+  }
 
-  return tcl->parseString(str);
-}
+  auto *list1 = new CTclList;
 
-//----------
+  for (const auto &vs : valueSet)
+    list1->addValue(vs);
 
-CTclValueRef
-CTclCommentCommand::
-exec(const std::vector<CTclValueRef> &)
-{
-  return CTclValueRef();
+  return CTclValueRef(list1);
 }
 
 //----------
 
+// memory info|data|usage ?varName?|resetpeak|pool
+// memory sites start|stop|clear|report ?-limit n?|data|snapshot name|diff name ?name?
+//
+// value counts and sites are process wide (see CTclProcessMemory)
 CTclValueRef
-CTclAfterCommand::
+CTclMemoryCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
+  static const char *typeNames[] = { "none", "string", "array", "list", "map" };
+
   uint numArgs = args.size();
 
   if (numArgs < 1) {
-    tcl_->wrongNumArgs("after option ?arg arg ...?");
+    tcl_->wrongNumArgs("memory option ?arg ...?");
     return CTclValueRef();
   }
 
   const std::string &opt = args[0]->toString();
 
-  if      (opt == "cancel") {
-    if (numArgs < 2) {
-      tcl_->wrongNumArgs("after cancel id|command");
+  uint  numParse;
+  ulong parseBytes;
+
+  tcl_->getParseMemory(numParse, parseBytes);
+
+  if      (opt == "info") {
+    std::string str =
+      CStrUtil::strprintf("%-8s %10s %12s %10s %12s %12s\n",
+                          "type", "count", "bytes", "peak count", "peak bytes", "allocs");
+
+    for (uint i = 1; i < CTclProcessMemory::NUM_TYPES; ++i) {
+      const auto &stats = CTclProcessMemory::getStats(CTclValue::ValueType(i));
+
+      str += CStrUtil::strprintf("%-8s %10ld %12ld %10ld %12ld %12lu\n", typeNames[i],
+                                 stats.count, stats.bytes, stats.peakCount, stats.peakBytes,
+                                 stats.allocs);
+    }
+
+    str += CStrUtil::strprintf("%-8s %10s %12ld %10s %12ld\n", "total", "",
+                               CTclProcessMemory::getTotalBytes(), "",
+                               CTclProcessMemory::getPeakBytes());
+
+    str += CStrUtil::strprintf("scopes %ld\n", CTclProcessMemory::getNumScopes());
+    str += CStrUtil::strprintf("parse buffers %u (%lu bytes)", numParse, parseBytes);
+
+    return tcl_->createValue(str);
+  }
+  else if (opt == "data") {
+    // name value list : <type>.count, <type>.bytes, ...
+    std::vector<CTclValueRef> values;
+
+    auto addValue = [&](const std::string &name, long value) {
+      values.push_back(tcl_->createValue(name));
+      values.push_back(tcl_->createValue(value));
+    };
+
+    for (uint i = 1; i < CTclProcessMemory::NUM_TYPES; ++i) {
+      const auto &stats = CTclProcessMemory::getStats(CTclValue::ValueType(i));
+
+      std::string name = typeNames[i];
+
+      addValue(name + ".count"    , stats.count);
+      addValue(name + ".bytes"    , stats.bytes);
+      addValue(name + ".peakCount", stats.peakCount);
+      addValue(name + ".peakBytes", stats.peakBytes);
+    }
+
+    addValue("total.bytes"    , CTclProcessMemory::getTotalBytes());
+    addValue("total.peakBytes", CTclProcessMemory::getPeakBytes());
+    addValue("scopes"         , CTclProcessMemory::getNumScopes());
+    addValue("parse.count"    , long(numParse));
+    addValue("parse.bytes"    , long(parseBytes));
+
+    return tcl_->createValue(values);
+  }
+  else if (opt == "usage") {
+    if (numArgs > 2) {
+      tcl_->wrongNumArgs("memory usage ?varName?");
       return CTclValueRef();
     }
 
-    for (uint i = 1; i < numArgs; ++i) {
-      const std::string &id = args[i]->toString();
+    // bytes of variable value (including elements)
+    if (numArgs == 2) {
+      const std::string &varName = args[1]->toString();
 
-      tcl_->cancelTimer(id);
+      auto var = tcl_->getVariable(varName);
+
+      if (! var.isValid()) {
+        tcl_->throwError("can't read \"" + varName + "\": no such variable");
+        return CTclValueRef();
+      }
+
+      auto value = var->peekValue();
+
+      return tcl_->createValue(long(value.isValid() ? value->memUsage() : 0));
     }
+
+    // {name bytes} of variables in current scope, largest first
+    std::vector<std::string> names;
+
+    tcl_->getScope()->getVariableNames(names);
+
+    using NameBytes = std::pair<std::string,ulong>;
+
+    std::vector<NameBytes> nameBytes;
+
+    for (const auto &name : names) {
+      auto var = tcl_->getScope()->getVariable(name);
+
+      auto value = (var.isValid() ? var->peekValue() : CTclValueRef());
+
+      nameBytes.push_back(NameBytes(name, value.isValid() ? value->memUsage() : 0));
+    }
+
+    std::stable_sort(nameBytes.begin(), nameBytes.end(),
+      [](const NameBytes &lhs, const NameBytes &rhs) { return lhs.second > rhs.second; });
+
+    std::vector<CTclValueRef> values;
+
+    for (const auto &nb : nameBytes) {
+      std::vector<CTclValueRef> values1;
+
+      values1.push_back(tcl_->createValue(nb.first));
+      values1.push_back(tcl_->createValue(nb.second));
+
+      values.push_back(tcl_->createValue(values1));
+    }
+
+    return tcl_->createValue(values);
   }
-  else if (opt == "idle") {
+  else if (opt == "resetpeak") {
+    CTclProcessMemory::resetPeak();
+  }
+  else if (opt == "sites") {
     if (numArgs < 2) {
-      tcl_->wrongNumArgs("after idle script script ...");
+      tcl_->wrongNumArgs("memory sites start|stop|clear|report ?-limit n?|data|"
+                         "snapshot name|diff name ?name?");
       return CTclValueRef();
     }
 
-    std::string str;
+    const std::string &opt1 = args[1]->toString();
 
-    for (uint i = 1; i < numArgs; ++i) {
-      if (i > 1) str += " ";
+    // site stats sorted by live bytes
+    auto sortedSites = [](const CTclProcessMemory::Snapshot &snapshot) {
+      std::vector<CTclProcessMemory::SiteStats> sites;
 
-      str += args[i]->toString();
+      for (const auto &ps : snapshot)
+        sites.push_back(ps.second);
+
+      std::stable_sort(sites.begin(), sites.end(),
+        [](const CTclProcessMemory::SiteStats &lhs, const CTclProcessMemory::SiteStats &rhs) {
+          return lhs.bytes > rhs.bytes;
+        });
+
+      return sites;
+    };
+
+    if      (opt1 == "start") {
+      tcl_->startMemorySites();
     }
+    else if (opt1 == "stop") {
+      tcl_->stopMemorySites();
+    }
+    else if (opt1 == "clear") {
+      CTclProcessMemory::clearSites();
 
-    std::string name = tcl_->addTimer(0, str);
+      if (tcl_->isMemorySites())
+        tcl_->startMemorySites();
+    }
+    else if (opt1 == "report") {
+      long limit = 0;
 
-    return tcl_->createValue(name);
-  }
-  else if (opt == "info") {
-    if (numArgs == 1) {
-      std::vector<std::string> names;
+      if      (numArgs == 4 && args[2]->toString() == "-limit") {
+        if (! args[3]->checkInt(tcl_, limit))
+          return CTclValueRef();
+      }
+      else if (numArgs != 2) {
+        tcl_->wrongNumArgs("memory sites report ?-limit n?");
+        return CTclValueRef();
+      }
 
-      tcl_->getTimerNames(names);
+      CTclProcessMemory::Snapshot snapshot;
 
-      return tcl_->createValue(names);
+      CTclProcessMemory::getSnapshot(snapshot);
+
+      auto sites = sortedSites(snapshot);
+
+      std::string str =
+        CStrUtil::strprintf("%-32s %10s %12s %10s\n", "site", "count", "bytes", "allocs");
+
+      long n = 0;
+
+      for (const auto &site : sites) {
+        if (limit > 0 && n++ >= limit) break;
+
+        str += CStrUtil::strprintf("%-32s %10ld %12ld %10lu\n", site.name.c_str(),
+                                   site.count, site.bytes, site.allocs);
+      }
+
+      return tcl_->createValue(str);
     }
-    else {
-      std::vector<CTclValueRef> values;
+    else if (opt1 == "data") {
+      // list of {site count bytes allocs}
+      CTclProcessMemory::Snapshot snapshot;
 
-      for (uint i = 1; i < numArgs; ++i) {
-        const std::string &id = args[i]->toString();
+      CTclProcessMemory::getSnapshot(snapshot);
 
-        auto *timer = tcl_->getTimer(id);
+      std::vector<CTclValueRef> values;
 
-        if (timer) {
-          std::vector<CTclValueRef> values1;
+      for (const auto &site : sortedSites(snapshot)) {
+        std::vector<CTclValueRef> values1;
 
-          values1.push_back(tcl_->createValue(timer->getName  ()));
-          values1.push_back(tcl_->createValue(timer->getScript()));
+        values1.push_back(tcl_->createValue(site.name));
+        values1.push_back(tcl_->createValue(site.count));
+        values1.push_back(tcl_->createValue(site.bytes));
+        values1.push_back(tcl_->createValue(site.allocs));
 
-          values.push_back(tcl_->createValue(values1));
-        }
-        else
-          tcl_->throwError("event \"" + id + "\" doesn't exist");
+        values.push_back(tcl_->createValue(values1));
       }
 
       return tcl_->createValue(values);
     }
-  }
-  else {
-    long ms;
-
-    bool ok = args[0]->toInt(ms);
+    else if (opt1 == "snapshot") {
+      if (numArgs != 3) {
+        tcl_->wrongNumArgs("memory sites snapshot name");
+        return CTclValueRef();
+      }
 
-    if (! ok) {
-      tcl_->throwError("bad argument \"" + opt + "\": must be "
-                       "cancel, idle, info, or a number");
-      return CTclValueRef();
+      CTclProcessMemory::saveSnapshot(args[2]->toString());
     }
+    else if (opt1 == "diff") {
+      // list of {site count bytes} changed from snapshot name to name (or current)
+      if (numArgs != 3 && numArgs != 4) {
+        tcl_->wrongNumArgs("memory sites diff name ?name?");
+        return CTclValueRef();
+      }
 
-    if (numArgs == 1)
-      COSTimer::milli_sleep(ms);
-    else {
-      std::string str;
+      CTclProcessMemory::Snapshot snapshot1, snapshot2;
 
-      for (uint i = 1; i < numArgs; ++i) {
-        if (i > 1) str += " ";
+      for (uint i = 2; i < numArgs; ++i) {
+        auto &snapshot = (i == 2 ? snapshot1 : snapshot2);
 
-        str += args[i]->toString();
+        const std::string &name = args[i]->toString();
+
+        if (! CTclProcessMemory::getSavedSnapshot(name, snapshot)) {
+          tcl_->throwError("unknown snapshot \"" + name + "\"");
+          return CTclValueRef();
+        }
       }
 
-      std::string name = tcl_->addTimer(ms, str);
+      if (numArgs == 3)
+        CTclProcessMemory::getSnapshot(snapshot2);
 
-      return tcl_->createValue(name);
-    }
-  }
+      CTclProcessMemory::Snapshot diff;
 
-  return CTclValueRef();
-}
+      for (const auto &ps : snapshot2) {
+        auto &site = diff[ps.first];
 
-//----------
+        site.name   = ps.first;
+        site.count  = ps.second.count;
+        site.bytes  = ps.second.bytes;
+        site.allocs = ps.second.allocs;
+      }
 
-CTclValueRef
-CTclAppendCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+      for (const auto &ps : snapshot1) {
+        auto &site = diff[ps.first];
 
-  if (numArgs < 2) {
-    tcl_->wrongNumArgs("append varName ?value value ...?");
-    return CTclValueRef();
+        site.name    = ps.first;
+        site.count  -= ps.second.count;
+        site.bytes  -= ps.second.bytes;
+        site.allocs -= ps.second.allocs;
+      }
+
+      std::vector<CTclValueRef> values;
+
+      for (const auto &site : sortedSites(diff)) {
+        if (site.count == 0 && site.bytes == 0) continue;
+
+        std::vector<CTclValueRef> values1;
+
+        values1.push_back(tcl_->createValue(site.name));
+        values1.push_back(tcl_->createValue(site.count));
+        values1.push_back(tcl_->createValue(site.bytes));
+
+        values.push_back(tcl_->createValue(values1));
+      }
+
+      return tcl_->createValue(values);
+    }
+    else {
+      tcl_->throwError("bad option \"" + opt1 + "\": must be clear, data, diff, report, "
+                       "snapshot, start, or stop");
+      return CTclValueRef();
+    }
   }
+  else if (opt == "pool") {
+    if (numArgs != 1) {
+      tcl_->wrongNumArgs("memory pool");
+      return CTclValueRef();
+    }
 
-  auto *scope = tcl_->getScope();
+    // name value list of value pool stats and free blocks per size class
+    const auto &stats = CTclValuePool::getStats();
 
-  const std::string &varName = args[0]->toString();
+    std::vector<CTclValueRef> values;
 
-  auto var = scope->getVariable(varName);
+    auto addValue = [&](const std::string &name, ulong value) {
+      values.push_back(tcl_->createValue(name));
+      values.push_back(tcl_->createValue(value));
+    };
 
-  if (! var.isValid()) {
-    scope->setVariableValue(varName, args[1]);
+    addValue("allocs", stats.allocs);
+    addValue("reused", stats.reused);
+    addValue("large" , stats.large);
+    addValue("chunks", stats.chunks);
+    addValue("bytes" , stats.bytes);
 
-    var = scope->getVariable(varName);
+    for (uint c = 0; c < CTclValuePool::NUM_CLASSES; ++c) {
+      if (CTclValuePool::numFree(c) == 0) continue;
 
-    for (uint i = 2; i < numArgs; ++i)
-      var->appendValue(args[i]);
+      addValue(CStrUtil::strprintf("free.%lu", ulong(CTclValuePool::classSize(c))),
+               CTclValuePool::numFree(c));
+    }
+
+    return tcl_->createValue(values);
   }
   else {
-    for (uint i = 1; i < numArgs; ++i)
-      var->appendValue(args[i]);
+    tcl_->throwError("bad option \"" + opt + "\": must be data, info, pool, resetpeak, "
+                     "sites, or usage");
+    return CTclValueRef();
   }
 
   return CTclValueRef();
@@ -2706,278 +7540,419 @@ exec(const std::vector<CTclValueRef> &args)
 //----------
 
 CTclValueRef
-CTclArrayCommand::
+CTclNamespaceCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs < 2) {
-    tcl_->wrongNumArgs("array option arrayName ?arg ...?");
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("namespace subcommand ?arg ...?");
     return CTclValueRef();
   }
 
-  const std::string &cmd     = args[0]->toString();
-  const std::string &varName = args[1]->toString();
+  const std::string &cmd = args[0]->toString();
 
-  if      (cmd == "anymore") {
-    return CTclValueRef();
+  if      (cmd == "children") {
   }
-  else if (cmd == "donesearch") {
-    return CTclValueRef();
+  else if (cmd == "code") {
   }
-  else if (cmd == "exists") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("array exists arrayName");
-      return CTclValueRef();
-    }
-
-    auto *scope = tcl_->getScope();
-
-    auto value = scope->getVariableValue(varName);
-
-    bool is_array = (value.isValid() && value->getType() == CTclValue::ValueType::VALUE_MAP);
-
-    return CTclValueRef(tcl_->createValue(long(is_array)));
+  else if (cmd == "current") {
   }
-  else if (cmd == "get") {
-    auto *scope = tcl_->getScope();
-
-    auto value = scope->getVariableValue(varName);
-
-    if (! value.isValid())
-      return CTclValueRef();
-
-    if (value->getType() == CTclValue::ValueType::ARRAY) {
-      auto *array = value.cast<CTclArray>();
-
-      std::vector<std::string>  names;
-      std::vector<CTclValueRef> values;
-
-      array->getNameValues(names, values);
-
-      uint num_names = names.size();
-
-      auto *list = new CTclList;
+  else if (cmd == "delete") {
+    for (uint i = 1; i < numArgs; ++i) {
+      const std::string &name = args[i]->toString();
 
-      for (uint i = 0; i < num_names; ++i) {
-        auto *list1 = new CTclList;
+      // remove last name component from its parent namespace
+      auto pos = name.rfind("::");
 
-        list1->addValue(tcl_->createValue(names[i]));
-        list1->addValue(values[i]);
+      CTclScope   *scope = nullptr;
+      std::string  tail;
 
-        list->addValue(CTclValueRef(list1));
+      if (pos == std::string::npos) {
+        scope = tcl_->getScope();
+        tail  = name;
+      }
+      else {
+        scope = tcl_->getNamedScope(pos > 0 ? name.substr(0, pos) : "::");
+        tail  = name.substr(pos + 2);
       }
 
-      return CTclValueRef(list);
-    }
-    else
-      return CTclValueRef();
-  }
-  else if (cmd == "names") {
-    auto *scope = tcl_->getScope();
-
-    auto value = scope->getVariableValue(varName);
-
-    if (! value.isValid())
-      return CTclValueRef();
-
-    if (value->getType() == CTclValue::ValueType::VALUE_MAP) {
-      auto *array = value.cast<CTclArray>();
-
-      std::vector<std::string> names;
-
-      array->getNames(names);
-
-      return CTclValueRef(tcl_->createValue(names));
+      if (! scope || ! scope->removeNamedScope(tail)) {
+        tcl_->throwError("unknown namespace \"" + name + "\" in namespace delete command");
+        return CTclValueRef();
+      }
     }
-    else
-      return CTclValueRef();
-  }
-  else if (cmd == "nextelement") {
-    return CTclValueRef();
   }
-  else if (cmd == "set") {
+  else if (cmd == "eval") {
     if (numArgs < 3) {
-      tcl_->wrongNumArgs("array set arrayName list");
+      tcl_->wrongNumArgs("namespace eval name ?arg ...?");
       return CTclValueRef();
     }
 
-    CTclValueRef list;
-
-    if (args[2]->getType() == CTclValue::ValueType::LIST)
-      list = args[2];
-    else
-      list = args[2]->toList(tcl_);
+    const std::string &name = args[1]->toString();
 
-    uint length = list->getLength();
+    auto *scope = tcl_->getNamedScope(name, true);
 
-    if (length & 1) {
-      tcl_->throwError("list must have an even number of elements");
-      return CTclValueRef();
-    }
+    tcl_->pushScope(scope);
 
-    auto *array = new CTclArray;
+    CTclValueRef value;
 
-    for (uint i = 0; i < length; i += 2) {
-      auto name  = list->getIndexValue(i    );
-      auto value = list->getIndexValue(i + 1);
+    for (uint i = 2; i < numArgs; ++i) {
+      value = args[i]->exec(tcl_);
 
-      array->setValue(name->toString(), value);
+      if (tcl_->getResultCode() != CTcl::ResultCode::OK) break;
     }
 
-    auto *scope = tcl_->getScope();
-
-    scope->setVariableValue(varName, CTclValueRef(array));
+    tcl_->popScope();
 
-    return CTclValueRef();
+    return value;
   }
-  else if (cmd == "size") {
-    return CTclValueRef();
+  else if (cmd == "exists") {
   }
-  else if (cmd == "startsearch") {
-    return CTclValueRef();
+  else if (cmd == "export") {
   }
-  else if (cmd == "statistics") {
-    return CTclValueRef();
+  else if (cmd == "forget") {
   }
-  else if (cmd == "unset") {
-    tcl_->removeVariable(varName);
-
-    return CTclValueRef();
+  else if (cmd == "import") {
+  }
+  else if (cmd == "inscope") {
+  }
+  else if (cmd == "origin") {
+  }
+  else if (cmd == "parent") {
+  }
+  else if (cmd == "qualifiers") {
+  }
+  else if (cmd == "tail") {
+  }
+  else if (cmd == "which") {
   }
   else {
-    tcl_->throwError("bad option \"" + cmd + "\": must be "
-                     "anymore, donesearch, exists, get, names, nextelement, set, size, "
-                     "startsearch, statistics, or unset");
+    tcl_->throwError("bad option \"" + cmd + "\": must be children, code, current, "
+                     "delete, eval, exists, export, forget, import, inscope, origin, "
+                     "parent, qualifiers, tail, or which");
     return CTclValueRef();
   }
+
+  return CTclValueRef();
 }
 
 //----------
 
 CTclValueRef
-CTclBreakCommand::
+CTclOpenCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs != 0) {
-    tcl_->wrongNumArgs("break");
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("open fileName ?access? ?permissions?");
     return CTclValueRef();
   }
 
-  auto *cmd = tcl_->getCommand();
+  const std::string &name = args[0]->toString();
 
-  if (cmd->getType() & uint(CTclCommand::CommandType::ITERATION)) {
-    tcl_->throwError("invoked \"continue\" outside of a loop");
-    return CTclValueRef();
+  std::string access = "r";
+
+  if (numArgs > 1)
+    access = args[1]->toString();
+
+  long perm = 0666;
+
+  if (numArgs > 2) {
+    if (! args[2]->checkInt(tcl_, perm))
+      return CTclValueRef();
   }
 
-  tcl_->setBreakFlag(true);
+  std::string handle = tcl_->openFile(name, access);
+
+  return CTclValueRef(tcl_->createValue(handle));
+}
+
+//----------
+
+CTclValueRef
+CTclPackageCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("should be \"package option ?arg ...?\"");
+    return CTclValueRef();
+  }
 
   return CTclValueRef();
 }
 
 //----------
 
+// profile start|stop|reset|report ?-sort count|total|self|name? ?-limit n?|data
+// profile sample start ?hz?|stop|clear|count|folded|write fileName
+// profile trace start ?-maxevents n? ?-argsize n?|stop|clear|count|write fileName
+// profile lines start|stop|clear|data|listing fileName
 CTclValueRef
-CTclCatchCommand::
+CTclProfileCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
   if (numArgs < 1) {
-    tcl_->wrongNumArgs("catch command ?varName?");
+    tcl_->wrongNumArgs("profile option ?arg ...?");
     return CTclValueRef();
   }
 
-  std::string errMsg;
-  bool        isError = false;
+  const std::string &opt = args[0]->toString();
+
+  if      (opt == "start") {
+    tcl_->startProfile();
+  }
+  else if (opt == "stop") {
+    tcl_->stopProfile();
+  }
+  else if (opt == "reset") {
+    if (tcl_->getProfiler())
+      tcl_->getProfiler()->reset();
+  }
+  else if (opt == "report") {
+    std::string sort  = "self";
+    long        limit = 0;
+
+    for (uint i = 1; i < numArgs; ++i) {
+      const std::string &arg = args[i]->toString();
+
+      if      (arg == "-sort" && i < numArgs - 1) {
+        sort = args[++i]->toString();
+
+        if (sort != "count" && sort != "total" && sort != "self" && sort != "name") {
+          tcl_->throwError("bad sort \"" + sort + "\": must be count, total, self, or name");
+          return CTclValueRef();
+        }
+      }
+      else if (arg == "-limit" && i < numArgs - 1) {
+        if (! args[++i]->checkInt(tcl_, limit))
+          return CTclValueRef();
+      }
+      else {
+        tcl_->wrongNumArgs("profile report ?-sort count|total|self|name? ?-limit n?");
+        return CTclValueRef();
+      }
+    }
+
+    if (! tcl_->getProfiler())
+      return tcl_->createValue("");
+
+    return tcl_->createValue(tcl_->getProfiler()->report(sort, uint(std::max(limit, 0L))));
+  }
+  else if (opt == "sample") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs("profile sample start ?hz?|stop|clear|folded|write fileName");
+      return CTclValueRef();
+    }
+
+    const std::string &opt1 = args[1]->toString();
+
+    auto *sampler = tcl_->getSampler();
+
+    if      (opt1 == "start") {
+      long hz = 1000;
+
+      if (numArgs > 2 && ! args[2]->checkInt(tcl_, hz))
+        return CTclValueRef();
+
+      if (hz <= 0 || hz > 1000000) {
+        tcl_->throwError("bad sample rate \"" + args[2]->toString() + "\"");
+        return CTclValueRef();
+      }
+
+      if (! tcl_->startSampling(uint(hz))) {
+        tcl_->throwError("failed to start sample timer");
+        return CTclValueRef();
+      }
+    }
+    else if (opt1 == "stop") {
+      tcl_->stopSampling();
+    }
+    else if (opt1 == "clear") {
+      if (sampler)
+        sampler->clear();
+    }
+    else if (opt1 == "count") {
+      return tcl_->createValue(sampler ? sampler->getNumSamples() : 0UL);
+    }
+    else if (opt1 == "folded") {
+      return tcl_->createValue(sampler ? sampler->folded() : std::string());
+    }
+    else if (opt1 == "write") {
+      if (numArgs != 3) {
+        tcl_->wrongNumArgs("profile sample write fileName");
+        return CTclValueRef();
+      }
+
+      const std::string &fileName = args[2]->toString();
+
+      if (! sampler || ! sampler->writeFolded(fileName)) {
+        tcl_->throwError("couldn't write samples to \"" + fileName + "\"");
+        return CTclValueRef();
+      }
+    }
+    else {
+      tcl_->throwError("bad option \"" + opt1 + "\": must be clear, count, folded, start, "
+                       "stop, or write");
+      return CTclValueRef();
+    }
+  }
+  else if (opt == "trace") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs("profile trace start ?-maxevents n? ?-argsize n?|stop|clear|count|"
+                         "write fileName");
+      return CTclValueRef();
+    }
+
+    const std::string &opt1 = args[1]->toString();
 
-  try {
-    args[0]->exec(tcl_);
-  }
-  catch (CTclError err) {
-    errMsg  = err.getMsg();
-    isError = true;
-  }
+    if      (opt1 == "start") {
+      long maxEvents = -1, argSize = -1;
 
-  if (numArgs > 1) {
-    const std::string &varName = args[1]->toString();
+      for (uint i = 2; i < numArgs; ++i) {
+        const std::string &arg = args[i]->toString();
+
+        if      (arg == "-maxevents" && i < numArgs - 1) {
+          if (! args[++i]->checkInt(tcl_, maxEvents))
+            return CTclValueRef();
+        }
+        else if (arg == "-argsize" && i < numArgs - 1) {
+          if (! args[++i]->checkInt(tcl_, argSize))
+            return CTclValueRef();
+        }
+        else {
+          tcl_->wrongNumArgs("profile trace start ?-maxevents n? ?-argsize n?");
+          return CTclValueRef();
+        }
+      }
+
+      tcl_->startTraceLog();
+
+      if (maxEvents >= 0) tcl_->getTraceLog()->setMaxEvents(uint(maxEvents));
+      if (argSize   >= 0) tcl_->getTraceLog()->setArgSize  (uint(argSize));
+    }
+    else if (opt1 == "stop") {
+      tcl_->stopTraceLog();
+    }
+    else if (opt1 == "clear") {
+      if (tcl_->getTraceLog())
+        tcl_->getTraceLog()->clear();
+    }
+    else if (opt1 == "count") {
+      return tcl_->createValue(tcl_->getTraceLog() ? tcl_->getTraceLog()->getNumEvents() : 0UL);
+    }
+    else if (opt1 == "write") {
+      if (numArgs != 3) {
+        tcl_->wrongNumArgs("profile trace write fileName");
+        return CTclValueRef();
+      }
 
-    if (isError) {
-      auto *scope = tcl_->getScope();
+      const std::string &fileName = args[2]->toString();
 
-      scope->setVariableValue(varName, tcl_->createValue(errMsg));
+      if (! tcl_->getTraceLog() || ! tcl_->getTraceLog()->writeJson(fileName)) {
+        tcl_->throwError("couldn't write trace to \"" + fileName + "\"");
+        return CTclValueRef();
+      }
+    }
+    else {
+      tcl_->throwError("bad option \"" + opt1 + "\": must be clear, count, start, stop, "
+                       "or write");
+      return CTclValueRef();
     }
   }
+  else if (opt == "lines") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs("profile lines start|stop|clear|data|listing fileName");
+      return CTclValueRef();
+    }
 
-  return CTclValueRef(tcl_->createValue(long(! isError)));
-}
+    const std::string &opt1 = args[1]->toString();
 
-//----------
+    auto *profiler = tcl_->getLineProfiler();
 
-CTclValueRef
-CTclCDCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    if      (opt1 == "start") {
+      tcl_->startLineProfile();
+    }
+    else if (opt1 == "stop") {
+      tcl_->stopLineProfile();
+    }
+    else if (opt1 == "clear") {
+      if (profiler)
+        profiler->clear();
+    }
+    else if (opt1 == "data") {
+      // list of {file line count nsecs}
+      std::vector<CTclValueRef> values;
 
-  std::string dirName;
+      if (profiler) {
+        for (const auto &pf : profiler->getFiles()) {
+          for (const auto &pl : pf.second) {
+            std::vector<CTclValueRef> values1;
 
-  if      (numArgs == 0)
-    dirName = COSUser::getUserHome();
-  else if (numArgs == 1)
-    dirName = args[0]->toString();
-  else {
-    tcl_->wrongNumArgs("cd ?dirName?");
-    return CTclValueRef();
-  }
+            values1.push_back(tcl_->createValue(pf.first));
+            values1.push_back(tcl_->createValue(long(pl.first)));
+            values1.push_back(tcl_->createValue(pl.second.count));
+            values1.push_back(tcl_->createValue(pl.second.nsecs));
 
-  if (! COSFile::changeDir(dirName)) {
-    tcl_->throwError("couldn't change working directory to \"" + dirName + "\": "
-                    "no such file or directory");
-    return CTclValueRef();
-  }
+            values.push_back(tcl_->createValue(values1));
+          }
+        }
+      }
 
-  return CTclValueRef();
-}
+      return tcl_->createValue(values);
+    }
+    else if (opt1 == "listing") {
+      if (numArgs != 3) {
+        tcl_->wrongNumArgs("profile lines listing fileName");
+        return CTclValueRef();
+      }
 
-//----------
+      const std::string &fileName = args[2]->toString();
 
-CTclValueRef
-CTclClockCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+      if (! CFile::isRegular(fileName)) {
+        tcl_->throwError("couldn't read file \"" + fileName + "\"");
+        return CTclValueRef();
+      }
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("clock option ?arg ...?");
-    return CTclValueRef();
+      return tcl_->createValue(profiler ? profiler->listing(fileName) : std::string());
+    }
+    else {
+      tcl_->throwError("bad option \"" + opt1 + "\": must be clear, data, listing, start, "
+                       "or stop");
+      return CTclValueRef();
+    }
   }
+  else if (opt == "data") {
+    // list of {name type count total self} (times in nanoseconds)
+    std::vector<CTclValueRef> values;
 
-  const std::string &opt = args[0]->toString();
-
-  if      (opt == "clicks") {
-    long secs, usecs;
+    if (tcl_->getProfiler()) {
+      for (const auto &ps : tcl_->getProfiler()->getStats()) {
+        const auto &stats = ps.second;
 
-    COSTime::getHRTime(&secs, &usecs);
+        std::vector<CTclValueRef> values1;
 
-    std::string str = CStrUtil::strprintf("%d%06d", secs, usecs);
+        values1.push_back(tcl_->createValue(ps.first));
+        values1.push_back(tcl_->createValue(
+          std::string(stats.type == CTclProfiler::CallType::PROC ? "proc" : "command")));
+        values1.push_back(tcl_->createValue(stats.count));
+        values1.push_back(tcl_->createValue(stats.total));
+        values1.push_back(tcl_->createValue(stats.self));
 
-    return CTclValueRef(tcl_->createValue(str));
-  }
-  else if (opt == "format") {
-  }
-  else if (opt == "scan") {
-  }
-  else if (opt == "seconds") {
-    time_t t = time(nullptr);
+        values.push_back(tcl_->createValue(values1));
+      }
+    }
 
-    return CTclValueRef(tcl_->createValue(long(t)));
+    return tcl_->createValue(values);
   }
   else {
-    tcl_->throwError("bad option \"" + opt + "\": must be clicks, format, scan, or seconds");
+    tcl_->throwError("bad option \"" + opt + "\": must be data, lines, report, reset, "
+                     "sample, start, stop, or trace");
     return CTclValueRef();
   }
 
@@ -2987,1080 +7962,966 @@ exec(const std::vector<CTclValueRef> &args)
 //----------
 
 CTclValueRef
-CTclCloseCommand::
+CTclProcCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("close channelId");
-    return CTclValueRef();
-  }
+  if (numArgs != 3) return CTclValueRef();
 
   const std::string &name = args[0]->toString();
 
-  tcl_->closeFile(name);
+  CTclValueRef list;
 
-  return CTclValueRef();
-}
+  if (args[1]->getType() == CTclValue::ValueType::LIST)
+    list = args[1];
+  else
+    list = args[1]->toList(tcl_);
 
-//----------
+  std::vector<std::string> args1;
 
-CTclValueRef
-CTclContinueCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  uint length = list->getLength();
 
-  if (numArgs != 0) {
-    tcl_->wrongNumArgs("continue");
-    return CTclValueRef();
-  }
+  for (uint i = 0; i < length; ++i) {
+    auto value = list->getIndexValue(i);
 
-  auto *cmd = tcl_->getCommand();
+    // TODO: name + def value
 
-  if (cmd->getType() & uint(CTclCommand::CommandType::ITERATION)) {
-    tcl_->throwError("invoked \"continue\" outside of a loop");
-    return CTclValueRef();
+    args1.push_back(value->toString());
   }
 
-  tcl_->setContinueFlag(true);
+  auto *proc = tcl_->defineProc(name, args1, args[2]);
+
+  if (proc)
+    proc->setLocation(tcl_->getSourceFile(), tcl_->getSourceLine());
 
   return CTclValueRef();
 }
 
 //----------
 
+// puts [-nonewline] [channelId] string
 CTclValueRef
-CTclEchoCommand::
+CTclPutsCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  for (uint i = 0; i < numArgs; ++i) {
-    args[i]->print(std::cout);
+  int pos = 0;
 
-    std::cout << "\n";
+  bool newline = true;
+
+  if (numArgs > 1) {
+    if (args[pos]->toString() == "-nonewline") {
+      newline = false;
+
+      ++pos;
+      --numArgs;
+    }
   }
 
-  return CTclValueRef();
-}
+  FILE *fp = stdout;
 
-//----------
+  if (numArgs > 1) {
+    const std::string &fileId = args[pos]->toString();
 
-CTclValueRef
-CTclEofCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    if      (fileId == "stdout")
+      fp = stdout;
+    else if (fileId == "stderr")
+      fp = stderr;
+    else {
+      fp = tcl_->getFile(fileId);
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("eof channelId");
-    return CTclValueRef();
+      if (fp == nullptr) {
+        tcl_->throwError("can not find channel named \"" + fileId + "\"");
+        return CTclValueRef();
+      }
+    }
+
+    ++pos;
+    --numArgs;
   }
 
-  const std::string &fileId = args[0]->toString();
+  if (numArgs == 1) {
+    std::ostringstream ostr;
 
-  FILE *fp = nullptr;
+    args[pos]->print(ostr);
 
-  if (fileId == "stdin")
-    fp = stdin;
-  else {
-    fp = tcl_->getFile(fileId);
+    const std::string &str = ostr.str();
 
-    if (fp == nullptr) {
-      tcl_->throwError("can not find channel named \"" + fileId + "\"");
-      return CTclValueRef();
-    }
+    fwrite(str.c_str(), 1, str.size(), fp);
   }
 
-  bool flag = feof(fp);
+  if (newline)
+    fputc('\n', fp);
 
-  return CTclValueRef(tcl_->createValue(long(flag)));
+  return CTclValueRef();
 }
 
 //----------
 
 CTclValueRef
-CTclEvalCommand::
+CTclPidCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("eval arg ?arg ...?");
+  if (numArgs > 1) {
+    tcl_->wrongNumArgs("pid");
     return CTclValueRef();
   }
 
-  std::string str;
-
-  for (uint i = 0; i < numArgs; ++i) {
-    if (i > 0) str += " ";
-
-    str += args[i]->toString();
-  }
+  auto pid = COSProcess::getProcessId();
 
-  return tcl_->parseString(str);
+  return CTclValueRef(tcl_->createValue(long(pid)));
 }
 
 //----------
 
 CTclValueRef
-CTclExecCommand::
+CTclPwdCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("exec ?switches? arg ?arg ...?");
-    return CTclValueRef();
-  }
-
-  std::vector<CCommand *> cmds;
-
-  bool ignore_arg = false;
-
-  std::string name = args[0]->toString();
-  std::string path = tcl_->lookupPathCommand(name);
-
-  if (path == "") {
-    tcl_->throwError("couldn't execute \"" + name + "\" no such file or directory");
-    return CTclValueRef();
-  }
-
-  auto *command = new CCommand(name, path);
-
-  cmds.push_back(command);
-
-//CCommandMgrInst->setDebug(true);
-
-  for (uint i = 1; i < numArgs; ++i) {
-    std::string arg = args[i]->toString();
-
-    if (ignore_arg) {
-      command->addArg(arg);
-
-      continue;
-    }
-
-    if      (arg == "--") {
-      ignore_arg = true;
-    }
-    else if (arg == "|" || arg == "|&") {
-      if (i >= numArgs - 1) {
-        tcl_->throwError("illegal use of | or |& in command");
-        return CTclValueRef();
-      }
-
-      ignore_arg = false;
-
-      ++i;
+  if (numArgs != 0) {
+    tcl_->wrongNumArgs("pwd");
+    return CTclValueRef();
+  }
 
-      command->addPipeDest(1);
+  std::string dirName = COSFile::getCurrentDir();
 
-      if (arg == "|&")
-        command->addPipeDest(2);
+  return CTclValueRef(tcl_->createValue(dirName));
+}
 
-      name = args[i]->toString();
-      path = tcl_->lookupPathCommand(name);
+//----------
 
-      if (path == "") {
-        tcl_->throwError("couldn't execute \"" + name + "\" no such file or directory");
-        return CTclValueRef();
-      }
+// randlist uniform count ?min max?     : uniform reals in [min, max) (default [0, 1))
+// randlist normal count ?mean stddev?  : normal reals (default mean 0, stddev 1)
+//
+// Uses interpreter generator (seeded by srand()).
+CTclValueRef
+CTclRandListCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-      command = new CCommand(name, path);
+  if (numArgs != 2 && numArgs != 4) {
+    tcl_->wrongNumArgs("randlist uniform|normal count ?arg arg?");
+    return CTclValueRef();
+  }
 
-      cmds.push_back(command);
+  const std::string &type = args[0]->toString();
 
-      command->addPipeSrc();
-    }
-    else if (arg == "<") {
-      if (i >= numArgs - 1) {
-        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
-        return CTclValueRef();
-      }
+  bool normal = false;
 
-      ++i;
+  if      (type == "uniform") normal = false;
+  else if (type == "normal" ) normal = true;
+  else {
+    tcl_->throwError("bad type \"" + type + "\": must be uniform or normal");
+    return CTclValueRef();
+  }
 
-      const std::string &src = args[i]->toString();
+  long count;
 
-      command->addFileSrc(src);
-    }
-    else if (arg == "<@") {
-    }
-    else if (arg == "<<") {
-    }
-    else if (arg == ">" || arg == ">&") {
-      if (i >= numArgs - 1) {
-        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
-        return CTclValueRef();
-      }
+  if (! args[1]->toInt(count) || count < 0) {
+    tcl_->throwError("expected non-negative integer but got \"" + args[1]->toString() + "\"");
+    return CTclValueRef();
+  }
 
-      ++i;
+  // list length is an int
+  if (count > INT_MAX) {
+    tcl_->throwError("max length of a Tcl list exceeded");
+    return CTclValueRef();
+  }
 
-      const std::string &dest = args[i]->toString();
+  // min and max, or mean and standard deviation
+  double a = 0.0;
+  double b = 1.0;
 
-      command->addFileDest(dest);
+  if (numArgs == 4) {
+    for (uint i = 2; i < 4; ++i) {
+      double r;
 
-      if (arg == ">&")
-        command->addFileDest(dest, 2);
-    }
-    else if (arg == "2>") {
-    }
-    else if (arg == ">>") {
-      if (i >= numArgs - 1) {
-        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
+      if (! args[i]->toReal(r)) {
+        tcl_->throwError("expected floating-point number but got \"" +
+                         args[i]->toString() + "\"");
         return CTclValueRef();
       }
 
-      ++i;
+      (i == 2 ? a : b) = r;
+    }
+  }
 
-      const std::string &dest = args[i]->toString();
+  auto &random = tcl_->getRandom();
 
-      command->addFileDest(dest);
+  CTclList::ValueList values;
 
-      command->setFileDestAppend(true);
+  try {
+    values.reserve(count);
+
+    if (normal) {
+      for (long i = 0; i < count; ++i)
+        values.push_back(tcl_->createValue(a + b*random.nextNormal()));
     }
-    else if (arg == "2>>") {
+    else {
+      for (long i = 0; i < count; ++i)
+        values.push_back(tcl_->createValue(random.nextReal(a, b)));
     }
-    else if (arg == ">>&") {
-      if (i >= numArgs - 1) {
-        tcl_->throwError("can't specify \"" + arg + "\" as last word in command");
-        return CTclValueRef();
-      }
+  }
+  catch (const std::bad_alloc &) {
+    tcl_->throwError("not enough memory to allocate list of " + std::to_string(count) +
+                     " elements");
+    return CTclValueRef();
+  }
 
-      ++i;
+  return CTclValueRef(new CTclList(values));
+}
 
-      const std::string &dest = args[i]->toString();
+//----------
 
-      command->addFileDest(dest, 1);
-      command->addFileDest(dest, 2);
+CTclValueRef
+CTclReadCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
+  uint pos     = 0;
 
-      command->setFileDestAppend(true);
-    }
-    else if (arg == ">@") {
-    }
-    else if (arg == "2>@") {
-    }
-    else if (arg == "2>@1") {
-    }
-    else if (arg == ">&@") {
+  bool newline = true;
+
+  if (numArgs > 1) {
+    if (args[pos]->toString() == "-nonewline") {
+      newline = false;
+
+      ++pos;
+      --numArgs;
     }
-    else
-      command->addArg(arg);
   }
 
-  std::string dest;
+  if (numArgs != 1 && numArgs != 2) {
+    tcl_->wrongNumArgs("read channelId ?numChars?\" or \"read ?-nonewline? channelId");
+    return CTclValueRef();
+  }
 
-  uint num_cmds = cmds.size();
+  const std::string &fileId = args[pos]->toString();
 
-  auto *cmd2 = cmds[num_cmds - 1];
+  std::string dirName = COSFile::getCurrentDir();
 
-  cmd2->addStringDest(dest);
+  FILE *fp = nullptr;
 
-  for (uint i = 0; i < num_cmds; ++i) {
-    auto *cmd = cmds[i];
+  if (fileId == "stdin")
+    fp = stdin;
+  else {
+    fp = tcl_->getFile(fileId);
 
-    if (i == 0)
-      cmd->setProcessGroupLeader();
-    else
-      cmd->setProcessGroup(cmds[0]);
+    if (fp == nullptr) {
+      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+      return CTclValueRef();
+    }
   }
 
-  for (uint i = 0; i < num_cmds; ++i) {
-    auto *cmd = cmds[i];
+  std::string line;
 
-    cmd->start();
-  }
+  if (numArgs == 1) {
+    int c = getc(fp);
 
-  for (uint i = 0; i < num_cmds; ++i) {
-    auto *cmd = cmds[i];
+    while (c != EOF) {
+      line += (char) c;
 
-    cmd->wait();
+      c = getc(fp);
+    }
   }
+  else {
+    long num;
 
-  dest = CStrUtil::stripSpaces(dest);
+    if (! args[pos + 1]->checkInt(tcl_, num))
+      return CTclValueRef();
 
-  for (uint i = 0; i < num_cmds; ++i)
-    delete cmds[i];
+    for (int i = 0; i < num; ++i) {
+      int c = getc(fp);
 
-  return CTclValueRef(tcl_->createValue(dest));
+      if (c == EOF) break;
+
+      line += (char) c;
+    }
+  }
+
+  return CTclValueRef(tcl_->createValue(line));
 }
 
 //----------
 
 CTclValueRef
-CTclExitCommand::
+CTclReturnCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
-  uint numArgs = args.size();
-
-  if (numArgs > 1) {
-    tcl_->wrongNumArgs("exit ?returnCode?");
-    return CTclValueRef();
-  }
+  CTclValueRef retVal;
 
-  long code = 0;
+  uint numArgs = args.size();
 
-  if (numArgs > 0) {
-    if (! args[0]->checkInt(tcl_, code))
-      return CTclValueRef();
-  }
+  if (numArgs > 0)
+    retVal = args[0];
 
-  exit(code);
+  tcl_->setResultCode(CTcl::ResultCode::RETURN);
 
-  return CTclValueRef();
+  return retVal;
 }
 
-//----------
+//-----------
 
 CTclValueRef
-CTclExprCommand::
+CTclSetCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  std::string str;
+  if (numArgs < 1 || numArgs > 2)
+    return CTclValueRef();
 
-  for (uint i = 0; i < numArgs; ++i) {
-    if (i > 0) str += " ";
+  const std::string &varName = args[0]->toString();
 
-    str += args[i]->toString();
+  auto *scope = tcl_->getScope();
+
+  auto pos1 = varName.find ('(');
+  auto pos2 = varName.rfind(')');
+
+  if (pos1 != std::string::npos && pos2 != std::string::npos && pos2 == varName.size() - 1) {
+    std::string varName1 = varName.substr(0, pos1);
+    std::string indexStr = varName.substr(pos1 + 1, pos2 - pos1 - 1);
+
+    if (numArgs == 2) {
+      scope->setArrayVariableValue(varName1, indexStr, args[1]);
+
+      return args[1];
+    }
+    else
+      return scope->getArrayVariableValue(varName1, indexStr);
+  }
+  else if (varName.find("::") != std::string::npos) {
+    if (numArgs == 2) {
+      tcl_->setVariableValue(varName, args[1]);
+
+      return args[1];
+    }
+    else
+      return tcl_->getVariableValue(varName);
+  }
+  else {
+    if (numArgs == 2) {
+      scope->setVariableValue(varName, args[1]);
+
+      return args[1];
+    }
+    else
+      return scope->getVariableValue(varName);
   }
 
-  return tcl_->evalString(str);
+  return CTclValueRef();
 }
 
-//----------
+//-----------
 
 CTclValueRef
-CTclFileCommand::
+CTclSourceCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("file option ?arg ...?");
+  if (numArgs != 1) {
+    tcl_->wrongNumArgs("source fileName");
     return CTclValueRef();
   }
 
-  const std::string &option = args[0]->toString();
+  const std::string &fileName = args[0]->toString();
 
-  if      (option == "atime") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file atime name ?time?");
-      return CTclValueRef();
-    }
+  tcl_->sourceFile(fileName);
 
-    const std::string &fileName = args[1]->toString();
+  return CTclValueRef();
+}
 
-    auto atime = CFile::getATime(fileName);
+//-----------
+
+CTclValueRef
+CTclStringCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-    return CTclValueRef(tcl_->createValue(long(atime)));
+  if (numArgs == 0) {
+    tcl_->wrongNumArgs("string option arg ?arg ...?");
+    return CTclValueRef();
   }
-  else if (option == "attributes") {
+
+  const std::string &cmd = args[0]->toString();
+
+  if      (cmd == "bytelength") {
     if (numArgs != 2) {
-      tcl_->wrongNumArgs("file attributes name ?option? ?value? ?option value ...?");
+      tcl_->wrongNumArgs("wrong # args: should be \"string bytelength string\"");
       return CTclValueRef();
     }
 
-    const std::string &fileName = args[1]->toString();
+    const std::string &str = args[1]->toString();
 
-    struct stat file_stat;
+    auto len = str.size();
 
-    if (! CFile::getStat(fileName, &file_stat)) {
-      tcl_->wrongNumArgs("could not read \"" + fileName + "\": no such file or directory");
+    return CTclValueRef(tcl_->createValue(ulong(len)));
+  }
+  else if (cmd == "compare" || cmd == "equal") {
+    if (numArgs < 3) {
+      tcl_->wrongNumArgs("string " + cmd + " ?-nocase? ?-length int? string1 string2");
       return CTclValueRef();
     }
 
-    std::string str;
+    bool is_equal = (cmd == "equal");
 
-    str += "-group " + COSUser::getGroupName(file_stat.st_gid);
-    str += " -owner " + COSUser::getUserName(file_stat.st_uid);
-    str += " -permissions 0" + CStrUtil::toOctString(file_stat.st_mode);
+    bool        nocase = false;
+    long        length = -1;
+    std::string str1, str2;
 
-    return CTclValueRef(tcl_->createValue(str));
-  }
-  else if (option == "channels") {
-    auto *list = new CTclList;
+    uint pos = 1;
 
-    if (numArgs == 1) {
-      list->addValue(tcl_->createValue("stdin"));
-      list->addValue(tcl_->createValue("stdout"));
-      list->addValue(tcl_->createValue("stderr"));
-    }
+    if (pos < numArgs && args[pos]->toString() == "-nocase") {
+      ++pos;
 
-    return CTclValueRef(list);
-  }
-  else if (option == "copy") {
-  }
-  else if (option == "delete") {
-  }
-  else if (option == "dirname") {
-  }
-  else if (option == "executable") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isdirectory name");
-      return CTclValueRef();
+      nocase = true;
     }
 
-    const std::string &fileName = args[1]->toString();
+    if (pos < numArgs && args[pos]->toString() == "-length") {
+      ++pos;
 
-    bool is_exec = CFile::isExecutable(fileName);
+      if (pos < numArgs) {
+        bool ok = args[pos++]->toInt(length);
 
-    return CTclValueRef(tcl_->createValue(long(is_exec)));
-  }
-  else if (option == "exists") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file exists name");
-      return CTclValueRef();
+        if (! ok) return CTclValueRef();
+      }
     }
 
-    const std::string &fileName = args[1]->toString();
-
-    bool exists = CFile::exists(fileName);
+    if (pos < numArgs)
+      str1 = args[pos++]->toString();
 
-    return CTclValueRef(tcl_->createValue(long(exists)));
-  }
-  else if (option == "extension") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isdirectory name");
-      return CTclValueRef();
-    }
+    if (pos < numArgs)
+      str2 = args[pos++]->toString();
 
-    const std::string &fileName = args[1]->toString();
+    long cmp = 0;
 
-    std::string suffix = CFile::getSuffix(fileName);
+    if (length >= 0) {
+      str1 = str1.substr(0, length);
+      str2 = str2.substr(0, length);
 
-    if (! suffix.empty())
-      suffix = "." + suffix;
+      if (nocase)
+        cmp = CStrUtil::casecmp(str1, str2);
+      else
+        cmp = CStrUtil::cmp(str1, str2);
+    }
+    else {
+      if (nocase)
+        cmp = CStrUtil::casecmp(str1, str2);
+      else
+        cmp = CStrUtil::cmp(str1, str2);
+    }
 
-    return CTclValueRef(tcl_->createValue(suffix));
+    if (is_equal)
+      return CTclValueRef(tcl_->createValue(cmp));
+    else
+      return CTclValueRef(tcl_->createValue(long(cmp == 0)));
   }
-  else if (option == "isdirectory") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isdirectory name");
+  else if (cmd == "first") {
+    if (numArgs != 3 && numArgs != 4) {
+      tcl_->wrongNumArgs("should be \"string first subString string ?startIndex?\"");
       return CTclValueRef();
     }
 
-    const std::string &fileName = args[1]->toString();
+    const std::string &substr = args[1]->toString();
+    const std::string &str    = args[2]->toString();
 
-    bool is_dir = CFile::isDirectory(fileName);
+    auto pos = str.find(substr);
 
-    return CTclValueRef(tcl_->createValue(long(is_dir)));
+    return CTclValueRef(tcl_->createValue(pos));
   }
-  else if (option == "isfile") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isregular name");
+  else if (cmd == "index") {
+    if (numArgs != 3 && numArgs != 4) {
+      tcl_->wrongNumArgs("should be \"string index string charIndex\"");
       return CTclValueRef();
     }
 
-    const std::string &fileName = args[1]->toString();
+    const std::string &str = args[1]->toString();
 
-    bool is_dir = CFile::isRegular(fileName);
+    long pos;
 
-    return CTclValueRef(tcl_->createValue(long(is_dir)));
-  }
-  else if (option == "join") {
-  }
-  else if (option == "link") {
-  }
-  else if (option == "lstat") {
-  }
-  else if (option == "mkdir") {
-  }
-  else if (option == "mtime") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file atime name ?time?");
-      return CTclValueRef();
-    }
+    bool ok = args[2]->toInt(pos);
 
-    const std::string &fileName = args[1]->toString();
+    if (! ok) return CTclValueRef();
 
-    auto mtime = CFile::getMTime(fileName);
+    int len = str.size();
 
-    return CTclValueRef(tcl_->createValue(long(mtime)));
-  }
-  else if (option == "nativename") {
-  }
-  else if (option == "normalize") {
-  }
-  else if (option == "owned") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isregular name");
+    if (pos < 0 || pos >= len)
       return CTclValueRef();
-    }
-
-    const std::string &fileName = args[1]->toString();
-
-    bool is_owner = CFile::isOwner(fileName);
 
-    return CTclValueRef(tcl_->createValue(long(is_owner)));
+    return CTclValueRef(tcl_->createValue(str.substr(pos, 1)));
   }
-  else if (option == "pathtype") {
+  else if (cmd == "is") {
+    return CTclValueRef();
   }
-  else if (option == "readable") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isdirectory name");
+  else if (cmd == "last") {
+    if (numArgs != 3 && numArgs != 4) {
+      tcl_->wrongNumArgs("should be \"string last subString string ?startIndex?\"");
       return CTclValueRef();
     }
 
-    const std::string &fileName = args[1]->toString();
+    const std::string &substr = args[1]->toString();
+    const std::string &str    = args[2]->toString();
 
-    bool is_read = CFile::isReadable(fileName);
+    auto pos = str.rfind(substr);
 
-    return CTclValueRef(tcl_->createValue(long(is_read)));
-  }
-  else if (option == "readlink") {
-  }
-  else if (option == "rename") {
-  }
-  else if (option == "rootname") {
-  }
-  else if (option == "separator") {
-  }
-  else if (option == "size") {
-  }
-  else if (option == "split") {
-  }
-  else if (option == "stat") {
-  }
-  else if (option == "system") {
-  }
-  else if (option == "tail") {
-  }
-  else if (option == "type") {
-  }
-  else if (option == "volumes") {
+    return CTclValueRef(tcl_->createValue(pos));
   }
-  else if (option == "writable") {
+  else if (cmd == "length") {
     if (numArgs != 2) {
-      tcl_->wrongNumArgs("file isdirectory name");
+      tcl_->wrongNumArgs("string length string");
       return CTclValueRef();
     }
 
-    const std::string &fileName = args[1]->toString();
+    const std::string &str = args[1]->toString();
 
-    bool is_write = CFile::isWritable(fileName);
+    auto len = str.size();
 
-    return CTclValueRef(tcl_->createValue(long(is_write)));
-  }
-  else {
-    tcl_->throwError("bad option \"" + option + "\": must be "
-                     "atime, attributes, channels, copy, delete, dirname, executable, "
-                     "exists, extension, isdirectory, isfile, join, link, lstat, mtime, "
-                     "mkdir, nativename, normalize, owned, pathtype, readable, readlink, "
-                     "rename, rootname, separator, size, split, stat, system, tail, type, "
-                     "volumes, or writable");
-    return CTclValueRef();
+    return CTclValueRef(tcl_->createValue(ulong(len)));
   }
-
-  return CTclValueRef();
-}
-
-//----------
-
-CTclValueRef
-CTclFlushCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
-
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("flush channelId");
+  else if (cmd == "map") {
     return CTclValueRef();
   }
-
-  FILE *fp = nullptr;
-
-  const std::string &fileId = args[0]->toString();
-
-  if      (fileId == "stdout")
-    fp = stdout;
-  else if (fileId == "stderr")
-    fp = stderr;
-  else {
-    fp = tcl_->getFile(fileId);
-
-    if (fp == nullptr) {
-      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+  else if (cmd == "match") {
+    if (numArgs < 3) {
+      tcl_->wrongNumArgs("string match ?-nocase? pattern string");
       return CTclValueRef();
     }
-  }
-
-  fflush(fp);
 
-  return CTclValueRef();
-}
+    bool        nocase = false;
+    std::string str1, str2;
 
-//----------
+    uint pos = 1;
 
-CTclValueRef
-CTclForCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    if (pos < numArgs && args[pos]->toString() == "-nocase") {
+      ++pos;
 
-  if (numArgs != 4) {
-    tcl_->wrongNumArgs("for start test next command");
-    return CTclValueRef();
-  }
+      nocase = true;
+    }
 
-  tcl_->setBreakFlag   (false);
-  tcl_->setContinueFlag(false);
+    if (pos < numArgs)
+      str1 = args[pos++]->toString();
 
-  args[0]->exec(tcl_);
+    if (pos < numArgs)
+      str2 = args[pos++]->toString();
 
-  while (args[1]->evalBool(tcl_)) {
-    args[3]->exec(tcl_);
+    CGlob glob(str1);
 
-    tcl_->setContinueFlag(false);
+    if (nocase)
+      glob.setCaseSensitive(false);
 
-    args[2]->exec(tcl_);
+    bool cmp = glob.compare(str2);
 
-    if (tcl_->getBreakFlag() || tcl_->getReturnFlag()) break;
+    return CTclValueRef(tcl_->createValue(long(cmp)));
   }
+  else if (cmd == "range") {
+    if (numArgs != 4) {
+      tcl_->wrongNumArgs("string range string first last");
+      return CTclValueRef();
+    }
 
-  tcl_->setBreakFlag   (false);
-  tcl_->setContinueFlag(false);
+    const std::string &str = args[1]->toString();
 
-  return CTclValueRef();
-}
+    long ind1, ind2;
 
-//----------
+    if (! args[2]->toIndex(tcl_, ind1))
+      return CTclValueRef();
 
-CTclValueRef
-CTclForeachCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    if (! args[3]->toIndex(tcl_, ind2))
+      return CTclValueRef();
 
-  if (numArgs != 3) {
-    tcl_->wrongNumArgs("foreach varList list ?varList list ...? command");
-    return CTclValueRef();
+    std::string str1 = str.substr(ind1, ind2 - ind1);
+
+    return CTclValueRef(tcl_->createValue(str1));
   }
+  else if (cmd == "repeat") {
+    if (numArgs != 3) {
+      tcl_->wrongNumArgs("string repeat string count");
+      return CTclValueRef();
+    }
 
-  CTclValueRef varList;
+    const std::string &str = args[1]->toString();
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    varList = args[0];
-  else
-    varList = args[0]->toList(tcl_);
+    long num;
 
-  uint numVars = varList->getLength();
+    if (! args[2]->checkInt(tcl_, num))
+      return CTclValueRef();
 
-  if (numVars <= 0) {
-    tcl_->throwError("foreach varlist is empty");
-    return CTclValueRef();
+    std::string str1;
+
+    for (int i = 0; i < num; ++i)
+      str1 += str;
+
+    return CTclValueRef(tcl_->createValue(str1));
   }
+  else if (cmd == "replace") {
+    if (numArgs != 4 && numArgs != 5) {
+      tcl_->wrongNumArgs("string replace string first last ?string?");
+      return CTclValueRef();
+    }
 
-  CTclValueRef valList;
+    const std::string &str = args[1]->toString();
 
-  if (args[1]->getType() == CTclValue::ValueType::LIST)
-    valList = args[1];
-  else
-    valList = args[1]->toList(tcl_);
+    long start, end;
 
-  uint numVals = valList->getLength();
+    if (! args[2]->checkInt(tcl_, start) || ! args[3]->checkInt(tcl_, end))
+      return CTclValueRef();
 
-  auto *scope = tcl_->getScope();
+    std::string rep_str;
 
-  tcl_->setBreakFlag   (false);
-  tcl_->setContinueFlag(false);
+    if (numArgs == 5)
+      rep_str = args[4]->toString();
 
-  uint numIters = numVals/numVars;
+    int len = str.size();
 
-  for (uint i = 0, k = 0; i < numIters; ++i, k += numVars) {
-    for (uint j = 0; j < numVars; ++j) {
-      auto value = valList->getIndexValue(k + j);
+    std::string lstr = (start >= 0 && start < len ? str.substr(0, start) : "");
+    std::string rstr = (end   >= 0 && end   < len ? str.substr(end + 1): "");
 
-      const std::string &varName = varList->getIndexValue(j)->toString();
+    std::string str1 = lstr + rep_str + rstr;
 
-      scope->setVariableValue(varName, value);
+    return CTclValueRef(tcl_->createValue(str1));
+  }
+  else if (cmd == "tolower") {
+    if (numArgs < 2 || numArgs > 4) {
+      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
+      return CTclValueRef();
     }
 
-    tcl_->setContinueFlag(false);
+    auto str = args[1]->toString();
 
-    args[2]->exec(tcl_);
+    auto len = str.size();
 
-    if (tcl_->getBreakFlag() || tcl_->getReturnFlag()) break;
-  }
+    long start = 0, end = len;
 
-  tcl_->setBreakFlag   (false);
-  tcl_->setContinueFlag(false);
+    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
+      return CTclValueRef();
 
-  return CTclValueRef();
-}
+    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
+      return CTclValueRef();
 
-//----------
+    for (int i = start; i <= end && i < len; ++i)
+      str[i] = tolower(str[i]);
 
-class CTclPrintF : public CPrintF {
- public:
-  CTclPrintF(const std::string &fmt, const std::vector<CTclValueRef> &args) :
-   CPrintF(fmt), args_(args), argNum_(0), numArgs_(0) {
-    numArgs_ = args_.size();
+    return CTclValueRef(tcl_->createValue(str));
   }
+  else if (cmd == "toupper") {
+    if (numArgs < 2 || numArgs > 4) {
+      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
+      return CTclValueRef();
+    }
 
-  CTclValueRef nextArg() const { return args_[argNum_++]; }
+    std::string str = args[1]->toString();
 
-  int   getInt     () const override {
-    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
-  long  getLong    () const override {
-    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
-  LLong getLongLong() const override {
-    long i=0; if (argNum_ < numArgs_) nextArg()->toInt(i); return i; }
+    auto len = str.size();
 
-  double getDouble() const override {
-    double r=0; if (argNum_ < numArgs_) nextArg()->toReal(r); return r; }
+    long start = 0, end = len;
 
-  std::string getString() const override {
-    return (argNum_ < numArgs_ ? nextArg()->toString() : "" ); }
+    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
+      return CTclValueRef();
 
- private:
-  std::vector<CTclValueRef> args_;
-  mutable uint              argNum_;
-  uint                      numArgs_;
-};
+    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
+      return CTclValueRef();
 
-CTclValueRef
-CTclFormatCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    for (int i = start; i <= end && i < len; ++i)
+      str[i] = toupper(str[i]);
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("format formatString ?arg arg ...?");
-    return CTclValueRef();
+    return CTclValueRef(tcl_->createValue(str));
   }
+  else if (cmd == "totitle") {
+    if (numArgs < 2 || numArgs > 4) {
+      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
+      return CTclValueRef();
+    }
 
-  const std::string &fmt = args[0]->toString();
-
-  CTclPrintF printf(fmt, args);
+    std::string str = args[1]->toString();
 
-  printf.nextArg();
+    auto len = str.size();
 
-  std::string str = printf.format();
+    long start = 0, end = len;
 
-  return CTclValueRef(tcl_->createValue(str));
-}
+    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
+      return CTclValueRef();
 
-//----------
+    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
+      return CTclValueRef();
 
-CTclValueRef
-CTclGetsCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    for (int i = start; i <= end && i < len; ++i) {
+      if (i == start)
+        str[i] = toupper(str[i]);
+      else
+        str[i] = tolower(str[i]);
+    }
 
-  if (numArgs < 1 || numArgs > 2) {
-    tcl_->wrongNumArgs("gets channelId ?varName?");
-    return CTclValueRef();
+    return CTclValueRef(tcl_->createValue(str));
   }
-
-  const std::string &fileId = args[0]->toString();
-
-  FILE *fp = nullptr;
-
-  if (fileId == "stdin")
-    fp = stdin;
-  else {
-    fp = tcl_->getFile(fileId);
-
-    if (fp == nullptr) {
-      tcl_->throwError("can not find channel named \"" + fileId + "\"");
+  else if (cmd == "trim") {
+    if (numArgs < 2 || numArgs > 3) {
+      tcl_->wrongNumArgs("string trim string ?chars?");
       return CTclValueRef();
     }
-  }
 
-  std::string line;
+    const std::string &str = args[1]->toString();
 
-  int c = getc(fp);
+    uint len = str.size();
 
-  while (c != EOF && c != '\n') {
-    line += (char) c;
+    uint l = 0;
+    uint r = len - 1;
 
-    c = getc(fp);
-  }
+    if (numArgs == 2) {
+      while (l <= r) {
+        if (! isspace(str[l])) break;
 
-  if (numArgs == 2) {
-    const std::string &varName = args[1]->toString();
+        ++l;
+      }
 
-    auto *scope = tcl_->getScope();
+      while (r >= l) {
+        if (! isspace(str[r])) break;
 
-    scope->setVariableValue(varName, tcl_->createValue(line));
+        --r;
+      }
+    }
+    else {
+      std::string chars = args[2]->toString();
 
-    auto len = line.size();
+      while (l <= r) {
+        if (chars.find(str[l]) == std::string::npos) break;
 
-    return CTclValueRef(tcl_->createValue(ulong(len)));
-  }
-  else
-    return CTclValueRef(tcl_->createValue(line));
-}
+        ++l;
+      }
 
-//----------
+      while (r >= l) {
+        if (chars.find(str[r]) == std::string::npos) break;
 
-CTclValueRef
-CTclGlobCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+        --r;
+      }
+    }
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("glob ?switches? name ?name ...?");
-    return CTclValueRef();
-  }
+    std::string str1 = str.substr(l, r - l + 1);
 
-  bool        join       = true;
-  bool        complain   = false;
-  bool        tails      = true;
-  std::string directory  = "";
-  std::string pathPrefix = "";
-  std::string types      = "";
+    return CTclValueRef(tcl_->createValue(str1));
+  }
+  else if (cmd == "trimleft") {
+    if (numArgs < 2 || numArgs > 3) {
+      tcl_->wrongNumArgs("string trimleft string ?chars?");
+      return CTclValueRef();
+    }
 
-  uint pos = 0;
+    const std::string &str = args[1]->toString();
 
-  while (pos < numArgs) {
-    const std::string &arg = args[pos]->toString();
+    uint len = str.size();
 
-    if (arg.size() > 0 && arg[0] == '-') {
-      ++pos;
+    uint l = 0;
+    uint r = len - 1;
 
-      if      (arg == "--"         ) break;
-      else if (arg == "-join"      ) join     = true;
-      else if (arg == "-nocomplain") complain = false;
-      else if (arg == "-tails"     ) tails    = true;
+    if (numArgs == 2) {
+      while (l <= r) {
+        if (! isspace(str[l])) break;
 
-      else if (arg == "-directory") {
-        if (pos < numArgs)
-          directory = args[pos++]->toString();
-      }
-      else if (arg == "-path") {
-        if (pos < numArgs)
-          pathPrefix = args[pos++]->toString();
-      }
-      else if (arg == "-types") {
-        if (pos < numArgs)
-          types = args[pos++]->toString();
-      }
-      else {
-        tcl_->throwError("bad option \"" + arg + "\": must be -directory, -join, "
-                         "-nocomplain, -path, -tails, -types, or --");
-        return CTclValueRef();
+        ++l;
       }
     }
-    else
-      break;
-  }
+    else {
+      std::string chars = args[2]->toString();
 
-  std::string allArgs;
+      while (l <= r) {
+        if (chars.find(str[l]) == std::string::npos) break;
 
-  for (uint pos1 = pos; pos1 < numArgs; ++pos1) {
-    const std::string &arg = args[pos]->toString();
+        ++l;
+      }
+    }
 
-    if (pos1 > pos) allArgs += " ";
+    std::string str1 = str.substr(l, r - l + 1);
 
-    allArgs += arg;
+    return CTclValueRef(tcl_->createValue(str1));
   }
-
-  if (directory != "") {
-    if (! CDir::enter(directory)) {
-      if (complain) tcl_->throwError("no files matched glob patterns \"" + allArgs + "\"");
+  else if (cmd == "trimright") {
+    if (numArgs < 2 || numArgs > 3) {
+      tcl_->wrongNumArgs("string trimright string ?chars?");
       return CTclValueRef();
     }
-  }
 
-  std::vector<std::string> files;
+    const std::string &str = args[1]->toString();
 
-  for ( ; pos < numArgs; ++pos) {
-    const std::string &arg = args[pos]->toString();
+    uint len = str.size();
 
-    CFileMatch match;
+    uint l = 0;
+    uint r = len - 1;
 
-    std::vector<std::string> files1;
+    if (numArgs == 2) {
+      while (r >= l) {
+        if (! isspace(str[r])) break;
 
-    match.matchCurrentDir(arg, files1);
+        --r;
+      }
+    }
+    else {
+      std::string chars = args[2]->toString();
 
-    std::copy(files1.begin(), files1.end(), std::back_inserter(files));
-  }
+      while (r >= l) {
+        if (chars.find(str[r]) == std::string::npos) break;
 
-  if (directory != "")
-    CDir::leave();
+        --r;
+      }
+    }
 
-  if (files.empty()) {
-    if (complain) tcl_->throwError("no files matched glob patterns \"" + allArgs + "\"");
+    std::string str1 = str.substr(l, r - l + 1);
+
+    return CTclValueRef(tcl_->createValue(str1));
+  }
+  else if (cmd == "wordend") {
+    return CTclValueRef();
+  }
+  else if (cmd == "wordstart") {
+    return CTclValueRef();
+  }
+  else {
+    tcl_->throwError("bad option \"" + cmd + "\": must be "
+                     "bytelength, compare, equal, first, index, is, last, length, map, "
+                     "match, range, repeat, replace, tolower, toupper, totitle, trim, "
+                     "trimleft, trimright, wordend, or wordstart");
     return CTclValueRef();
   }
-
-  return CTclValueRef(tcl_->createValue(files));
 }
 
 //----------
 
 CTclValueRef
-CTclGlobalCommand::
+CTclSwitchCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("global varName ?varName ...?");
-    return CTclValueRef();
-  }
+  bool is_exact  = true;
+  bool is_glob   = false;
+  bool is_regexp = false;
 
-  auto *scope  = tcl_->getScope();
-  auto *gscope = tcl_->getGlobalScope();
+  uint pos = 0;
 
-  for (uint i = 0; i < numArgs; ++i) {
-    const std::string &varName = args[i]->toString();
+  while (pos < numArgs) {
+    const std::string &arg = args[pos]->toString();
 
-    auto var = scope->getVariable(varName);
+    if (arg.size() > 0 && arg[0] == '-') {
+      ++pos;
 
-    if (var.isValid()) {
-      tcl_->throwError("variable \"" + varName + "\" already exists");
-      return CTclValueRef();
+      if      (arg == "--"     ) break;
+      else if (arg == "-exact" ) is_exact  = true;
+      else if (arg == "-glob"  ) is_glob   = true;
+      else if (arg == "-regexp") is_regexp = true;
     }
-
-    var = gscope->getVariable(varName);
-
-    if (! var.isValid())
-      var = gscope->addVariable(varName, CTclValueRef());
-
-    scope->addVariable(varName, var);
+    else
+      break;
   }
 
-  return CTclValueRef();
-}
-
-//----------
+  if (pos >= numArgs - 1) {
+    tcl_->wrongNumArgs("switch ?switches? string pattern body ... ?default body?");
+    return CTclValueRef();
+  }
 
-CTclValueRef
-CTclHistoryCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  const std::string &str = args[pos++]->toString();
 
-  std::string cmd;
+  bool extra_pattern = false;
 
-  if (numArgs > 0) {
-    const std::string &cmd = args[0]->toString();
+  std::vector<std::string>  patterns;
+  std::vector<CTclValueRef> bodies;
 
-    if      (cmd == "add") {
-    }
-    else if (cmd == "change") {
-    }
-    else if (cmd == "clear") {
-    }
-    else if (cmd == "event") {
-    }
-    else if (cmd == "info") {
-    }
-    else if (cmd == "keep") {
-    }
-    else if (cmd == "nextid") {
-    }
-    else if (cmd == "redo") {
-    }
-    else {
-      tcl_->throwError("bad option \"" + cmd + "\": must be "
-                       "add, change, clear, event, info, keep, nextid, or redo");
-      return CTclValueRef();
-    }
-  }
-  else {
-    auto *history = tcl_->getHistory();
+  if (pos == numArgs - 1) {
+    // single list of pattern body
+    CTclValueRef list;
 
-    for (auto pc1 = history->beginCommand(), pc2 = history->endCommand(); pc1 != pc2; ++pc1) {
-      auto *cmd = *pc1;
+    if (args[pos]->getType() == CTclValue::ValueType::LIST)
+      list = args[pos];
+    else
+      list = args[pos]->toList(tcl_);
 
-      std::cout << cmd->getNumber() << " " << cmd->getCommand() << "\n";
-    }
-  }
+    uint length = list->getLength();
 
-  return CTclValueRef();
-}
+    uint i = 0;
 
-//----------
+    for ( ; i < length - 1; i += 2) {
+      const auto &pattern = list->getIndexValue(i)->toString();
+      auto        body    = list->getIndexValue(i + 1);
 
-CTclValueRef
-CTclIfCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+      patterns.push_back(pattern);
+      bodies  .push_back(body);
+    }
 
-  if (numArgs < 2) {
-    tcl_->throwError("wrong # args: no expression after \"if\" argument");
-    return CTclValueRef();
+    if (i < length)
+      extra_pattern = true;
   }
+  else {
+    while (pos < numArgs - 1) {
+      const auto &pattern = args[pos]->toString();
+      auto        body    = args[pos + 1];
 
-  bool has_then = false;
-
-  const std::string &name = args[1]->toString();
+      patterns.push_back(pattern);
+      bodies  .push_back(body);
 
-  if (name == "then") {
-    if (numArgs < 3) {
-      tcl_->throwError("wrong # args: no script following \"then\" argument");
-      return CTclValueRef();
+      pos += 2;
     }
 
-    has_then = true;
+    if (pos < numArgs)
+      extra_pattern = true;
   }
 
-  if (args[0]->evalBool(tcl_)) {
-    int pos = (has_then ? 2 : 1);
-
-    args[pos]->exec(tcl_);
-
+  if (extra_pattern) {
+    tcl_->throwError("extra switch pattern with no body");
     return CTclValueRef();
   }
 
-  uint pos = (has_then ? 3 : 2);
+  uint num_patterns = patterns.size();
 
-  while (pos < numArgs) {
-    const std::string &name = args[pos]->toString();
+  if (is_regexp) {
+    CRegExp regexp(str);
 
-    if      (name == "elseif") {
-      ++pos;
+    for (uint i = 0; i < num_patterns; ++i) {
+      const auto &pattern = patterns[i];
+      auto        body    = bodies  [i];
 
-      if  (pos >= numArgs) {
-        tcl_->throwError("wrong # args: no expression following \"elseif\" argument");
-        return CTclValueRef();
+      if (i == num_patterns - 1 && pattern == "default") {
+        return body->exec(tcl_);
       }
 
-      if (pos >= numArgs - 1) {
-        const std::string &arg = args[pos]->toString();
-        tcl_->throwError("wrong # args: no script following \"" + arg + "\" argument");
-        return CTclValueRef();
+      if (regexp.find(pattern)) {
+        return body->exec(tcl_);
       }
+    }
+  }
+  else if (is_glob) {
+    CGlob glob(str);
 
-      if (args[pos]->evalBool(tcl_)) {
-        args[pos + 1]->exec(tcl_);
+    for (uint i = 0; i < num_patterns; ++i) {
+      const auto &pattern = patterns[i];
+      auto        body    = bodies  [i];
 
-        return CTclValueRef();
+      if (i == num_patterns - 1 && pattern == "default") {
+        return body->exec(tcl_);
       }
 
-      pos += 2;
+      if (glob.compare(pattern)) {
+        return body->exec(tcl_);
+      }
     }
-    else if (name == "else") {
-      ++pos;
+  }
+  else {
+    for (uint i = 0; i < num_patterns; ++i) {
+      const auto &pattern = patterns[i];
+      auto        body    = bodies  [i];
 
-      if (pos >= numArgs) {
-        tcl_->throwError("wrong # args: no script following \"else\" argument");
-        return CTclValueRef();
+      if (i == num_patterns - 1 && pattern == "default") {
+        return body->exec(tcl_);
       }
 
-      if (pos < numArgs - 1) {
-        tcl_->throwError("wrong # args: extra words after \"else\" clause in \"if\" command");
-        return CTclValueRef();
+      if (str == pattern) {
+        return body->exec(tcl_);
       }
-
-      args[pos]->exec(tcl_);
-
-      return CTclValueRef();
-    }
-    else {
-      tcl_->throwError("invalid command name \"" + name + "\"");
-      return CTclValueRef();
     }
   }
 
@@ -4069,1906 +8930,2163 @@ exec(const std::vector<CTclValueRef> &args)
 
 //----------
 
+// tailcall command ?arg ...? : replace current proc call with command
 CTclValueRef
-CTclIncrCommand::
+CTclTailcallCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs < 1 || numArgs > 2)
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("tailcall command ?arg ...?");
     return CTclValueRef();
+  }
 
-  const std::string &varName = args[0]->toString();
-
-  auto *scope = tcl_->getScope();
-
-  auto var = scope->getVariable(varName);
-
-  if (! var.isValid()) {
-    tcl_->throwError("can't read \"" + varName + "\": no such variable");
+  if (! tcl_->getProc()) {
+    tcl_->throwError("tailcall can only be called from a proc or lambda");
     return CTclValueRef();
   }
 
-  auto value = var->getValue();
-
-  long ivalue;
-
-  bool ok = value->toInt(ivalue);
-
-  if (numArgs == 1) {
-    if (ok)
-      ++ivalue;
-  }
-  else {
-    long inc;
+  tcl_->setTailCall(args);
 
-    bool ok = args[1]->toInt(inc);
+  tcl_->setResultCode(CTcl::ResultCode::RETURN);
 
-    if (ok)
-      ivalue += inc;
-  }
+  return CTclValueRef();
+}
 
-  auto value1 = tcl_->createValue(ivalue);
+//----------
 
-  var->setValue(value1);
+using CTclClock = std::chrono::steady_clock;
 
-  return value1;
+static long
+elapsedNSecs(CTclClock::time_point t1, CTclClock::time_point t2)
+{
+  return long(std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count());
 }
 
-//----------
-
+// time script ?count? : average time of count runs of script
 CTclValueRef
-CTclInfoCommand::
+CTclTimeCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("info option ?arg arg ...?");
+  if (numArgs < 1 || numArgs > 2) {
+    tcl_->wrongNumArgs("time command ?count?");
     return CTclValueRef();
   }
 
-  const std::string &cmd = args[0]->toString();
+  long count = 1;
 
-  if      (cmd == "args") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("info args procname");
+  if (numArgs == 2) {
+    if (! args[1]->checkInt(tcl_, count))
       return CTclValueRef();
-    }
+  }
 
-    const std::string &procName = args[1]->toString();
+  const std::string &script = args[0]->toString();
 
-    auto *proc = tcl_->getProc(procName);
+  auto t1 = CTclClock::now();
 
-    if (! proc) {
-      tcl_->throwError("\"" + procName + "\" is not a procedure");
-      return CTclValueRef();
-    }
+  // number of iterations run (break ends loop early)
+  long n = 0;
 
-    std::vector<std::string> args;
+  while (n < count) {
+    CTclValueRef value;
 
-    proc->getArgs(args);
+    auto code = tcl_->execScript(script, value);
 
-    return CTclValueRef(tcl_->createValue(args));
-  }
-  else if (cmd == "body") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("info body procname");
-      return CTclValueRef();
-    }
+    ++n;
 
-    const std::string &procName = args[1]->toString();
+    if (code == CTcl::ResultCode::ERROR)
+      return CTclValueRef();
 
-    auto *proc = tcl_->getProc(procName);
+    if (code == CTcl::ResultCode::BREAK)
+      break;
 
-    if (! proc) {
-      tcl_->throwError("\"" + procName + "\" is not a procedure");
-      return CTclValueRef();
+    if (code == CTcl::ResultCode::RETURN) {
+      tcl_->setResultCode(code);
+      return value;
     }
-
-    return proc->getBody();
-  }
-  else if (cmd == "cmdcount") {
-    return CTclValueRef(tcl_->createValue(0L));
   }
-  else if (cmd == "commands") {
-    std::vector<std::string> names;
 
-    tcl_->getCommandNames(names);
+  auto t2 = CTclClock::now();
 
-    return CTclValueRef(tcl_->createValue(names));
-  }
-  else if (cmd == "complete") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("info complete command");
-      return CTclValueRef();
-    }
+  double usecs = (n > 0 ? elapsedNSecs(t1, t2)/(1000.0*n) : 0.0);
 
-    const std::string &cmd = args[1]->toString();
+  return tcl_->createValue(CStrUtil::strprintf("%g microseconds per iteration", usecs));
+}
 
-    bool rc = tcl_->isCompleteLine(cmd);
+//----------
 
-    return CTclValueRef(tcl_->createValue(long(rc ? 1 : 0)));
-  }
-  else if (cmd == "default") {
-  }
-  else if (cmd == "exists") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("info exists command");
-      return CTclValueRef();
-    }
+// timerate ?-overhead ns? script ?ms? ?max-count? : run script repeatedly for
+// ms milliseconds (default 1000) and return per iteration statistics in
+// nanoseconds with the measured loop overhead removed
+CTclValueRef
+CTclTimerateCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  static const char *usage = "timerate ?-overhead ns? command ?time ?max-count??";
 
-    auto *scope = tcl_->getScope();
+  static const std::size_t maxSamples = 1000000;
 
-    const std::string &varName = args[1]->toString();
+  uint numArgs = args.size();
 
-    auto var = scope->getVariable(varName);
+  uint pos = 0;
 
-    return CTclValueRef(tcl_->createValue(long(var.isValid() ? 1 : 0)));
-  }
-  else if (cmd == "frame") {
-  }
-  else if (cmd == "functions") {
-  }
-  else if (cmd == "globals") {
-    auto *scope = tcl_->getGlobalScope();
+  long overhead = -1;
 
-    std::vector<std::string> names;
+  if (numArgs > 0 && args[0]->toString() == "-overhead") {
+    if (numArgs < 2) {
+      tcl_->wrongNumArgs(usage);
+      return CTclValueRef();
+    }
 
-    scope->getVariableNames(names);
+    if (! args[1]->checkInt(tcl_, overhead))
+      return CTclValueRef();
 
-    return CTclValueRef(tcl_->createValue(names));
+    pos = 2;
   }
-  else if (cmd == "hostname") {
-    std::string name = COSUser::getHostName();
 
-    return CTclValueRef(tcl_->createValue(name));
-  }
-  else if (cmd == "level") {
-    return CTclValueRef(tcl_->createValue(0L));
-  }
-  else if (cmd == "library") {
-  }
-  else if (cmd == "loaded") {
-  }
-  else if (cmd == "locals") {
-  }
-  else if (cmd == "nameofexecutable") {
-  }
-  else if (cmd == "patchlevel") {
+  if (numArgs < pos + 1 || numArgs > pos + 3) {
+    tcl_->wrongNumArgs(usage);
+    return CTclValueRef();
   }
-  else if (cmd == "procs") {
-    std::vector<std::string> names;
 
-    auto *scope = tcl_->getGlobalScope();
+  const std::string &script = args[pos]->toString();
 
-    scope->getProcNames(names);
+  long msecs    = 1000;
+  long maxCount = -1;
 
-    return CTclValueRef(tcl_->createValue(names));
-  }
-  else if (cmd == "script") {
-  }
-  else if (cmd == "sharedlibextension") {
+  if (numArgs > pos + 1) {
+    if (! args[pos + 1]->checkInt(tcl_, msecs))
+      return CTclValueRef();
   }
-  else if (cmd == "tclversion") {
+
+  if (numArgs > pos + 2) {
+    if (! args[pos + 2]->checkInt(tcl_, maxCount))
+      return CTclValueRef();
   }
-  else if (cmd == "vars") {
-    auto *scope = tcl_->getScope();
 
-    std::vector<std::string> names;
+  using Samples = std::vector<long>;
 
-    scope->getVariableNames(names);
+  // run script collecting per iteration times (reservoir sampled when too many)
+  std::minstd_rand rand;
 
-    return CTclValueRef(tcl_->createValue(names));
-  }
+  auto runSamples = [&](const std::string &str, long runNSecs, long runCount,
+                        Samples &samples, long &count, long &total) {
+    count = 0;
+    total = 0;
 
-  return CTclValueRef();
-}
+    auto start = CTclClock::now();
 
-//----------
+    while (runCount < 0 || count < runCount) {
+      CTclValueRef value;
 
-CTclValueRef
-CTclJoinCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+      auto t1 = CTclClock::now();
 
-  if (numArgs == 0 || numArgs > 2) {
-    tcl_->wrongNumArgs("join list ?joinString?");
-    return CTclValueRef();
-  }
+      auto code = tcl_->execScript(str, value);
 
-  CTclValueRef list;
+      auto t2 = CTclClock::now();
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+      if (code == CTcl::ResultCode::ERROR)
+        return false;
 
-  std::string sep = " ";
+      if (code == CTcl::ResultCode::BREAK)
+        break;
 
-  if (numArgs == 2)
-    sep = args[1]->toString();
+      long t = elapsedNSecs(t1, t2);
 
-  std::string res;
+      if      (samples.size() < maxSamples)
+        samples.push_back(t);
+      else {
+        std::size_t i = rand() % (count + 1);
 
-  uint length = list->getLength();
+        if (i < maxSamples)
+          samples[i] = t;
+      }
 
-  for (uint i = 0; i < length; ++i) {
-    std::string item = list->getIndexValue(i)->toString();
+      ++count;
 
-    if (i > 0) res += sep;
+      total += t;
 
-    res += item;
-  }
+      if (elapsedNSecs(start, t2) >= runNSecs)
+        break;
+    }
 
-  return CTclValueRef(tcl_->createValue(res));
-}
+    return true;
+  };
 
-//----------
+  auto median = [](Samples &samples) {
+    if (samples.empty()) return 0L;
 
-CTclValueRef
-CTclLAppendCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    std::size_t n = samples.size()/2;
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("lappend varName ?value value ...?");
-    return CTclValueRef();
-  }
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
 
-  const std::string &varName = args[0]->toString();
+    return samples[n];
+  };
 
-  auto *scope = tcl_->getScope();
+  // calibrate : time of running empty script with same timing loop
+  if (overhead < 0) {
+    Samples samples;
 
-  auto var = scope->getVariable(varName);
+    samples.reserve(1000);
 
-  if (! var.isValid()) {
-    auto *list = new CTclList;
+    long count, total;
 
-    scope->setVariableValue(varName, CTclValueRef(list));
+    (void) runSamples("", 10*1000*1000L, 1000, samples, count, total);
 
-    var = scope->getVariable(varName);
+    overhead = median(samples);
   }
 
-  auto value = var->getValue();
+  Samples samples;
 
-  CTclValueRef list;
+  long count = 0, total = 0;
 
-  if (value->getType() == CTclValue::ValueType::LIST)
-    list = value;
-  else
-    list = value->toList(tcl_);
+  if (! runSamples(script, msecs*1000*1000L, maxCount, samples, count, total))
+    return CTclValueRef();
 
-  for (uint i = 1; i < numArgs; ++i)
-    list->addValue(args[i]);
+  for (auto &t : samples)
+    t = std::max(t - overhead, 0L);
 
-  return CTclValueRef(list);
-}
+  std::sort(samples.begin(), samples.end());
 
-//----------
+  auto percentile = [&](double p) {
+    if (samples.empty()) return 0L;
 
-CTclValueRef
-CTclListCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  auto *list = new CTclList;
+    auto i = std::size_t(p*double(samples.size() - 1) + 0.5);
 
-  uint numArgs = args.size();
+    return samples[i];
+  };
 
-  for (uint i = 0; i < numArgs; ++i)
-    list->addValue(args[i]);
+  long net = std::max(total - count*overhead, 0L);
 
-  return CTclValueRef(list);
+  std::vector<CTclValueRef> values;
+
+  auto addValue = [&](const std::string &name, long value) {
+    values.push_back(tcl_->createValue(name));
+    values.push_back(tcl_->createValue(value));
+  };
+
+  addValue("count"   , count);
+  addValue("mean"    , count > 0 ? net/count : 0L);
+  addValue("min"     , samples.empty() ? 0L : samples.front());
+  addValue("max"     , samples.empty() ? 0L : samples.back());
+  addValue("p50"     , percentile(0.50));
+  addValue("p90"     , percentile(0.90));
+  addValue("p99"     , percentile(0.99));
+  addValue("overhead", overhead);
+
+  return tcl_->createValue(values);
 }
 
 //----------
 
-CTclValueRef
-CTclLIndexCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
-
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("lindex list ?index...?");
-    return CTclValueRef();
+// variable trace callback : runs 'command name1 name2 op'
+class CTclTraceVariableProc : public CTclVariableProc {
+ public:
+  CTclTraceVariableProc(CTcl *tcl, const std::string &name, uint ops,
+                        const std::string &command) :
+   tcl_(tcl), name_(name), command_(command) {
+    setOps(ops);
   }
 
-  if (numArgs == 1) {
-    if (args[0]->getType() == CTclValue::ValueType::LIST)
-      return args[0];
-    else
-      return args[0]->toList(tcl_);
+  const std::string &getCommand() const { return command_; }
+
+  void notify(CTclVariable *var) override {
+    notify(var, TraceOp::WRITE, "");
   }
 
-  long ind;
+  void notify(CTclVariable *, TraceOp op, const std::string &index) override {
+    std::string opName;
 
-  if (! args[1]->toIndex(tcl_, ind))
-    return CTclValueRef();
+    if      (op == TraceOp::READ ) opName = "read";
+    else if (op == TraceOp::WRITE) opName = "write";
+    else if (op == TraceOp::UNSET) opName = "unset";
 
-  CTclValueRef list;
+    std::vector<CTclValueRef> values;
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+    values.push_back(tcl_->createValue(name_));
+    values.push_back(tcl_->createValue(index));
+    values.push_back(tcl_->createValue(opName));
 
-  int length = list->getLength();
+    CTclValueRef value;
 
-  if (ind < 0) ind = length + ind;
+    (void) tcl_->execScript(command_ + " " + CTclList(values).toString(), value);
+  }
 
-  if (ind < 0 || ind >= length)
-    return CTclValueRef();
+ private:
+  CTcl*       tcl_ { nullptr };
+  std::string name_;
+  std::string command_;
+};
 
-  return list->getIndexValue(ind);
-}
+static std::string
+traceOpsToString(uint ops, const std::vector<std::string> &names)
+{
+  std::string str;
 
-//----------
+  for (uint i = 0; i < names.size(); ++i) {
+    if (! (ops & (1U<<i))) continue;
+
+    if (! str.empty()) str += " ";
+
+    str += names[i];
+  }
+
+  return str;
+}
 
 CTclValueRef
-CTclLInsertCommand::
+CTclTraceCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
   if (numArgs < 3) {
-    tcl_->wrongNumArgs("linsert list index element ?element ...?");
+    tcl_->wrongNumArgs("trace option type name ?arg ...?");
     return CTclValueRef();
   }
 
-  long ind;
+  const std::string &opt  = args[0]->toString();
+  const std::string &type = args[1]->toString();
+  const std::string &name = args[2]->toString();
 
-  if (! args[1]->toIndex(tcl_, ind))
+  if (opt != "add" && opt != "remove" && opt != "info") {
+    tcl_->throwError("bad option \"" + opt + "\": must be add, info, or remove");
     return CTclValueRef();
+  }
 
-  CTclValueRef list;
-
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+  bool is_var = (type == "variable");
 
-  int length = list->getLength();
+  if (! is_var && type != "execution") {
+    tcl_->throwError("bad type \"" + type + "\": must be execution or variable");
+    return CTclValueRef();
+  }
 
-  if (ind < 0) ind = length + ind;
+  // variable ops map to TraceOp bits, execution ops to ExecTraceOp bits
+  std::vector<std::string> opNames;
 
-  if (ind < 0 || ind > length)
-    return CTclValueRef();
+  if (is_var)
+    opNames = {"read", "write", "unset"};
+  else
+    opNames = {"enter", "leave"};
 
-  auto *list1 = new CTclList;
+  if (opt == "info") {
+    if (numArgs != 3) {
+      tcl_->wrongNumArgs("trace info " + type + " name");
+      return CTclValueRef();
+    }
 
-  for (int i = 0; i < ind; ++i)
-    list1->addValue(list->getIndexValue(i));
+    std::vector<CTclValueRef> values;
 
-  for (uint i = 2; i < numArgs; ++i)
-    list1->addValue(args[i]);
+    if (is_var) {
+      auto var = tcl_->getVariable(name);
 
-  for (uint i = ind; i < numArgs; ++i)
-    list1->addValue(list->getIndexValue(i));
+      if (var.isValid()) {
+        std::vector<CTclVariableProc *> procs;
 
-  return CTclValueRef(list1);
-}
+        var->getNotifyProcs(procs);
 
-//----------
+        for (auto *proc : procs) {
+          auto *tproc = dynamic_cast<CTclTraceVariableProc *>(proc);
+          if (! tproc) continue;
 
-CTclValueRef
-CTclLLengthCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+          std::vector<CTclValueRef> values1;
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("llength list");
-    return CTclValueRef();
-  }
+          values1.push_back(tcl_->createValue(traceOpsToString(tproc->getOps(), opNames)));
+          values1.push_back(tcl_->createValue(tproc->getCommand()));
 
-  CTclValueRef list;
+          values.push_back(tcl_->createValue(values1));
+        }
+      }
+    }
+    else {
+      CTcl::ExecTraceList traces;
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+      tcl_->getExecTraces(name, traces);
 
-  auto length = list->getLength();
+      for (const auto &trace : traces) {
+        std::vector<CTclValueRef> values1;
 
-  return CTclValueRef(tcl_->createValue(ulong(length)));
-}
+        values1.push_back(tcl_->createValue(traceOpsToString(trace.ops, opNames)));
+        values1.push_back(tcl_->createValue(trace.command));
 
-//----------
+        values.push_back(tcl_->createValue(values1));
+      }
+    }
 
-CTclValueRef
-CTclLRangeCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    return tcl_->createValue(values);
+  }
 
-  if (numArgs != 3) {
-    tcl_->wrongNumArgs("lrange list first last");
+  if (numArgs != 5) {
+    tcl_->wrongNumArgs("trace " + opt + " " + type + " name opList command");
     return CTclValueRef();
   }
 
-  CTclValueRef list;
+  CTclValueRef opList;
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
+  if (args[3]->getType() == CTclValue::ValueType::LIST)
+    opList = args[3];
   else
-    list = args[0]->toList(tcl_);
-
-  int length = list->getLength();
+    opList = args[3]->toList(tcl_);
 
-  long first;
+  uint ops = 0;
 
-  if (! args[1]->toIndex(tcl_, first))
-    return CTclValueRef();
+  uint numOps = opList->getLength();
 
-  long last;
+  for (uint i = 0; i < numOps; ++i) {
+    const std::string &opName = opList->getIndexValue(i)->toString();
 
-  if (! args[2]->toIndex(tcl_, last))
-    return CTclValueRef();
+    if (is_var && opName == "array")
+      continue;
 
-  auto *list1 = new CTclList;
+    auto p = std::find(opNames.begin(), opNames.end(), opName);
 
-  for (int i = first; i <= last && i >= 0 && i < length; ++i) {
-    auto value = list->getIndexValue(i);
+    if (p == opNames.end()) {
+      if (is_var)
+        tcl_->throwError("bad operation \"" + opName + "\": must be array, read, unset, or write");
+      else
+        tcl_->throwError("bad operation \"" + opName + "\": must be enter or leave");
+      return CTclValueRef();
+    }
 
-    list1->addValue(CTclValueRef(value->dup()));
+    ops |= (1U<<(p - opNames.begin()));
   }
 
-  return CTclValueRef(list1);
-}
+  const std::string &command = args[4]->toString();
 
-//----------
+  if (is_var) {
+    auto var = tcl_->getVariable(name);
 
-CTclValueRef
-CTclLRepeatCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    if (opt == "add") {
+      // tracing an unknown variable creates it (undefined)
+      if (! var.isValid())
+        var = tcl_->getScope()->addVariable(name, CTclValueRef());
 
-  if (numArgs < 2) {
-    tcl_->wrongNumArgs("lrepeat positiveCount value ?value ...?");
-    return CTclValueRef();
-  }
+      var->addNotifyProc(new CTclTraceVariableProc(tcl_, name, ops, command));
+    }
+    else {
+      if (! var.isValid())
+        return CTclValueRef();
 
-  long count;
+      std::vector<CTclVariableProc *> procs;
 
-  if (! args[0]->toIndex(tcl_, count))
-    return CTclValueRef();
+      var->getNotifyProcs(procs);
 
-  auto *list = new CTclList;
+      for (auto *proc : procs) {
+        auto *tproc = dynamic_cast<CTclTraceVariableProc *>(proc);
 
-  for (int i = 0; i < count; ++i) {
-    for (uint j = 1; j < numArgs; ++j)
-      list->addValue(CTclValueRef(args[j]->dup()));
+        if (tproc && tproc->getOps() == ops && tproc->getCommand() == command) {
+          var->removeNotifyProc(tproc->getId());
+          break;
+        }
+      }
+    }
+  }
+  else {
+    if (opt == "add") {
+      if (! tcl_->getCommand(name) && ! tcl_->getProc(name)) {
+        tcl_->throwError("unknown command \"" + name + "\"");
+        return CTclValueRef();
+      }
+
+      tcl_->addExecTrace(name, ops, command);
+    }
+    else
+      tcl_->removeExecTrace(name, ops, command);
   }
 
-  return CTclValueRef(list);
+  return CTclValueRef();
 }
 
 //----------
 
 CTclValueRef
-CTclLReplaceCommand::
+CTclUpdateCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs < 3) {
-    tcl_->wrongNumArgs("lreplace list first last ?element element ...?");
+  if (numArgs > 1) {
+    tcl_->wrongNumArgs("update ?idletasks?");
     return CTclValueRef();
   }
 
-  CTclValueRef list;
-
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
-
-  long ind1, ind2;
-
-  if (! args[1]->toIndex(tcl_, ind1))
-    return CTclValueRef();
-
-  if (! args[2]->toIndex(tcl_, ind2))
-    return CTclValueRef();
-
-  int length = list->getLength();
-
-  if (ind1 < 0) ind1 += length;
-  if (ind2 < 0) ind2 += length;
+  bool idletasks = false;
 
-  auto *list1 = new CTclList;
+  if (numArgs == 1) {
+    const std::string &arg = args[0]->toString();
 
-  if (ind1 < 0 || ind1 >= length) {
-    tcl_->throwError("list doesn't contain element " + CStrUtil::toString(ind1));
-    return CTclValueRef();
+    if (arg == "idletasks")
+      idletasks = true;
+    else {
+      tcl_->throwError("bad option \"" + arg + "\": must be idletasks");
+      return CTclValueRef();
+    }
   }
 
-  if (ind2 < 0 || ind2 >= length) {
-    tcl_->throwError("list doesn't contain element " + CStrUtil::toString(ind2));
-    return CTclValueRef();
-  }
+  tcl_->update(idletasks);
 
-  for (int i = 0; i < ind1 && i < int(length); ++i) {
-    auto value = list->getIndexValue(i);
+  return CTclValueRef();
+}
 
-    list1->addValue(value);
-  }
+//----------
 
-  for (uint i = 3; i < numArgs; ++i)
-    list1->addValue(args[i]);
+CTclValueRef
+CTclUnsetCommand::
+exec(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-  for (int i = ind2 + 1; i < int(length); ++i) {
-    auto value = list->getIndexValue(i);
+  for (uint i = 0; i < numArgs; ++i) {
+    const std::string &varName = args[i]->toString();
 
-    list1->addValue(value);
+    tcl_->removeVariable(varName);
   }
 
-  return CTclValueRef(list1);
+  return CTclValueRef();
 }
 
 //----------
 
 CTclValueRef
-CTclLSearchCommand::
+CTclUplevelCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
-#if 0
-  static CommandOpts[] = {
-    { "-exact"      , COMMAND_OPT_FLAG },
-    { "-glob"       , COMMAND_OPT_FLAG },
-    { "-regexp"     , COMMAND_OPT_FLAG },
-    { "-sorted"     , COMMAND_OPT_FLAG },
-    { "-all"        , COMMAND_OPT_FLAG },
-    { "-inline"     , COMMAND_OPT_FLAG },
-    { "-not"        , COMMAND_OPT_FLAG },
-    { "-start"      , COMMAND_OPT_FLAG },
-    { "-ascii"      , COMMAND_OPT_FLAG },
-    { "-dictionary" , COMMAND_OPT_FLAG },
-    { "-integer"    , COMMAND_OPT_FLAG },
-    { "-nocase"     , COMMAND_OPT_FLAG },
-    { "-real"       , COMMAND_OPT_FLAG },
-    { "-decreasing" , COMMAND_OPT_FLAG },
-    { "-increasing" , COMMAND_OPT_FLAG },
-    { "-index"      , COMMAND_OPT_LIST },
-    { "-subindices" , COMMAND_OPT_FLAG },
-  };
-#endif
+  CTclValueRef script;
+
+  if (! getScript(args, script))
+    return CTclValueRef();
+
+  auto value = tcl_->parseString(script->toString());
+
+  tcl_->endLevel();
+
+  return value;
+}
 
+// get script and start its level (ended by caller when script completes)
+bool
+CTclUplevelCommand::
+getScript(const std::vector<CTclValueRef> &args, CTclValueRef &script)
+{
   uint numArgs = args.size();
 
-  if (numArgs != 2) {
-    tcl_->wrongNumArgs("lsearch ?options? list pattern");
-    return CTclValueRef();
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("uplevel ?level? command ?arg ...?");
+    return false;
   }
 
-  CTclValueRef list;
+  uint level = 0;
+  uint pos   = 0;
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+  if (tcl_->parseLevel(args[0]->toString(), level))
+    ++pos;
+  else {
+    if (! tcl_->parseLevel("1", level)) {
+      tcl_->throwError("bad level \"1\"");
+      return false;
+    }
+  }
 
-  auto value = args[1];
+  if (pos >= numArgs) {
+    tcl_->wrongNumArgs("uplevel ?level? command ?arg ...?");
+    return false;
+  }
 
-  auto length = list->getLength();
+  std::string str;
 
-  for (uint i = 0; i < length; ++i) {
-    auto value1 = list->getIndexValue(i);
+  for (uint i = pos; i < numArgs; ++i) {
+    if (i > pos) str += " ";
 
-    if (value1->cmp(value) == 0)
-      return CTclValueRef(tcl_->createValue(ulong(i)));
+    str += args[i]->toString();
   }
 
-  return CTclValueRef(tcl_->createValue(-1L));
+  script = tcl_->createValue(str);
+
+  tcl_->startLevel(level);
+
+  return true;
 }
 
 //----------
 
 CTclValueRef
-CTclLSetCommand::
+CTclUpvarCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
   if (numArgs < 2) {
-    tcl_->wrongNumArgs("lset listVar index ?index...? value");
+    tcl_->wrongNumArgs("upvar ?level? otherVar localVar ?otherVar localVar ...?");
     return CTclValueRef();
   }
 
-  auto *scope = tcl_->getScope();
+  uint level = 0;
+  uint pos   = 0;
 
-  const std::string &varName = args[0]->toString();
+  // odd number of args means first is level
+  if (numArgs & 1) {
+    const std::string &levelStr = args[0]->toString();
 
-  auto var = scope->getVariable(varName);
+    if (! tcl_->parseLevel(levelStr, level)) {
+      tcl_->throwError("bad level \"" + levelStr + "\"");
+      return CTclValueRef();
+    }
 
-  if (! var.isValid()) {
-    tcl_->throwError("can't read \"" + varName + "\": no such variable");
-    return CTclValueRef();
+    ++pos;
+  }
+  else {
+    if (! tcl_->parseLevel("1", level)) {
+      tcl_->throwError("bad level \"1\"");
+      return CTclValueRef();
+    }
   }
 
-  if (numArgs > 2) {
-    auto value = var->getValue();
+  auto *scope  = tcl_->getScope();
+  auto *oscope = tcl_->getLevelScope(level);
 
-    for (uint i = 1; i < numArgs - 2; ++i) {
-      CTclValueRef list;
+  for ( ; pos < numArgs - 1; pos += 2) {
+    const std::string &otherName = args[pos    ]->toString();
+    const std::string &localName = args[pos + 1]->toString();
 
-      if (value->getType() == CTclValue::ValueType::LIST)
-        list = value;
-      else
-        list = value->toList(tcl_);
+    // array element (name(index)) is linked through array variable
+    auto len  = otherName.size();
+    auto lpos = otherName.find('(');
 
-      long ind;
+    if (lpos != std::string::npos && lpos > 0 && otherName[len - 1] == ')') {
+      auto arrayName = otherName.substr(0, lpos);
 
-      if (! args[i]->toIndex(tcl_, ind))
-        return CTclValueRef();
+      auto avar = oscope->getVariable(arrayName);
 
-      value = list->getIndexValue(ind);
-    }
+      if (! avar.isValid())
+        avar = oscope->addVariable(arrayName, CTclValueRef());
 
-    CTclValueRef list;
+      auto indexStr = otherName.substr(lpos + 1, len - lpos - 2);
 
-    if (value->getType() == CTclValue::ValueType::LIST)
-      list = value;
-    else
-      list = value->toList(tcl_);
+      scope->addVariable(localName,
+        CTclVariableRef(new CTclArrayElementVariable(avar, indexStr)));
 
-    long ind;
+      continue;
+    }
 
-    if (! args[numArgs - 2]->toIndex(tcl_, ind))
-      return CTclValueRef();
+    // link shares the variable of the outer frame (no copy)
+    auto var = oscope->getVariable(otherName);
 
-    list->setIndexValue(ind, args[numArgs - 1]);
+    if (! var.isValid())
+      var = oscope->addVariable(otherName, CTclValueRef());
 
-    var->setValue(list);
+    if (oscope == scope && otherName == localName)
+      continue;
+
+    scope->addVariable(localName, var);
   }
-  else
-    var->setValue(args[1]);
 
-  return var->getValue();
+  return CTclValueRef();
 }
 
 //----------
 
 CTclValueRef
-CTclLSortCommand::
+CTclVariableCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("lsort list");
+  if (numArgs < 1) {
+    tcl_->wrongNumArgs("variable ?name value...? name ?value?");
     return CTclValueRef();
   }
 
-  CTclValueRef list;
+  auto *scope = tcl_->getScope();
 
-  if (args[0]->getType() == CTclValue::ValueType::LIST)
-    list = args[0];
-  else
-    list = args[0]->toList(tcl_);
+  if (numArgs == 1) {
+    const std::string &name = args[0]->toString();
 
-  typedef std::set<CTclValueRef> ValueSet;
+    auto var = scope->getVariable(name);
 
-  ValueSet valueSet;
+    if (! var.isValid())
+      scope->addVariable(name, CTclValueRef());
+  }
+  else {
+    for (uint i = 0; i < numArgs - 1; i += 2) {
+      const auto &name  = args[i    ]->toString();
+      auto        value = args[i + 1];
 
-  uint length = list->getLength();
+      auto var = scope->getVariable(name);
 
-  for (uint i = 0; i < length; ++i) {
-    auto value = list->getIndexValue(i);
+      if (var.isValid())
+        var->setValue(value);
+      else
+        var = scope->addVariable(name, value);
 
-    valueSet.insert(value);
+      scope->addVariable(name, var);
+    }
   }
 
-  auto *list1 = new CTclList;
-
-  for (const auto &vs : valueSet)
-    list1->addValue(vs);
-
-  return CTclValueRef(list1);
+  return CTclValueRef();
 }
 
 //----------
 
-CTclValueRef
-CTclNamespaceCommand::
-exec(const std::vector<CTclValueRef> &args)
+// vector math kernels on packed arrays. Loops are kept simple so the compiler
+// can vectorize them and reductions use four partial results to break the
+// dependency between iterations. Kernels are used for both real and (64 bit)
+// integer arrays.
+
+// apply binary operator element-wise (single value array is used for all elements)
+template<typename T, typename OP>
+static void
+vexprBinary(const std::vector<T> &a, const std::vector<T> &b, std::vector<T> &r, OP op)
 {
-  uint numArgs = args.size();
+  size_t na = a.size();
+  size_t nb = b.size();
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("namespace subcommand ?arg ...?");
-    return CTclValueRef();
-  }
+  size_t n = (na == 1 ? nb : na);
 
-  const std::string &cmd = args[0]->toString();
+  r.resize(n);
 
-  if      (cmd == "children") {
-  }
-  else if (cmd == "code") {
+  const T *pa = a.data();
+  const T *pb = b.data();
+  T       *pr = r.data();
+
+  if      (na == nb) {
+    for (size_t i = 0; i < n; ++i)
+      pr[i] = op(pa[i], pb[i]);
   }
-  else if (cmd == "current") {
+  else if (na == 1) {
+    T sa = pa[0];
+
+    for (size_t i = 0; i < n; ++i)
+      pr[i] = op(sa, pb[i]);
   }
-  else if (cmd == "delete") {
+  else {
+    T sb = pb[0];
+
+    for (size_t i = 0; i < n; ++i)
+      pr[i] = op(pa[i], sb);
   }
-  else if (cmd == "eval") {
-    if (numArgs < 3) {
-      tcl_->wrongNumArgs("namespace eval name ?arg ...?");
-      return CTclValueRef();
-    }
+}
 
-    const std::string &name = args[1]->toString();
+template<typename T, typename OP>
+static void
+vexprUnary(const std::vector<T> &a, std::vector<T> &r, OP op)
+{
+  size_t n = a.size();
 
-    auto *scope = tcl_->getNamedScope(name, true);
+  r.resize(n);
 
-    tcl_->pushScope(scope);
+  const T *pa = a.data();
+  T       *pr = r.data();
 
-    for (uint i = 2; i < numArgs; ++i)
-      args[i]->exec(tcl_);
+  for (size_t i = 0; i < n; ++i)
+    pr[i] = op(pa[i]);
+}
 
-    tcl_->popScope();
-  }
-  else if (cmd == "exists") {
-  }
-  else if (cmd == "export") {
-  }
-  else if (cmd == "forget") {
-  }
-  else if (cmd == "import") {
-  }
-  else if (cmd == "inscope") {
-  }
-  else if (cmd == "origin") {
-  }
-  else if (cmd == "parent") {
-  }
-  else if (cmd == "qualifiers") {
-  }
-  else if (cmd == "tail") {
-  }
-  else if (cmd == "which") {
+// reduce non-empty array using operator
+template<typename T, typename OP>
+static T
+vexprReduce(const std::vector<T> &a, T init, OP op)
+{
+  size_t n = a.size();
+
+  const T *pa = a.data();
+
+  T r0 = init, r1 = init, r2 = init, r3 = init;
+
+  size_t i = 0;
+
+  for ( ; i + 4 <= n; i += 4) {
+    r0 = op(r0, pa[i    ]);
+    r1 = op(r1, pa[i + 1]);
+    r2 = op(r2, pa[i + 2]);
+    r3 = op(r3, pa[i + 3]);
   }
-  else {
-    tcl_->throwError("bad option \"" + cmd + "\": must be children, code, current, "
-                     "delete, eval, exists, export, forget, import, inscope, origin, "
-                     "parent, qualifiers, tail, or which");
-    return CTclValueRef();
+
+  for ( ; i < n; ++i)
+    r0 = op(r0, pa[i]);
+
+  return op(op(r0, r1), op(r2, r3));
+}
+
+static double
+vexprDot(const std::vector<double> &a, const std::vector<double> &b)
+{
+  size_t n = a.size();
+
+  const double *pa = a.data();
+  const double *pb = b.data();
+
+  double r0 = 0.0, r1 = 0.0, r2 = 0.0, r3 = 0.0;
+
+  size_t i = 0;
+
+  for ( ; i + 4 <= n; i += 4) {
+    r0 += pa[i    ]*pb[i    ];
+    r1 += pa[i + 1]*pb[i + 1];
+    r2 += pa[i + 2]*pb[i + 2];
+    r3 += pa[i + 3]*pb[i + 3];
   }
 
-  return CTclValueRef();
+  for ( ; i < n; ++i)
+    r0 += pa[i]*pb[i];
+
+  return (r0 + r1) + (r2 + r3);
 }
 
-//----------
+// inclusive prefix scan
+template<typename T, typename OP>
+static void
+vexprScan(const std::vector<T> &a, std::vector<T> &r, OP op)
+{
+  size_t n = a.size();
 
-CTclValueRef
-CTclOpenCommand::
-exec(const std::vector<CTclValueRef> &args)
+  r.resize(n);
+
+  if (n == 0)
+    return;
+
+  const T *pa = a.data();
+  T       *pr = r.data();
+
+  T s = pa[0];
+
+  pr[0] = s;
+
+  for (size_t i = 1; i < n; ++i) {
+    s = op(s, pa[i]);
+
+    pr[i] = s;
+  }
+}
+
+// get packed reals for list value. If all values are (64 bit) integers they
+// are also returned as packed integers
+static bool
+vexprValues(CTcl *tcl, const CTclValueRef &value, std::vector<double> &reals,
+            std::vector<long> &integers, bool &isInteger)
 {
-  uint numArgs = args.size();
+  CTclValueRef list;
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("open fileName ?access? ?permissions?");
-    return CTclValueRef();
+  if (value->getType() == CTclValue::ValueType::LIST)
+    list = value;
+  else
+    list = value->toList(tcl);
+
+  if (! list.isValid() || list->getType() != CTclValue::ValueType::LIST) {
+    tcl->throwError("expected list but got \"" + value->toString() + "\"");
+    return false;
   }
 
-  const std::string &name = args[0]->toString();
+  const auto &values = list.cast<CTclList>()->getValues();
 
-  std::string access = "r";
+  reals   .resize(values.size());
+  integers.resize(values.size());
 
-  if (numArgs > 1)
-    access = args[1]->toString();
+  isInteger = true;
 
-  long perm = 0666;
+  size_t i = 0;
 
-  if (numArgs > 2) {
-    if (! args[2]->checkInt(tcl_, perm))
-      return CTclValueRef();
+  for (const auto &v : values) {
+    if (isInteger && ! v->toInt(integers[i]))
+      isInteger = false;
+
+    if (! v->toReal(reals[i++])) {
+      tcl->throwError("expected floating-point number but got \"" + v->toString() + "\"");
+      return false;
+    }
   }
 
-  std::string handle = tcl_->openFile(name, access);
+  if (! isInteger)
+    integers.clear();
 
-  return CTclValueRef(tcl_->createValue(handle));
+  return true;
 }
 
-//----------
-
+// vexpr op list list   : element-wise + - * / % ^ < <= > >= == != min max
+//                        (single value list is used for all elements)
+// vexpr op list        : element-wise - abs sqrt, or reduction sum min max mean
+// vexpr dot list list  : dot product
+// vexpr scan op list   : prefix scan (op is + * min max)
+//
+// Lists of integers are processed as 64 bit integers (an integer result which
+// does not fit is an error), other lists as reals. / ^ sqrt and mean always
+// use reals (so / is real division).
 CTclValueRef
-CTclPackageCommand::
+CTclVExprCommand::
 exec(const std::vector<CTclValueRef> &args)
 {
   uint numArgs = args.size();
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("should be \"package option ?arg ...?\"");
+  if (numArgs < 2 || numArgs > 3) {
+    tcl_->wrongNumArgs("vexpr op list ?list?");
     return CTclValueRef();
   }
 
-  return CTclValueRef();
-}
+  const std::string &op = args[0]->toString();
 
-//----------
+  std::vector<double> a, b, r;
+  std::vector<long>   ia, ib, ir;
 
-CTclValueRef
-CTclProcCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  bool isIntA = false, isIntB = false;
 
-  if (numArgs != 3) return CTclValueRef();
+  // set on integer overflow by integer operators
+  bool overflow = false;
 
-  const std::string &name = args[0]->toString();
+  auto iadd = [&](long x, long y) { long z; overflow |= __builtin_add_overflow(x, y, &z); return z; };
+  auto isub = [&](long x, long y) { long z; overflow |= __builtin_sub_overflow(x, y, &z); return z; };
+  auto imul = [&](long x, long y) { long z; overflow |= __builtin_mul_overflow(x, y, &z); return z; };
 
-  CTclValueRef list;
+  auto imin = [](long x, long y) { return std::min(x, y); };
+  auto imax = [](long x, long y) { return std::max(x, y); };
 
-  if (args[1]->getType() == CTclValue::ValueType::LIST)
-    list = args[1];
-  else
-    list = args[1]->toList(tcl_);
+  auto overflowError = [&]() {
+    tcl_->throwError("integer overflow");
+    return CTclValueRef();
+  };
 
-  std::vector<std::string> args1;
+  auto listValue = [&]() {
+    CTclList::ValueList values;
 
-  uint length = list->getLength();
+    values.reserve(r.size());
 
-  for (uint i = 0; i < length; ++i) {
-    auto value = list->getIndexValue(i);
+    for (const auto &x : r)
+      values.push_back(tcl_->createValue(x));
 
-    // TODO: name + def value
+    return CTclValueRef(new CTclList(values));
+  };
 
-    args1.push_back(value->toString());
-  }
+  auto intListValue = [&]() {
+    if (overflow)
+      return overflowError();
 
-  tcl_->defineProc(name, args1, args[2]);
+    CTclList::ValueList values;
 
-  return CTclValueRef();
-}
+    values.reserve(ir.size());
 
-//----------
+    for (const auto &x : ir)
+      values.push_back(tcl_->createValue(x));
 
-// puts [-nonewline] [channelId] string
-CTclValueRef
-CTclPutsCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    return CTclValueRef(new CTclList(values));
+  };
 
-  int pos = 0;
+  auto intValue = [&](long x) {
+    if (overflow)
+      return overflowError();
 
-  bool newline = true;
+    return CTclValueRef(tcl_->createValue(x));
+  };
 
-  if (numArgs > 1) {
-    if (args[pos]->toString() == "-nonewline") {
-      newline = false;
+  auto badOp = [&](const std::string &op, const std::string &ops) {
+    tcl_->throwError("bad operator \"" + op + "\": must be " + ops);
+    return CTclValueRef();
+  };
 
-      ++pos;
-      --numArgs;
+  //---
+
+  // prefix scan
+  if (op == "scan") {
+    if (numArgs != 3) {
+      tcl_->wrongNumArgs("vexpr scan op list");
+      return CTclValueRef();
     }
-  }
 
-  FILE *fp = stdout;
+    const std::string &op1 = args[1]->toString();
 
-  if (numArgs > 1) {
-    const std::string &fileId = args[pos]->toString();
+    if (op1 != "+" && op1 != "*" && op1 != "min" && op1 != "max")
+      return badOp(op1, "+, *, min or max");
 
-    if      (fileId == "stdout")
-      fp = stdout;
-    else if (fileId == "stderr")
-      fp = stderr;
-    else {
-      fp = tcl_->getFile(fileId);
+    if (! vexprValues(tcl_, args[2], a, ia, isIntA))
+      return CTclValueRef();
 
-      if (fp == nullptr) {
-        tcl_->throwError("can not find channel named \"" + fileId + "\"");
+    if (isIntA) {
+      if      (op1 == "+"  ) vexprScan(ia, ir, iadd);
+      else if (op1 == "*"  ) vexprScan(ia, ir, imul);
+      else if (op1 == "min") vexprScan(ia, ir, imin);
+      else                   vexprScan(ia, ir, imax);
+
+      return intListValue();
+    }
+
+    if      (op1 == "+"  ) vexprScan(a, r, [](double x, double y) { return x + y; });
+    else if (op1 == "*"  ) vexprScan(a, r, [](double x, double y) { return x*y; });
+    else if (op1 == "min") vexprScan(a, r, [](double x, double y) { return std::min(x, y); });
+    else                   vexprScan(a, r, [](double x, double y) { return std::max(x, y); });
+
+    return listValue();
+  }
+
+  if (! vexprValues(tcl_, args[1], a, ia, isIntA))
+    return CTclValueRef();
+
+  //---
+
+  // unary operator or reduction
+  if (numArgs == 2) {
+    if (op == "min" || op == "max" || op == "mean") {
+      if (a.empty()) {
+        tcl_->throwError("empty list for \"" + op + "\"");
         return CTclValueRef();
       }
     }
 
-    ++pos;
-    --numArgs;
+    if (isIntA) {
+      if      (op == "-")
+        vexprUnary(ia, ir, [&](long x) { return isub(0, x); });
+      else if (op == "abs")
+        vexprUnary(ia, ir, [&](long x) { return (x < 0 ? isub(0, x) : x); });
+      else if (op == "sum")
+        return intValue(vexprReduce(ia, 0L, iadd));
+      else if (op == "min")
+        return intValue(vexprReduce(ia, ia[0], imin));
+      else if (op == "max")
+        return intValue(vexprReduce(ia, ia[0], imax));
+
+      if (op == "-" || op == "abs")
+        return intListValue();
+    }
+
+    if      (op == "-"   ) vexprUnary(a, r, [](double x) { return -x; });
+    else if (op == "abs" ) vexprUnary(a, r, [](double x) { return std::fabs(x); });
+    else if (op == "sqrt") vexprUnary(a, r, [](double x) { return std::sqrt(x); });
+    else if (op == "sum")
+      return tcl_->createValue(vexprReduce(a, 0.0, [](double x, double y) { return x + y; }));
+    else if (op == "min")
+      return tcl_->createValue(
+        vexprReduce(a, a[0], [](double x, double y) { return std::min(x, y); }));
+    else if (op == "max")
+      return tcl_->createValue(
+        vexprReduce(a, a[0], [](double x, double y) { return std::max(x, y); }));
+    else if (op == "mean")
+      return tcl_->createValue(
+        vexprReduce(a, 0.0, [](double x, double y) { return x + y; })/double(a.size()));
+    else
+      return badOp(op, "-, abs, sqrt, sum, min, max or mean");
+
+    return listValue();
   }
 
-  if (numArgs == 1) {
-    std::ostringstream ostr;
+  //---
 
-    args[pos]->print(ostr);
+  // binary operator
+  if (! vexprValues(tcl_, args[2], b, ib, isIntB))
+    return CTclValueRef();
 
-    const std::string &str = ostr.str();
+  if (a.size() != b.size() && a.size() != 1 && b.size() != 1) {
+    tcl_->throwError(CStrUtil::strprintf("list lengths differ (%lu and %lu)",
+                                         ulong(a.size()), ulong(b.size())));
+    return CTclValueRef();
+  }
 
-    fwrite(str.c_str(), 1, str.size(), fp);
+  bool isInt = (isIntA && isIntB);
+
+  if (op == "dot") {
+    if (a.size() != b.size()) {
+      tcl_->throwError(CStrUtil::strprintf("list lengths differ (%lu and %lu)",
+                                           ulong(a.size()), ulong(b.size())));
+      return CTclValueRef();
+    }
+
+    if (isInt) {
+      vexprBinary(ia, ib, ir, imul);
+
+      return intValue(vexprReduce(ir, 0L, iadd));
+    }
+
+    return tcl_->createValue(vexprDot(a, b));
   }
 
-  if (newline)
-    fputc('\n', fp);
+  if (isInt) {
+    bool divZero = false;
 
-  return CTclValueRef();
-}
+    // remainder has sign of dividend (like fmod)
+    auto imod = [&](long x, long y) {
+      if (y == 0) { divZero = true; return 0L; }
 
-//----------
+      return (y == -1 ? 0L : x % y);
+    };
 
-CTclValueRef
-CTclPidCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+    bool isIntOp = true;
 
-  if (numArgs > 1) {
-    tcl_->wrongNumArgs("pid");
-    return CTclValueRef();
+    if      (op == "+"  ) vexprBinary(ia, ib, ir, iadd);
+    else if (op == "-"  ) vexprBinary(ia, ib, ir, isub);
+    else if (op == "*"  ) vexprBinary(ia, ib, ir, imul);
+    else if (op == "%"  ) vexprBinary(ia, ib, ir, imod);
+    else if (op == "<"  ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x <  y); });
+    else if (op == "<=" ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x <= y); });
+    else if (op == ">"  ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x >  y); });
+    else if (op == ">=" ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x >= y); });
+    else if (op == "==" ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x == y); });
+    else if (op == "!=" ) vexprBinary(ia, ib, ir, [](long x, long y) { return long(x != y); });
+    else if (op == "min") vexprBinary(ia, ib, ir, imin);
+    else if (op == "max") vexprBinary(ia, ib, ir, imax);
+    else                  isIntOp = false;
+
+    if (isIntOp) {
+      if (divZero) {
+        tcl_->throwError("divide by zero");
+        return CTclValueRef();
+      }
+
+      return intListValue();
+    }
   }
 
-  auto pid = COSProcess::getProcessId();
+  if      (op == "+"  ) vexprBinary(a, b, r, [](double x, double y) { return x + y; });
+  else if (op == "-"  ) vexprBinary(a, b, r, [](double x, double y) { return x - y; });
+  else if (op == "*"  ) vexprBinary(a, b, r, [](double x, double y) { return x*y; });
+  else if (op == "/"  ) vexprBinary(a, b, r, [](double x, double y) { return x/y; });
+  else if (op == "%"  ) vexprBinary(a, b, r, [](double x, double y) { return std::fmod(x, y); });
+  else if (op == "^"  ) vexprBinary(a, b, r, [](double x, double y) { return std::pow(x, y); });
+  else if (op == "<"  ) vexprBinary(a, b, r, [](double x, double y) { return double(x <  y); });
+  else if (op == "<=" ) vexprBinary(a, b, r, [](double x, double y) { return double(x <= y); });
+  else if (op == ">"  ) vexprBinary(a, b, r, [](double x, double y) { return double(x >  y); });
+  else if (op == ">=" ) vexprBinary(a, b, r, [](double x, double y) { return double(x >= y); });
+  else if (op == "==" ) vexprBinary(a, b, r, [](double x, double y) { return double(x == y); });
+  else if (op == "!=" ) vexprBinary(a, b, r, [](double x, double y) { return double(x != y); });
+  else if (op == "min") vexprBinary(a, b, r, [](double x, double y) { return std::min(x, y); });
+  else if (op == "max") vexprBinary(a, b, r, [](double x, double y) { return std::max(x, y); });
+  else
+    return badOp(op, "+, -, *, /, %, ^, <, <=, >, >=, ==, !=, min, max or dot");
 
-  return CTclValueRef(tcl_->createValue(long(pid)));
+  return listValue();
 }
 
 //----------
 
-CTclValueRef
-CTclPwdCommand::
-exec(const std::vector<CTclValueRef> &args)
+bool
+CTclWhileCommand::
+loopStart(const std::vector<CTclValueRef> &args, LoopState &)
 {
   uint numArgs = args.size();
 
-  if (numArgs != 0) {
-    tcl_->wrongNumArgs("pwd");
-    return CTclValueRef();
+  if (numArgs != 2) {
+    tcl_->wrongNumArgs("while test command");
+    return false;
   }
 
-  std::string dirName = COSFile::getCurrentDir();
+  return true;
+}
 
-  return CTclValueRef(tcl_->createValue(dirName));
+bool
+CTclWhileCommand::
+loopNext(const std::vector<CTclValueRef> &args, LoopState &state, CTclValueRef &body)
+{
+  bool b = args[0]->evalBool(tcl_);
+
+  if (tcl_->isError() || ! b) return false;
+
+  body = args[1];
+
+  ++state.iter;
+
+  return true;
 }
 
-//----------
+//-----------
 
-CTclValueRef
-CTclReadCommand::
-exec(const std::vector<CTclValueRef> &args)
+CTclProc::
+~CTclProc()
 {
-  uint numArgs = args.size();
-  uint pos     = 0;
+  if (scopeRef_)
+    scope_->unref();
+}
 
-  bool newline = true;
+void
+CTclProc::
+setScope(CTclScope *scope, bool ref)
+{
+  if (scopeRef_)
+    scope_->unref();
 
-  if (numArgs > 1) {
-    if (args[pos]->toString() == "-nonewline") {
-      newline = false;
+  scope_    = scope;
+  scopeRef_ = ref;
 
-      ++pos;
-      --numArgs;
-    }
-  }
+  if (scopeRef_)
+    scope_->ref();
+}
 
-  if (numArgs != 1 && numArgs != 2) {
-    tcl_->wrongNumArgs("read channelId ?numChars?\" or \"read ?-nonewline? channelId");
-    return CTclValueRef();
-  }
+CTclValueRef
+CTclProc::
+exec(const std::vector<CTclValueRef> &args)
+{
+  CTclValueRef value;
 
-  const std::string &fileId = args[pos]->toString();
+  (void) tcl_->callProc(this, args, value);
 
-  std::string dirName = COSFile::getCurrentDir();
+  return value;
+}
 
-  FILE *fp = nullptr;
+// create call scope with argument variables (nullptr on error)
+CTclScope *
+CTclProc::
+bindArgs(const std::vector<CTclValueRef> &args)
+{
+  uint numArgs = args.size();
 
-  if (fileId == "stdin")
-    fp = stdin;
-  else {
-    fp = tcl_->getFile(fileId);
+  uint numProcArgs = args_.size();
 
-    if (fp == nullptr) {
-      tcl_->throwError("can not find channel named \"" + fileId + "\"");
-      return CTclValueRef();
-    }
-  }
+  bool var_args = (numProcArgs > 0 && args_[numProcArgs - 1] == "args");
 
-  std::string line;
+  if (! var_args) {
+    if (numArgs != numProcArgs) {
+      std::string usage = name_;
 
-  if (numArgs == 1) {
-    int c = getc(fp);
+      for (uint i = 0; i < numProcArgs; ++i)
+        usage += " " + args_[i];
 
-    while (c != EOF) {
-      line += (char) c;
+      tcl_->throwError("wrong # args: should be \"" + usage + "\"");
 
-      c = getc(fp);
+      return nullptr;
     }
   }
   else {
-    long num;
-
-    if (! args[pos + 1]->checkInt(tcl_, num))
-      return CTclValueRef();
+    if (numArgs < numProcArgs - 1) {
+      std::string usage = name_;
 
-    for (int i = 0; i < num; ++i) {
-      int c = getc(fp);
+      for (uint i = 0; i < numProcArgs; ++i)
+        usage += " " + args_[i];
 
-      if (c == EOF) break;
+      tcl_->throwError("wrong # args: should be \"" + usage + "\"");
 
-      line += (char) c;
+      return nullptr;
     }
   }
 
-  return CTclValueRef(tcl_->createValue(line));
-}
+  // variables not local to proc are looked up in its namespace (not the
+  // caller's scope) so lookup cost does not grow with call depth
+  auto *pscope = (scope_ ? scope_ : tcl_->getScope()->namespaceScope());
 
-//----------
+  auto *scope = new CTclScope(tcl_, pscope);
 
-CTclValueRef
-CTclReturnCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  CTclValueRef retVal;
+  if (! var_args) {
+    for (uint i = 0; i < numProcArgs; ++i)
+      scope->setVariableValue(args_[i], args[i]);
+  }
+  else {
+    for (uint i = 0; i < numProcArgs - 1; ++i)
+      scope->setVariableValue(args_[i], args[i]);
 
-  uint numArgs = args.size();
+    auto *list = new CTclList;
 
-  if (numArgs > 0)
-    retVal = args[0];
+    for (uint i = numProcArgs - 1; i < numArgs; ++i)
+      list->addValue(args[i]);
+
+    scope->setVariableValue("args", CTclValueRef(list));
+  }
+
+  return scope;
+}
 
-  tcl_->setReturnFlag(retVal);
+//-----------
 
-  return CTclValueRef();
+bool
+operator<(CTclValueRef lhs, CTclValueRef rhs) {
+  if (lhs->getType() != rhs->getType()) return (lhs->getType() < rhs->getType());
+
+  return lhs->cmp(rhs);
 }
 
 //-----------
 
-CTclValueRef
-CTclSetCommand::
-exec(const std::vector<CTclValueRef> &args)
+static long
+profileNSecs()
 {
-  uint numArgs = args.size();
+  using namespace std::chrono;
 
-  if (numArgs < 1 || numArgs > 2)
-    return CTclValueRef();
+  return long(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
 
-  const std::string &varName = args[0]->toString();
+void
+CTclProfiler::
+startCall(const std::string &name, CallType type)
+{
+  auto &stats = stats_[name];
 
-  auto *scope = tcl_->getScope();
+  stats.type = type;
 
-  auto pos1 = varName.find ('(');
-  auto pos2 = varName.rfind(')');
+  ++stats.count;
+  ++stats.active;
 
-  if (pos1 != std::string::npos && pos2 != std::string::npos && pos2 == varName.size() - 1) {
-    std::string varName1 = varName.substr(0, pos1);
-    std::string indexStr = varName.substr(pos1 + 1, pos2 - pos1 - 1);
+  Call call;
 
-    if (numArgs == 2) {
-      scope->setArrayVariableValue(varName1, indexStr, args[1]);
+  call.stats = &stats;
+  call.start = profileNSecs();
 
-      return args[1];
-    }
-    else
-      return scope->getArrayVariableValue(varName1, indexStr);
-  }
-  else {
-    if (numArgs == 2) {
-      scope->setVariableValue(varName, args[1]);
+  calls_.push_back(call);
+}
 
-      return args[1];
-    }
-    else
-      return scope->getVariableValue(varName);
-  }
+void
+CTclProfiler::
+endCall()
+{
+  // call started before profiling enabled
+  if (calls_.empty())
+    return;
 
-  return CTclValueRef();
-}
+  long t = profileNSecs();
 
-//-----------
+  auto call = calls_.back();
 
-CTclValueRef
-CTclSourceCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  calls_.pop_back();
 
-  if (numArgs != 1) {
-    tcl_->wrongNumArgs("source fileName");
-    return CTclValueRef();
-  }
+  long elapsed = t - call.start;
 
-  const std::string &fileName = args[0]->toString();
+  auto *stats = call.stats;
 
-  tcl_->parseFile(fileName);
+  stats->self += elapsed - call.child;
 
-  return CTclValueRef();
+  // only count outermost of recursive calls in total
+  if (--stats->active == 0)
+    stats->total += elapsed;
+
+  if (! calls_.empty())
+    calls_.back().child += elapsed;
 }
 
-//-----------
+void
+CTclProfiler::
+clearCalls()
+{
+  // dropped calls are no longer active (so later calls count in total)
+  for (auto &call : calls_)
+    --call.stats->active;
 
-CTclValueRef
-CTclStringCommand::
-exec(const std::vector<CTclValueRef> &args)
+  calls_.clear();
+}
+
+void
+CTclProfiler::
+reset()
 {
-  uint numArgs = args.size();
+  stats_.clear();
+  calls_.clear();
+}
 
-  if (numArgs == 0) {
-    tcl_->wrongNumArgs("string option arg ?arg ...?");
-    return CTclValueRef();
-  }
+std::string
+CTclProfiler::
+report(const std::string &sort, uint limit) const
+{
+  using NamedStats = std::pair<std::string,const Stats *>;
 
-  const std::string &cmd = args[0]->toString();
+  std::vector<NamedStats> entries;
 
-  if      (cmd == "bytelength") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("wrong # args: should be \"string bytelength string\"");
-      return CTclValueRef();
-    }
+  for (const auto &ps : stats_)
+    entries.push_back(NamedStats(ps.first, &ps.second));
 
-    const std::string &str = args[1]->toString();
+  std::sort(entries.begin(), entries.end(), [&](const NamedStats &lhs, const NamedStats &rhs) {
+    if      (sort == "count") return (lhs.second->count > rhs.second->count);
+    else if (sort == "total") return (lhs.second->total > rhs.second->total);
+    else if (sort == "name" ) return (lhs.first < rhs.first);
+    else                      return (lhs.second->self > rhs.second->self);
+  });
 
-    auto len = str.size();
+  if (limit > 0 && entries.size() > limit)
+    entries.resize(limit);
 
-    return CTclValueRef(tcl_->createValue(ulong(len)));
-  }
-  else if (cmd == "compare" || cmd == "equal") {
-    if (numArgs < 3) {
-      tcl_->wrongNumArgs("string " + cmd + " ?-nocase? ?-length int? string1 string2");
-      return CTclValueRef();
-    }
+  std::string str =
+    CStrUtil::strprintf("%-24s %-7s %10s %14s %14s %12s\n",
+                        "name", "type", "calls", "total(us)", "self(us)", "self/call");
 
-    bool is_equal = (cmd == "equal");
+  for (const auto &entry : entries) {
+    const auto *stats = entry.second;
 
-    bool        nocase = false;
-    long        length = -1;
-    std::string str1, str2;
+    double perCall = (stats->count > 0 ? stats->self/(1000.0*stats->count) : 0.0);
 
-    uint pos = 1;
+    str += CStrUtil::strprintf("%-24s %-7s %10lu %14.3f %14.3f %12.3f\n",
+                               entry.first.c_str(),
+                               stats->type == CallType::PROC ? "proc" : "command",
+                               stats->count, stats->total/1000.0, stats->self/1000.0, perCall);
+  }
 
-    if (pos < numArgs && args[pos]->toString() == "-nocase") {
-      ++pos;
+  return str;
+}
 
-      nocase = true;
-    }
+//-----------
 
-    if (pos < numArgs && args[pos]->toString() == "-length") {
-      ++pos;
+volatile sig_atomic_t CTclSampler::pending_ = 0;
 
-      if (pos < numArgs) {
-        bool ok = args[pos++]->toInt(length);
+CTclSampler::
+CTclSampler(uint size)
+{
+  samples_.resize(std::max(size, 1U));
+}
 
-        if (! ok) return CTclValueRef();
-      }
-    }
+CTclSampler::
+~CTclSampler()
+{
+  stop();
+}
 
-    if (pos < numArgs)
-      str1 = args[pos++]->toString();
+// install tick handler and timer (previous ones are restored by stop)
+bool
+CTclSampler::
+start(uint hz)
+{
+  stop();
 
-    if (pos < numArgs)
-      str2 = args[pos++]->toString();
+  struct sigaction action;
 
-    long cmp = 0;
+  memset(&action, 0, sizeof(action));
 
-    if (length >= 0) {
-      str1 = str1.substr(0, length);
-      str2 = str2.substr(0, length);
+  action.sa_handler = CTclSampler::tickHandler;
+  action.sa_flags   = SA_RESTART;
 
-      if (nocase)
-        cmp = CStrUtil::casecmp(str1, str2);
-      else
-        cmp = CStrUtil::cmp(str1, str2);
-    }
-    else {
-      if (nocase)
-        cmp = CStrUtil::casecmp(str1, str2);
-      else
-        cmp = CStrUtil::cmp(str1, str2);
-    }
+  sigemptyset(&action.sa_mask);
 
-    if (is_equal)
-      return CTclValueRef(tcl_->createValue(cmp));
-    else
-      return CTclValueRef(tcl_->createValue(long(cmp == 0)));
-  }
-  else if (cmd == "first") {
-    if (numArgs != 3 && numArgs != 4) {
-      tcl_->wrongNumArgs("should be \"string first subString string ?startIndex?\"");
-      return CTclValueRef();
-    }
+  if (sigaction(SIGPROF, &action, &oldAction_) != 0)
+    return false;
 
-    const std::string &substr = args[1]->toString();
-    const std::string &str    = args[2]->toString();
+  long usecs = std::max(1000000L/long(hz), 1L);
 
-    auto pos = str.find(substr);
+  struct itimerval timer;
 
-    return CTclValueRef(tcl_->createValue(pos));
+  timer.it_interval.tv_sec  = usecs/1000000;
+  timer.it_interval.tv_usec = usecs%1000000;
+  timer.it_value            = timer.it_interval;
+
+  if (setitimer(ITIMER_PROF, &timer, &oldTimer_) != 0) {
+    (void) sigaction(SIGPROF, &oldAction_, nullptr);
+    return false;
   }
-  else if (cmd == "index") {
-    if (numArgs != 3 && numArgs != 4) {
-      tcl_->wrongNumArgs("should be \"string index string charIndex\"");
-      return CTclValueRef();
-    }
 
-    const std::string &str = args[1]->toString();
+  pending_ = 0;
+  running_ = true;
 
-    long pos;
+  return true;
+}
 
-    bool ok = args[2]->toInt(pos);
+void
+CTclSampler::
+stop()
+{
+  if (! running_)
+    return;
 
-    if (! ok) return CTclValueRef();
+  // stop timer before restoring handler (a tick raised before the timer is
+  // stopped is delivered to our handler on return from setitimer)
+  (void) setitimer(ITIMER_PROF, &oldTimer_, nullptr);
 
-    int len = str.size();
+  (void) sigaction(SIGPROF, &oldAction_, nullptr);
 
-    if (pos < 0 || pos >= len)
-      return CTclValueRef();
+  pending_ = 0;
+  running_ = false;
+}
 
-    return CTclValueRef(tcl_->createValue(str.substr(pos, 1)));
-  }
-  else if (cmd == "is") {
-    return CTclValueRef();
-  }
-  else if (cmd == "last") {
-    if (numArgs != 3 && numArgs != 4) {
-      tcl_->wrongNumArgs("should be \"string last subString string ?startIndex?\"");
-      return CTclValueRef();
-    }
+// signal handler : only counts ticks (stack is recorded outside handler)
+void
+CTclSampler::
+tickHandler(int)
+{
+  pending_ = pending_ + 1;
+}
 
-    const std::string &substr = args[1]->toString();
-    const std::string &str    = args[2]->toString();
+void
+CTclSampler::
+sample(const std::string &stack)
+{
+  uint ticks = uint(pending_);
 
-    auto pos = str.rfind(substr);
+  pending_ = 0;
 
-    return CTclValueRef(tcl_->createValue(pos));
-  }
-  else if (cmd == "length") {
-    if (numArgs != 2) {
-      tcl_->wrongNumArgs("string length string");
-      return CTclValueRef();
-    }
+  if (ticks == 0)
+    return;
 
-    const std::string &str = args[1]->toString();
+  auto &sample = samples_[pos_];
 
-    auto len = str.size();
+  if (sample.ticks > 0) {
+    evicted_[sample.stack] += sample.ticks;
 
-    return CTclValueRef(tcl_->createValue(ulong(len)));
-  }
-  else if (cmd == "map") {
-    return CTclValueRef();
+    ++numEvicted_;
   }
-  else if (cmd == "match") {
-    if (numArgs < 3) {
-      tcl_->wrongNumArgs("string match ?-nocase? pattern string");
-      return CTclValueRef();
-    }
-
-    bool        nocase = false;
-    std::string str1, str2;
-
-    uint pos = 1;
 
-    if (pos < numArgs && args[pos]->toString() == "-nocase") {
-      ++pos;
+  sample.stack = stack;
+  sample.ticks = ticks;
 
-      nocase = true;
-    }
+  pos_ = (pos_ + 1) % samples_.size();
 
-    if (pos < numArgs)
-      str1 = args[pos++]->toString();
+  numSamples_ += ticks;
+}
 
-    if (pos < numArgs)
-      str2 = args[pos++]->toString();
+void
+CTclSampler::
+clear()
+{
+  for (auto &sample : samples_) {
+    sample.stack = "";
+    sample.ticks = 0;
+  }
 
-    CGlob glob(str1);
+  evicted_.clear();
 
-    if (nocase)
-      glob.setCaseSensitive(false);
+  pos_        = 0;
+  numSamples_ = 0;
+  numEvicted_ = 0;
+}
 
-    bool cmp = glob.compare(str2);
+// folded stack format : 'a;b;c count' per line
+std::string
+CTclSampler::
+folded() const
+{
+  auto counts = evicted_;
 
-    return CTclValueRef(tcl_->createValue(long(cmp)));
+  for (const auto &sample : samples_) {
+    if (sample.ticks > 0)
+      counts[sample.stack] += sample.ticks;
   }
-  else if (cmd == "range") {
-    if (numArgs != 4) {
-      tcl_->wrongNumArgs("string range string first last");
-      return CTclValueRef();
-    }
 
-    const std::string &str = args[1]->toString();
+  std::string str;
 
-    long ind1, ind2;
+  for (const auto &pc : counts)
+    str += pc.first + " " + std::to_string(pc.second) + "\n";
 
-    if (! args[2]->toIndex(tcl_, ind1))
-      return CTclValueRef();
+  return str;
+}
 
-    if (! args[3]->toIndex(tcl_, ind2))
-      return CTclValueRef();
+bool
+CTclSampler::
+writeFolded(const std::string &fileName) const
+{
+  FILE *fp = fopen(fileName.c_str(), "w");
 
-    std::string str1 = str.substr(ind1, ind2 - ind1);
+  if (! fp)
+    return false;
 
-    return CTclValueRef(tcl_->createValue(str1));
-  }
-  else if (cmd == "repeat") {
-    if (numArgs != 3) {
-      tcl_->wrongNumArgs("string repeat string count");
-      return CTclValueRef();
-    }
+  std::string str = folded();
 
-    const std::string &str = args[1]->toString();
+  bool rc = (fwrite(str.c_str(), 1, str.size(), fp) == str.size());
 
-    long num;
+  fclose(fp);
 
-    if (! args[2]->checkInt(tcl_, num))
-      return CTclValueRef();
+  return rc;
+}
 
-    std::string str1;
+//-----------
 
-    for (int i = 0; i < num; ++i)
-      str1 += str;
+CTclTraceLog::
+CTclTraceLog()
+{
+  start_ = profileNSecs();
+}
 
-    return CTclValueRef(tcl_->createValue(str1));
+// append value string to str stopping once str is longer than maxLen. Strings
+// are copied up to limit and lists are added element by element so large
+// arguments cost no more than the limit
+static void
+traceArgString(const CTclValueRef &value, std::string &str, size_t maxLen)
+{
+  if (str.size() > maxLen)
+    return;
+
+  if      (value->getType() == CTclValue::ValueType::STRING) {
+    const auto &str1 = value.cast<CTclString>()->getValue();
+
+    str += str1.substr(0, maxLen + 1 - str.size());
   }
-  else if (cmd == "replace") {
-    if (numArgs != 4 && numArgs != 5) {
-      tcl_->wrongNumArgs("string replace string first last ?string?");
-      return CTclValueRef();
-    }
+  else if (value->getType() == CTclValue::ValueType::LIST) {
+    const auto &values = value.cast<CTclList>()->getValues();
 
-    const std::string &str = args[1]->toString();
+    bool first = true;
 
-    long start, end;
+    for (const auto &v : values) {
+      if (! first) str += " ";
 
-    if (! args[2]->checkInt(tcl_, start) || ! args[3]->checkInt(tcl_, end))
-      return CTclValueRef();
+      if (str.size() > maxLen) break;
 
-    std::string rep_str;
+      first = false;
 
-    if (numArgs == 5)
-      rep_str = args[4]->toString();
+      if (v->getType() == CTclValue::ValueType::LIST && v->getLength() != 1) {
+        str += "{";
 
-    int len = str.size();
+        traceArgString(v, str, maxLen);
 
-    std::string lstr = (start >= 0 && start < len ? str.substr(0, start) : "");
-    std::string rstr = (end   >= 0 && end   < len ? str.substr(end + 1): "");
+        str += "}";
+      }
+      else {
+        std::string str1;
 
-    std::string str1 = lstr + rep_str + rstr;
+        traceArgString(v, str1, maxLen - str.size());
 
-    return CTclValueRef(tcl_->createValue(str1));
-  }
-  else if (cmd == "tolower") {
-    if (numArgs < 2 || numArgs > 4) {
-      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
-      return CTclValueRef();
+        if (CTcl::needsBraces(str1))
+          str += "{" + str1 + "}";
+        else
+          str += str1;
+      }
     }
+  }
+  else
+    str += value->toString();
+}
 
-    auto str = args[1]->toString();
+void
+CTclTraceLog::
+begin(const std::string &name, const char *category, const std::vector<CTclValueRef> &args)
+{
+  // keep end events of recorded begins when full
+  if (events_.size() >= maxEvents_) {
+    ++numDropped_;
 
-    auto len = str.size();
+    recorded_.push_back(false);
 
-    long start = 0, end = len;
+    return;
+  }
 
-    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
-      return CTclValueRef();
+  Event event;
 
-    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
-      return CTclValueRef();
+  event.phase    = 'B';
+  event.name     = name;
+  event.category = category;
+  event.ts       = profileNSecs() - start_;
+  event.depth    = recorded_.size();
 
-    for (int i = start; i <= end && i < len; ++i)
-      str[i] = tolower(str[i]);
+  for (const auto &arg : args) {
+    if (event.args.size() >= argSize_) break;
 
-    return CTclValueRef(tcl_->createValue(str));
+    if (! event.args.empty()) event.args += " ";
+
+    traceArgString(arg, event.args, argSize_);
   }
-  else if (cmd == "toupper") {
-    if (numArgs < 2 || numArgs > 4) {
-      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
-      return CTclValueRef();
-    }
 
-    std::string str = args[1]->toString();
+  if (event.args.size() > argSize_) {
+    // truncate at start of UTF-8 character (skip back over continuation bytes)
+    size_t len = argSize_;
 
-    auto len = str.size();
+    while (len > 0 && (static_cast<unsigned char>(event.args[len]) & 0xC0) == 0x80)
+      --len;
 
-    long start = 0, end = len;
+    event.args.resize(len);
 
-    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
-      return CTclValueRef();
+    event.args += "...";
+  }
 
-    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
-      return CTclValueRef();
+  events_.push_back(event);
 
-    for (int i = start; i <= end && i < len; ++i)
-      str[i] = toupper(str[i]);
+  recorded_.push_back(true);
+}
 
-    return CTclValueRef(tcl_->createValue(str));
-  }
-  else if (cmd == "totitle") {
-    if (numArgs < 2 || numArgs > 4) {
-      tcl_->wrongNumArgs("string tolower string ?first? ?last?");
-      return CTclValueRef();
-    }
+void
+CTclTraceLog::
+end()
+{
+  // call started before tracing enabled
+  if (recorded_.empty())
+    return;
 
-    std::string str = args[1]->toString();
+  bool recorded = recorded_.back();
 
-    auto len = str.size();
+  recorded_.pop_back();
 
-    long start = 0, end = len;
+  if (! recorded)
+    return;
 
-    if (numArgs > 2 && ! args[2]->checkInt(tcl_, start))
-      return CTclValueRef();
+  Event event;
 
-    if (numArgs > 3 && ! args[3]->checkInt(tcl_, end))
-      return CTclValueRef();
+  event.phase = 'E';
+  event.ts    = profileNSecs() - start_;
+  event.depth = recorded_.size();
 
-    for (int i = start; i <= end && i < len; ++i) {
-      if (i == start)
-        str[i] = toupper(str[i]);
-      else
-        str[i] = tolower(str[i]);
-    }
+  events_.push_back(event);
+}
 
-    return CTclValueRef(tcl_->createValue(str));
-  }
-  else if (cmd == "trim") {
-    if (numArgs < 2 || numArgs > 3) {
-      tcl_->wrongNumArgs("string trim string ?chars?");
-      return CTclValueRef();
-    }
+void
+CTclTraceLog::
+clear()
+{
+  events_  .clear();
+  recorded_.clear();
 
-    const std::string &str = args[1]->toString();
+  numDropped_ = 0;
 
-    uint len = str.size();
+  start_ = profileNSecs();
+}
 
-    uint l = 0;
-    uint r = len - 1;
+static std::string
+jsonString(const std::string &str)
+{
+  std::string str1 = "\"";
 
-    if (numArgs == 2) {
-      while (l <= r) {
-        if (! isspace(str[l])) break;
+  for (auto c : str) {
+    if      (c == '"' ) str1 += "\\\"";
+    else if (c == '\\') str1 += "\\\\";
+    else if (c == '\n') str1 += "\\n";
+    else if (c == '\t') str1 += "\\t";
+    else if (static_cast<unsigned char>(c) < 0x20)
+      str1 += CStrUtil::strprintf("\\u%04x", int(c));
+    else
+      str1 += c;
+  }
 
-        ++l;
-      }
+  return str1 + "\"";
+}
 
-      while (r >= l) {
-        if (! isspace(str[r])) break;
+bool
+CTclTraceLog::
+writeJson(const std::string &fileName) const
+{
+  FILE *fp = fopen(fileName.c_str(), "w");
 
-        --r;
-      }
-    }
-    else {
-      std::string chars = args[2]->toString();
+  if (! fp)
+    return false;
 
-      while (l <= r) {
-        if (chars.find(str[l]) == std::string::npos) break;
+  auto pid = COSProcess::getProcessId();
 
-        ++l;
-      }
+  fprintf(fp, "{\"traceEvents\":[\n");
 
-      while (r >= l) {
-        if (chars.find(str[r]) == std::string::npos) break;
+  for (std::size_t i = 0; i < events_.size(); ++i) {
+    const auto &event = events_[i];
 
-        --r;
-      }
-    }
+    // timestamps are microseconds
+    fprintf(fp, "{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":1",
+            event.phase, event.ts/1000.0, int(pid));
 
-    std::string str1 = str.substr(l, r - l + 1);
+    if (event.phase == 'B')
+      fprintf(fp, ",\"name\":%s,\"cat\":\"%s\",\"args\":{\"args\":%s,\"depth\":%u}",
+              jsonString(event.name).c_str(), event.category,
+              jsonString(event.args).c_str(), event.depth);
 
-    return CTclValueRef(tcl_->createValue(str1));
+    fprintf(fp, "}%s\n", i < events_.size() - 1 ? "," : "");
   }
-  else if (cmd == "trimleft") {
-    if (numArgs < 2 || numArgs > 3) {
-      tcl_->wrongNumArgs("string trimleft string ?chars?");
-      return CTclValueRef();
-    }
-
-    const std::string &str = args[1]->toString();
 
-    uint len = str.size();
+  fprintf(fp, "],\"displayTimeUnit\":\"ns\"}\n");
 
-    uint l = 0;
-    uint r = len - 1;
+  bool rc = (ferror(fp) == 0);
 
-    if (numArgs == 2) {
-      while (l <= r) {
-        if (! isspace(str[l])) break;
+  fclose(fp);
 
-        ++l;
-      }
-    }
-    else {
-      std::string chars = args[2]->toString();
+  return rc;
+}
 
-      while (l <= r) {
-        if (chars.find(str[l]) == std::string::npos) break;
+//-----------
 
-        ++l;
-      }
-    }
+void
+CTclLineProfiler::
+line(const std::string &fileName, uint lineNum)
+{
+  long t = profileNSecs();
 
-    std::string str1 = str.substr(l, r - l + 1);
+  if (lastStats_)
+    lastStats_->nsecs += t - lastTime_;
 
-    return CTclValueRef(tcl_->createValue(str1));
+  if (! lastLines_ || fileName != lastFile_) {
+    lastFile_  = fileName;
+    lastLines_ = &files_[fileName];
   }
-  else if (cmd == "trimright") {
-    if (numArgs < 2 || numArgs > 3) {
-      tcl_->wrongNumArgs("string trimright string ?chars?");
-      return CTclValueRef();
-    }
-
-    const std::string &str = args[1]->toString();
-
-    uint len = str.size();
 
-    uint l = 0;
-    uint r = len - 1;
+  lastStats_ = &(*lastLines_)[lineNum];
 
-    if (numArgs == 2) {
-      while (r >= l) {
-        if (! isspace(str[r])) break;
+  ++lastStats_->count;
 
-        --r;
-      }
-    }
-    else {
-      std::string chars = args[2]->toString();
+  lastTime_ = t;
+}
 
-      while (r >= l) {
-        if (chars.find(str[r]) == std::string::npos) break;
+void
+CTclLineProfiler::
+flush()
+{
+  if (lastStats_)
+    lastStats_->nsecs += profileNSecs() - lastTime_;
 
-        --r;
-      }
-    }
+  lastStats_ = nullptr;
+}
 
-    std::string str1 = str.substr(l, r - l + 1);
+void
+CTclLineProfiler::
+clear()
+{
+  files_.clear();
 
-    return CTclValueRef(tcl_->createValue(str1));
-  }
-  else if (cmd == "wordend") {
-    return CTclValueRef();
-  }
-  else if (cmd == "wordstart") {
-    return CTclValueRef();
-  }
-  else {
-    tcl_->throwError("bad option \"" + cmd + "\": must be "
-                     "bytelength, compare, equal, first, index, is, last, length, map, "
-                     "match, range, repeat, replace, tolower, toupper, totitle, trim, "
-                     "trimleft, trimright, wordend, or wordstart");
-    return CTclValueRef();
-  }
+  lastFile_  = "";
+  lastLines_ = nullptr;
+  lastStats_ = nullptr;
 }
 
-//----------
-
-CTclValueRef
-CTclSwitchCommand::
-exec(const std::vector<CTclValueRef> &args)
+// lines never run are marked '-'
+std::string
+CTclLineProfiler::
+listing(const std::string &fileName) const
 {
-  uint numArgs = args.size();
+  auto pf = files_.find(fileName);
 
-  bool is_exact  = true;
-  bool is_glob   = false;
-  bool is_regexp = false;
+  CFile file(fileName);
 
-  uint pos = 0;
+  std::string str, line;
 
-  while (pos < numArgs) {
-    const std::string &arg = args[pos]->toString();
+  uint lineNum = 0;
 
-    if (arg.size() > 0 && arg[0] == '-') {
-      ++pos;
+  while (file.readLine(line)) {
+    ++lineNum;
 
-      if      (arg == "--"     ) break;
-      else if (arg == "-exact" ) is_exact  = true;
-      else if (arg == "-glob"  ) is_glob   = true;
-      else if (arg == "-regexp") is_regexp = true;
+    const LineStats *stats = nullptr;
+
+    if (pf != files_.end()) {
+      auto pl = (*pf).second.find(lineNum);
+
+      if (pl != (*pf).second.end())
+        stats = &(*pl).second;
     }
+
+    if (stats)
+      str += CStrUtil::strprintf("%10lu %12.3f %5u: ", stats->count, stats->nsecs/1000.0, lineNum);
     else
-      break;
-  }
+      str += CStrUtil::strprintf("%10s %12s %5u: ", "-", "-", lineNum);
 
-  if (pos >= numArgs - 1) {
-    tcl_->wrongNumArgs("switch ?switches? string pattern body ... ?default body?");
-    return CTclValueRef();
+    str += line + "\n";
   }
 
-  const std::string &str = args[pos++]->toString();
+  return str;
+}
+
+//-----------
+
+CTclProcessMemory::Stats CTclProcessMemory::stats_[CTclProcessMemory::NUM_TYPES];
 
-  bool extra_pattern = false;
+long CTclProcessMemory::totalBytes_ = 0;
+long CTclProcessMemory::peakBytes_  = 0;
+long CTclProcessMemory::numScopes_  = 0;
 
-  std::vector<std::string>  patterns;
-  std::vector<CTclValueRef> bodies;
+uint                         CTclProcessMemory::currentSite_ = 0;
+uint                         CTclProcessMemory::lastSiteId_  = 0;
+CTclProcessMemory::SiteIds   CTclProcessMemory::siteIds_;
+CTclProcessMemory::SiteMap   CTclProcessMemory::sites_;
+CTclProcessMemory::Snapshots CTclProcessMemory::snapshots_;
 
-  if (pos == numArgs - 1) {
-    // single list of pattern body
-    CTclValueRef list;
+CTclValuePool::Block *CTclValuePool::freeList_[CTclValuePool::NUM_CLASSES];
+ulong                 CTclValuePool::numFree_ [CTclValuePool::NUM_CLASSES];
+CTclValuePool::Stats  CTclValuePool::stats_;
 
-    if (args[pos]->getType() == CTclValue::ValueType::LIST)
-      list = args[pos];
-    else
-      list = args[pos]->toList(tcl_);
+// allocate chunk of blocks for size class, return first and add rest to free list
+void *
+CTclValuePool::
+allocChunk(uint c)
+{
+  size_t size = classSize(c);
 
-    uint length = list->getLength();
+  char *chunk = static_cast<char *>(::operator new(size*CHUNK_SIZE));
 
-    uint i = 0;
+  ++stats_.chunks;
 
-    for ( ; i < length - 1; i += 2) {
-      const auto &pattern = list->getIndexValue(i)->toString();
-      auto        body    = list->getIndexValue(i + 1);
+  stats_.bytes += size*CHUNK_SIZE;
 
-      patterns.push_back(pattern);
-      bodies  .push_back(body);
-    }
+  for (uint i = CHUNK_SIZE - 1; i >= 1; --i) {
+    Block *block = reinterpret_cast<Block *>(chunk + i*size);
 
-    if (i < length)
-      extra_pattern = true;
+    block->next  = freeList_[c];
+    freeList_[c] = block;
   }
-  else {
-    while (pos < numArgs - 1) {
-      const auto &pattern = args[pos]->toString();
-      auto        body    = args[pos + 1];
-
-      patterns.push_back(pattern);
-      bodies  .push_back(body);
 
-      pos += 2;
-    }
+  numFree_[c] += CHUNK_SIZE - 1;
 
-    if (pos < numArgs)
-      extra_pattern = true;
-  }
+  return chunk;
+}
 
-  if (extra_pattern) {
-    tcl_->throwError("extra switch pattern with no body");
-    return CTclValueRef();
-  }
+//-----------
 
-  uint num_patterns = patterns.size();
+// remove leading/trailing space from number string
+static void
+trimNumber(const char *&s, const char *&e)
+{
+  while (s < e && isspace(*s)) ++s;
+  while (e > s && isspace(e[-1])) --e;
+}
 
-  if (is_regexp) {
-    CRegExp regexp(str);
+bool
+CTclNumber::
+toInteger(const std::string &str, long &i)
+{
+  const char *s = str.data();
+  const char *e = s + str.size();
 
-    for (uint i = 0; i < num_patterns; ++i) {
-      const auto &pattern = patterns[i];
-      auto        body    = bodies  [i];
+  // fast path : short decimal integer (upto 18 digits so cannot overflow)
+  if (s < e && e - s <= 18) {
+    const char *p = s;
 
-      if (i == num_patterns - 1 && pattern == "default") {
-        body->exec(tcl_);
-        break;
-      }
+    bool neg = (*p == '-');
 
-      if (regexp.find(pattern)) {
-        body->exec(tcl_);
-        break;
-      }
-    }
-  }
-  else if (is_glob) {
-    CGlob glob(str);
+    if (neg) ++p;
 
-    for (uint i = 0; i < num_patterns; ++i) {
-      const auto &pattern = patterns[i];
-      auto        body    = bodies  [i];
+    if (p < e) {
+      long l = 0;
 
-      if (i == num_patterns - 1 && pattern == "default") {
-        body->exec(tcl_);
-        break;
-      }
+      for ( ; p < e; ++p) {
+        uint d = uint(*p - '0');
 
-      if (glob.compare(pattern)) {
-        body->exec(tcl_);
-        break;
-      }
-    }
-  }
-  else {
-    for (uint i = 0; i < num_patterns; ++i) {
-      const auto &pattern = patterns[i];
-      auto        body    = bodies  [i];
+        if (d > 9) break;
 
-      if (i == num_patterns - 1 && pattern == "default") {
-        body->exec(tcl_);
-        break;
+        l = 10*l + d;
       }
 
-      if (str == pattern) {
-        body->exec(tcl_);
-        break;
+      if (p == e) {
+        i = (neg ? -l : l);
+        return true;
       }
     }
   }
 
-  return CTclValueRef();
-}
+  trimNumber(s, e);
 
-//----------
+  if (s == e)
+    return false;
 
-CTclValueRef
-CTclUpdateCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  bool neg = false;
 
-  if (numArgs > 1) {
-    tcl_->wrongNumArgs("update ?idletasks?");
-    return CTclValueRef();
+  if (*s == '+' || *s == '-') {
+    neg = (*s == '-');
+
+    ++s;
   }
 
-  bool idletasks = false;
+  int base = 10;
 
-  if (numArgs == 1) {
-    const std::string &arg = args[0]->toString();
+  if (e - s > 2 && s[0] == '0') {
+    char c = char(tolower(s[1]));
 
-    if (arg == "idletasks")
-      idletasks = true;
-    else {
-      tcl_->throwError("bad option \"" + arg + "\": must be idletasks");
-      return CTclValueRef();
-    }
+    if      (c == 'x') base = 16;
+    else if (c == 'o') base = 8;
+    else if (c == 'b') base = 2;
+
+    if (base != 10)
+      s += 2;
   }
 
-  tcl_->update(idletasks);
+  // parse as unsigned (no sign allowed) so LONG_MIN can be represented
+  ulong u;
 
-  return CTclValueRef();
-}
+  auto res = std::from_chars(s, e, u, base);
 
-//----------
+  if (res.ec != std::errc() || res.ptr != e)
+    return false;
 
-CTclValueRef
-CTclUnsetCommand::
-exec(const std::vector<CTclValueRef> &args)
-{
-  uint numArgs = args.size();
+  if (neg) {
+    if (u > ulong(LONG_MAX) + 1)
+      return false;
 
-  for (uint i = 0; i < numArgs; ++i) {
-    const std::string &varName = args[i]->toString();
+    i = long(0UL - u);
+  }
+  else {
+    if (u > ulong(LONG_MAX))
+      return false;
 
-    tcl_->removeVariable(varName);
+    i = long(u);
   }
 
-  return CTclValueRef();
+  return true;
 }
 
-//----------
-
-CTclValueRef
-CTclVariableCommand::
-exec(const std::vector<CTclValueRef> &args)
+bool
+CTclNumber::
+toReal(const std::string &str, double &r)
 {
-  uint numArgs = args.size();
+  const char *s = str.data();
+  const char *e = s + str.size();
 
-  if (numArgs < 1) {
-    tcl_->wrongNumArgs("variable ?name value...? name ?value?");
-    return CTclValueRef();
-  }
+  trimNumber(s, e);
 
-  auto *scope = tcl_->getScope();
-
-  if (numArgs == 1) {
-    const std::string &name = args[0]->toString();
+  if (s == e)
+    return false;
 
-    auto var = scope->getVariable(name);
+  if (*s == '+') {
+    ++s;
 
-    if (! var.isValid())
-      scope->addVariable(name, CTclValueRef());
+    if (s == e || *s == '-')
+      return false;
   }
-  else {
-    for (uint i = 0; i < numArgs - 1; i += 2) {
-      const auto &name  = args[i    ]->toString();
-      auto        value = args[i + 1];
 
-      auto var = scope->getVariable(name);
+  auto res = std::from_chars(s, e, r);
 
-      if (var.isValid())
-        var->setValue(value);
-      else
-        var = scope->addVariable(name, value);
+  if (res.ptr != e)
+    return false;
 
-      scope->addVariable(name, var);
-    }
+  // from_chars leaves value unset on overflow/underflow so use strtod's inf/zero
+  if (res.ec == std::errc::result_out_of_range) {
+    r = strtod(std::string(s, e).c_str(), nullptr);
+    return true;
   }
 
-  return CTclValueRef();
+  return (res.ec == std::errc());
 }
 
-//----------
-
-CTclValueRef
-CTclWhileCommand::
-exec(const std::vector<CTclValueRef> &args)
+std::string
+CTclNumber::
+toString(long i)
 {
-  uint numArgs = args.size();
+  // small non-negative integers (counters, indices, ...) are most common
+  if (i >= 0 && i < SMALL_INT_MAX) {
+    static const std::vector<std::string> smallInts = []() {
+      std::vector<std::string> strs(SMALL_INT_MAX);
 
-  if (numArgs != 2) {
-    tcl_->wrongNumArgs("while test command");
-    return CTclValueRef();
+      for (long j = 0; j < SMALL_INT_MAX; ++j)
+        strs[j] = std::to_string(j);
+
+      return strs;
+    }();
+
+    return smallInts[i];
   }
 
-  tcl_->setBreakFlag(false);
+  char buffer[24];
 
-  while (args[0]->evalBool(tcl_)) {
-    tcl_->setContinueFlag(false);
+  auto res = std::to_chars(buffer, buffer + sizeof(buffer), i);
 
-    args[1]->exec(tcl_);
+  return std::string(buffer, res.ptr);
+}
 
-    if (tcl_->getBreakFlag() || tcl_->getReturnFlag()) break;
-  }
+std::string
+CTclNumber::
+toString(ulong i)
+{
+  if (i < ulong(SMALL_INT_MAX))
+    return toString(long(i));
 
-  tcl_->setBreakFlag   (false);
-  tcl_->setContinueFlag(false);
+  char buffer[24];
 
-  return CTclValueRef();
-}
+  auto res = std::to_chars(buffer, buffer + sizeof(buffer), i);
 
-//-----------
+  return std::string(buffer, res.ptr);
+}
 
-CTclValueRef
-CTclProc::
-exec(const std::vector<CTclValueRef> &args)
+std::string
+CTclNumber::
+toString(double r)
 {
-  uint numArgs = args.size();
+  // shortest digits which read back as same value. Like Tcl fixed notation is
+  // used for decimal exponents in [-5, 17) and integral values get a decimal
+  // point so they still read back as real
+  char buffer[32];
 
-  uint numProcArgs = args_.size();
+  if (! std::isfinite(r)) {
+    auto res = std::to_chars(buffer, buffer + sizeof(buffer), r);
 
-  bool var_args = (numProcArgs > 0 && args_[numProcArgs - 1] == "args");
+    return std::string(buffer, res.ptr);
+  }
 
-  if (! var_args) {
-    if (numArgs != numProcArgs) {
-      std::string usage = name_;
+  auto res = std::to_chars(buffer, buffer + sizeof(buffer), r, std::chars_format::scientific);
 
-      for (uint i = 0; i < numProcArgs; ++i)
-        usage += " " + args_[i];
+  std::string str(buffer, res.ptr);
 
-      tcl_->throwError("wrong # args: should be \"" + usage + "\"");
+  auto epos = str.find('e');
 
-      return CTclValueRef();
-    }
-  }
-  else {
-    if (numArgs < numProcArgs - 1) {
-      std::string usage = name_;
+  int exponent = std::atoi(str.c_str() + epos + 1);
 
-      for (uint i = 0; i < numProcArgs; ++i)
-        usage += " " + args_[i];
+  if (exponent < -5 || exponent >= 17)
+    return str;
 
-      tcl_->throwError("wrong # args: should be \"" + usage + "\"");
+  // mantissa digits without sign and decimal point
+  std::string digits;
 
-      return CTclValueRef();
-    }
-  }
+  bool negative = (str[0] == '-');
 
-  auto *pscope = tcl_->getScope();
+  for (std::size_t i = (negative ? 1 : 0); i < epos; ++i) {
+    if (str[i] != '.')
+      digits += str[i];
+  }
 
-  auto *scope = new CTclScope(tcl_, pscope);
+  std::string str1 = (negative ? "-" : "");
 
-  tcl_->pushScope(scope);
+  if (exponent >= 0) {
+    std::size_t numInt = std::size_t(exponent) + 1;
 
-  if (! var_args) {
-    for (uint i = 0; i < numProcArgs; ++i)
-      scope->setVariableValue(args_[i], args[i]);
+    if (digits.size() <= numInt)
+      str1 += digits + std::string(numInt - digits.size(), '0') + ".0";
+    else
+      str1 += digits.substr(0, numInt) + "." + digits.substr(numInt);
   }
-  else {
-    for (uint i = 0; i < numProcArgs - 1; ++i)
-      scope->setVariableValue(args_[i], args[i]);
+  else
+    str1 += "0." + std::string(std::size_t(-exponent - 1), '0') + digits;
 
-    auto *list = new CTclList;
+  return str1;
+}
 
-    for (uint i = numProcArgs - 1; i < numArgs; ++i)
-      list->addValue(args[i]);
+//-----------
 
-    scope->setVariableValue("args", CTclValueRef(list));
+void
+CTclProcessMemory::
+resetPeak()
+{
+  for (auto &stats : stats_) {
+    stats.peakCount = stats.count;
+    stats.peakBytes = stats.bytes;
   }
 
-  const std::string &bodyStr = body_->toString();
+  peakBytes_ = totalBytes_;
+}
 
-  auto value = tcl_->parseString(bodyStr);
+uint
+CTclProcessMemory::
+getSiteId(const std::string &name)
+{
+  auto p = siteIds_.find(name);
 
-  delete scope;
+  if (p != siteIds_.end())
+    return (*p).second;
 
-  tcl_->popScope();
+  uint id = ++lastSiteId_;
 
-  CTclValueRef retVal;
+  siteIds_[name] = id;
 
-  if (tcl_->getReturnFlag(retVal))
-    value = retVal;
+  sites_[id].name = name;
 
-  tcl_->setReturnFlag(false);
+  return id;
+}
 
-  return value;
+void
+CTclProcessMemory::
+addSite(uint site, long count, long bytes)
+{
+  auto p = sites_.find(site);
+
+  // site cleared
+  if (p == sites_.end())
+    return;
+
+  auto &stats = (*p).second;
+
+  stats.count += count;
+  stats.bytes += bytes;
+
+  if (count > 0)
+    stats.allocs += ulong(count);
 }
 
-//-----------
+void
+CTclProcessMemory::
+clearSites()
+{
+  currentSite_ = 0;
+
+  siteIds_.clear();
+  sites_  .clear();
+}
+
+void
+CTclProcessMemory::
+getSnapshot(Snapshot &snapshot)
+{
+  snapshot.clear();
+
+  for (const auto &ps : sites_)
+    snapshot[ps.second.name] = ps.second;
+}
+
+void
+CTclProcessMemory::
+saveSnapshot(const std::string &name)
+{
+  getSnapshot(snapshots_[name]);
+}
 
 bool
-operator<(CTclValueRef lhs, CTclValueRef rhs) {
-  if (lhs->getType() != rhs->getType()) return (lhs->getType() < rhs->getType());
+CTclProcessMemory::
+getSavedSnapshot(const std::string &name, Snapshot &snapshot)
+{
+  auto p = snapshots_.find(name);
 
-  return lhs->cmp(rhs);
+  if (p == snapshots_.end())
+    return false;
+
+  snapshot = (*p).second;
+
+  return true;
 }
+
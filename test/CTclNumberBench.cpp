@@ -0,0 +1,116 @@
+// micro-benchmark of value number conversion : CStrUtil (old) vs CTclNumber (new)
+//
+// usage: CTclNumberBench [count]
+
+#include <CTcl.h>
+#include <CStrUtil.h>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+static volatile long   isink;
+static volatile double rsink;
+
+template<typename FUNC>
+double
+timeIt(FUNC f)
+{
+  auto start = std::chrono::steady_clock::now();
+
+  f();
+
+  auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void
+report(const char *name, double oldTime, double newTime)
+{
+  printf("%-16s %10.2f %10.2f %8.2fx\n", name, oldTime, newTime,
+         newTime > 0 ? oldTime/newTime : 0.0);
+}
+
+int
+main(int argc, char **argv)
+{
+  long count = (argc > 1 ? atol(argv[1]) : 1000000);
+
+  // inputs : small and large integers, short and long reals
+  std::vector<std::string> intStrs, realStrs;
+  std::vector<long>        ints;
+  std::vector<double>      reals;
+
+  for (long i = 0; i < 1000; ++i) {
+    long l = (i % 2 ? i : i*7919*104729);
+
+    double r = (i % 2 ? i/8.0 : i/3.0);
+
+    ints .push_back(l);
+    reals.push_back(r);
+
+    intStrs .push_back(std::to_string(l));
+    realStrs.push_back(CTclNumber::toString(r));
+  }
+
+  printf("%-16s %10s %10s %9s\n", "conversion", "old (ms)", "new (ms)", "speedup");
+
+  //---
+
+  double t1 = timeIt([&]() {
+    for (long i = 0; i < count; ++i) {
+      long l; CStrUtil::toInteger(intStrs[i % 1000], &l); isink = l; }
+  });
+
+  double t2 = timeIt([&]() {
+    for (long i = 0; i < count; ++i) {
+      long l; CTclNumber::toInteger(intStrs[i % 1000], l); isink = l; }
+  });
+
+  report("parse integer", t1, t2);
+
+  //---
+
+  t1 = timeIt([&]() {
+    for (long i = 0; i < count; ++i) {
+      double r; CStrUtil::toReal(realStrs[i % 1000], &r); rsink = r; }
+  });
+
+  t2 = timeIt([&]() {
+    for (long i = 0; i < count; ++i) {
+      double r; CTclNumber::toReal(realStrs[i % 1000], r); rsink = r; }
+  });
+
+  report("parse real", t1, t2);
+
+  //---
+
+  t1 = timeIt([&]() {
+    for (long i = 0; i < count; ++i)
+      isink = long(CStrUtil::toString(ints[i % 1000]).size());
+  });
+
+  t2 = timeIt([&]() {
+    for (long i = 0; i < count; ++i)
+      isink = long(CTclNumber::toString(ints[i % 1000]).size());
+  });
+
+  report("format integer", t1, t2);
+
+  //---
+
+  t1 = timeIt([&]() {
+    for (long i = 0; i < count; ++i)
+      isink = long(CStrUtil::toString(reals[i % 1000]).size());
+  });
+
+  t2 = timeIt([&]() {
+    for (long i = 0; i < count; ++i)
+      isink = long(CTclNumber::toString(reals[i % 1000]).size());
+  });
+
+  report("format real", t1, t2);
+
+  return 0;
+}